@@ -4,11 +4,11 @@
  */
  
 /**
- * Uncomment following line to enable debug macros.
+ * Define DEBUG to enable debug macros, e.g. by loading the shader through `ProgramVariants` with a "DEBUG" option.
+ * This way the debug views are compiled into a separate variant and the regular variant stays free of branches.
  * A uniform uDebug is required to be set to the index of the debug view
  * then you can specify different debug views by using the DEBUG_VIEW macro.
  */
-//#define DEBUG
 #ifdef DEBUG
 #define RENDER_VIEW(c) if (uDebug == 0U) fragColor = c
 #define DEBUG_VIEW(i, v) if (uDebug == uint(i)) fragColor = v
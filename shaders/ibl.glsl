@@ -0,0 +1,29 @@
+#line 2 108
+/**
+ * Lookups for the image-based lighting precomputed by `IBL::load`.
+ * The cubemaps and spherical harmonics are stored mirrored along x like the skybox, so directions are mirrored before every lookup.
+ */
+
+/**
+ * Evaluates the diffuse radiance of a white Lambertian surface from the nine irradiance spherical harmonics coefficients.
+ */
+vec3 irradianceSH(vec3 sh[9], vec3 normal) {
+    vec3 n = normal * vec3(-1.0, 1.0, 1.0);
+    vec3 result = sh[0] * 0.282095
+        + sh[1] * 0.488603 * n.y
+        + sh[2] * 0.488603 * n.z
+        + sh[3] * 0.488603 * n.x
+        + sh[4] * 1.092548 * n.x * n.y
+        + sh[5] * 1.092548 * n.y * n.z
+        + sh[6] * 0.315392 * (3.0 * n.z * n.z - 1.0)
+        + sh[7] * 1.092548 * n.x * n.z
+        + sh[8] * 0.546274 * (n.x * n.x - n.y * n.y);
+    return max(result, vec3(0.0));
+}
+
+/**
+ * Looks up the GGX prefiltered radiance in the reflected direction, the roughness is stored linearly across the mip levels.
+ */
+vec3 prefilteredRadiance(samplerCube specular, float levels, vec3 reflected, float roughness) {
+    return textureLod(specular, reflected * vec3(-1.0, 1.0, 1.0), roughness * (levels - 1.0)).rgb;
+}
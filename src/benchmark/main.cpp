@@ -0,0 +1,473 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <stb_image_write.h>
+
+#include "framework/bvh.hpp"
+#include "framework/camera.hpp"
+#include "framework/context.hpp"
+#include "framework/exr.hpp"
+#include "framework/meshlet.hpp"
+#include "framework/meshlod.hpp"
+#include "framework/objparser.hpp"
+#include "framework/occlusionculler.hpp"
+#include "framework/pathtracer.hpp"
+#include "framework/pixelconvert.hpp"
+#include "framework/png.hpp"
+#include "framework/scene.hpp"
+#include "framework/threadpool.hpp"
+
+/**
+ * @file main.cpp
+ * @brief Measures the throughput of the CPU side framework kernels, run without arguments for all suites or with the names of the suites to run.
+ */
+
+namespace {
+
+struct Suite {
+    const char* name;
+    std::function<void()> run;
+};
+
+/**
+ * @brief Runs a function repeatedly for at least a quarter second and returns the best time of a single run in seconds.
+ */
+double measure(const std::function<void()>& function) {
+    using Clock = std::chrono::steady_clock;
+    function(); // Warm up caches and page in the buffers
+    double best = 1e30;
+    const auto start = Clock::now();
+    int runs = 0;
+    while (runs < 5 || std::chrono::duration<double>(Clock::now() - start).count() < 0.25) {
+        const auto begin = Clock::now();
+        function();
+        best = std::min(best, std::chrono::duration<double>(Clock::now() - begin).count());
+        runs++;
+    }
+    return best;
+}
+
+void benchmarkPixelConvert() {
+    using namespace PixelConvert;
+    constexpr size_t PIXELS = 2048 * 2048;
+
+    std::mt19937 random(42);
+    std::vector<uint8_t> bytes(PIXELS * 4), bytesOut(PIXELS * 4);
+    for (auto& byte : bytes) byte = static_cast<uint8_t>(random());
+    std::vector<float> floats(PIXELS * 4), floatsOut(PIXELS * 4);
+    std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+    for (auto& value : floats) value = distribution(random);
+    std::vector<uint16_t> halfs(PIXELS * 4);
+    floatToHalf(floats.data(), halfs.data(), halfs.size());
+
+    // The throughput counts the bytes read and written
+    struct Kernel {
+        const char* name;
+        size_t bytes;
+        std::function<void()> run;
+    };
+    const std::vector<Kernel> kernels = {
+        {"unsignedToSigned", PIXELS * 8, [&] { unsignedToSigned(bytes.data(), reinterpret_cast<int8_t*>(bytesOut.data()), PIXELS * 4); }},
+        {"floatToHalf", PIXELS * 24, [&] { floatToHalf(floats.data(), halfs.data(), PIXELS * 4); }},
+        {"halfToFloat", PIXELS * 24, [&] { halfToFloat(halfs.data(), floatsOut.data(), PIXELS * 4); }},
+        {"srgbToLinear", PIXELS * 20, [&] { srgbToLinear(bytes.data(), floatsOut.data(), PIXELS, 4, true); }},
+        {"linearToSRGB", PIXELS * 20, [&] { linearToSRGB(floats.data(), bytesOut.data(), PIXELS, 4, true); }},
+        {"expandRGBToRGBA", PIXELS * 7, [&] { expandRGBToRGBA(bytes.data(), bytesOut.data(), PIXELS); }},
+        {"swizzleRGBA", PIXELS * 8, [&] { swizzleRGBA(bytes.data(), bytesOut.data(), PIXELS, {2, 1, 0, 3}); }},
+        {"flipRows", PIXELS * 8, [&] { flipRows(bytesOut.data(), 2048 * 4, 2048); }},
+    };
+
+    std::vector<InstructionSet> instructionSets = {InstructionSet::Scalar};
+    for (auto instructionSet : {InstructionSet::SSE41, InstructionSet::AVX2, InstructionSet::NEON}) {
+        if (setInstructionSet(instructionSet)) instructionSets.push_back(instructionSet);
+    }
+
+    std::cout << std::left << std::setw(20) << "GB/s";
+    for (auto instructionSet : instructionSets) std::cout << std::right << std::setw(10) << getName(instructionSet);
+    std::cout << std::endl;
+    for (const auto& kernel : kernels) {
+        std::cout << std::left << std::setw(20) << kernel.name << std::right << std::fixed << std::setprecision(2);
+        for (auto instructionSet : instructionSets) {
+            setInstructionSet(instructionSet);
+            std::cout << std::setw(10) << kernel.bytes / measure(kernel.run) * 1e-9;
+        }
+        std::cout << std::endl;
+    }
+    setInstructionSet(getSupportedInstructionSet());
+}
+
+void benchmarkPNG() {
+    constexpr int WIDTH = 3840, HEIGHT = 2160, CHANNELS = 4;
+
+    // A synthetic frame resembling a screenshot: a smooth gradient with flat UI panels and a band of film grain
+    std::mt19937 random(42);
+    std::vector<uint8_t> pixels(static_cast<size_t>(WIDTH) * HEIGHT * CHANNELS);
+    for (int y = 0; y < HEIGHT; y++) {
+        for (int x = 0; x < WIDTH; x++) {
+            uint8_t* pixel = &pixels[(static_cast<size_t>(y) * WIDTH + x) * CHANNELS];
+            const bool panel = x < WIDTH / 5 && y < HEIGHT / 2;
+            const int grain = y > HEIGHT * 3 / 4 ? static_cast<int>(random() % 16) - 8 : 0;
+            pixel[0] = panel ? 40 : static_cast<uint8_t>(std::clamp(x * 255 / WIDTH + grain, 0, 255));
+            pixel[1] = panel ? 40 : static_cast<uint8_t>(std::clamp(y * 255 / HEIGHT + grain, 0, 255));
+            pixel[2] = panel ? 48 : static_cast<uint8_t>(std::clamp((x + y) * 255 / (WIDTH + HEIGHT) + grain, 0, 255));
+            pixel[3] = 255;
+        }
+    }
+    const size_t rawSize = pixels.size();
+
+    size_t size = 0;
+    const double pngTime = measure([&] { size = PNG::encode(pixels.data(), WIDTH, HEIGHT, CHANNELS).size(); });
+    const size_t pngSize = size;
+    const double stbTime = measure([&] {
+        size = 0;
+        stbi_write_png_to_func([](void* context, void*, int bytes) { *static_cast<size_t*>(context) += bytes; },
+                               &size, WIDTH, HEIGHT, CHANNELS, pixels.data(), WIDTH * CHANNELS);
+    });
+    const size_t stbSize = size;
+
+    std::cout << std::left << std::setw(20) << "3840x2160 RGBA" << std::right << std::setw(10) << "ms" << std::setw(10) << "MB/s" << std::setw(10) << "ratio" << std::endl;
+    const auto print = [&](const char* name, double time, size_t compressed) {
+        std::cout << std::left << std::setw(20) << name << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(10) << time * 1e3 << std::setw(10) << rawSize / time * 1e-6 << std::setprecision(2) << std::setw(10) << static_cast<double>(rawSize) / compressed << std::endl;
+    };
+    print("PNG::encode", pngTime, pngSize);
+    print("stbi_write_png", stbTime, stbSize);
+}
+
+void benchmarkEXR() {
+    constexpr int WIDTH = 3840, HEIGHT = 2160, CHANNELS = 4;
+
+    // A synthetic HDR G-buffer attachment: smooth lighting with a noisy band of specular highlights
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> distribution(0.0f, 4.0f);
+    std::vector<float> pixels(static_cast<size_t>(WIDTH) * HEIGHT * CHANNELS);
+    for (int y = 0; y < HEIGHT; y++) {
+        for (int x = 0; x < WIDTH; x++) {
+            float* pixel = &pixels[(static_cast<size_t>(y) * WIDTH + x) * CHANNELS];
+            const float highlight = y > HEIGHT * 3 / 4 ? distribution(random) : 0.0f;
+            pixel[0] = static_cast<float>(x) / WIDTH + highlight;
+            pixel[1] = static_cast<float>(y) / HEIGHT + highlight;
+            pixel[2] = 0.5f + highlight;
+            pixel[3] = 1.0f;
+        }
+    }
+    const size_t rawSize = pixels.size() * sizeof(float);
+
+    std::cout << std::left << std::setw(20) << "3840x2160 RGBA32F" << std::right << std::setw(10) << "ms" << std::setw(10) << "MB/s" << std::setw(10) << "ratio" << std::endl;
+    const auto print = [&](const std::string& name, double time, size_t compressed) {
+        std::cout << std::left << std::setw(20) << name << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(10) << time * 1e3 << std::setw(10) << rawSize / time * 1e-6 << std::setprecision(2) << std::setw(10) << static_cast<double>(rawSize) / compressed << std::endl;
+    };
+
+    for (auto type : {EXR::PixelType::HALF, EXR::PixelType::FLOAT}) {
+        for (auto compression : {EXR::Compression::NONE, EXR::Compression::RLE, EXR::Compression::ZIP}) {
+            size_t size = 0;
+            const double time = measure([&] { size = EXR::encode(pixels.data(), WIDTH, HEIGHT, "RGBA", type, compression).size(); });
+            const std::string name = std::string(type == EXR::PixelType::HALF ? "half " : "float ")
+                                   + (compression == EXR::Compression::NONE ? "none" : compression == EXR::Compression::RLE ? "rle" : "zip");
+            print(name, time, size);
+        }
+    }
+
+    size_t size = 0;
+    const double time = measure([&] {
+        size = 0;
+        stbi_write_hdr_to_func([](void* context, void*, int bytes) { *static_cast<size_t*>(context) += bytes; },
+                               &size, WIDTH, HEIGHT, CHANNELS, pixels.data());
+    });
+    print("stbi_write_hdr", time, size);
+}
+
+void benchmarkScene() {
+    // A wide hierarchy of 8^6 leaves, e.g. instances grouped into cells of a world
+    constexpr int DEPTH = 6, FANOUT = 8;
+    Scene scene;
+    std::vector<Scene::Node> level = {scene.create()};
+    for (int depth = 0; depth < DEPTH; depth++) {
+        std::vector<Scene::Node> next;
+        for (auto parent : level) {
+            for (int i = 0; i < FANOUT; i++) next.push_back(scene.create(parent, vec3(static_cast<float>(i), 0.0f, 0.0f)));
+        }
+        level = std::move(next);
+    }
+    scene.update();
+
+    struct ObjectData {
+        mat4 uLocalToClip;
+        mat4 uLocalToWorld;
+    };
+    std::vector<ObjectData> objects(scene.size());
+    const quat rotation = angleAxis(0.1f, vec3(0.0f, 1.0f, 0.0f));
+
+    std::cout << scene.size() << " nodes" << std::endl;
+    std::cout << std::left << std::setw(24) << "" << std::right << std::setw(10) << "ms" << std::setw(14) << "Mnodes/s" << std::endl;
+    const auto print = [&](const char* name, double time, size_t nodes) {
+        std::cout << std::left << std::setw(24) << name << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(10) << time * 1e3 << std::setprecision(1) << std::setw(14) << nodes / time * 1e-6 << std::endl;
+    };
+    size_t updated = 0;
+    double time = measure([&] { scene.setRotation(0, rotation); updated = scene.update(); });
+    print("update all", time, updated);
+    time = measure([&] { scene.setRotation(1, rotation); updated = scene.update(); });
+    print("update one subtree", time, updated);
+    time = measure([&] { scene.update(); });
+    print("update clean", time, scene.size());
+    time = measure([&] { scene.writeObjectBuffers(mat4(1.0f), objects.data()); });
+    print("writeObjectBuffers", time, scene.size());
+}
+
+/**
+ * @brief Generates a bumpy unit sphere with 2 * rings * segments triangles.
+ */
+void bumpySphere(int rings, int segments, std::vector<vec3>& positions, std::vector<unsigned int>& indices) {
+    for (int ring = 0; ring <= rings; ring++) {
+        const float theta = static_cast<float>(ring) / rings * 3.14159265f;
+        for (int segment = 0; segment <= segments; segment++) {
+            const float phi = static_cast<float>(segment) / segments * 6.28318531f;
+            const float radius = 1.0f + 0.05f * std::sin(theta * 40.0f) * std::sin(phi * 40.0f);
+            positions.push_back(radius * vec3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)));
+        }
+    }
+    for (int ring = 0; ring < rings; ring++) {
+        for (int segment = 0; segment < segments; segment++) {
+            const unsigned int a = ring * (segments + 1) + segment, b = a + segments + 1;
+            indices.insert(indices.end(), {a, b, a + 1, a + 1, b, b + 1});
+        }
+    }
+}
+
+void benchmarkBVH() {
+    std::vector<vec3> positions;
+    std::vector<unsigned int> indices;
+    bumpySphere(512, 1024, positions, indices);
+
+    // Coherent primary rays of a 1024x1024 view and incoherent rays between random points around the sphere
+    constexpr int VIEW = 1024;
+    std::vector<Ray> coherent, incoherent;
+    for (int y = 0; y < VIEW; y++) {
+        for (int x = 0; x < VIEW; x++) {
+            const vec2 clip = (vec2(static_cast<float>(x), static_cast<float>(y)) + 0.5f) / static_cast<float>(VIEW) * 2.0f - 1.0f;
+            coherent.push_back({vec3(0.0f, 0.0f, 3.0f), 0.0f, vec3(clip * 0.5f, -1.0f)});
+        }
+    }
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> distribution(-1.5f, 1.5f);
+    for (size_t i = 0; i < coherent.size(); i++) {
+        const vec3 from(distribution(random), distribution(random), distribution(random));
+        const vec3 to(distribution(random), distribution(random), distribution(random));
+        incoherent.push_back({from, 0.0f, to - from});
+    }
+
+    BVH bvh;
+    double time = measure([&] { bvh.build(positions, indices); });
+    std::cout << indices.size() / 3 << " triangles, " << bvh.nodes.size() << " nodes, " << ThreadPool::global().size() + 1 << " threads" << std::endl;
+    std::cout << std::left << std::setw(24) << "build" << std::right << std::fixed << std::setprecision(3) << std::setw(10) << time * 1e3 << " ms" << std::endl;
+
+    std::cout << std::left << std::setw(24) << "" << std::right << std::setw(10) << "ms" << std::setw(14) << "MRays/s" << std::setw(10) << "hits" << std::endl;
+    const auto trace = [&](const char* name, const std::vector<Ray>& rays, bool shadow) {
+        std::atomic<size_t> hits = 0;
+        const double time = measure([&] {
+            hits = 0;
+            ThreadPool::global().parallelForChunks(0, rays.size(), [&](size_t begin, size_t end) {
+                size_t count = 0;
+                for (size_t i = begin; i < end; i++) {
+                    Hit hit;
+                    count += shadow ? bvh.occluded(rays[i]) : bvh.intersect(rays[i], hit);
+                }
+                hits += count;
+            }, 4096);
+        });
+        std::cout << std::left << std::setw(24) << name << std::right << std::fixed << std::setprecision(3) << std::setw(10) << time * 1e3
+                  << std::setprecision(1) << std::setw(14) << rays.size() / time * 1e-6 << std::setw(10) << hits.load() << std::endl;
+    };
+    trace("coherent intersect", coherent, false);
+    trace("incoherent intersect", incoherent, false);
+    trace("incoherent occluded", incoherent, true);
+}
+
+void benchmarkMeshLOD() {
+    // Position, texture coordinates and normal like the vertices of OBJ files
+    std::vector<vec3> positions;
+    std::vector<unsigned int> indices;
+    bumpySphere(128, 256, positions, indices);
+    std::vector<float> vertices;
+    for (const auto& position : positions) vertices.insert(vertices.end(), {position.x, position.y, position.z, 0.0f, 0.0f, position.x, position.y, position.z});
+    MeshLOD::Vertices description;
+    description.data = vertices.data();
+    description.count = positions.size();
+    description.stride = 8;
+    description.attributeWeights = {0.01f, 0.01f, 0.001f, 0.001f, 0.001f};
+
+    std::vector<MeshLOD::Level> chain;
+    double time = measure([&] { chain = MeshLOD::generate(description, indices, 6); });
+    std::cout << std::left << std::setw(24) << "generate" << std::right << std::fixed << std::setprecision(3) << std::setw(10) << time * 1e3 << " ms" << std::endl;
+    for (size_t level = 0; level < chain.size(); level++) {
+        std::cout << std::left << std::setw(24) << ("level " + std::to_string(level)) << std::right << std::setw(10) << chain[level].indices.size() / 3
+                  << " triangles, error " << std::setprecision(5) << chain[level].error << std::endl;
+    }
+    time = measure([&] { MeshLOD::simplify(description, indices, indices.size() / 4); });
+    std::cout << std::left << std::setw(24) << "simplify to 25%" << std::right << std::setprecision(3) << std::setw(10) << time * 1e3 << " ms" << std::endl;
+}
+
+void benchmarkMeshlet() {
+    // Share of the triangles that survive culling while orbiting the bundled meshes at three times their radius
+    Context::setWorkingDirectory();
+    const auto lookAt = [](const vec3& eye, const vec3& center) {
+        const vec3 forward = normalize(center - eye), side = normalize(cross(forward, vec3(0.0f, 1.0f, 0.0f))), up = cross(side, forward);
+        mat4 view(1.0f);
+        for (int i = 0; i < 3; i++) {
+            view[i][0] = side[i];
+            view[i][1] = up[i];
+            view[i][2] = -forward[i];
+        }
+        view[3] = vec4(-dot(side, eye), -dot(up, eye), dot(forward, eye), 1.0f);
+        return view;
+    };
+    Camera camera;
+    camera.aspectRatio = 16.0f / 9.0f;
+    camera.updateIfChanged();
+
+    std::cout << std::left << std::setw(24) << "" << std::right << std::setw(10) << "meshlets" << std::setw(10) << "build ms" << std::setw(10) << "cull us"
+              << "  visible triangles at azimuth 0, 45, ... 315 and elevation 0 / 45" << std::endl;
+    for (const char* name : {"suzanne", "donut", "cylinder", "cube"}) {
+        std::vector<Mesh::VertexPTN> vertices;
+        std::vector<unsigned int> indices;
+        ObjParser::parse(std::string("meshes/") + name + ".obj", vertices, indices);
+        std::vector<vec3> positions(vertices.size());
+        vec3 minimum(1e30f), maximum(-1e30f);
+        for (size_t i = 0; i < vertices.size(); i++) {
+            positions[i] = vertices[i].position;
+            minimum = min(minimum, positions[i]);
+            maximum = max(maximum, positions[i]);
+        }
+        const vec3 center = (minimum + maximum) * 0.5f;
+        const float radius = length(maximum - minimum) * 0.5f;
+
+        Meshlets meshlets;
+        std::vector<unsigned int> reordered;
+        const double buildTime = measure([&] {
+            reordered = indices;
+            meshlets.meshlets = Meshlets::build(positions, reordered);
+        });
+        double cullTime = 0.0;
+        std::stringstream reduction;
+        for (float elevation : {0.0f, 45.0f}) {
+            for (int azimuth = 0; azimuth < 360; azimuth += 45) {
+                const float a = radians(static_cast<float>(azimuth)), e = radians(elevation);
+                const vec3 eye = center + 3.0f * radius * vec3(std::cos(e) * std::sin(a), std::sin(e), std::cos(e) * std::cos(a));
+                const mat4 localToClip = camera.projectionMatrix * lookAt(eye, center);
+                cullTime += measure([&] { meshlets.cull(localToClip, eye); }) / 16.0;
+                reduction << std::setw(5) << 100 * meshlets.stats.visibleTriangles / meshlets.stats.totalTriangles << "%";
+            }
+            if (elevation == 0.0f) reduction << " /";
+        }
+        std::cout << std::left << std::setw(24) << name << std::right << std::setw(10) << meshlets.meshlets.size() << std::fixed << std::setprecision(3)
+                  << std::setw(10) << buildTime * 1e3 << std::setw(10) << cullTime * 1e6 << " " << reduction.str() << std::endl;
+    }
+}
+
+void benchmarkOcclusion() {
+    // The bumpy sphere fills the middle of the view and hides a grid of boxes behind it
+    std::vector<vec3> positions;
+    std::vector<unsigned int> indices;
+    bumpySphere(128, 256, positions, indices);
+    Camera camera;
+    camera.aspectRatio = 2.0f;
+    camera.updateIfChanged();
+    const mat4 viewProjection = camera.projectionMatrix * camera.viewMatrix;
+    std::vector<mat4> boxes;
+    for (int y = -50; y < 50; y++) {
+        for (int z = -50; z < 50; z++) {
+            mat4 box(1.0f);
+            box[3] = vec4(-3.0f, y * 0.04f, z * 0.04f, 1.0f);
+            boxes.push_back(box);
+        }
+    }
+    AABB bounds;
+    bounds.extend(vec3(-0.01f));
+    bounds.extend(vec3(0.01f));
+
+    OcclusionCuller culler;
+    culler.begin(viewProjection);
+    culler.addOccluder(positions, indices, mat4(1.0f));
+    std::cout << indices.size() / 3 << " occluder triangles, " << culler.width << "x" << culler.height << " pixels, " << OcclusionCuller::getInstructionSet() << std::endl;
+    double time = measure([&] { culler.rasterize(); });
+    std::cout << std::left << std::setw(24) << "rasterize" << std::right << std::fixed << std::setprecision(3) << std::setw(10) << time * 1e3 << " ms" << std::endl;
+    time = measure([&] {
+        culler.begin(viewProjection);
+        for (const auto& box : boxes) culler.isVisible(bounds, box);
+    });
+    const auto stats = culler.getStats();
+    std::cout << std::left << std::setw(24) << "test boxes" << std::right << std::setw(10) << time * 1e3 << " ms, " << stats.occluded << " of " << stats.tested << " occluded" << std::endl;
+}
+
+void benchmarkPathTracer() {
+    std::vector<vec3> positions;
+    std::vector<unsigned int> indices;
+    bumpySphere(128, 256, positions, indices);
+    BVH bvh;
+    bvh.build(positions, indices);
+    TLAS tlas;
+    tlas.addInstance(bvh, mat4(1.0f));
+    tlas.build();
+    Camera camera;
+    camera.updateIfChanged();
+
+    // A single thread shows the per core throughput, the global pool how well the tiles scale
+    PathTracer tracer;
+    tracer.samples = 4;
+    ThreadPool single(0);
+    std::cout << std::left << std::setw(24) << "" << std::right << std::setw(10) << "ms" << std::setw(10) << "threads" << std::setw(20) << "samples/s/core" << std::endl;
+    const auto render = [&](const char* name, ThreadPool& pool) {
+        const double time = measure([&] { tracer.render(camera, tlas, 256, 256, pool); });
+        std::cout << std::left << std::setw(24) << name << std::right << std::fixed << std::setprecision(3) << std::setw(10) << time * 1e3
+                  << std::setw(10) << tracer.threads << std::setprecision(0) << std::setw(20) << 256.0 * 256.0 * tracer.samples / time / tracer.threads << std::endl;
+    };
+    render("single thread", single);
+    render("thread pool", ThreadPool::global());
+}
+
+const std::vector<Suite> SUITES = {
+    {"pixelconvert", benchmarkPixelConvert},
+    {"png", benchmarkPNG},
+    {"exr", benchmarkEXR},
+    {"scene", benchmarkScene},
+    {"bvh", benchmarkBVH},
+    {"meshlod", benchmarkMeshLOD},
+    {"meshlet", benchmarkMeshlet},
+    {"occlusion", benchmarkOcclusion},
+    {"pathtracer", benchmarkPathTracer},
+};
+
+}
+
+int main(int argc, char* argv[]) {
+    bool found = argc == 1;
+    for (const auto& suite : SUITES) {
+        bool selected = argc == 1;
+        for (int i = 1; i < argc; i++) selected |= std::strcmp(argv[i], suite.name) == 0;
+        if (!selected) continue;
+        found = true;
+        std::cout << "== " << suite.name << " ==" << std::endl;
+        suite.run();
+    }
+    if (!found) {
+        std::cerr << "Usage: " << argv[0] << " [suite...]\nSuites:";
+        for (const auto& suite : SUITES) std::cerr << " " << suite.name;
+        std::cerr << std::endl;
+        return 1;
+    }
+    return 0;
+}
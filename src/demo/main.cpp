@@ -1,10 +1,19 @@
 #include <iostream>
+#include <string>
 
 #include "mainapp.hpp"
+#include "framework/trace.hpp"
+#include "framework/gl/capture.hpp"
 
-int main() {
+int main(int argc, char* argv[]) {
+    if constexpr (Trace::COMPILED) Trace::start(); // Captures the startup, F8 writes the trace
     try {
+        // Records the OpenGL calls of the startup and the first frames for the replay tool
+        const bool capture = argc > 3 && std::string(argv[1]) == "--capture";
+        if (capture) GLCapture::start(argv[2], std::stoi(argv[3]));
         MainApp app;
+        // Benchmark runs play a recorded camera path and exit
+        if (argc > 1 && !capture) app.playCameraPath(argv[1], true);
         app.run();
     } catch (std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
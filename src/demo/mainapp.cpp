@@ -6,22 +6,35 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <imgui.h>
 
+#include <chrono>
+#include <filesystem>
 #include <vector>
 #include <iostream>
 
 #include "framework/imguiutil.hpp"
 #include "framework/app.hpp"
+#include "framework/bvh.hpp"
 #include "framework/camera.hpp"
+#include "framework/camerapath.hpp"
+#include "framework/dynamicresolution.hpp"
+#include "framework/ibl.hpp"
 #include "framework/mesh.hpp"
+#include "framework/meshlet.hpp"
+#include "framework/occlusionculler.hpp"
+#include "framework/occlusionqueries.hpp"
+#include "framework/pathtracer.hpp"
+#include "framework/scene.hpp"
+#include "framework/trace.hpp"
 #include "framework/uniformbuffer.hpp"
 #include "framework/gl/program.hpp"
 #include "framework/gl/texture.hpp"
 #include "framework/gl/framebuffer.hpp"
+#include "framework/gl/state.hpp"
 
 using namespace glm;
 
 MainApp::MainApp() : App(800, 600), worldUBO(0, world), objectUBO(1, object) {
-    App::setVSync(true); // Enable vertical synchronization
+    App::setVSync(vsync); // Enable vertical synchronization
     /* The background is rendered using a triangle that spans the whole frame */
     fullscreenTriangle.load(Mesh::FULLSCREEN_VERTICES, Mesh::FULLSCREEN_INDICES);
     backgroundShader.load("shaders/raygen.vert", "shaders/background.frag");
@@ -29,7 +42,23 @@ MainApp::MainApp() : App(800, 600), worldUBO(0, world), objectUBO(1, object) {
     backgroundShader.bindUBO("ObjectBuffer", 1);
     backgroundShader.bindTextureUnit("tCubemap", 0);
 
-    mesh.loadWithTangents("meshes/bunny.obj");
+    mesh.loadWithTangents("meshes/bunny.obj", 4); // Generates and caches 4 levels of detail
+    meshNode = scene.create();
+    meshlets.build(mesh); // Reorders the triangles, so it runs before the BVH is built
+    /* A ring of cubes around the bunny, the ones hidden behind it are culled on the CPU and on the GPU */
+    cube.load("meshes/cube.obj");
+    for (const auto& position : cube.positions) cubeBounds.extend(position);
+    for (int i = 0; i < 16; i++) {
+        const float angle = radians(22.5f * static_cast<float>(i));
+        cubeNodes.push_back(scene.create(Scene::NONE, vec3(3.0f * cos(angle), 0.0f, 3.0f * sin(angle)), quat(1.0f, 0.0f, 0.0f, 0.0f), vec3(0.25f)));
+        cubeQueries.push_back(occlusionQueries.add());
+    }
+    objects.resize(scene.size());
+    scene.update();
+    /* The bunny is picked with the mouse by casting rays against a BVH of its triangles */
+    meshBVH.build(mesh);
+    meshInstance = tlas.addInstance(meshBVH, scene.getWorldMatrix(meshNode));
+    tlas.build();
     meshShader.load("shaders/projection.vert", "shaders/debug.frag");
     meshShader.bindUBO("WorldBuffer", 0);
     meshShader.bindUBO("ObjectBuffer", 1);
@@ -43,17 +72,24 @@ MainApp::MainApp() : App(800, 600), worldUBO(0, world), objectUBO(1, object) {
     cubemap.loadCubemap(GL_RGB16F, "textures/studio");
     cubemap.bindTextureUnit(0);
 
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_CULL_FACE);
-    glCullFace(GL_BACK);
 }
 
 void MainApp::render() {
+    // Enable depth testing and backface culling, the state cache skips these calls if nothing changed
+    GLState::enable(GL_DEPTH_TEST);
+    GLState::enable(GL_CULL_FACE);
+    GLState::cullFace(GL_BACK);
+
+    // Render the scene offscreen at the scale that keeps the GPU time in budget
+    dynamicResolution.begin();
+    const vec2 renderResolution(dynamicResolution.getRenderResolution());
+
     // Clear the depth buffer
+    GLState::depthMask(true); // glClear respects the depth mask
     glClear(GL_DEPTH_BUFFER_BIT);
 
     /* Update uniforms that only change once per frame */
-    world.uResolution = resolution;
+    world.uResolution = renderResolution;
     world.uTime = time;
     world.uTimeDelta = delta;
 
@@ -65,33 +101,88 @@ void MainApp::render() {
     if (isKeyDown(Key::D)) cam.moveInEyeSpace(vec3(camDelta, 0.0f, 0.0f));
     if (isKeyDown(Key::Q)) cam.moveInEyeSpace(vec3(0.0f, camDelta, 0.0f));
     if (isKeyDown(Key::E)) cam.moveInEyeSpace(vec3(0.0f, -camDelta, 0.0f));
+    updateCameraPath();
 
     if (cam.updateIfChanged()) {
+        showReference = false;
         world.uAspectRatio = cam.aspectRatio;
         world.uCameraMatrix = cam.cameraMatrix;
         world.uFocalLength = cam.focalLength;
     }
     worldUBO.upload(world); // Send to GPU
 
+    /* Calculate object transformation, the scene only recomputes world matrices of changed nodes */
+    scene.setRotation(meshNode, angleAxis(time, vec3(0.0f, 1.0f, 0.0f)));
+    scene.update();
+
+    occlusionQueries.newFrame(); // Collects the results of earlier frames that have arrived
+
+    /* Rasterize the bunny as occluder on worker threads while the rest of the frame is prepared */
+    occlusionCuller.begin(cam.projectionMatrix * cam.viewMatrix);
+    occlusionCuller.addOccluder(mesh.positions, mesh.indices, scene.getWorldMatrix(meshNode));
+    auto occludersRasterized = occlusionCuller.rasterizeAsync();
+
     /* Render procedural sky in the background */
-    glDepthMask(GL_FALSE); // Disable writing to the depth buffer
+    GLState::depthMask(false); // Disable writing to the depth buffer
     backgroundShader.use(); // Bind shader
     fullscreenTriangle.draw(); // Draw fullscreen
 
-    /* Calculate object transformation */
-    mat4 projMat = cam.projectionMatrix;
-    mat4 viewMat = cam.viewMatrix;
-    mat4 modelMat = rotate(mat4(1.0f), time, vec3(0.0f, 1.0f, 0.0f));
+    /* Find the triangle under the cursor, refitting only updates the bounds of the moved instance */
+    if (scene.wasUpdated(meshNode)) {
+        tlas.setTransform(meshInstance, scene.getWorldMatrix(meshNode));
+        tlas.refit();
+    }
+    hoveredHit = Hit();
+    tlas.intersect({cam.worldPosition, 0.0f, cam.getRayDirection(convertCursorToClipSpace())}, hoveredHit);
 
     /* Update object specific uniforms */
-    object.uLocalToWorld = modelMat;
-    object.uLocalToClip = projMat * viewMat * modelMat;
-    objectUBO.upload(object); // Send to GPU
+    scene.writeObjectBuffers(cam.projectionMatrix * cam.viewMatrix, objects.data());
+    objectUBO.upload(objects[meshNode]); // Send to GPU
 
     /* Render mesh with texture in the foreground */
-    glDepthMask(GL_TRUE); // Enable writing to the depth buffer
+    GLState::depthMask(true); // Enable writing to the depth buffer
     meshShader.use(); // Bind shader
-    mesh.draw(); // Draw mesh
+    texture.bindTextureUnit(0); // The upscale of the last frame used the same unit
+    meshLOD = mesh.selectLOD(cam, scene.getWorldMatrix(meshNode), renderResolution.y); // The coarsest level that deviates less than a pixel
+    if (meshLOD == 0) {
+        // Close up, only the meshlets in the frustum that face the camera are drawn
+        meshlets.cull(cam, scene.getWorldMatrix(meshNode));
+        meshlets.draw(mesh);
+    } else {
+        mesh.drawLOD(meshLOD); // Draw mesh
+    }
+
+    /* Only draw the cubes that are not hidden behind the bunny */
+    occludersRasterized.wait();
+    std::vector<size_t> visibleCubes;
+    for (size_t i = 0; i < cubeNodes.size(); i++) {
+        if (occlusionCuller.isVisible(cubeBounds, scene.getWorldMatrix(cubeNodes[i]))) visibleCubes.push_back(i);
+    }
+    /* The coarse CPU test is refined on the GPU against the full resolution depth of the bunny, without waiting for the results */
+    occlusionQueries.beginTests();
+    for (const auto i : visibleCubes) occlusionQueries.test(cubeQueries[i], cubeBounds, objects[cubeNodes[i]].uLocalToClip);
+    occlusionQueries.endTests();
+    meshShader.use();
+    for (const auto i : visibleCubes) {
+        objectUBO.upload(objects[cubeNodes[i]]);
+        occlusionQueries.beginDraw(cubeQueries[i]);
+        cube.draw();
+        occlusionQueries.endDraw(cubeQueries[i]);
+    }
+
+    dynamicResolution.end(); // Upscales to the window
+
+    /* Show the CPU reference on top until the camera moves */
+    if (showReference) {
+    #ifdef MODERN_GL
+        glBlitNamedFramebuffer(referenceFramebuffer.handle, 0, 0, 0, pathTracer.width, pathTracer.height, 0, 0, static_cast<GLint>(resolution.x), static_cast<GLint>(resolution.y), GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    #else
+        referenceFramebuffer.bind(GL_READ_FRAMEBUFFER);
+        Framebuffer::bindDefault(GL_DRAW_FRAMEBUFFER);
+        glBlitFramebuffer(0, 0, pathTracer.width, pathTracer.height, 0, 0, static_cast<GLint>(resolution.x), static_cast<GLint>(resolution.y), GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        Framebuffer::bindDefault();
+    #endif
+    }
     traceOpenGLCalls = false; // Disable OpenGL call tracing
 }
 
@@ -109,6 +200,74 @@ void MainApp::keyCallback(Key key, Action action, Modifier modifier) {
     }
     // Take a screenshot with Shift + S
     if (key == Key::S && modifier >= Modifier::SHIFT && action == Action::PRESS) takeScreenshot("screenshot.bmp");
+    // Record a camera path with F5 and play it back with F6
+    if (key == Key::F5 && action == Action::PRESS) {
+        if (recordingPath) stopRecording();
+        else startRecording();
+    }
+    if (key == Key::F6 && action == Action::PRESS && !recordingPath) playCameraPath("camerapath.bin");
+    // Path trace the current view on the CPU with F7
+    if (key == Key::F7 && action == Action::PRESS) {
+        if (showReference) showReference = false;
+        else renderReference();
+    }
+    // Write the trace recorded since the start with F8, pressing it again starts a new one
+    if (key == Key::F8 && action == Action::PRESS) {
+        if (!Trace::COMPILED) {
+            std::cout << "Tracing is not compiled in, configure with -DENABLE_TRACE=ON" << std::endl;
+        } else if (Trace::isRecording()) {
+            Trace::stop();
+            if (Trace::write("trace.json")) std::cout << "Trace written to trace.json, open it in https://ui.perfetto.dev" << std::endl;
+        } else {
+            Trace::start();
+        }
+    }
+}
+
+void MainApp::renderReference() {
+    // The CPU reference is lit by the same environment, which is only loaded once a reference is rendered
+    if (pathTracer.environment.levels.empty()) pathTracer.environment = IBL::loadCubemap("textures/studio");
+    pathTracer.render(cam, tlas, static_cast<GLsizei>(resolution.x), static_cast<GLsizei>(resolution.y));
+    std::cout << "Reference: " << pathTracer.seconds << " s on " << pathTracer.threads << " threads, "
+              << pathTracer.samplesPerSecondPerCore() << " samples per second per core" << std::endl;
+    pathTracer.write("reference.exr");
+    pathTracer.upload(referenceTexture);
+    referenceFramebuffer.attach(GL_COLOR_ATTACHMENT0, referenceTexture);
+    showReference = true;
+}
+
+void MainApp::startRecording() {
+    cameraPath.clear();
+    recordingPath = true;
+    pathStartTime = time;
+}
+
+void MainApp::stopRecording() {
+    recordingPath = false;
+    cameraPath.save("camerapath.bin");
+}
+
+void MainApp::playCameraPath(const std::filesystem::path& filepath, bool closeWhenDone) {
+    cameraPath.load(filepath);
+    playingPath = true;
+    closeAfterPlayback = closeWhenDone;
+    fixedDelta = 1.0f / 60.0f; // Every run renders the same views
+    // The path starts with the next frame
+    pathStartTime = time + fixedDelta;
+    pathStartFrame = frames;
+    pathStartClock = std::chrono::steady_clock::now();
+}
+
+void MainApp::updateCameraPath() {
+    if (recordingPath) cameraPath.record(time - pathStartTime, cam);
+    if (playingPath && !cameraPath.apply(time - pathStartTime, cam)) {
+        playingPath = false;
+        fixedDelta = 0.0f;
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - pathStartClock).count();
+        const unsigned int played = frames - pathStartFrame;
+        std::cout << "Camera path: " << played << " frames in " << seconds << " s, " << seconds * 1000.0 / played << " ms per frame" << std::endl;
+        if (closeAfterPlayback) close();
+    }
 }
 
 void MainApp::scrollCallback(float xamount, float yamount) {
@@ -125,17 +284,43 @@ void MainApp::moveCallback(const vec2& movement, bool leftButton, bool rightButt
 void MainApp::resizeCallback(const vec2& resolution) {
     // Resize camera with window
     cam.resize(resolution.x / resolution.y);
+    dynamicResolution.resize(ivec2(resolution));
 }
 
 /* Build GUI elements here using the functions from imgui.h and util.cpp */
 void MainApp::buildImGui() {
     /* Render FPS, frametime and resolution. FPS and frametime are rolling averages */
     ImGui::StatisticsWindow(delta, resolution);
+    ImGui::GPUMemoryWindow();
+    ImGui::GLValidationWindow();
+    ImGui::FramePacingWindow(framePacer);
 
     /* Render a simple window with text and a button */
     ImGui::Begin("Hello, world!");
     ImGui::Text("Read me!");
     ImGui::Button("Click me!");
     ImGui::Text("Press ESC to exit or COMMA to toggle GUI.");
+    if (ImGui::Checkbox("VSync", &vsync)) setVSync(vsync);
+    ImGui::Text("Press F5 to record a camera path and F6 to play it.");
+    if (recordingPath) ImGui::Text("Recording camera path: %zu keyframes", cameraPath.keyframes.size());
+    if (playingPath) ImGui::Text("Playing camera path: %.1f / %.1f s", time - pathStartTime, cameraPath.duration());
+    ImGui::Text("Mesh LOD %zu of %zu: %d triangles", meshLOD, mesh.lods.size(), mesh.lods[meshLOD].count / 3);
+    if (meshLOD == 0) ImGui::Text("Meshlets: %zu of %zu visible, %zu triangles culled", meshlets.stats.visibleMeshlets, meshlets.meshlets.size(), meshlets.stats.totalTriangles - meshlets.stats.visibleTriangles);
+    const auto occlusion = occlusionCuller.getStats();
+    ImGui::Text("Occlusion culling (%s): %zu of %zu cubes culled, %zu occluder triangles in %.2f ms", OcclusionCuller::getInstructionSet(), occlusion.occluded, occlusion.tested, occlusion.occluderTriangles, occlusion.rasterizeMilliseconds);
+    const auto queries = occlusionQueries.getStats();
+    ImGui::Text("Occlusion queries: %zu tested, %zu skipped as recently visible, results %zu visible / %zu hidden", queries.tested, queries.skipped, queries.visibleResults, queries.hiddenResults);
+    ImGui::Text("Press F7 to path trace the view on the CPU.");
+    if (Trace::COMPILED) ImGui::Text("Press F8 to %s the trace.", Trace::isRecording() ? "write" : "restart");
+    if (showReference) ImGui::Text("Reference: %.0f samples/s per core", pathTracer.samplesPerSecondPerCore());
+    const ivec2 renderResolution = dynamicResolution.getRenderResolution();
+    ImGui::Text("Dynamic resolution: %.0f%% (%d x %d), GPU %.2f ms", dynamicResolution.getScale() * 100.0f, renderResolution.x, renderResolution.y, dynamicResolution.getGPUMilliseconds());
+    ImGui::Checkbox("Dynamic resolution", &dynamicResolution.enabled);
+    ImGui::SliderFloat("GPU budget (ms)", &dynamicResolution.targetMilliseconds, 1.0f, 33.0f);
+    ImGui::SliderFloat("Minimum scale", &dynamicResolution.minScale, 0.25f, 1.0f);
+    int filter = static_cast<int>(dynamicResolution.filter);
+    if (ImGui::Combo("Upscale filter", &filter, "Bilinear\0Sharpened\0")) dynamicResolution.filter = static_cast<DynamicResolution::Filter>(filter);
+    if (dynamicResolution.filter == DynamicResolution::Filter::Sharpened) ImGui::SliderFloat("Sharpness", &dynamicResolution.sharpness, 0.0f, 1.0f);
+    if (hoveredHit.valid()) ImGui::Text("Hovered triangle %u at distance %.2f, barycentrics (%.2f, %.2f)", hoveredHit.triangle, hoveredHit.t, hoveredHit.barycentrics.x, hoveredHit.barycentrics.y);
     ImGui::End();
 }
\ No newline at end of file
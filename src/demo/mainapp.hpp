@@ -1,12 +1,25 @@
 #pragma once
 
+#include <chrono>
+#include <filesystem>
+#include <vector>
+
 #include <glm/glm.hpp>
 using namespace glm;
 
 #include "framework/app.hpp"
+#include "framework/bvh.hpp"
 #include "framework/camera.hpp"
+#include "framework/camerapath.hpp"
+#include "framework/dynamicresolution.hpp"
 #include "framework/mesh.hpp"
+#include "framework/meshlet.hpp"
+#include "framework/occlusionculler.hpp"
+#include "framework/occlusionqueries.hpp"
+#include "framework/pathtracer.hpp"
+#include "framework/scene.hpp"
 #include "framework/uniformbuffer.hpp"
+#include "framework/gl/framebuffer.hpp"
 #include "framework/gl/program.hpp"
 #include "framework/gl/texture.hpp"
 
@@ -34,6 +47,12 @@ class MainApp : public App {
    public:
     MainApp();
 
+    /**
+     * @brief Plays a recorded camera path with a fixed timestep of 60 frames per second and prints the frame time when it is finished.
+     * @param closeWhenDone Whether to close the application after the playback, for scripted benchmark runs.
+     */
+    void playCameraPath(const std::filesystem::path& filepath, bool closeWhenDone = false);
+
    protected:
     void buildImGui() override;
     void render() override;
@@ -43,15 +62,48 @@ class MainApp : public App {
     void resizeCallback(const vec2& resolution) override;
 
    private:
+    void startRecording();
+    void stopRecording();
+    void updateCameraPath();
+    void renderReference();
+
+    bool vsync = true;
     Camera cam;
+    Scene scene;
+    Scene::Node meshNode;
+    CameraPath cameraPath;
+    bool recordingPath = false;
+    bool playingPath = false;
+    bool closeAfterPlayback = false;
+    float pathStartTime = 0.0f;
+    unsigned int pathStartFrame = 0;
+    std::chrono::steady_clock::time_point pathStartClock;
+    DynamicResolution dynamicResolution;
     Mesh fullscreenTriangle;
     Program backgroundShader;
     Mesh mesh;
+    size_t meshLOD = 0;
+    Meshlets meshlets;
+    Mesh cube;
+    AABB cubeBounds;
+    std::vector<Scene::Node> cubeNodes;
+    OcclusionCuller occlusionCuller;
+    OcclusionQueries occlusionQueries;
+    std::vector<uint32_t> cubeQueries;
+    BVH meshBVH;
+    TLAS tlas;
+    uint32_t meshInstance;
+    Hit hoveredHit;
+    PathTracer pathTracer;
+    Texture<GL_TEXTURE_2D> referenceTexture;
+    Framebuffer referenceFramebuffer;
+    bool showReference = false;
     Texture<GL_TEXTURE_2D> texture;
     Texture<GL_TEXTURE_CUBE_MAP> cubemap;
     Program meshShader;
     WorldBuffer world;
     ObjectBuffer object;
+    std::vector<ObjectBuffer> objects;
     UniformBuffer<WorldBuffer> worldUBO;
     UniformBuffer<ObjectBuffer> objectUBO;
 };
\ No newline at end of file
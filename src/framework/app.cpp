@@ -5,6 +5,9 @@
 #include <stdexcept>
 #include <filesystem>
 #include <set>
+#include <mutex>
+
+#include <stb_image_write.h>
 
 #include <glad/gl.h>
 
@@ -18,9 +21,17 @@
 #include <glm/glm.hpp>
 using namespace glm;
 
+#include "framework/gl/capture.hpp"
 #include "framework/gl/texture.hpp"
+#include "framework/gl/state.hpp"
+#include "framework/gl/validation.hpp"
+#include "framework/pixelconvert.hpp"
+#include "framework/png.hpp"
+#include "framework/trace.hpp"
 
 App::App(unsigned int width, unsigned int height) : resolution(width, height) {
+    if constexpr (Trace::COMPILED) Trace::setThreadName("Main");
+    TRACE_ZONE("App::App");
     initGLFW();
     initImGui();
     initGL();
@@ -48,6 +59,8 @@ void App::initGLFW() {
 #ifdef __APPLE__
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GLFW_TRUE);
 #endif
+    // Some drivers only report all debug messages in debug contexts
+    glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GLValidation::DEFAULT_LEVEL != GLValidation::Level::Off);
 
     window = glfwCreateWindow(resolution.x, resolution.y, "", nullptr, nullptr);
     if (!window) throw std::runtime_error("Failed to create window");
@@ -63,7 +76,7 @@ void App::initGLFW() {
     mouse = vec2(x, y);
     // Callbacks
     glfwSetFramebufferSizeCallback(window, [](GLFWwindow* window, int width, int height) {
-        glViewport(0, 0, width, height);
+        GLState::viewport(0, 0, width, height);
         App* app = static_cast<App*>(glfwGetWindowUserPointer(window));
         app->resolution.x = width;
         app->resolution.y = height;
@@ -152,38 +165,6 @@ std::string glSeverityToString(GLenum severity) {
     }
 }
 
-std::string glErrorToString(GLenum error) {
-    switch (error) {
-        case GL_NO_ERROR: return "GL_NO_ERROR";
-        case GL_INVALID_ENUM: return "GL_INVALID_ENUM";
-        case GL_INVALID_VALUE: return "GL_INVALID_VALUE";
-        case GL_INVALID_OPERATION: return "GL_INVALID_OPERATION";
-        case GL_INVALID_FRAMEBUFFER_OPERATION: return "GL_INVALID_FRAMEBUFFER_OPERATION";
-        case GL_CONTEXT_LOST: return "GL_CONTEXT_LOST";
-        case GL_OUT_OF_MEMORY: return "GL_OUT_OF_MEMORY";
-        case GL_STACK_OVERFLOW: return "GL_STACK_OVERFLOW";
-        case GL_STACK_UNDERFLOW: return "GL_STACK_UNDERFLOW";
-        default: return "Unknown";
-    }
-}
-
-// Print function if error occurs
-void gladPostCallback(void* ret, const char* name, GLADapiproc funcptr, int len_args, ...) {
-    GLenum error = glad_glGetError();
-    if (error != GL_NO_ERROR) {
-        std::cerr << "OpenGL Error: " << glErrorToString(error) << " in " << name << "(";
-        va_list args;
-        va_start(args, len_args);
-        for (int i = 0; i < len_args; i++) {
-            GLenum arg = va_arg(args, GLenum);
-            std::cerr << arg;
-            if (i < len_args - 1) std::cerr << ", ";
-        }
-        va_end(args);
-        std::cerr << ")" << std::endl;
-    }
-}
-
 void App::initGL() {
     if (!gladLoadGL(glfwGetProcAddress)) throw std::runtime_error("Failed to initialize GLAD");
 
@@ -196,21 +177,24 @@ void App::initGL() {
 
     glEnable(GL_FRAMEBUFFER_SRGB); // Enables SRGB rendering
 
-    gladSetGLPostCallback(gladPostCallback);
-    
     // Enables better debug output, only supported for OpenGL 4.3+
 #ifdef MODERN_GL
-    glEnable(GL_DEBUG_OUTPUT);
-    glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
     glDebugMessageCallback([](GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam) {
+        // Without GL_DEBUG_OUTPUT_SYNCHRONOUS the driver may call from other threads
+        static std::mutex mutex;
+        std::lock_guard lock(mutex);
         auto app = static_cast<App*>(const_cast<void*>(userParam));
         if (app->seenMessageIDs.insert(id).second)
             std::cerr << "[" << glSourceToString(source) << "] " << glTypeToString(type) << ": " << message << " (" << glSeverityToString(severity) << ")" << std::endl;
     }, this);
 #endif
+    GLValidation::setCallLogging(&traceOpenGLCalls);
+    GLValidation::setLevel(GLValidation::DEFAULT_LEVEL);
 }
 
 App::~App() {
+    GLCapture::stop();
+    framePacer.finish();
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
@@ -231,13 +215,40 @@ void App::run() {
     resizeCallback(resolution);
     frames = 0;
     while (!glfwWindowShouldClose(window)) {
-        glfwPollEvents();
-        auto current = static_cast<float>(glfwGetTime());
-        delta = current - time;
-        time = current;
-        render();
-        if (imguiEnabled) renderImGui();
-        glfwSwapBuffers(window); // Double Buffering
+        if (GLCapture::isCapturing()) GLCapture::newFrame(ivec2(resolution));
+        if constexpr (Trace::COMPILED) Trace::newFrame(); // Collects the GPU zones of earlier frames
+        TRACE_ZONE("Frame");
+        GLState::newFrame();
+        GLValidation::newFrame();
+        // Waits before the events are polled, so the input is as recent as possible when the frame is rendered
+        framePacer.beginFrame();
+        {
+            TRACE_ZONE("Poll events");
+            glfwPollEvents();
+        }
+        framePacer.markInputSampled();
+        double current = glfwGetTime();
+        double measured = current - lastFrameTime;
+        lastFrameTime = current;
+        // Accumulate in double precision so long fixed timestep runs do not drift
+        elapsedTime += fixedDelta > 0.0f ? fixedDelta : measured;
+        delta = static_cast<float>(fixedDelta > 0.0f ? fixedDelta : measured);
+        time = static_cast<float>(elapsedTime);
+        {
+            TRACE_ZONE("Render");
+            TRACE_GPU_ZONE("Render");
+            render();
+        }
+        if (imguiEnabled) {
+            TRACE_ZONE("ImGui");
+            TRACE_GPU_ZONE("ImGui");
+            renderImGui();
+        }
+        {
+            TRACE_ZONE("Swap buffers");
+            glfwSwapBuffers(window); // Double Buffering
+        }
+        framePacer.endFrame();
         frames++;
     }
 }
@@ -275,7 +286,7 @@ bool App::takeScreenshot(const std::filesystem::path &path, GLenum baseFormat, G
 #ifdef MODERN_GL
     glNamedFramebufferReadBuffer(0, attachment);
 #else
-    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    GLState::bindFramebuffer(GL_READ_FRAMEBUFFER, 0);
     glReadBuffer(attachment);
 #endif
 
@@ -283,16 +294,16 @@ bool App::takeScreenshot(const std::filesystem::path &path, GLenum baseFormat, G
     glfwGetFramebufferSize(window, &width, &height);
     GLenum dataType = GL_UNSIGNED_BYTE;
     GLint channels = getChannels(baseFormat);
-    
-    stbi_flip_vertically_on_write(true);
 
     auto ubyteData = std::make_unique<unsigned char[]>(width * height * channels);
     glReadPixels(0, 0, width, height, baseFormat, dataType, ubyteData.get());
 
     auto ext = path.extension();
     if (ext == ".png")
-        return stbi_write_png(path.string().c_str(), width, height, channels, ubyteData.get(), width * channels);
-    else if (ext == ".bmp")
+        return PNG::write(path, ubyteData.get(), width, height, channels, true);
+
+    PixelConvert::flipRows(ubyteData.get(), width * channels, height);
+    if (ext == ".bmp")
         return stbi_write_bmp(path.string().c_str(), width, height, channels, ubyteData.get());
     else if (ext == ".tga")
         return stbi_write_tga(path.string().c_str(), width, height, channels, ubyteData.get());
@@ -12,6 +12,8 @@ using namespace glm;
 #include <filesystem>
 #include <set>
 
+#include "framework/framepacer.hpp"
+
 enum class Key {
     UNKNOWN = GLFW_KEY_UNKNOWN,
     SPACE = GLFW_KEY_SPACE,
@@ -95,7 +97,20 @@ class App {
     unsigned int frames = 0;
 
     /**
-     * @brief Enable or disable logging of all OpenGL calls.
+     * @brief Enables a fixed timestep if greater than zero.
+     * `run()` then advances `time` by exactly this many seconds per frame instead of the measured frame time,
+     * so animations and `CameraPath` playback produce the same sequence of frames on every run independent of the frame rate.
+     */
+    float fixedDelta = 0.0f;
+
+    /**
+     * @brief Limits the frames queued on the GPU and the frame rate, and measures the input latency and frame pacing.
+     */
+    FramePacer framePacer;
+
+    /**
+     * @brief Enable or disable logging of all OpenGL calls with their arguments.
+     * Only has an effect while `GLValidation::Level::CallChecks` is selected, it is read on every call so it can be toggled around a section.
      */
     bool traceOpenGLCalls = false;
 
@@ -176,7 +191,7 @@ class App {
 
     /**
      * @brief Writes the color attachment of the default framebuffer to a file.
-     * @param path The path to write the image to. Supported formats are PNG, BMP, TGA, and JPG. BMP and TGA are generally fastest because they are uncompressed.
+     * @param path The path to write the image to. Supported formats are PNG, BMP, TGA, and JPG. PNG is encoded in parallel by `PNG::write`, BMP and TGA are uncompressed.
      * @param baseFormat The base format of the image, e.g. `GL_RGBA`, `GL_RGB`, mainly used to enable/disable reading the alpha channel.
      * @param attachment The attachment point, e.g. `GL_FRONT`, `GL_BACK`, (Reading from specialized attachments like `GL_COLOR_ATTACHMENTi` and `GL_DEPTH_ATTACHMENT` is not supported for the default framebuffer).
      * By default `GL_BACK` as in double-buffered configurations reading from the front buffer is not advisable.
@@ -204,4 +219,7 @@ class App {
     void initGL();
     void renderImGui();
     void registerGLLoggingCallback();
+
+    double lastFrameTime = 0.0;
+    double elapsedTime = 0.0;
 };
\ No newline at end of file
@@ -0,0 +1,712 @@
+#include "bcencoder.hpp"
+
+#include <glad/gl.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "pixelconvert.hpp"
+#include "threadpool.hpp"
+#include "gl/texture.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define BCENCODER_X86
+    #include <immintrin.h>
+    #ifdef _MSC_VER
+        #define TARGET_SSE41
+        #define TARGET_AVX2
+    #else
+        #define TARGET_SSE41 __attribute__((target("sse4.1")))
+        #define TARGET_AVX2 __attribute__((target("avx2")))
+    #endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    #define BCENCODER_NEON
+    #include <arm_neon.h>
+#endif
+
+namespace {
+
+using PixelConvert::InstructionSet;
+
+/**
+ * @brief Writes bit fields into a block starting at the least significant bit, as required by BC6H and BC7.
+ */
+struct BitWriter {
+    uint8_t* data;
+    uint32_t position = 0;
+
+    void write(uint32_t value, uint32_t bits) {
+        for (uint32_t i = 0; i < bits; i++, position++) {
+            if (value >> i & 1) data[position >> 3] |= static_cast<uint8_t>(1 << (position & 7));
+        }
+    }
+};
+
+////////////////////////////////////////// Kernels //////////////////////////////////////////
+
+/**
+ * @brief The inner loops of the encoder, selected for the instruction set of `PixelConvert` so that both share the CPU detection and `PixelConvert::setInstructionSet`.
+ * All variants produce the same blocks.
+ */
+struct Kernels {
+    /**
+     * @brief Picks the palette entry with the smallest squared error for each of the 16 pixels of a block, ties go to the first entry.
+     * The errors are summed in 32 bits, which holds 4 channels of 8 bit or 3 channels of 15 bit values.
+     * @param pixels The channels of the pixels, `pixels[c][i]`.
+     * @param palette The entries, `palette[p][c]`.
+     * @param errors The squared error of the chosen entry of each pixel.
+     */
+    void (*selectIndices)(const int32_t pixels[4][16], int channels, const int32_t palette[][4], int entries, uint8_t indices[16], uint32_t errors[16]);
+
+    /**
+     * @brief Projects the 16 points of a block onto an axis through their mean, `points[c][i]`.
+     */
+    void (*project)(const float points[4][16], int channels, const float mean[4], const float axis[4], float projections[16]);
+};
+
+void selectIndicesScalar(const int32_t pixels[4][16], int channels, const int32_t palette[][4], int entries, uint8_t indices[16], uint32_t errors[16]) {
+    for (int i = 0; i < 16; i++) {
+        uint32_t bestError = UINT32_MAX;
+        int best = 0;
+        for (int p = 0; p < entries; p++) {
+            uint32_t error = 0;
+            for (int c = 0; c < channels; c++) {
+                const int32_t diff = pixels[c][i] - palette[p][c];
+                error += static_cast<uint32_t>(diff * diff);
+            }
+            if (error < bestError) best = p, bestError = error;
+        }
+        indices[i] = static_cast<uint8_t>(best);
+        errors[i] = bestError;
+    }
+}
+
+void projectScalar(const float points[4][16], int channels, const float mean[4], const float axis[4], float projections[16]) {
+    for (int i = 0; i < 16; i++) {
+        float t = 0.0f;
+        for (int c = 0; c < channels; c++) t += (points[c][i] - mean[c]) * axis[c];
+        projections[i] = t;
+    }
+}
+
+const Kernels SCALAR = {selectIndicesScalar, projectScalar};
+
+#ifdef BCENCODER_X86
+
+TARGET_SSE41 void selectIndicesSSE41(const int32_t pixels[4][16], int channels, const int32_t palette[][4], int entries, uint8_t indices[16], uint32_t errors[16]) {
+    const __m128i ones = _mm_set1_epi32(-1);
+    for (int i = 0; i < 16; i += 4) {
+        __m128i channel[4];
+        for (int c = 0; c < channels; c++) channel[c] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels[c] + i));
+        __m128i bestError = ones, best = _mm_setzero_si128();
+        for (int p = 0; p < entries; p++) {
+            __m128i error = _mm_setzero_si128();
+            for (int c = 0; c < channels; c++) {
+                const __m128i diff = _mm_sub_epi32(channel[c], _mm_set1_epi32(palette[p][c]));
+                error = _mm_add_epi32(error, _mm_mullo_epi32(diff, diff));
+            }
+            // Unsigned error < bestError, as SSE only compares signed integers for less
+            const __m128i less = _mm_andnot_si128(_mm_cmpeq_epi32(_mm_max_epu32(error, bestError), error), ones);
+            bestError = _mm_min_epu32(error, bestError);
+            best = _mm_blendv_epi8(best, _mm_set1_epi32(p), less);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(errors + i), bestError);
+        const int packed = _mm_cvtsi128_si32(_mm_packus_epi16(_mm_packus_epi32(best, best), best));
+        std::memcpy(indices + i, &packed, 4);
+    }
+}
+
+TARGET_SSE41 void projectSSE41(const float points[4][16], int channels, const float mean[4], const float axis[4], float projections[16]) {
+    for (int i = 0; i < 16; i += 4) {
+        __m128 t = _mm_setzero_ps();
+        for (int c = 0; c < channels; c++)
+            t = _mm_add_ps(t, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(points[c] + i), _mm_set1_ps(mean[c])), _mm_set1_ps(axis[c])));
+        _mm_storeu_ps(projections + i, t);
+    }
+}
+
+const Kernels SSE41 = {selectIndicesSSE41, projectSSE41};
+
+TARGET_AVX2 void selectIndicesAVX2(const int32_t pixels[4][16], int channels, const int32_t palette[][4], int entries, uint8_t indices[16], uint32_t errors[16]) {
+    const __m256i ones = _mm256_set1_epi32(-1);
+    for (int i = 0; i < 16; i += 8) {
+        __m256i channel[4];
+        for (int c = 0; c < channels; c++) channel[c] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pixels[c] + i));
+        __m256i bestError = ones, best = _mm256_setzero_si256();
+        for (int p = 0; p < entries; p++) {
+            __m256i error = _mm256_setzero_si256();
+            for (int c = 0; c < channels; c++) {
+                const __m256i diff = _mm256_sub_epi32(channel[c], _mm256_set1_epi32(palette[p][c]));
+                error = _mm256_add_epi32(error, _mm256_mullo_epi32(diff, diff));
+            }
+            const __m256i less = _mm256_andnot_si256(_mm256_cmpeq_epi32(_mm256_max_epu32(error, bestError), error), ones);
+            bestError = _mm256_min_epu32(error, bestError);
+            best = _mm256_blendv_epi8(best, _mm256_set1_epi32(p), less);
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(errors + i), bestError);
+        alignas(32) int32_t lanes[8];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), best);
+        for (int k = 0; k < 8; k++) indices[i + k] = static_cast<uint8_t>(lanes[k]);
+    }
+}
+
+TARGET_AVX2 void projectAVX2(const float points[4][16], int channels, const float mean[4], const float axis[4], float projections[16]) {
+    for (int i = 0; i < 16; i += 8) {
+        __m256 t = _mm256_setzero_ps();
+        for (int c = 0; c < channels; c++)
+            t = _mm256_add_ps(t, _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(points[c] + i), _mm256_set1_ps(mean[c])), _mm256_set1_ps(axis[c])));
+        _mm256_storeu_ps(projections + i, t);
+    }
+}
+
+const Kernels AVX2 = {selectIndicesAVX2, projectAVX2};
+
+#endif
+
+#ifdef BCENCODER_NEON
+
+void selectIndicesNEON(const int32_t pixels[4][16], int channels, const int32_t palette[][4], int entries, uint8_t indices[16], uint32_t errors[16]) {
+    for (int i = 0; i < 16; i += 4) {
+        int32x4_t channel[4];
+        for (int c = 0; c < channels; c++) channel[c] = vld1q_s32(pixels[c] + i);
+        uint32x4_t bestError = vdupq_n_u32(UINT32_MAX), best = vdupq_n_u32(0);
+        for (int p = 0; p < entries; p++) {
+            uint32x4_t error = vdupq_n_u32(0);
+            for (int c = 0; c < channels; c++) {
+                const int32x4_t diff = vsubq_s32(channel[c], vdupq_n_s32(palette[p][c]));
+                error = vaddq_u32(error, vreinterpretq_u32_s32(vmulq_s32(diff, diff)));
+            }
+            const uint32x4_t less = vcltq_u32(error, bestError);
+            bestError = vminq_u32(error, bestError);
+            best = vbslq_u32(less, vdupq_n_u32(static_cast<uint32_t>(p)), best);
+        }
+        vst1q_u32(errors + i, bestError);
+        uint32_t lanes[4];
+        vst1q_u32(lanes, best);
+        for (int k = 0; k < 4; k++) indices[i + k] = static_cast<uint8_t>(lanes[k]);
+    }
+}
+
+void projectNEON(const float points[4][16], int channels, const float mean[4], const float axis[4], float projections[16]) {
+    for (int i = 0; i < 16; i += 4) {
+        float32x4_t t = vdupq_n_f32(0.0f);
+        // Multiply and add separately, a fused multiply-add would round differently from the other variants
+        for (int c = 0; c < channels; c++) t = vaddq_f32(t, vmulq_f32(vsubq_f32(vld1q_f32(points[c] + i), vdupq_n_f32(mean[c])), vdupq_n_f32(axis[c])));
+        vst1q_f32(projections + i, t);
+    }
+}
+
+const Kernels NEON = {selectIndicesNEON, projectNEON};
+
+#endif
+
+const Kernels& kernels() {
+    switch (PixelConvert::getInstructionSet()) {
+#ifdef BCENCODER_X86
+        case InstructionSet::AVX2: return AVX2;
+        case InstructionSet::SSE41: return SSE41;
+#endif
+#ifdef BCENCODER_NEON
+        case InstructionSet::NEON: return NEON;
+#endif
+        default: return SCALAR;
+    }
+}
+
+////////////////////////////////////////// Endpoints //////////////////////////////////////////
+
+/**
+ * @brief Finds the principal axis of a point cloud with a few power iterations of its covariance matrix.
+ */
+template <int D>
+void principalAxis(const float points[16][D], int count, float mean[D], float axis[D]) {
+    for (int d = 0; d < D; d++) mean[d] = 0.0f;
+    for (int i = 0; i < count; i++)
+        for (int d = 0; d < D; d++) mean[d] += points[i][d];
+    for (int d = 0; d < D; d++) mean[d] /= static_cast<float>(count);
+
+    float covariance[D][D] = {};
+    for (int i = 0; i < count; i++) {
+        for (int a = 0; a < D; a++)
+            for (int b = 0; b < D; b++) covariance[a][b] += (points[i][a] - mean[a]) * (points[i][b] - mean[b]);
+    }
+
+    for (int d = 0; d < D; d++) axis[d] = 1.0f;
+    for (int iteration = 0; iteration < 8; iteration++) {
+        float next[D] = {};
+        for (int a = 0; a < D; a++)
+            for (int b = 0; b < D; b++) next[a] += covariance[a][b] * axis[b];
+        float length = 0.0f;
+        for (int d = 0; d < D; d++) length = std::max(length, std::abs(next[d]));
+        if (length < 1e-8f) break;
+        for (int d = 0; d < D; d++) axis[d] = next[d] / length;
+    }
+}
+
+/**
+ * @brief Picks the endpoints as the points with the smallest and largest projection onto the principal axis.
+ */
+template <int D>
+void fitEndpoints(const float points[16][D], int count, float e0[D], float e1[D]) {
+    float mean[4] = {}, axis[4] = {};
+    principalAxis<D>(points, count, mean, axis);
+    float soa[4][16] = {}, projections[16];
+    for (int i = 0; i < count; i++)
+        for (int d = 0; d < D; d++) soa[d][i] = points[i][d];
+    kernels().project(soa, D, mean, axis, projections);
+    float minT = INFINITY, maxT = -INFINITY;
+    int minI = 0, maxI = 0;
+    for (int i = 0; i < count; i++) {
+        if (projections[i] < minT) minT = projections[i], minI = i;
+        if (projections[i] > maxT) maxT = projections[i], maxI = i;
+    }
+    for (int d = 0; d < D; d++) {
+        e0[d] = points[maxI][d];
+        e1[d] = points[minI][d];
+    }
+}
+
+/**
+ * @brief Solves for the endpoints that minimize the squared error for fixed interpolation weights.
+ * @param weights The weight of the second endpoint for every point.
+ * @return False if the system is singular, e.g. when all points use the same weight.
+ */
+template <int D>
+bool leastSquares(const float points[16][D], const float weights[16], int count, float e0[D], float e1[D]) {
+    float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+    float ax[D] = {}, bx[D] = {};
+    for (int i = 0; i < count; i++) {
+        float b = weights[i], a = 1.0f - b;
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+        for (int d = 0; d < D; d++) {
+            ax[d] += a * points[i][d];
+            bx[d] += b * points[i][d];
+        }
+    }
+    float det = aa * bb - ab * ab;
+    if (std::abs(det) < 1e-6f) return false;
+    for (int d = 0; d < D; d++) {
+        e0[d] = (bb * ax[d] - ab * bx[d]) / det;
+        e1[d] = (aa * bx[d] - ab * ax[d]) / det;
+    }
+    return true;
+}
+
+////////////////////////////////////////// BC1 //////////////////////////////////////////
+
+uint16_t packRGB565(const float color[3]) {
+    auto quantize = [](float value, int maximum) {
+        return static_cast<uint16_t>(std::clamp(static_cast<int>(std::lround(value * maximum / 255.0f)), 0, maximum));
+    };
+    return static_cast<uint16_t>(quantize(color[0], 31) << 11 | quantize(color[1], 63) << 5 | quantize(color[2], 31));
+}
+
+void unpackRGB565(uint16_t color, int output[3]) {
+    int r = color >> 11, g = color >> 5 & 63, b = color & 31;
+    output[0] = r << 3 | r >> 2;
+    output[1] = g << 2 | g >> 4;
+    output[2] = b << 3 | b >> 2;
+}
+
+/**
+ * @brief Chooses the indices of a BC1 color block for the given endpoints.
+ * @return The squared error of all opaque pixels.
+ */
+int fitBC1Indices(const uint8_t block[16][4], const bool transparent[16], uint16_t c0, uint16_t c1, bool threeColor, uint32_t& indices) {
+    int32_t palette[4][4] = {};
+    unpackRGB565(c0, palette[0]);
+    unpackRGB565(c1, palette[1]);
+    for (int c = 0; c < 3; c++) {
+        if (threeColor) {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        } else {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+    }
+
+    int32_t pixels[4][16];
+    for (int i = 0; i < 16; i++)
+        for (int c = 0; c < 3; c++) pixels[c][i] = block[i][c];
+    uint8_t best[16];
+    uint32_t errors[16];
+    kernels().selectIndices(pixels, 3, palette, threeColor ? 3 : 4, best, errors);
+
+    indices = 0;
+    int total = 0;
+    for (int i = 0; i < 16; i++) {
+        if (transparent[i]) {
+            indices |= 3u << (2 * i);
+            continue;
+        }
+        indices |= static_cast<uint32_t>(best[i]) << (2 * i);
+        total += static_cast<int>(errors[i]);
+    }
+    return total;
+}
+
+void writeBC1(uint8_t* output, uint16_t c0, uint16_t c1, uint32_t indices) {
+    output[0] = static_cast<uint8_t>(c0);
+    output[1] = static_cast<uint8_t>(c0 >> 8);
+    output[2] = static_cast<uint8_t>(c1);
+    output[3] = static_cast<uint8_t>(c1 >> 8);
+    for (int i = 0; i < 4; i++) output[4 + i] = static_cast<uint8_t>(indices >> (8 * i));
+}
+
+/**
+ * @brief Orders the endpoints for the requested mode (c0 > c1 selects four colors, c0 <= c1 three colors and transparency) and writes the block.
+ */
+int encodeBC1Endpoints(const uint8_t block[16][4], const bool transparent[16], uint16_t c0, uint16_t c1, bool threeColor, uint8_t* output) {
+    if (threeColor ? c0 > c1 : c0 < c1) std::swap(c0, c1);
+    uint32_t indices;
+    int error;
+    if (!threeColor && c0 == c1) {
+        // Four color mode is impossible with equal endpoints, but index 0 reproduces the color exactly
+        indices = 0;
+        error = fitBC1Indices(block, transparent, c0, c1, true, indices);
+        indices = 0;
+    } else {
+        error = fitBC1Indices(block, transparent, c0, c1, threeColor, indices);
+    }
+    writeBC1(output, c0, c1, indices);
+    return error;
+}
+
+////////////////////////////////////////// BC6H //////////////////////////////////////////
+
+/**
+ * @brief Converts a float to the bits of an unsigned half float, clamping negative values to zero and large values to the largest finite half.
+ */
+int floatToUnsignedHalf(float value) {
+    if (!(value > 0.0f)) return 0; // Also catches NaN
+    if (value >= 65504.0f) return 0x7BFF;
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    int exponent = static_cast<int>(bits >> 23 & 0xFF) - 127 + 15;
+    uint32_t mantissa = bits & 0x7FFFFF;
+    if (exponent <= 0) {
+        // Denormal half
+        if (exponent < -10) return 0;
+        mantissa |= 0x800000;
+        uint32_t shift = static_cast<uint32_t>(14 - exponent);
+        return static_cast<int>((mantissa + (1u << (shift - 1))) >> shift);
+    }
+    int half = exponent << 10 | static_cast<int>(mantissa >> 13);
+    if (mantissa & 0x1000) half++; // Round half up, can carry into the exponent which is still correct
+    return std::min(half, 0x7BFF);
+}
+
+int quantizeBC6H(float half) {
+    return std::clamp(static_cast<int>(std::lround((half * 64.0f / 31.0f - 32.0f) / 64.0f)), 0, 1023);
+}
+
+int unquantizeBC6H(int value) {
+    if (value == 0) return 0;
+    if (value == 1023) return 0xFFFF;
+    return ((value << 16) + 0x8000) >> 10;
+}
+
+////////////////////////////////////////// BC7 //////////////////////////////////////////
+
+const int WEIGHTS4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+/**
+ * @brief Quantizes an RGBA endpoint to 7 bits per channel plus a shared p-bit, choosing the p-bit with the smaller error.
+ */
+void quantizeBC7Endpoint(const float endpoint[4], int quantized[4], int& pbit) {
+    int bestError = INT32_MAX;
+    for (int p = 0; p < 2; p++) {
+        int candidate[4], error = 0;
+        for (int c = 0; c < 4; c++) {
+            candidate[c] = std::clamp(static_cast<int>(std::lround((endpoint[c] - p) / 2.0f)), 0, 127);
+            int diff = (candidate[c] << 1 | p) - static_cast<int>(std::lround(endpoint[c]));
+            error += diff * diff;
+        }
+        if (error < bestError) {
+            bestError = error;
+            pbit = p;
+            std::copy(candidate, candidate + 4, quantized);
+        }
+    }
+}
+
+/**
+ * @brief Chooses the 4 bit indices of a mode 6 block for the given endpoints.
+ * @return The squared error.
+ */
+int fitBC7Indices(const uint8_t block[16][4], const int q0[4], int p0, const int q1[4], int p1, int indices[16]) {
+    int32_t palette[16][4];
+    for (int c = 0; c < 4; c++) {
+        int a = q0[c] << 1 | p0, b = q1[c] << 1 | p1;
+        for (int w = 0; w < 16; w++) palette[w][c] = ((64 - WEIGHTS4[w]) * a + WEIGHTS4[w] * b + 32) >> 6;
+    }
+    int32_t pixels[4][16];
+    for (int i = 0; i < 16; i++)
+        for (int c = 0; c < 4; c++) pixels[c][i] = block[i][c];
+    uint8_t best[16];
+    uint32_t errors[16];
+    kernels().selectIndices(pixels, 4, palette, 16, best, errors);
+    int total = 0;
+    for (int i = 0; i < 16; i++) {
+        indices[i] = best[i];
+        total += static_cast<int>(errors[i]);
+    }
+    return total;
+}
+
+template <typename T>
+void extractBlock(const T* image, GLsizei width, GLsizei height, int channels, GLsizei bx, GLsizei by, T* block) {
+    for (int y = 0; y < 4; y++) {
+        GLsizei sy = std::min(by * 4 + y, height - 1);
+        for (int x = 0; x < 4; x++) {
+            GLsizei sx = std::min(bx * 4 + x, width - 1);
+            const T* pixel = image + (static_cast<size_t>(sy) * width + sx) * channels;
+            std::copy(pixel, pixel + channels, block + (y * 4 + x) * channels);
+        }
+    }
+}
+
+/**
+ * @brief Encodes all blocks of an image in parallel, each row of blocks is one task.
+ */
+template <typename T, int C, typename Encode>
+std::vector<uint8_t> compressImage(GLenum internalFormat, const T* image, GLsizei width, GLsizei height, const Encode& encode) {
+    const GLsizei blockBytes = getBlockBytes(internalFormat);
+    const GLsizei blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+    std::vector<uint8_t> output(getCompressedSize(internalFormat, width, height));
+    ThreadPool::global().parallelFor(0, static_cast<size_t>(blocksY), [&](size_t by) {
+        T block[16][C];
+        for (GLsizei bx = 0; bx < blocksX; bx++) {
+            extractBlock(image, width, height, C, bx, static_cast<GLsizei>(by), &block[0][0]);
+            encode(block, &output[(by * blocksX + bx) * blockBytes]);
+        }
+    });
+    return output;
+}
+
+}
+
+void BCEncoder::encodeBC1(const uint8_t block[16][4], uint8_t* output, bool alpha) {
+    bool transparent[16];
+    float points[16][3];
+    int count = 0;
+    for (int i = 0; i < 16; i++) {
+        transparent[i] = alpha && block[i][3] < 128;
+        if (transparent[i]) continue;
+        for (int c = 0; c < 3; c++) points[count][c] = block[i][c];
+        count++;
+    }
+    bool threeColor = count < 16;
+    if (count == 0) {
+        writeBC1(output, 0, 0, 0xFFFFFFFF);
+        return;
+    }
+
+    float e0[3], e1[3];
+    fitEndpoints<3>(points, count, e0, e1);
+    uint16_t c0 = packRGB565(e0), c1 = packRGB565(e1);
+    uint8_t best[8];
+    int bestError = encodeBC1Endpoints(block, transparent, c0, c1, threeColor, best);
+
+    if (!threeColor && bestError > 0) {
+        // Refine the endpoints for the chosen indices
+        uint32_t indices = static_cast<uint32_t>(best[4] | best[5] << 8 | best[6] << 16 | best[7] << 24);
+        const float weights[4] = {0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f};
+        float pixelWeights[16];
+        for (int i = 0; i < 16; i++) pixelWeights[i] = weights[indices >> (2 * i) & 3];
+        uint16_t b0 = static_cast<uint16_t>(best[0] | best[1] << 8);
+        uint16_t b1 = static_cast<uint16_t>(best[2] | best[3] << 8);
+        if (b0 != b1 && leastSquares<3>(points, pixelWeights, count, e0, e1)) {
+            uint8_t refined[8];
+            int error = encodeBC1Endpoints(block, transparent, packRGB565(e0), packRGB565(e1), false, refined);
+            if (error < bestError) std::copy(refined, refined + 8, best);
+        }
+    }
+    std::copy(best, best + 8, output);
+}
+
+void BCEncoder::encodeBC4(const uint8_t block[16], uint8_t* output) {
+    int r0 = 0, r1 = 255;
+    for (int i = 0; i < 16; i++) {
+        r0 = std::max(r0, static_cast<int>(block[i]));
+        r1 = std::min(r1, static_cast<int>(block[i]));
+    }
+    output[0] = static_cast<uint8_t>(r0);
+    output[1] = static_cast<uint8_t>(r1);
+
+    uint64_t indices = 0;
+    if (r0 > r1) {
+        // Eight value mode, the palette is r0, r1 and six values in between
+        int range = r0 - r1;
+        for (int i = 0; i < 16; i++) {
+            // Position along r0 -> r1 in steps of 1/7, rounded to the nearest step
+            int t = ((r0 - block[i]) * 14 + range) / (2 * range);
+            int index = t == 0 ? 0 : t == 7 ? 1 : t + 1;
+            indices |= static_cast<uint64_t>(index) << (3 * i);
+        }
+    }
+    for (int i = 0; i < 6; i++) output[2 + i] = static_cast<uint8_t>(indices >> (8 * i));
+}
+
+void BCEncoder::encodeBC3(const uint8_t block[16][4], uint8_t* output) {
+    uint8_t alpha[16];
+    uint8_t opaque[16][4];
+    for (int i = 0; i < 16; i++) {
+        alpha[i] = block[i][3];
+        std::copy(block[i], block[i] + 3, opaque[i]);
+        opaque[i][3] = 255;
+    }
+    encodeBC4(alpha, output);
+    encodeBC1(opaque, output + 8, false);
+}
+
+void BCEncoder::encodeBC5(const uint8_t block[16][4], uint8_t* output) {
+    uint8_t red[16], green[16];
+    for (int i = 0; i < 16; i++) {
+        red[i] = block[i][0];
+        green[i] = block[i][1];
+    }
+    encodeBC4(red, output);
+    encodeBC4(green, output + 8);
+}
+
+void BCEncoder::encodeBC6H(const float block[16][3], uint8_t* output) {
+    // Work with the half float bit patterns, which behave roughly logarithmic and thus match the perceived error better than linear values
+    float points[16][3];
+    int32_t halves[4][16];
+    for (int i = 0; i < 16; i++) {
+        for (int c = 0; c < 3; c++) {
+            halves[c][i] = floatToUnsignedHalf(block[i][c]);
+            points[i][c] = static_cast<float>(halves[c][i]);
+        }
+    }
+
+    float e0[3], e1[3];
+    fitEndpoints<3>(points, 16, e0, e1);
+    int q0[3], q1[3];
+    int32_t palette[16][4];
+    for (int c = 0; c < 3; c++) {
+        q0[c] = quantizeBC6H(e0[c]);
+        q1[c] = quantizeBC6H(e1[c]);
+        int a = unquantizeBC6H(q0[c]), b = unquantizeBC6H(q1[c]);
+        for (int w = 0; w < 16; w++) palette[w][c] = (((64 - WEIGHTS4[w]) * a + WEIGHTS4[w] * b + 32) >> 6) * 31 >> 6;
+    }
+
+    // Halves are at most 0x7BFF, so the errors of the 3 channels still fit into 32 bits
+    uint8_t indices[16];
+    uint32_t errors[16];
+    kernels().selectIndices(halves, 3, palette, 16, indices, errors);
+
+    // The most significant index bit of the first pixel is implicitly zero
+    if (indices[0] >= 8) {
+        std::swap(q0, q1);
+        for (auto& index : indices) index = static_cast<uint8_t>(15 - index);
+    }
+
+    std::fill(output, output + 16, 0);
+    BitWriter writer{output};
+    writer.write(0x03, 5); // Mode 11
+    for (int c = 0; c < 3; c++) writer.write(static_cast<uint32_t>(q0[c]), 10);
+    for (int c = 0; c < 3; c++) writer.write(static_cast<uint32_t>(q1[c]), 10);
+    writer.write(static_cast<uint32_t>(indices[0]), 3);
+    for (int i = 1; i < 16; i++) writer.write(static_cast<uint32_t>(indices[i]), 4);
+}
+
+void BCEncoder::encodeBC7(const uint8_t block[16][4], uint8_t* output) {
+    float points[16][4];
+    for (int i = 0; i < 16; i++)
+        for (int c = 0; c < 4; c++) points[i][c] = block[i][c];
+
+    float e0[4], e1[4];
+    fitEndpoints<4>(points, 16, e0, e1);
+    int q0[4], q1[4], p0, p1, indices[16];
+    quantizeBC7Endpoint(e0, q0, p0);
+    quantizeBC7Endpoint(e1, q1, p1);
+    int error = fitBC7Indices(block, q0, p0, q1, p1, indices);
+
+    if (error > 0) {
+        // Refine the endpoints for the chosen indices
+        float weights[16];
+        for (int i = 0; i < 16; i++) weights[i] = WEIGHTS4[indices[i]] / 64.0f;
+        if (leastSquares<4>(points, weights, 16, e0, e1)) {
+            for (int c = 0; c < 4; c++) {
+                e0[c] = std::clamp(e0[c], 0.0f, 255.0f);
+                e1[c] = std::clamp(e1[c], 0.0f, 255.0f);
+            }
+            int r0[4], r1[4], rp0, rp1, refined[16];
+            quantizeBC7Endpoint(e0, r0, rp0);
+            quantizeBC7Endpoint(e1, r1, rp1);
+            if (fitBC7Indices(block, r0, rp0, r1, rp1, refined) < error) {
+                std::copy(r0, r0 + 4, q0);
+                std::copy(r1, r1 + 4, q1);
+                std::copy(refined, refined + 16, indices);
+                p0 = rp0;
+                p1 = rp1;
+            }
+        }
+    }
+
+    // The most significant index bit of the first pixel is implicitly zero
+    if (indices[0] >= 8) {
+        std::swap(q0, q1);
+        std::swap(p0, p1);
+        for (int& index : indices) index = 15 - index;
+    }
+
+    std::fill(output, output + 16, 0);
+    BitWriter writer{output};
+    writer.write(1 << 6, 7); // Mode 6
+    for (int c = 0; c < 4; c++) {
+        writer.write(static_cast<uint32_t>(q0[c]), 7);
+        writer.write(static_cast<uint32_t>(q1[c]), 7);
+    }
+    writer.write(static_cast<uint32_t>(p0), 1);
+    writer.write(static_cast<uint32_t>(p1), 1);
+    writer.write(static_cast<uint32_t>(indices[0]), 3);
+    for (int i = 1; i < 16; i++) writer.write(static_cast<uint32_t>(indices[i]), 4);
+}
+
+bool BCEncoder::isFloatFormat(GLenum internalFormat) {
+    return internalFormat == GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT;
+}
+
+std::vector<uint8_t> BCEncoder::compress(GLenum internalFormat, const uint8_t* rgba, GLsizei width, GLsizei height) {
+    using Block = uint8_t[16][4];
+    switch (internalFormat) {
+        case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+            return compressImage<uint8_t, 4>(internalFormat, rgba, width, height, [](const Block& block, uint8_t* out) { encodeBC1(block, out, false); });
+        case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+            return compressImage<uint8_t, 4>(internalFormat, rgba, width, height, [](const Block& block, uint8_t* out) { encodeBC1(block, out, true); });
+        case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+            return compressImage<uint8_t, 4>(internalFormat, rgba, width, height, [](const Block& block, uint8_t* out) { encodeBC3(block, out); });
+        case GL_COMPRESSED_RED_RGTC1:
+            return compressImage<uint8_t, 4>(internalFormat, rgba, width, height, [](const Block& block, uint8_t* out) {
+                uint8_t red[16];
+                for (int i = 0; i < 16; i++) red[i] = block[i][0];
+                encodeBC4(red, out);
+            });
+        case GL_COMPRESSED_RG_RGTC2:
+            return compressImage<uint8_t, 4>(internalFormat, rgba, width, height, [](const Block& block, uint8_t* out) { encodeBC5(block, out); });
+        case GL_COMPRESSED_RGBA_BPTC_UNORM:
+        case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+            return compressImage<uint8_t, 4>(internalFormat, rgba, width, height, [](const Block& block, uint8_t* out) { encodeBC7(block, out); });
+        default:
+            throw std::runtime_error("BCEncoder: Unsupported format for 8 bit input");
+    }
+}
+
+std::vector<uint8_t> BCEncoder::compress(GLenum internalFormat, const float* rgb, GLsizei width, GLsizei height) {
+    using Block = float[16][3];
+    if (!isFloatFormat(internalFormat)) throw std::runtime_error("BCEncoder: Unsupported format for floating point input");
+    return compressImage<float, 3>(internalFormat, rgb, width, height, [](const Block& block, uint8_t* out) { encodeBC6H(block, out); });
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <glad/gl.h>
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * @file bcencoder.hpp
+ * @brief Defines a CPU encoder for the block compressed texture formats BC1, BC3, BC4, BC5, BC6H and BC7.
+ */
+
+/**
+ * @brief Encodes images into 4x4 pixel blocks of the BCn formats, see https://learn.microsoft.com/en-us/windows/win32/direct3d11/texture-block-compression-in-direct3d-11.
+ * The encoder favors speed over quality as it is meant to run once at import time, see `TextureCache`:
+ * - BC1/BC3 fit the color endpoints along the principal axis of the block and refine them with a least squares fit.
+ * - BC4/BC5 use the minimum and maximum of each channel.
+ * - BC6H uses mode 11 (one region, 10 bit endpoints) of the unsigned variant.
+ * - BC7 uses mode 6 (one subset, RGBA 7.7.7.7 endpoints with p-bits, 4 bit indices).
+ * The index selection and the endpoint search use SSE4.1, AVX2 or NEON kernels, picked at runtime with the instruction set of `PixelConvert`.
+ * Whole images are encoded in parallel on `ThreadPool::global()`.
+ */
+namespace BCEncoder {
+
+    /**
+     * @brief Encodes a BC1 block.
+     * @param block 16 RGBA pixels in row-major order.
+     * @param output 8 bytes.
+     * @param alpha Whether pixels with alpha below 128 are encoded as transparent (`GL_COMPRESSED_RGBA_S3TC_DXT1_EXT`).
+     */
+    void encodeBC1(const uint8_t block[16][4], uint8_t* output, bool alpha = false);
+
+    /**
+     * @brief Encodes a BC3 block, a BC4 block for the alpha channel followed by a BC1 block for the color.
+     * @param block 16 RGBA pixels in row-major order.
+     * @param output 16 bytes.
+     */
+    void encodeBC3(const uint8_t block[16][4], uint8_t* output);
+
+    /**
+     * @brief Encodes a BC4 block of a single channel.
+     * @param block 16 values in row-major order.
+     * @param output 8 bytes.
+     */
+    void encodeBC4(const uint8_t block[16], uint8_t* output);
+
+    /**
+     * @brief Encodes a BC5 block, two BC4 blocks for the red and green channel.
+     * @param block 16 RGBA pixels in row-major order.
+     * @param output 16 bytes.
+     */
+    void encodeBC5(const uint8_t block[16][4], uint8_t* output);
+
+    /**
+     * @brief Encodes an unsigned BC6H block, negative values are clamped to zero.
+     * @param block 16 RGB pixels in row-major order.
+     * @param output 16 bytes.
+     */
+    void encodeBC6H(const float block[16][3], uint8_t* output);
+
+    /**
+     * @brief Encodes a BC7 block.
+     * @param block 16 RGBA pixels in row-major order.
+     * @param output 16 bytes.
+     */
+    void encodeBC7(const uint8_t block[16][4], uint8_t* output);
+
+    /**
+     * @brief Compresses an 8 bit image into one of the LDR formats (BC1, BC3, BC4, BC5, BC7 and their sRGB variants).
+     * Edge blocks of images that are not a multiple of 4 in size repeat the border pixels.
+     * @param internalFormat The compressed internal format.
+     * @param rgba RGBA pixels in row-major order.
+     * @param width The width of the image.
+     * @param height The height of the image.
+     * @return The blocks in row-major order as expected by `glCompressedTextureSubImage2D`.
+     * @throw `std::runtime_error` if the format is not supported.
+     */
+    std::vector<uint8_t> compress(GLenum internalFormat, const uint8_t* rgba, GLsizei width, GLsizei height);
+
+    /**
+     * @brief Compresses a floating point image into BC6H (`GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT`).
+     * @param internalFormat The compressed internal format.
+     * @param rgb RGB pixels in row-major order.
+     * @param width The width of the image.
+     * @param height The height of the image.
+     * @return The blocks in row-major order as expected by `glCompressedTextureSubImage2D`.
+     * @throw `std::runtime_error` if the format is not supported.
+     */
+    std::vector<uint8_t> compress(GLenum internalFormat, const float* rgb, GLsizei width, GLsizei height);
+
+    /**
+     * @brief Checks whether `compress` expects floating point input for a format.
+     */
+    bool isFloatFormat(GLenum internalFormat);
+
+}
@@ -0,0 +1,633 @@
+#include "bvh.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "mesh.hpp"
+#include "threadpool.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define BVH_SSE2
+    #include <emmintrin.h>
+#endif
+
+using namespace glm;
+
+namespace {
+
+constexpr int BINS = 16;
+constexpr float TRAVERSAL_COST = 1.0f; // Relative to the cost of intersecting one primitive
+constexpr uint32_t MAX_DEPTH = 64; // Bounds the traversal stack
+constexpr size_t PARALLEL_SUBTREE_SIZE = 4096; // Subtrees with more primitives are built as separate tasks
+constexpr size_t PARALLEL_RANGE_SIZE = 1 << 16; // Bounds and bins of larger ranges are computed in parallel chunks
+constexpr size_t CHUNK_SIZE = 1 << 14;
+constexpr float INF = std::numeric_limits<float>::infinity();
+
+struct Bins {
+    AABB bounds[3][BINS];
+    uint32_t counts[3][BINS] = {};
+
+    void merge(const Bins& other) {
+        for (int axis = 0; axis < 3; axis++) {
+            for (int bin = 0; bin < BINS; bin++) {
+                bounds[axis][bin].extend(other.bounds[axis][bin]);
+                counts[axis][bin] += other.counts[axis][bin];
+            }
+        }
+    }
+};
+
+/**
+ * @brief Reduces a range in parallel chunks if it is large, `chunk(begin, end)` returns the partial result that is merged with `merge(a, b)`.
+ */
+template <typename T, typename Chunk, typename Merge>
+T reduce(ThreadPool& pool, size_t begin, size_t end, Chunk chunk, Merge merge) {
+    if (end - begin < PARALLEL_RANGE_SIZE) return chunk(begin, end);
+    const size_t chunks = (end - begin + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    std::vector<T> partials(chunks);
+    pool.parallelFor(0, chunks, [&](size_t i) {
+        partials[i] = chunk(begin + i * CHUNK_SIZE, std::min(end, begin + (i + 1) * CHUNK_SIZE));
+    });
+    T result = std::move(partials[0]);
+    for (size_t i = 1; i < chunks; i++) merge(result, partials[i]);
+    return result;
+}
+
+/**
+ * @brief Builds a hierarchy over primitive bounds with binned SAH, independent subtrees are built in parallel.
+ */
+class Builder {
+   public:
+    Builder(const std::vector<AABB>& bounds, uint32_t maxLeafSize, ThreadPool& pool) : bounds(bounds), maxLeafSize(maxLeafSize), pool(pool) {}
+
+    void build(std::vector<BVH::Node>& outNodes, std::vector<uint32_t>& outIds) {
+        const size_t count = bounds.size();
+        ids.resize(count);
+        std::iota(ids.begin(), ids.end(), 0);
+        centroids.resize(count);
+        pool.parallelForChunks(0, count, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) centroids[i] = bounds[i].center();
+        }, CHUNK_SIZE);
+
+        // A binary tree with single primitive leaves has at most 2 * count - 1 nodes, an empty tree has none
+        nodes.resize(count > 0 ? 2 * count - 1 : 0);
+        nodeCount = count > 0 ? 1 : 0;
+        if (count > 0) buildNode(0, 0, static_cast<uint32_t>(count), 0);
+        nodes.resize(nodeCount);
+        outNodes = std::move(nodes);
+        outIds = std::move(ids);
+    }
+
+   private:
+    void buildNode(uint32_t index, uint32_t first, uint32_t count, uint32_t depth) {
+        struct RangeBounds {
+            AABB bounds, centroids;
+        };
+        const auto range = reduce<RangeBounds>(pool, first, first + count, [&](size_t begin, size_t end) {
+            RangeBounds result;
+            for (size_t i = begin; i < end; i++) {
+                result.bounds.extend(bounds[ids[i]]);
+                result.centroids.extend(centroids[ids[i]]);
+            }
+            return result;
+        }, [](RangeBounds& a, const RangeBounds& b) {
+            a.bounds.extend(b.bounds);
+            a.centroids.extend(b.centroids);
+        });
+
+        BVH::Node& node = nodes[index];
+        node.min = range.bounds.min;
+        node.max = range.bounds.max;
+        const auto makeLeaf = [&] {
+            node.leftOrFirst = first;
+            node.count = count;
+        };
+        if (count <= 1 || depth + 1 >= MAX_DEPTH) return makeLeaf();
+
+        // Evaluate the surface area heuristic at the bin boundaries of all three axes
+        const vec3 extent = range.centroids.max - range.centroids.min;
+        const vec3 scale = vec3(BINS) / max(extent, vec3(1e-30f));
+        const auto binOf = [&](uint32_t id, int axis) {
+            return std::min(BINS - 1, static_cast<int>((centroids[id][axis] - range.centroids.min[axis]) * scale[axis]));
+        };
+        float bestCost = INF;
+        int bestAxis = -1, bestSplit = 0;
+        if (extent.x > 0.0f || extent.y > 0.0f || extent.z > 0.0f) {
+            const Bins bins = reduce<Bins>(pool, first, first + count, [&](size_t begin, size_t end) {
+                Bins result;
+                for (size_t i = begin; i < end; i++) {
+                    for (int axis = 0; axis < 3; axis++) {
+                        const int bin = binOf(ids[i], axis);
+                        result.bounds[axis][bin].extend(bounds[ids[i]]);
+                        result.counts[axis][bin]++;
+                    }
+                }
+                return result;
+            }, [](Bins& a, const Bins& b) { a.merge(b); });
+
+            for (int axis = 0; axis < 3; axis++) {
+                if (extent[axis] <= 0.0f) continue;
+                float rightCosts[BINS];
+                AABB right;
+                uint32_t rightCount = 0;
+                for (int bin = BINS - 1; bin > 0; bin--) {
+                    right.extend(bins.bounds[axis][bin]);
+                    rightCount += bins.counts[axis][bin];
+                    rightCosts[bin] = rightCount ? right.surfaceArea() * rightCount : 0.0f;
+                }
+                AABB left;
+                uint32_t leftCount = 0;
+                for (int split = 1; split < BINS; split++) {
+                    left.extend(bins.bounds[axis][split - 1]);
+                    leftCount += bins.counts[axis][split - 1];
+                    if (leftCount == 0 || leftCount == count) continue;
+                    const float cost = left.surfaceArea() * leftCount + rightCosts[split];
+                    if (cost < bestCost) {
+                        bestCost = cost;
+                        bestAxis = axis;
+                        bestSplit = split;
+                    }
+                }
+            }
+        }
+
+        const float splitCost = TRAVERSAL_COST + bestCost / std::max(range.bounds.surfaceArea(), 1e-30f);
+        if (count <= maxLeafSize && (bestAxis < 0 || splitCost >= static_cast<float>(count))) return makeLeaf();
+
+        uint32_t middle;
+        if (bestAxis >= 0) {
+            const auto it = std::partition(ids.begin() + first, ids.begin() + first + count, [&](uint32_t id) { return binOf(id, bestAxis) < bestSplit; });
+            middle = static_cast<uint32_t>(it - ids.begin());
+        } else {
+            middle = first + count / 2; // All centroids coincide, any split is as good
+        }
+
+        const uint32_t left = nodeCount.fetch_add(2);
+        node.leftOrFirst = left;
+        node.count = 0;
+        const auto buildChild = [&](size_t child) {
+            if (child == 0) buildNode(left, first, middle - first, depth + 1);
+            else buildNode(left + 1, middle, first + count - middle, depth + 1);
+        };
+        if (count >= PARALLEL_SUBTREE_SIZE) pool.parallelFor(0, 2, buildChild);
+        else {
+            buildChild(0);
+            buildChild(1);
+        }
+    }
+
+    const std::vector<AABB>& bounds;
+    const uint32_t maxLeafSize;
+    ThreadPool& pool;
+    std::vector<vec3> centroids;
+    std::vector<uint32_t> ids;
+    std::vector<BVH::Node> nodes;
+    std::atomic<uint32_t> nodeCount = 0;
+};
+
+/**
+ * @brief The entry distance of the ray into the box of a node, infinity if it misses.
+ */
+inline float intersectBox(const BVH::Node& node, const vec3& origin, const vec3& inverseDirection, float tMin, float tMax) {
+    const float tx1 = (node.min.x - origin.x) * inverseDirection.x, tx2 = (node.max.x - origin.x) * inverseDirection.x;
+    const float ty1 = (node.min.y - origin.y) * inverseDirection.y, ty2 = (node.max.y - origin.y) * inverseDirection.y;
+    const float tz1 = (node.min.z - origin.z) * inverseDirection.z, tz2 = (node.max.z - origin.z) * inverseDirection.z;
+    const float tNear = std::max(std::max(std::min(tx1, tx2), std::min(ty1, ty2)), std::max(std::min(tz1, tz2), tMin));
+    const float tFar = std::min(std::min(std::max(tx1, tx2), std::max(ty1, ty2)), std::min(std::max(tz1, tz2), tMax));
+    return tNear <= tFar ? tNear : INF;
+}
+
+/**
+ * @brief Möller-Trumbore intersection with a triangle given by its first vertex and two edges.
+ */
+template <typename Triangle>
+inline bool intersectTriangle(const Triangle& triangle, const Ray& ray, float tMax, float& t, vec2& barycentrics) {
+    const vec3 p = cross(ray.direction, triangle.edge2);
+    const float determinant = dot(triangle.edge1, p);
+    if (determinant == 0.0f) return false;
+    const float inverseDeterminant = 1.0f / determinant;
+    const vec3 s = ray.origin - triangle.v0;
+    const float u = dot(s, p) * inverseDeterminant;
+    if (u < 0.0f || u > 1.0f) return false;
+    const vec3 q = cross(s, triangle.edge1);
+    const float v = dot(ray.direction, q) * inverseDeterminant;
+    if (v < 0.0f || u + v > 1.0f) return false;
+    t = dot(triangle.edge2, q) * inverseDeterminant;
+    barycentrics = vec2(u, v);
+    return t >= ray.tMin && t < tMax;
+}
+
+struct StackEntry {
+    uint32_t node;
+    float distance;
+};
+
+/**
+ * @brief Traverses the nodes front to back, `leaf(first, count, tMax)` intersects the primitives of a leaf and shrinks `tMax` on hits.
+ * @param anyHit Stops at the first hit, for occlusion queries.
+ */
+template <typename Leaf>
+bool traverse(const std::vector<BVH::Node>& nodes, const Ray& ray, float tMax, bool anyHit, Leaf leaf) {
+    if (nodes.empty()) return false;
+    const vec3 inverseDirection = vec3(1.0f) / ray.direction;
+    if (intersectBox(nodes[0], ray.origin, inverseDirection, ray.tMin, tMax) == INF) return false;
+
+    StackEntry stack[MAX_DEPTH];
+    int size = 0;
+    uint32_t index = 0;
+    bool found = false;
+    while (true) {
+        const BVH::Node& node = nodes[index];
+        if (node.count > 0) {
+            if (leaf(node.leftOrFirst, node.count, tMax)) {
+                found = true;
+                if (anyHit) return true;
+            }
+        } else {
+            uint32_t near = node.leftOrFirst, far = near + 1;
+            float nearDistance = intersectBox(nodes[near], ray.origin, inverseDirection, ray.tMin, tMax);
+            float farDistance = intersectBox(nodes[far], ray.origin, inverseDirection, ray.tMin, tMax);
+            if (farDistance < nearDistance) {
+                std::swap(near, far);
+                std::swap(nearDistance, farDistance);
+            }
+            if (nearDistance != INF) {
+                if (farDistance != INF) stack[size++] = {far, farDistance};
+                index = near;
+                continue;
+            }
+        }
+        // Pop the next node that is still closer than the closest hit
+        while (size > 0 && stack[size - 1].distance > tMax) size--;
+        if (size == 0) break;
+        index = stack[--size].node;
+    }
+    return found;
+}
+
+
+/**
+ * @brief The rays of a packet in structure of arrays layout, the box and triangle tests run on all four lanes at once.
+ */
+struct Packet {
+    alignas(16) float ox[RayPacket::SIZE], oy[RayPacket::SIZE], oz[RayPacket::SIZE];
+    alignas(16) float dx[RayPacket::SIZE], dy[RayPacket::SIZE], dz[RayPacket::SIZE];
+    alignas(16) float ix[RayPacket::SIZE], iy[RayPacket::SIZE], iz[RayPacket::SIZE];
+    alignas(16) float tMin[RayPacket::SIZE], tMax[RayPacket::SIZE];
+
+    Packet(const RayPacket& packet, const Hit (&hits)[RayPacket::SIZE]) {
+        for (int i = 0; i < RayPacket::SIZE; i++) {
+            const Ray& ray = packet.rays[i];
+            ox[i] = ray.origin.x, oy[i] = ray.origin.y, oz[i] = ray.origin.z;
+            dx[i] = ray.direction.x, dy[i] = ray.direction.y, dz[i] = ray.direction.z;
+            ix[i] = 1.0f / dx[i], iy[i] = 1.0f / dy[i], iz[i] = 1.0f / dz[i];
+            tMin[i] = ray.tMin;
+            tMax[i] = std::min(ray.tMax, hits[i].t);
+        }
+    }
+
+    Ray ray(int i) const {
+        return {vec3(ox[i], oy[i], oz[i]), tMin[i], vec3(dx[i], dy[i], dz[i]), tMax[i]};
+    }
+
+    float maxT() const {
+        return std::max(std::max(tMax[0], tMax[1]), std::max(tMax[2], tMax[3]));
+    }
+
+    /**
+     * @brief Tests a box against all rays.
+     * @return A bit mask of the rays that hit the box, `nearest` receives their smallest entry distance or infinity.
+     */
+    int testBox(const BVH::Node& node, float& nearest) const {
+#if defined(BVH_SSE2)
+        const __m128 t1x = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.min.x), _mm_load_ps(ox)), _mm_load_ps(ix));
+        const __m128 t2x = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.max.x), _mm_load_ps(ox)), _mm_load_ps(ix));
+        const __m128 t1y = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.min.y), _mm_load_ps(oy)), _mm_load_ps(iy));
+        const __m128 t2y = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.max.y), _mm_load_ps(oy)), _mm_load_ps(iy));
+        const __m128 t1z = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.min.z), _mm_load_ps(oz)), _mm_load_ps(iz));
+        const __m128 t2z = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.max.z), _mm_load_ps(oz)), _mm_load_ps(iz));
+        const __m128 tNear = _mm_max_ps(_mm_max_ps(_mm_min_ps(t1x, t2x), _mm_min_ps(t1y, t2y)), _mm_max_ps(_mm_min_ps(t1z, t2z), _mm_load_ps(tMin)));
+        const __m128 tFar = _mm_min_ps(_mm_min_ps(_mm_max_ps(t1x, t2x), _mm_max_ps(t1y, t2y)), _mm_min_ps(_mm_max_ps(t1z, t2z), _mm_load_ps(tMax)));
+        const __m128 hit = _mm_cmple_ps(tNear, tFar);
+        // Horizontal minimum of the entry distances of the rays that hit
+        __m128 distances = _mm_or_ps(_mm_and_ps(hit, tNear), _mm_andnot_ps(hit, _mm_set1_ps(INF)));
+        distances = _mm_min_ps(distances, _mm_shuffle_ps(distances, distances, _MM_SHUFFLE(2, 3, 0, 1)));
+        distances = _mm_min_ps(distances, _mm_shuffle_ps(distances, distances, _MM_SHUFFLE(1, 0, 3, 2)));
+        nearest = _mm_cvtss_f32(distances);
+        return _mm_movemask_ps(hit);
+#else
+        int mask = 0;
+        nearest = INF;
+        for (int i = 0; i < RayPacket::SIZE; i++) {
+            const float distance = intersectBox(node, vec3(ox[i], oy[i], oz[i]), vec3(ix[i], iy[i], iz[i]), tMin[i], tMax[i]);
+            if (distance == INF) continue;
+            mask |= 1 << i;
+            nearest = std::min(nearest, distance);
+        }
+        return mask;
+#endif
+    }
+
+    /**
+     * @brief Möller-Trumbore intersection of a triangle with all rays, shrinks `tMax` of the rays that hit.
+     * @return A bit mask of the rays that hit the triangle closer than before, `u` and `v` receive their barycentrics.
+     */
+    template <typename Triangle>
+    int testTriangle(const Triangle& triangle, float (&u)[RayPacket::SIZE], float (&v)[RayPacket::SIZE]) {
+#if defined(BVH_SSE2)
+        const auto crossComponent = [](__m128 a, __m128 b, __m128 c, __m128 d) { return _mm_sub_ps(_mm_mul_ps(a, b), _mm_mul_ps(c, d)); };
+        const auto dot = [](__m128 ax, __m128 ay, __m128 az, __m128 bx, __m128 by, __m128 bz) {
+            return _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_mul_ps(az, bz));
+        };
+        const __m128 e1x = _mm_set1_ps(triangle.edge1.x), e1y = _mm_set1_ps(triangle.edge1.y), e1z = _mm_set1_ps(triangle.edge1.z);
+        const __m128 e2x = _mm_set1_ps(triangle.edge2.x), e2y = _mm_set1_ps(triangle.edge2.y), e2z = _mm_set1_ps(triangle.edge2.z);
+        const __m128 rdx = _mm_load_ps(dx), rdy = _mm_load_ps(dy), rdz = _mm_load_ps(dz);
+        const __m128 px = crossComponent(rdy, e2z, rdz, e2y), py = crossComponent(rdz, e2x, rdx, e2z), pz = crossComponent(rdx, e2y, rdy, e2x);
+        const __m128 determinant = dot(e1x, e1y, e1z, px, py, pz);
+        const __m128 inverseDeterminant = _mm_div_ps(_mm_set1_ps(1.0f), determinant);
+        const __m128 sx = _mm_sub_ps(_mm_load_ps(ox), _mm_set1_ps(triangle.v0.x));
+        const __m128 sy = _mm_sub_ps(_mm_load_ps(oy), _mm_set1_ps(triangle.v0.y));
+        const __m128 sz = _mm_sub_ps(_mm_load_ps(oz), _mm_set1_ps(triangle.v0.z));
+        const __m128 uu = _mm_mul_ps(dot(sx, sy, sz, px, py, pz), inverseDeterminant);
+        const __m128 qx = crossComponent(sy, e1z, sz, e1y), qy = crossComponent(sz, e1x, sx, e1z), qz = crossComponent(sx, e1y, sy, e1x);
+        const __m128 vv = _mm_mul_ps(dot(rdx, rdy, rdz, qx, qy, qz), inverseDeterminant);
+        const __m128 t = _mm_mul_ps(dot(e2x, e2y, e2z, qx, qy, qz), inverseDeterminant);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 currentMax = _mm_load_ps(tMax);
+        __m128 valid = _mm_and_ps(_mm_cmpneq_ps(determinant, zero), _mm_and_ps(_mm_cmpge_ps(uu, zero), _mm_cmpge_ps(vv, zero)));
+        valid = _mm_and_ps(valid, _mm_cmple_ps(_mm_add_ps(uu, vv), _mm_set1_ps(1.0f)));
+        valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmpge_ps(t, _mm_load_ps(tMin)), _mm_cmplt_ps(t, currentMax)));
+        const int mask = _mm_movemask_ps(valid);
+        if (mask) {
+            _mm_storeu_ps(u, uu);
+            _mm_storeu_ps(v, vv);
+            _mm_store_ps(tMax, _mm_or_ps(_mm_and_ps(valid, t), _mm_andnot_ps(valid, currentMax)));
+        }
+        return mask;
+#else
+        int mask = 0;
+        for (int i = 0; i < RayPacket::SIZE; i++) {
+            float t;
+            vec2 barycentrics;
+            if (!intersectTriangle(triangle, ray(i), tMax[i], t, barycentrics)) continue;
+            tMax[i] = t;
+            u[i] = barycentrics.x;
+            v[i] = barycentrics.y;
+            mask |= 1 << i;
+        }
+        return mask;
+#endif
+    }
+};
+
+/**
+ * @brief Traverses the nodes with a packet of rays, a node is visited if any ray hits it and the children are ordered by the nearest entry of any ray.
+ * `leaf(first, count)` intersects the primitives of a leaf with the packet and returns the bit mask of rays that found a closer hit.
+ */
+template <typename Leaf>
+int traversePacket(const std::vector<BVH::Node>& nodes, const Packet& packet, Leaf leaf) {
+    float distance;
+    if (nodes.empty() || !packet.testBox(nodes[0], distance)) return 0;
+
+    StackEntry stack[MAX_DEPTH];
+    int size = 0;
+    uint32_t index = 0;
+    int found = 0;
+    while (true) {
+        const BVH::Node& node = nodes[index];
+        if (node.count > 0) {
+            found |= leaf(node.leftOrFirst, node.count);
+        } else {
+            uint32_t near = node.leftOrFirst, far = near + 1;
+            float nearDistance, farDistance;
+            packet.testBox(nodes[near], nearDistance);
+            packet.testBox(nodes[far], farDistance);
+            if (farDistance < nearDistance) {
+                std::swap(near, far);
+                std::swap(nearDistance, farDistance);
+            }
+            if (nearDistance != INF) {
+                if (farDistance != INF) stack[size++] = {far, farDistance};
+                index = near;
+                continue;
+            }
+        }
+        // Pop the next node that is still closer than the farthest closest hit of the rays
+        const float tMax = packet.maxT();
+        while (size > 0 && stack[size - 1].distance > tMax) size--;
+        if (size == 0) break;
+        index = stack[--size].node;
+    }
+    return found;
+}
+
+}
+
+AABB AABB::transform(const mat4& matrix) const {
+    AABB result;
+    if (empty()) return result;
+    for (int corner = 0; corner < 8; corner++) {
+        const vec3 point((corner & 1) ? max.x : min.x, (corner & 2) ? max.y : min.y, (corner & 4) ? max.z : min.z);
+        result.extend(vec3(matrix * vec4(point, 1.0f)));
+    }
+    return result;
+}
+
+////////////////////////////// BVH //////////////////////////////
+
+void BVH::build(const std::vector<vec3>& positions, const std::vector<unsigned int>& indices, ThreadPool& pool) {
+    const size_t count = indices.size() / 3;
+    std::vector<AABB> bounds(count);
+    pool.parallelForChunks(0, count, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            for (int vertex = 0; vertex < 3; vertex++) bounds[i].extend(positions[indices[3 * i + vertex]]);
+        }
+    }, CHUNK_SIZE);
+
+    Builder(bounds, 4, pool).build(nodes, triangleIds);
+
+    // Store the triangles in leaf order
+    triangles.resize(count);
+    pool.parallelForChunks(0, count, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            const uint32_t id = triangleIds[i];
+            const vec3 v0 = positions[indices[3 * id]], v1 = positions[indices[3 * id + 1]], v2 = positions[indices[3 * id + 2]];
+            triangles[i] = {v0, v1 - v0, v2 - v0};
+        }
+    }, CHUNK_SIZE);
+}
+
+void BVH::build(const Mesh& mesh, ThreadPool& pool) {
+    build(mesh.positions, mesh.indices, pool);
+}
+
+bool BVH::intersect(const Ray& ray, Hit& hit) const {
+    return traverse(nodes, ray, std::min(ray.tMax, hit.t), false, [&](uint32_t first, uint32_t count, float& tMax) {
+        bool found = false;
+        for (uint32_t i = first; i < first + count; i++) {
+            float t;
+            vec2 barycentrics;
+            if (!intersectTriangle(triangles[i], ray, tMax, t, barycentrics)) continue;
+            tMax = t;
+            hit.t = t;
+            hit.barycentrics = barycentrics;
+            hit.triangle = triangleIds[i];
+            hit.normal = cross(triangles[i].edge1, triangles[i].edge2);
+            found = true;
+        }
+        return found;
+    });
+}
+
+int BVH::intersect(const RayPacket& rays, Hit (&hits)[RayPacket::SIZE]) const {
+    Packet packet(rays, hits);
+    return traversePacket(nodes, packet, [&](uint32_t first, uint32_t count) {
+        int found = 0;
+        float u[RayPacket::SIZE], v[RayPacket::SIZE];
+        for (uint32_t i = first; i < first + count; i++) {
+            const int mask = packet.testTriangle(triangles[i], u, v);
+            if (!mask) continue;
+            for (int lane = 0; lane < RayPacket::SIZE; lane++) {
+                if (!(mask & (1 << lane))) continue;
+                Hit& hit = hits[lane];
+                hit.t = packet.tMax[lane];
+                hit.barycentrics = vec2(u[lane], v[lane]);
+                hit.triangle = triangleIds[i];
+                hit.normal = cross(triangles[i].edge1, triangles[i].edge2);
+            }
+            found |= mask;
+        }
+        return found;
+    });
+}
+
+bool BVH::occluded(const Ray& ray) const {
+    return traverse(nodes, ray, ray.tMax, true, [&](uint32_t first, uint32_t count, float& tMax) {
+        float t;
+        vec2 barycentrics;
+        for (uint32_t i = first; i < first + count; i++) {
+            if (intersectTriangle(triangles[i], ray, tMax, t, barycentrics)) return true;
+        }
+        return false;
+    });
+}
+
+AABB BVH::getBounds() const {
+    if (nodes.empty()) return {};
+    return {nodes[0].min, nodes[0].max};
+}
+
+////////////////////////////// TLAS //////////////////////////////
+
+uint32_t TLAS::addInstance(const BVH& blas, const mat4& transform) {
+    instances.push_back({&blas, transform, inverse(transform), blas.getBounds().transform(transform)});
+    return static_cast<uint32_t>(instances.size() - 1);
+}
+
+void TLAS::setTransform(uint32_t instance, const mat4& transform) {
+    Instance& target = instances[instance];
+    target.transform = transform;
+    target.inverse = inverse(transform);
+    target.bounds = target.blas->getBounds().transform(transform);
+}
+
+const mat4& TLAS::getTransform(uint32_t instance) const {
+    return instances[instance].transform;
+}
+
+void TLAS::clear() {
+    instances.clear();
+    nodes.clear();
+    instanceIds.clear();
+}
+
+void TLAS::build() {
+    std::vector<AABB> bounds(instances.size());
+    for (size_t i = 0; i < instances.size(); i++) bounds[i] = instances[i].bounds;
+    Builder(bounds, 1, ThreadPool::global()).build(nodes, instanceIds);
+}
+
+void TLAS::refit() {
+    // Children are always stored after their parent
+    for (size_t i = nodes.size(); i-- > 0;) {
+        BVH::Node& node = nodes[i];
+        AABB bounds;
+        if (node.count > 0) {
+            for (uint32_t j = node.leftOrFirst; j < node.leftOrFirst + node.count; j++) bounds.extend(instances[instanceIds[j]].bounds);
+        } else {
+            bounds.extend(AABB{nodes[node.leftOrFirst].min, nodes[node.leftOrFirst].max});
+            bounds.extend(AABB{nodes[node.leftOrFirst + 1].min, nodes[node.leftOrFirst + 1].max});
+        }
+        node.min = bounds.min;
+        node.max = bounds.max;
+    }
+}
+
+bool TLAS::intersect(const Ray& ray, Hit& hit) const {
+    return traverse(nodes, ray, std::min(ray.tMax, hit.t), false, [&](uint32_t first, uint32_t count, float& tMax) {
+        bool found = false;
+        for (uint32_t i = first; i < first + count; i++) {
+            const uint32_t id = instanceIds[i];
+            const Instance& instance = instances[id];
+            // The distance is preserved because the direction is transformed without normalization
+            const Ray local = {vec3(instance.inverse * vec4(ray.origin, 1.0f)), ray.tMin, mat3(instance.inverse) * ray.direction, tMax};
+            if (instance.blas->intersect(local, hit)) {
+                tMax = hit.t;
+                hit.instance = id;
+                hit.normal = transpose(mat3(instance.inverse)) * hit.normal;
+                found = true;
+            }
+        }
+        return found;
+    });
+}
+
+int TLAS::intersect(const RayPacket& rays, Hit (&hits)[RayPacket::SIZE]) const {
+    Packet packet(rays, hits);
+    return traversePacket(nodes, packet, [&](uint32_t first, uint32_t count) {
+        int found = 0;
+        for (uint32_t i = first; i < first + count; i++) {
+            const uint32_t id = instanceIds[i];
+            const Instance& instance = instances[id];
+            RayPacket local;
+            for (int lane = 0; lane < RayPacket::SIZE; lane++) {
+                const Ray ray = packet.ray(lane);
+                local.rays[lane] = {vec3(instance.inverse * vec4(ray.origin, 1.0f)), ray.tMin, mat3(instance.inverse) * ray.direction, ray.tMax};
+            }
+            const int mask = instance.blas->intersect(local, hits);
+            if (!mask) continue;
+            const mat3 normalMatrix = transpose(mat3(instance.inverse));
+            for (int lane = 0; lane < RayPacket::SIZE; lane++) {
+                if (!(mask & (1 << lane))) continue;
+                packet.tMax[lane] = hits[lane].t;
+                hits[lane].instance = id;
+                hits[lane].normal = normalMatrix * hits[lane].normal;
+            }
+            found |= mask;
+        }
+        return found;
+    });
+}
+
+bool TLAS::occluded(const Ray& ray) const {
+    return traverse(nodes, ray, ray.tMax, true, [&](uint32_t first, uint32_t count, float& tMax) {
+        for (uint32_t i = first; i < first + count; i++) {
+            const Instance& instance = instances[instanceIds[i]];
+            const Ray local = {vec3(instance.inverse * vec4(ray.origin, 1.0f)), ray.tMin, mat3(instance.inverse) * ray.direction, tMax};
+            if (instance.blas->occluded(local)) return true;
+        }
+        return false;
+    });
+}
+
+size_t TLAS::numInstances() const {
+    return instances.size();
+}
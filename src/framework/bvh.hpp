@@ -0,0 +1,245 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "mesh.hpp"
+#include "threadpool.hpp"
+
+using namespace glm;
+
+/**
+ * @file bvh.hpp
+ * @brief Defines bounding volume hierarchies for ray queries against meshes, a bottom level `BVH` per mesh and a top level `TLAS` over instances.
+ */
+
+/**
+ * @brief A ray or segment, points along it are `origin + t * direction` for `t` in `[tMin, tMax]`.
+ * The direction does not have to be normalized, the hit distance is measured in multiples of it.
+ */
+struct Ray {
+    vec3 origin = vec3(0.0f);
+    float tMin = 0.0f;
+    vec3 direction = vec3(0.0f, 0.0f, -1.0f);
+    float tMax = std::numeric_limits<float>::infinity();
+
+    /**
+     * @brief The segment from `from` to `to`, hits have `t` in `[0, 1]`.
+     */
+    static Ray segment(const vec3& from, const vec3& to) {
+        return {from, 0.0f, to - from, 1.0f};
+    }
+};
+
+/**
+ * @brief Four rays that are traversed together. Coherent rays like the primary rays of a 2x2 pixel quad visit mostly the same nodes,
+ * so every node and triangle is tested against all rays at once with SIMD.
+ */
+struct RayPacket {
+    static constexpr int SIZE = 4;
+    Ray rays[SIZE];
+};
+
+/**
+ * @brief The closest intersection found by a ray query.
+ */
+struct Hit {
+    static constexpr uint32_t INVALID = std::numeric_limits<uint32_t>::max();
+
+    /** Distance along the ray in multiples of its direction */
+    float t = std::numeric_limits<float>::infinity();
+    /** Weights of the second and third vertex of the triangle, the first vertex has weight `1 - u - v` */
+    vec2 barycentrics = vec2(0.0f);
+    /** Index of the triangle in the mesh, its vertices are `indices[3 * triangle + 0..2]` */
+    uint32_t triangle = INVALID;
+    /** Index of the instance in the `TLAS`, `INVALID` for queries against a single `BVH` */
+    uint32_t instance = INVALID;
+    /** Unnormalized geometric normal of the triangle in the space of the query, facing the side from which the vertices are counterclockwise */
+    vec3 normal = vec3(0.0f);
+
+    bool valid() const {
+        return triangle != INVALID;
+    }
+
+    /**
+     * @brief Interpolates a vertex attribute of the hit triangle.
+     */
+    template <typename T>
+    T interpolate(const T& a, const T& b, const T& c) const {
+        return a * (1.0f - barycentrics.x - barycentrics.y) + b * barycentrics.x + c * barycentrics.y;
+    }
+};
+
+/**
+ * @brief An axis aligned bounding box, empty by default.
+ */
+struct AABB {
+    vec3 min = vec3(std::numeric_limits<float>::infinity());
+    vec3 max = vec3(-std::numeric_limits<float>::infinity());
+
+    void extend(const vec3& point) {
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+    }
+
+    void extend(const AABB& other) {
+        min = glm::min(min, other.min);
+        max = glm::max(max, other.max);
+    }
+
+    vec3 center() const {
+        return (min + max) * 0.5f;
+    }
+
+    float surfaceArea() const {
+        if (empty()) return 0.0f;
+        const vec3 extent = max - min;
+        return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+    }
+
+    bool empty() const {
+        return min.x > max.x;
+    }
+
+    /** The bounds of the box transformed by a matrix */
+    AABB transform(const mat4& matrix) const;
+};
+
+/**
+ * @class BVH
+ * @brief A bottom level bounding volume hierarchy over the triangles of a mesh, built with binned SAH in parallel.
+ * Example:
+ * ```cpp
+ * BVH bvh;
+ * bvh.build(mesh);
+ * Hit hit;
+ * if (bvh.intersect({cam.worldPosition, 0.0f, cam.getRayDirection(convertCursorToClipSpace())}, hit)) { ... }
+ * ```
+ */
+class BVH {
+   public:
+    /**
+     * @brief A node of 32 bytes, interior nodes have `count == 0` and their children at `leftOrFirst` and `leftOrFirst + 1`,
+     * leaves reference `count` primitives starting at `leftOrFirst`.
+     */
+    struct Node {
+        vec3 min;
+        uint32_t leftOrFirst;
+        vec3 max;
+        uint32_t count;
+    };
+
+    /**
+     * @brief Builds the hierarchy over indexed triangles, the triangles are copied.
+     */
+    void build(const std::vector<vec3>& positions, const std::vector<unsigned int>& indices, ThreadPool& pool = ThreadPool::global());
+
+    /**
+     * @brief Builds the hierarchy over the CPU copy of the triangles of a mesh, see `Mesh::positions` and `Mesh::indices`.
+     */
+    void build(const Mesh& mesh, ThreadPool& pool = ThreadPool::global());
+
+    /**
+     * @brief Finds the closest hit along the ray that is closer than `hit.t`.
+     * @return True if `hit` was updated.
+     */
+    bool intersect(const Ray& ray, Hit& hit) const;
+
+    /**
+     * @brief Finds the closest hits of a packet of rays that are closer than the `t` of their hits.
+     * @return A bit mask of the updated hits.
+     */
+    int intersect(const RayPacket& packet, Hit (&hits)[RayPacket::SIZE]) const;
+
+    /**
+     * @brief Checks whether any triangle intersects the ray, faster than `intersect` for shadow rays.
+     */
+    bool occluded(const Ray& ray) const;
+
+    /**
+     * @brief The bounds of all triangles.
+     */
+    AABB getBounds() const;
+
+    std::vector<Node> nodes;
+
+   private:
+    /** The first vertex and the two edges to the other vertices, precomputed for the intersection test */
+    struct Triangle {
+        vec3 v0, edge1, edge2;
+    };
+
+    std::vector<Triangle> triangles;
+    std::vector<uint32_t> triangleIds;
+};
+
+/**
+ * @class TLAS
+ * @brief A top level bounding volume hierarchy over transformed instances of bottom level hierarchies.
+ * Call `build` after adding instances and `refit` after changing transforms, which only updates the bounds and is much faster than a rebuild.
+ */
+class TLAS {
+   public:
+    /**
+     * @brief Adds an instance of a bottom level hierarchy, which has to outlive the `TLAS`.
+     * @return The index of the instance reported in `Hit::instance`.
+     */
+    uint32_t addInstance(const BVH& blas, const mat4& transform);
+
+    /**
+     * @brief Sets the local to world transform of an instance, call `refit` or `build` before the next query.
+     */
+    void setTransform(uint32_t instance, const mat4& transform);
+
+    const mat4& getTransform(uint32_t instance) const;
+
+    /**
+     * @brief Removes all instances.
+     */
+    void clear();
+
+    /**
+     * @brief Builds the hierarchy over the current bounds of the instances with binned SAH.
+     */
+    void build();
+
+    /**
+     * @brief Updates the bounds of all nodes bottom up while keeping the topology, the quality degrades if instances move far.
+     */
+    void refit();
+
+    /**
+     * @brief Finds the closest hit along the world space ray that is closer than `hit.t`.
+     * @return True if `hit` was updated.
+     */
+    bool intersect(const Ray& ray, Hit& hit) const;
+
+    /**
+     * @brief Finds the closest hits of a packet of world space rays, see `BVH::intersect`.
+     * @return A bit mask of the updated hits.
+     */
+    int intersect(const RayPacket& packet, Hit (&hits)[RayPacket::SIZE]) const;
+
+    /**
+     * @brief Checks whether any instance intersects the ray.
+     */
+    bool occluded(const Ray& ray) const;
+
+    size_t numInstances() const;
+
+   private:
+    struct Instance {
+        const BVH* blas;
+        mat4 transform;
+        mat4 inverse;
+        AABB bounds;
+    };
+
+    std::vector<Instance> instances;
+    std::vector<BVH::Node> nodes;
+    std::vector<uint32_t> instanceIds;
+};
@@ -78,4 +78,8 @@ bool Camera::updateIfChanged() {
     } else {
         return false;
     }
-}
\ No newline at end of file
+}
+
+vec3 Camera::getRayDirection(const vec2& clip) const {
+    return mat3(cameraMatrix) * vec3(clip.x * aspectRatio, clip.y, -focalLength);
+}
@@ -57,6 +57,13 @@ struct Camera {
      */
     bool updateIfChanged();
 
+    /**
+     * @brief Calculates the world space direction of the ray through a point on the screen, like `raygen.vert`.
+     * @param clip The point in clip space, e.g. from `App::convertCursorToClipSpace()`. The ray starts at `worldPosition`.
+     * @return The unnormalized direction.
+     */
+    vec3 getRayDirection(const vec2& clip) const;
+
     /**
      * @brief Target position in world coordinates. The target is where the camera looks at and orbits around.
      */
@@ -0,0 +1,135 @@
+#include "camerapath.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "camera.hpp"
+#include "common.hpp"
+
+using namespace glm;
+
+namespace {
+
+constexpr uint32_t MAGIC = 0x48545043; // "CPTH"
+constexpr uint32_t VERSION = 1;
+
+bool sameState(const CameraPath::Keyframe& a, const CameraPath::Keyframe& b) {
+    return a.worldPosition == b.worldPosition && a.target == b.target && a.fov == b.fov;
+}
+
+/**
+ * @brief The Catmull-Rom tangent of keyframe `i` for non uniform times, one sided at the ends of the track.
+ */
+template <typename T, typename Getter>
+T tangent(const std::vector<CameraPath::Keyframe>& keyframes, size_t i, Getter get) {
+    const size_t previous = i > 0 ? i - 1 : i;
+    const size_t next = std::min(i + 1, keyframes.size() - 1);
+    const float duration = keyframes[next].time - keyframes[previous].time;
+    if (duration <= 0.0f) return T(0.0f);
+    return (get(keyframes[next]) - get(keyframes[previous])) / duration;
+}
+
+template <typename T, typename Getter>
+T interpolate(const std::vector<CameraPath::Keyframe>& keyframes, size_t i, float t, Getter get) {
+    const T p0 = get(keyframes[i]), p1 = get(keyframes[i + 1]);
+    if (p0 == p1) return p0; // Holds stay exactly still
+    const float h = keyframes[i + 1].time - keyframes[i].time;
+    const T m0 = tangent<T>(keyframes, i, get) * h, m1 = tangent<T>(keyframes, i + 1, get) * h;
+    // Cubic Hermite basis
+    const float t2 = t * t, t3 = t2 * t;
+    return (2.0f * t3 - 3.0f * t2 + 1.0f) * p0 + (t3 - 2.0f * t2 + t) * m0 + (-2.0f * t3 + 3.0f * t2) * p1 + (t3 - t2) * m1;
+}
+
+}
+
+void CameraPath::record(float time, const Camera& camera) {
+    const Keyframe keyframe = {time, camera.worldPosition, camera.target, camera.fov};
+    if (!keyframes.empty() && time <= keyframes.back().time) return;
+    if (!keyframes.empty() && sameState(keyframes.back(), keyframe)) {
+        // Extend the hold instead of adding a keyframe per frame
+        if (holding) keyframes.back().time = time;
+        else keyframes.push_back(keyframe);
+        holding = true;
+        return;
+    }
+    keyframes.push_back(keyframe);
+    holding = false;
+}
+
+bool CameraPath::apply(float time, Camera& camera) const {
+    if (keyframes.empty()) return false;
+
+    const auto next = std::upper_bound(keyframes.begin(), keyframes.end(), time, [](float time, const Keyframe& keyframe) { return time < keyframe.time; });
+    if (next == keyframes.begin() || next == keyframes.end()) {
+        const Keyframe& keyframe = next == keyframes.end() ? keyframes.back() : keyframes.front();
+        camera.worldPosition = keyframe.worldPosition;
+        camera.target = keyframe.target;
+        camera.fov = keyframe.fov;
+    } else {
+        const size_t i = static_cast<size_t>(next - keyframes.begin()) - 1;
+        const float t = (time - keyframes[i].time) / (keyframes[i + 1].time - keyframes[i].time);
+        camera.worldPosition = interpolate<vec3>(keyframes, i, t, [](const Keyframe& keyframe) { return keyframe.worldPosition; });
+        camera.target = interpolate<vec3>(keyframes, i, t, [](const Keyframe& keyframe) { return keyframe.target; });
+        camera.fov = interpolate<float>(keyframes, i, t, [](const Keyframe& keyframe) { return keyframe.fov; });
+    }
+    camera.invalidate();
+    return time <= keyframes.back().time;
+}
+
+float CameraPath::duration() const {
+    return keyframes.empty() ? 0.0f : keyframes.back().time;
+}
+
+void CameraPath::clear() {
+    keyframes.clear();
+    holding = false;
+}
+
+void CameraPath::save(const std::filesystem::path& filepath) const {
+    std::vector<float> values;
+    values.reserve(keyframes.size() * 8);
+    for (const auto& keyframe : keyframes) {
+        values.insert(values.end(), {keyframe.time, keyframe.worldPosition.x, keyframe.worldPosition.y, keyframe.worldPosition.z,
+                                     keyframe.target.x, keyframe.target.y, keyframe.target.z, keyframe.fov});
+    }
+    const uint32_t header[] = {MAGIC, VERSION, static_cast<uint32_t>(keyframes.size())};
+
+    std::ofstream out{filepath, std::ios::binary};
+    std::cout << "Writing " << std::filesystem::absolute(filepath) << std::endl;
+    if (!out.is_open()) throw std::runtime_error("Could not open file: " + std::filesystem::absolute(filepath).string());
+    out.write(reinterpret_cast<const char*>(header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(values.data()), static_cast<std::streamsize>(values.size() * sizeof(float)));
+}
+
+void CameraPath::load(const std::filesystem::path& filepath) {
+    const auto data = Common::readBinaryFile(filepath);
+    const auto error = [&](const std::string& message) { return std::runtime_error("Failed to parse camera path " + filepath.string() + ": " + message); };
+
+    uint32_t header[3];
+    if (data.size() < sizeof(header)) throw error("File too small");
+    std::memcpy(header, data.data(), sizeof(header));
+    if (header[0] != MAGIC) throw error("Not a camera path");
+    if (header[1] != VERSION) throw error("Unsupported version " + std::to_string(header[1]));
+    // Computed in size_t, a corrupt count must not wrap around and match the size of the file
+    const size_t count = header[2];
+    if (data.size() != sizeof(header) + count * 8 * sizeof(float)) throw error("Size does not match the number of keyframes");
+
+    std::vector<float> values(count * 8);
+    std::memcpy(values.data(), data.data() + sizeof(header), values.size() * sizeof(float));
+    clear();
+    keyframes.reserve(count);
+    for (size_t i = 0; i < values.size(); i += 8) {
+        const float* v = &values[i];
+        keyframes.push_back({v[0], vec3(v[1], v[2], v[3]), vec3(v[4], v[5], v[6]), v[7]});
+        if (keyframes.size() > 1 && keyframes.back().time <= keyframes[keyframes.size() - 2].time) throw error("Keyframes are not sorted by time");
+    }
+}
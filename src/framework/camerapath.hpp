@@ -0,0 +1,74 @@
+#pragma once
+
+#include <filesystem>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "camera.hpp"
+
+using namespace glm;
+
+/**
+ * @file camerapath.hpp
+ * @brief Defines camera tracks that are recorded interactively and played back for reproducible benchmarks.
+ */
+
+/**
+ * @brief A timed track of camera states.
+ * Recording stores the camera state that results from the input instead of the input events, so playback does not depend on the frame rate or on how the input is handled.
+ * Play it back together with `App::fixedDelta` to render the exact same sequence of views on every run.
+ */
+class CameraPath {
+   public:
+    /**
+     * @brief A camera state at a point in time.
+     */
+    struct Keyframe {
+        float time;
+        vec3 worldPosition;
+        vec3 target;
+        float fov;
+    };
+
+    /**
+     * @brief The keyframes sorted by time.
+     */
+    std::vector<Keyframe> keyframes;
+
+    /**
+     * @brief Appends the state of the camera at `time`, which has to be later than the last keyframe.
+     * Consecutive identical states are merged into their first and last keyframe to keep the track compact.
+     */
+    void record(float time, const Camera& camera);
+
+    /**
+     * @brief Sets the camera to the state at `time` interpolated with Catmull-Rom splines, the time is clamped to the track.
+     * @return True while `time` lies within the track, false once playback is finished or if the track is empty.
+     */
+    bool apply(float time, Camera& camera) const;
+
+    /**
+     * @brief The time of the last keyframe.
+     */
+    float duration() const;
+
+    /**
+     * @brief Removes all keyframes.
+     */
+    void clear();
+
+    /**
+     * @brief Writes the track to a compact binary file.
+     */
+    void save(const std::filesystem::path& filepath) const;
+
+    /**
+     * @brief Reads a track written by `save`.
+     * @throw `std::runtime_error` if the file cannot be read or is not a camera path.
+     */
+    void load(const std::filesystem::path& filepath);
+
+   private:
+    bool holding = false;
+};
@@ -7,9 +7,22 @@
 #include <vector>
 #include <iostream>
 
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
 #include "framework/context.hpp"
+#include "framework/trace.hpp"
 
 std::string Common::readFile(const std::filesystem::path& filepath) {
+    TRACE_ZONE_TEXT("Common::readFile", filepath.string());
     std::ifstream stream{filepath};
     std::cout << "Loading " << std::filesystem::absolute(filepath) << std::endl;
     if (!stream.is_open()) throw std::runtime_error("Could not open file: " + std::filesystem::absolute(filepath).string() + "\n" + Context::getCWDWarning());
@@ -19,6 +32,7 @@ std::string Common::readFile(const std::filesystem::path& filepath) {
 }
 
 std::vector<char> Common::readBinaryFile(const std::filesystem::path& filepath) {
+    TRACE_ZONE_TEXT("Common::readBinaryFile", filepath.string());
     std::ifstream stream{filepath, std::ios::binary};
     std::cout << "Loading " << std::filesystem::absolute(filepath) << std::endl;
     if (stream.fail()) throw std::runtime_error("Could not open file: " + std::filesystem::absolute(filepath).string() + "\n" + Context::getCWDWarning());
@@ -42,4 +56,80 @@ void Common::filesInDirectory(const std::filesystem::path& directoryPath, std::s
             } 
         }
     }
-}
\ No newline at end of file
+}
+Common::MappedFile::MappedFile(const std::filesystem::path& filepath) {
+    std::cout << "Mapping " << std::filesystem::absolute(filepath) << std::endl;
+    const auto error = "Could not map file: " + std::filesystem::absolute(filepath).string() + "\n" + Context::getCWDWarning();
+#ifdef _WIN32
+    HANDLE file = CreateFileW(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) throw std::runtime_error(error);
+    LARGE_INTEGER fileSize;
+    GetFileSizeEx(file, &fileSize);
+    length = static_cast<size_t>(fileSize.QuadPart);
+    if (length > 0) {
+        mappingHandle = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mappingHandle) mapping = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+    }
+    CloseHandle(file); // The mapping keeps the file open
+    if (length > 0 && !mapping) {
+        release();
+        throw std::runtime_error(error);
+    }
+#else
+    int file = open(filepath.c_str(), O_RDONLY);
+    if (file < 0) throw std::runtime_error(error);
+    struct stat info;
+    if (fstat(file, &info) != 0) {
+        close(file);
+        throw std::runtime_error(error);
+    }
+    length = static_cast<size_t>(info.st_size);
+    if (length > 0) {
+        mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, file, 0);
+        if (mapping == MAP_FAILED) mapping = nullptr;
+        else madvise(mapping, length, MADV_SEQUENTIAL); // Uploads read the file front to back
+    }
+    close(file); // The mapping keeps the file open
+    if (length > 0 && !mapping) throw std::runtime_error(error);
+#endif
+}
+
+Common::MappedFile::MappedFile(MappedFile&& other) noexcept : mapping(other.mapping), length(other.length) {
+#ifdef _WIN32
+    mappingHandle = other.mappingHandle;
+    other.mappingHandle = nullptr;
+#endif
+    other.mapping = nullptr;
+    other.length = 0;
+}
+
+Common::MappedFile& Common::MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        release();
+        mapping = other.mapping;
+        length = other.length;
+    #ifdef _WIN32
+        mappingHandle = other.mappingHandle;
+        other.mappingHandle = nullptr;
+    #endif
+        other.mapping = nullptr;
+        other.length = 0;
+    }
+    return *this;
+}
+
+Common::MappedFile::~MappedFile() {
+    release();
+}
+
+void Common::MappedFile::release() {
+#ifdef _WIN32
+    if (mapping) UnmapViewOfFile(mapping);
+    if (mappingHandle) CloseHandle(mappingHandle);
+    mappingHandle = nullptr;
+#else
+    if (mapping) munmap(mapping, length);
+#endif
+    mapping = nullptr;
+    length = 0;
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <filesystem>
@@ -35,6 +37,39 @@ namespace Common {
     template <class T, typename... Rest>
     void hash_combine(std::size_t& seed, const T& v, const Rest&... rest);
 
+    /**
+     * @class MappedFile
+     * @brief RAII wrapper for a read-only memory mapping of a file, pages are only read from disk when they are accessed.
+     */
+    class MappedFile {
+       public:
+        MappedFile() = default;
+
+        /**
+         * @brief Maps a file into memory.
+         * @throw `std::runtime_error` if the file could not be opened or mapped.
+         */
+        explicit MappedFile(const std::filesystem::path& filepath);
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+        ~MappedFile();
+
+        const uint8_t* data() const { return static_cast<const uint8_t*>(mapping); }
+        size_t size() const { return length; }
+
+       private:
+        void release();
+
+        void* mapping = nullptr;
+        size_t length = 0;
+    #ifdef _WIN32
+        void* mappingHandle = nullptr;
+    #endif
+    };
+
 }
 
 /**
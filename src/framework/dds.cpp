@@ -0,0 +1,278 @@
+#include "dds.hpp"
+
+#include <glad/gl.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "gl/texture.hpp"
+
+namespace {
+
+constexpr uint32_t fourCC(char a, char b, char c, char d) {
+    return static_cast<uint32_t>(a) | static_cast<uint32_t>(b) << 8 | static_cast<uint32_t>(c) << 16 | static_cast<uint32_t>(d) << 24;
+}
+
+constexpr uint32_t DDS_MAGIC = fourCC('D', 'D', 'S', ' ');
+
+// Header flags
+constexpr uint32_t DDSD_CAPS = 0x1, DDSD_HEIGHT = 0x2, DDSD_WIDTH = 0x4, DDSD_PIXELFORMAT = 0x1000, DDSD_MIPMAPCOUNT = 0x20000, DDSD_LINEARSIZE = 0x80000;
+constexpr uint32_t DDPF_ALPHAPIXELS = 0x1, DDPF_FOURCC = 0x4, DDPF_RGB = 0x40, DDPF_LUMINANCE = 0x20000;
+constexpr uint32_t DDSCAPS_COMPLEX = 0x8, DDSCAPS_TEXTURE = 0x1000, DDSCAPS_MIPMAP = 0x400000;
+constexpr uint32_t DDSCAPS2_CUBEMAP = 0x200, DDSCAPS2_CUBEMAP_ALLFACES = 0xFC00, DDSCAPS2_VOLUME = 0x200000;
+constexpr uint32_t DDS_DIMENSION_TEXTURE2D = 3, DDS_RESOURCE_MISC_TEXTURECUBE = 0x4;
+
+// Limits of the header fields, beyond any texture OpenGL accepts, so the surface sizes computed from them cannot overflow
+constexpr uint32_t MAX_DIMENSION = 1u << 15;
+constexpr uint32_t MAX_ARRAY_SIZE = 2048;
+
+struct PixelFormat {
+    uint32_t size;
+    uint32_t flags;
+    uint32_t fourCC;
+    uint32_t rgbBitCount;
+    uint32_t rBitMask;
+    uint32_t gBitMask;
+    uint32_t bBitMask;
+    uint32_t aBitMask;
+};
+
+struct Header {
+    uint32_t size;
+    uint32_t flags;
+    uint32_t height;
+    uint32_t width;
+    uint32_t pitchOrLinearSize;
+    uint32_t depth;
+    uint32_t mipMapCount;
+    uint32_t reserved1[11];
+    PixelFormat pixelFormat;
+    uint32_t caps;
+    uint32_t caps2;
+    uint32_t caps3;
+    uint32_t caps4;
+    uint32_t reserved2;
+};
+
+struct HeaderDX10 {
+    uint32_t dxgiFormat;
+    uint32_t resourceDimension;
+    uint32_t miscFlag;
+    uint32_t arraySize;
+    uint32_t miscFlags2;
+};
+
+static_assert(sizeof(Header) == 124, "DDS header must be 124 bytes");
+static_assert(sizeof(HeaderDX10) == 20, "DDS DX10 header must be 20 bytes");
+
+struct FormatInfo {
+    uint32_t dxgiFormat;
+    GLenum internalFormat;
+    GLenum baseFormat;
+    GLenum dataType;
+};
+
+// Maps DXGI_FORMAT values to OpenGL, BC1 is mapped to the variant with alpha as Direct3D decodes it that way
+const FormatInfo FORMATS[] = {
+    {2, GL_RGBA32F, GL_RGBA, GL_FLOAT},
+    {6, GL_RGB32F, GL_RGB, GL_FLOAT},
+    {10, GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT},
+    {16, GL_RG32F, GL_RG, GL_FLOAT},
+    {24, GL_RGB10_A2, GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV},
+    {26, GL_R11F_G11F_B10F, GL_RGB, GL_UNSIGNED_INT_10F_11F_11F_REV},
+    {28, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE},
+    {29, GL_SRGB8_ALPHA8, GL_RGBA, GL_UNSIGNED_BYTE},
+    {34, GL_RG16F, GL_RG, GL_HALF_FLOAT},
+    {41, GL_R32F, GL_RED, GL_FLOAT},
+    {49, GL_RG8, GL_RG, GL_UNSIGNED_BYTE},
+    {54, GL_R16F, GL_RED, GL_HALF_FLOAT},
+    {61, GL_R8, GL_RED, GL_UNSIGNED_BYTE},
+    {71, GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, GL_NONE, GL_NONE},
+    {72, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT, GL_NONE, GL_NONE},
+    {74, GL_COMPRESSED_RGBA_S3TC_DXT3_EXT, GL_NONE, GL_NONE},
+    {75, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT, GL_NONE, GL_NONE},
+    {77, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, GL_NONE, GL_NONE},
+    {78, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT, GL_NONE, GL_NONE},
+    {80, GL_COMPRESSED_RED_RGTC1, GL_NONE, GL_NONE},
+    {81, GL_COMPRESSED_SIGNED_RED_RGTC1, GL_NONE, GL_NONE},
+    {83, GL_COMPRESSED_RG_RGTC2, GL_NONE, GL_NONE},
+    {84, GL_COMPRESSED_SIGNED_RG_RGTC2, GL_NONE, GL_NONE},
+    {95, GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT, GL_NONE, GL_NONE},
+    {96, GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT, GL_NONE, GL_NONE},
+    {98, GL_COMPRESSED_RGBA_BPTC_UNORM, GL_NONE, GL_NONE},
+    {99, GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM, GL_NONE, GL_NONE},
+};
+
+const FormatInfo* findDXGIFormat(uint32_t dxgiFormat) {
+    for (const auto& format : FORMATS)
+        if (format.dxgiFormat == dxgiFormat) return &format;
+    return nullptr;
+}
+
+const FormatInfo* findInternalFormat(GLenum internalFormat) {
+    // BC1 without alpha is stored the same way as BC1 with alpha
+    if (internalFormat == GL_COMPRESSED_RGB_S3TC_DXT1_EXT) internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+    if (internalFormat == GL_COMPRESSED_SRGB_S3TC_DXT1_EXT) internalFormat = GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT;
+    for (const auto& format : FORMATS)
+        if (format.internalFormat == internalFormat) return &format;
+    return nullptr;
+}
+
+/**
+ * @brief Translates the pixel format of files without DX10 header to the equivalent DXGI format.
+ */
+uint32_t legacyToDXGI(const PixelFormat& format) {
+    if (format.flags & DDPF_FOURCC) {
+        switch (format.fourCC) {
+            case fourCC('D', 'X', 'T', '1'): return 71;
+            case fourCC('D', 'X', 'T', '2'):
+            case fourCC('D', 'X', 'T', '3'): return 74;
+            case fourCC('D', 'X', 'T', '4'):
+            case fourCC('D', 'X', 'T', '5'): return 77;
+            case fourCC('A', 'T', 'I', '1'):
+            case fourCC('B', 'C', '4', 'U'): return 80;
+            case fourCC('B', 'C', '4', 'S'): return 81;
+            case fourCC('A', 'T', 'I', '2'):
+            case fourCC('B', 'C', '5', 'U'): return 83;
+            case fourCC('B', 'C', '5', 'S'): return 84;
+            case 111: return 54; // D3DFMT_R16F
+            case 112: return 34; // D3DFMT_G16R16F
+            case 113: return 10; // D3DFMT_A16B16G16R16F
+            case 114: return 41; // D3DFMT_R32F
+            case 115: return 16; // D3DFMT_G32R32F
+            case 116: return 2;  // D3DFMT_A32B32G32R32F
+            default: return 0;
+        }
+    }
+    if ((format.flags & DDPF_RGB) && format.rgbBitCount == 32 && format.rBitMask == 0x000000FF && format.gBitMask == 0x0000FF00 && format.bBitMask == 0x00FF0000)
+        return 28;
+    if ((format.flags & DDPF_LUMINANCE) && format.rgbBitCount == 8) return 61;
+    if ((format.flags & DDPF_LUMINANCE) && format.rgbBitCount == 16 && (format.flags & DDPF_ALPHAPIXELS)) return 49;
+    return 0;
+}
+
+}
+
+size_t DDS::getSurfaceSize(GLenum internalFormat, GLsizei width, GLsizei height) {
+    if (isCompressedFormat(internalFormat)) return getCompressedSize(internalFormat, width, height);
+    return static_cast<size_t>(width) * height * getBytesPerPixel(internalFormat);
+}
+
+DDS::Image DDS::load(const std::filesystem::path& filepath) {
+    Image image;
+    image.file = Common::MappedFile(filepath);
+    const uint8_t* data = image.file.data();
+    const size_t size = image.file.size();
+    const auto error = [&](const std::string& message) { return std::runtime_error("Failed to parse DDS " + filepath.string() + ": " + message); };
+
+    if (size < 4 + sizeof(Header)) throw error("File too small");
+    uint32_t magic;
+    std::memcpy(&magic, data, sizeof(magic));
+    if (magic != DDS_MAGIC) throw error("Not a DDS file");
+    Header header;
+    std::memcpy(&header, data + 4, sizeof(header));
+    if (header.size != sizeof(Header) || header.pixelFormat.size != sizeof(PixelFormat)) throw error("Invalid header");
+    if (header.caps2 & DDSCAPS2_VOLUME) throw error("Volume textures are not supported");
+
+    size_t offset = 4 + sizeof(Header);
+    uint32_t dxgiFormat;
+    if ((header.pixelFormat.flags & DDPF_FOURCC) && header.pixelFormat.fourCC == fourCC('D', 'X', '1', '0')) {
+        if (size < offset + sizeof(HeaderDX10)) throw error("File too small");
+        HeaderDX10 dx10;
+        std::memcpy(&dx10, data + offset, sizeof(dx10));
+        offset += sizeof(dx10);
+        if (dx10.resourceDimension != DDS_DIMENSION_TEXTURE2D) throw error("Only 2D textures are supported");
+        dxgiFormat = dx10.dxgiFormat;
+        image.cubemap = dx10.miscFlag & DDS_RESOURCE_MISC_TEXTURECUBE;
+        if (dx10.arraySize > MAX_ARRAY_SIZE) throw error("Array size " + std::to_string(dx10.arraySize) + " is too large");
+        image.layers = static_cast<GLint>(std::max(dx10.arraySize, 1u)) * (image.cubemap ? 6 : 1);
+    } else {
+        dxgiFormat = legacyToDXGI(header.pixelFormat);
+        image.cubemap = header.caps2 & DDSCAPS2_CUBEMAP;
+        if (image.cubemap && (header.caps2 & DDSCAPS2_CUBEMAP_ALLFACES) != DDSCAPS2_CUBEMAP_ALLFACES) throw error("Partial cubemaps are not supported");
+        image.layers = image.cubemap ? 6 : 1;
+    }
+
+    const FormatInfo* format = findDXGIFormat(dxgiFormat);
+    if (!format) throw error("Unsupported format " + std::to_string(dxgiFormat));
+    image.internalFormat = format->internalFormat;
+    image.baseFormat = format->baseFormat;
+    image.dataType = format->dataType;
+    if (header.width == 0 || header.height == 0 || header.width > MAX_DIMENSION || header.height > MAX_DIMENSION)
+        throw error("Invalid size " + std::to_string(header.width) + "x" + std::to_string(header.height));
+    image.width = static_cast<GLsizei>(header.width);
+    image.height = static_cast<GLsizei>(header.height);
+    image.levels = (header.flags & DDSD_MIPMAPCOUNT) ? static_cast<GLint>(std::min(std::max(header.mipMapCount, 1u), MAX_DIMENSION)) : 1;
+    GLint maxLevels = 1;
+    while ((std::max(image.width, image.height) >> maxLevels) > 0) maxLevels++;
+    if (image.levels > maxLevels) throw error(std::to_string(header.mipMapCount) + " mip levels exceed the full chain of " + std::to_string(maxLevels));
+
+    // Surfaces are stored layer by layer, each with its full mip chain
+    image.surfaces.reserve(static_cast<size_t>(image.layers) * image.levels);
+    for (GLint layer = 0; layer < image.layers; layer++) {
+        GLsizei width = image.width, height = image.height;
+        for (GLint level = 0; level < image.levels; level++) {
+            size_t surfaceSize = getSurfaceSize(image.internalFormat, width, height);
+            if (surfaceSize > size - offset) throw error("File truncated"); // offset never exceeds size, so this cannot wrap
+            image.surfaces.push_back({data + offset, surfaceSize, width, height});
+            offset += surfaceSize;
+            width = std::max(width / 2, 1);
+            height = std::max(height / 2, 1);
+        }
+    }
+    return image;
+}
+
+void DDS::write(const std::filesystem::path& filepath, GLenum internalFormat, GLsizei width, GLsizei height, bool cubemap,
+                const std::vector<std::vector<std::vector<uint8_t>>>& layers) {
+    const FormatInfo* format = findInternalFormat(internalFormat);
+    if (!format) throw std::runtime_error("DDS: Unsupported format for " + filepath.string());
+    if (layers.empty() || layers[0].empty()) throw std::runtime_error("DDS: No surfaces for " + filepath.string());
+    if (cubemap && layers.size() % 6 != 0) throw std::runtime_error("DDS: Cubemaps need six faces per cube for " + filepath.string());
+    const uint32_t levels = static_cast<uint32_t>(layers[0].size());
+
+    Header header = {};
+    header.size = sizeof(Header);
+    header.flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT | DDSD_LINEARSIZE;
+    header.height = static_cast<uint32_t>(height);
+    header.width = static_cast<uint32_t>(width);
+    header.pitchOrLinearSize = static_cast<uint32_t>(getSurfaceSize(internalFormat, width, height));
+    header.mipMapCount = levels;
+    header.pixelFormat.size = sizeof(PixelFormat);
+    header.pixelFormat.flags = DDPF_FOURCC;
+    header.pixelFormat.fourCC = fourCC('D', 'X', '1', '0');
+    header.caps = DDSCAPS_TEXTURE | (levels > 1 ? DDSCAPS_MIPMAP | DDSCAPS_COMPLEX : 0) | (cubemap ? DDSCAPS_COMPLEX : 0);
+    header.caps2 = cubemap ? DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_ALLFACES : 0;
+
+    HeaderDX10 dx10 = {};
+    dx10.dxgiFormat = format->dxgiFormat;
+    dx10.resourceDimension = DDS_DIMENSION_TEXTURE2D;
+    dx10.miscFlag = cubemap ? DDS_RESOURCE_MISC_TEXTURECUBE : 0;
+    dx10.arraySize = static_cast<uint32_t>(cubemap ? layers.size() / 6 : layers.size());
+
+    std::filesystem::create_directories(filepath.parent_path());
+    std::ofstream file(filepath, std::ios::binary);
+    std::cout << "Writing " << std::filesystem::absolute(filepath) << std::endl;
+    if (!file) throw std::runtime_error("Could not open file: " + std::filesystem::absolute(filepath).string());
+    file.write(reinterpret_cast<const char*>(&DDS_MAGIC), sizeof(DDS_MAGIC));
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(&dx10), sizeof(dx10));
+    for (const auto& layer : layers) {
+        if (layer.size() != levels) throw std::runtime_error("DDS: All layers need the same number of mip levels for " + filepath.string());
+        GLsizei w = width, h = height;
+        for (const auto& surface : layer) {
+            if (surface.size() != getSurfaceSize(internalFormat, w, h)) throw std::runtime_error("DDS: Surface has the wrong size for " + filepath.string());
+            file.write(reinterpret_cast<const char*>(surface.data()), static_cast<std::streamsize>(surface.size()));
+            w = std::max(w / 2, 1);
+            h = std::max(h / 2, 1);
+        }
+    }
+    if (!file) throw std::runtime_error("Could not write file: " + std::filesystem::absolute(filepath).string());
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <glad/gl.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+#include "common.hpp"
+
+/**
+ * @file dds.hpp
+ * @brief Defines functions to read and write DirectDraw Surface (DDS) texture containers.
+ */
+
+/**
+ * @brief Reads and writes DDS files, a container for GPU-ready texture data including mip chains, cubemap faces and array layers.
+ * Files are memory mapped, so the surfaces can be uploaded straight from the mapping without decoding, see `Texture::loadDDS`.
+ * Supported are the BC1-BC7 formats and the common uncompressed 8 bit, half and float formats, either with a legacy or a DX10 header.
+ * See https://learn.microsoft.com/en-us/windows/win32/direct3ddds/dx-graphics-dds-pguide
+ * @note DDS stores images top to bottom, while OpenGL expects the first row at the bottom. Files written by `texconv` are flipped for OpenGL (except cubemap faces), so they can be uploaded as is.
+ */
+namespace DDS {
+
+    /**
+     * @brief One mip level of one layer or cubemap face.
+     */
+    struct Surface {
+        const uint8_t* data;
+        size_t size;
+        GLsizei width;
+        GLsizei height;
+    };
+
+    /**
+     * @brief A memory mapped DDS file, the surfaces point into the mapping and stay valid as long as the image exists.
+     */
+    struct Image {
+        GLenum internalFormat = GL_NONE;
+        /** The format and type for `glTexSubImage2D`, `GL_NONE` for compressed formats */
+        GLenum baseFormat = GL_NONE;
+        GLenum dataType = GL_NONE;
+        GLsizei width = 0;
+        GLsizei height = 0;
+        GLint levels = 1;
+        /** Array layers, six times the number of cubes for cubemaps */
+        GLint layers = 1;
+        bool cubemap = false;
+        /** The surfaces in file order, all mip levels of the first layer, then of the second, ... */
+        std::vector<Surface> surfaces;
+        Common::MappedFile file;
+
+        const Surface& getSurface(GLint layer, GLint level) const { return surfaces[layer * levels + level]; }
+        bool isCompressed() const { return baseFormat == GL_NONE; }
+    };
+
+    /**
+     * @brief Maps a DDS file into memory and parses its header.
+     * @throw `std::runtime_error` if the file is not a valid DDS file or uses an unsupported format.
+     */
+    Image load(const std::filesystem::path& filepath);
+
+    /**
+     * @brief Writes a DDS file with a DX10 header.
+     * @param filepath The path to the output file.
+     * @param internalFormat The internal format of the data.
+     * @param width The width of the base level.
+     * @param height The height of the base level.
+     * @param cubemap Whether the layers are cubemap faces in the order +X, -X, +Y, -Y, +Z, -Z.
+     * @param layers The surfaces per layer and mip level, all layers need the same number of levels.
+     * @throw `std::runtime_error` if the format is not supported or the file could not be written.
+     */
+    void write(const std::filesystem::path& filepath, GLenum internalFormat, GLsizei width, GLsizei height, bool cubemap,
+               const std::vector<std::vector<std::vector<uint8_t>>>& layers);
+
+    /**
+     * @brief Gets the number of bytes of a surface.
+     */
+    size_t getSurfaceSize(GLenum internalFormat, GLsizei width, GLsizei height);
+
+}
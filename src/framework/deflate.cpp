@@ -0,0 +1,527 @@
+#include "deflate.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <queue>
+#include <vector>
+
+#include "threadpool.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define DEFLATE_SSE2
+    #include <emmintrin.h>
+#endif
+
+namespace {
+
+constexpr size_t WINDOW_SIZE = 32768;
+constexpr size_t MIN_MATCH = 4; // Matches are found through a hash of 4 bytes
+constexpr size_t MAX_MATCH = 258;
+constexpr int HASH_BITS = 15;
+constexpr size_t BLOCK_TOKENS = 1 << 15;
+constexpr size_t ZLIB_BAND_SIZE = 1 << 18;
+
+constexpr int LITLEN_SYMBOLS = 286;
+constexpr int DISTANCE_SYMBOLS = 30;
+constexpr int CODELENGTH_SYMBOLS = 19;
+
+constexpr uint16_t LENGTH_BASE[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+constexpr uint8_t LENGTH_EXTRA[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+constexpr uint16_t DISTANCE_BASE[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+constexpr uint8_t DISTANCE_EXTRA[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+constexpr uint8_t CODELENGTH_ORDER[CODELENGTH_SYMBOLS] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+struct Tables {
+    std::array<uint8_t, MAX_MATCH + 1> lengthCode{};
+    std::array<uint8_t, 512> distanceCode{};
+    std::array<std::array<uint32_t, 256>, 8> crc{};
+
+    Tables() {
+        for (int code = 0; code < 29; code++) {
+            int end = code + 1 < 29 ? LENGTH_BASE[code + 1] : MAX_MATCH + 1;
+            for (int length = LENGTH_BASE[code]; length < end; length++) lengthCode[length] = static_cast<uint8_t>(code);
+        }
+        lengthCode[MAX_MATCH] = 28; // 258 has its own code instead of 227 + 31
+        // Distances up to 256 are looked up directly, larger ones by their upper bits
+        for (int code = 0; code < 30; code++) {
+            for (int distance = DISTANCE_BASE[code]; distance < DISTANCE_BASE[code] + (1 << DISTANCE_EXTRA[code]); distance++) {
+                if (distance <= 256) distanceCode[distance - 1] = static_cast<uint8_t>(code);
+                else distanceCode[256 + ((distance - 1) >> 7)] = static_cast<uint8_t>(code);
+            }
+        }
+        // Slicing-by-8 tables for the reflected CRC-32 polynomial
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            crc[0][i] = c;
+        }
+        for (uint32_t i = 0; i < 256; i++)
+            for (int t = 1; t < 8; t++) crc[t][i] = (crc[t - 1][i] >> 8) ^ crc[0][crc[t - 1][i] & 0xFF];
+    }
+
+    int getDistanceCode(uint32_t distance) const {
+        return distance <= 256 ? distanceCode[distance - 1] : distanceCode[256 + ((distance - 1) >> 7)];
+    }
+};
+
+const Tables TABLES;
+
+/**
+ * @brief Writes bits starting with the least significant one, the output grows in steps reserved up front so that `put` needs no bounds checks.
+ */
+class BitWriter {
+   public:
+    explicit BitWriter(std::vector<uint8_t>& out) : out(out), position(out.size()) {}
+
+    ~BitWriter() { out.resize(position); }
+
+    /** Makes room for at least `bytes` more bytes */
+    void reserve(size_t bytes) {
+        if (out.size() < position + bytes + 8) out.resize(std::max(position + bytes + 8, out.size() * 3 / 2));
+    }
+
+    void put(uint32_t value, int count) {
+        bits |= static_cast<uint64_t>(value) << bitCount;
+        bitCount += count;
+        if (bitCount >= 32) {
+            const uint32_t low = static_cast<uint32_t>(bits);
+            std::memcpy(out.data() + position, &low, sizeof(low)); // Deflate streams are little endian like the supported platforms
+            position += 4;
+            bits >>= 32;
+            bitCount -= 32;
+        }
+    }
+
+    /** Pads with zero bits up to the next byte boundary */
+    void align() {
+        while (bitCount > 0) {
+            out[position++] = static_cast<uint8_t>(bits);
+            bits >>= 8;
+            bitCount = std::max(bitCount - 8, 0);
+        }
+        bits = 0;
+    }
+
+    /** Copies bytes, only valid at a byte boundary */
+    void append(const uint8_t* data, size_t size) {
+        reserve(size);
+        std::memcpy(out.data() + position, data, size);
+        position += size;
+    }
+
+   private:
+    std::vector<uint8_t>& out;
+    size_t position;
+    uint64_t bits = 0;
+    int bitCount = 0;
+};
+
+/**
+ * @brief Computes Huffman code lengths limited to `maxBits`, unused symbols get length 0.
+ */
+void buildLengths(const uint32_t* frequencies, int count, int maxBits, uint8_t* lengths) {
+    std::fill(lengths, lengths + count, 0);
+    std::vector<int> symbols;
+    for (int i = 0; i < count; i++)
+        if (frequencies[i]) symbols.push_back(i);
+    if (symbols.empty()) return;
+    if (symbols.size() == 1) {
+        lengths[symbols[0]] = 1;
+        return;
+    }
+
+    // Build the tree bottom up, nodes beyond the leaves are the internal nodes
+    std::vector<int> parent(2 * symbols.size(), -1);
+    using Node = std::pair<uint64_t, int>;
+    std::priority_queue<Node, std::vector<Node>, std::greater<>> queue;
+    for (size_t i = 0; i < symbols.size(); i++) queue.push({frequencies[symbols[i]], static_cast<int>(i)});
+    int next = static_cast<int>(symbols.size());
+    while (queue.size() > 1) {
+        auto a = queue.top();
+        queue.pop();
+        auto b = queue.top();
+        queue.pop();
+        parent[a.second] = parent[b.second] = next;
+        queue.push({a.first + b.first, next++});
+    }
+    std::vector<int> depth(next, 0);
+    for (int node = next - 2; node >= 0; node--) depth[node] = depth[parent[node]] + 1;
+
+    // Limit the depth as in miniz: fold deep leaves into the maximum and restore the Kraft inequality by splitting shallower leaves
+    std::vector<int> lengthCounts(std::max(maxBits, 32) + 1, 0);
+    for (size_t i = 0; i < symbols.size(); i++) lengthCounts[std::min(depth[i], maxBits)]++;
+    uint64_t total = 0;
+    for (int length = 1; length <= maxBits; length++) total += static_cast<uint64_t>(lengthCounts[length]) << (maxBits - length);
+    while (total > (1ull << maxBits)) {
+        lengthCounts[maxBits]--;
+        for (int length = maxBits - 1; length > 0; length--) {
+            if (lengthCounts[length]) {
+                lengthCounts[length]--;
+                lengthCounts[length + 1] += 2;
+                break;
+            }
+        }
+        total--;
+    }
+
+    // The most frequent symbols get the shortest codes
+    std::stable_sort(symbols.begin(), symbols.end(), [&](int a, int b) { return frequencies[a] > frequencies[b]; });
+    size_t index = 0;
+    for (int length = 1; length <= maxBits; length++)
+        for (int i = 0; i < lengthCounts[length]; i++) lengths[symbols[index++]] = static_cast<uint8_t>(length);
+}
+
+/**
+ * @brief Assigns canonical codes to lengths, bit reversed since deflate writes Huffman codes starting with the most significant bit.
+ */
+void buildCodes(const uint8_t* lengths, int count, uint16_t* codes) {
+    int lengthCounts[16] = {};
+    for (int i = 0; i < count; i++) lengthCounts[lengths[i]]++;
+    lengthCounts[0] = 0;
+    uint16_t nextCode[16] = {};
+    uint16_t code = 0;
+    for (int length = 1; length < 16; length++) {
+        code = static_cast<uint16_t>((code + lengthCounts[length - 1]) << 1);
+        nextCode[length] = code;
+    }
+    for (int i = 0; i < count; i++) {
+        int length = lengths[i];
+        if (!length) continue;
+        uint16_t value = nextCode[length]++, reversed = 0;
+        for (int bit = 0; bit < length; bit++) reversed |= static_cast<uint16_t>(((value >> bit) & 1) << (length - 1 - bit));
+        codes[i] = reversed;
+    }
+}
+
+struct Token {
+    uint16_t length; // Literal byte if distance is 0
+    uint16_t distance;
+};
+
+struct Huffman {
+    uint8_t litlenLengths[288] = {};
+    uint16_t litlenCodes[288] = {};
+    uint8_t distanceLengths[32] = {};
+    uint16_t distanceCodes[32] = {};
+};
+
+uint64_t countTokenBits(const Huffman& huffman, const uint32_t* litlenFrequencies, const uint32_t* distanceFrequencies) {
+    uint64_t bits = 0;
+    for (int i = 0; i < LITLEN_SYMBOLS; i++) bits += static_cast<uint64_t>(litlenFrequencies[i]) * (huffman.litlenLengths[i] + (i > 256 ? LENGTH_EXTRA[i - 257] : 0));
+    for (int i = 0; i < DISTANCE_SYMBOLS; i++) bits += static_cast<uint64_t>(distanceFrequencies[i]) * (huffman.distanceLengths[i] + DISTANCE_EXTRA[i]);
+    return bits;
+}
+
+void writeTokens(BitWriter& writer, const Huffman& huffman, const std::vector<Token>& tokens) {
+    for (const auto& token : tokens) {
+        if (token.distance == 0) {
+            writer.put(huffman.litlenCodes[token.length], huffman.litlenLengths[token.length]);
+            continue;
+        }
+        const int lengthCode = TABLES.lengthCode[token.length];
+        writer.put(huffman.litlenCodes[257 + lengthCode], huffman.litlenLengths[257 + lengthCode]);
+        if (LENGTH_EXTRA[lengthCode]) writer.put(token.length - LENGTH_BASE[lengthCode], LENGTH_EXTRA[lengthCode]);
+        const int distanceCode = TABLES.getDistanceCode(token.distance);
+        writer.put(huffman.distanceCodes[distanceCode], huffman.distanceLengths[distanceCode]);
+        if (DISTANCE_EXTRA[distanceCode]) writer.put(token.distance - DISTANCE_BASE[distanceCode], DISTANCE_EXTRA[distanceCode]);
+    }
+    writer.put(huffman.litlenCodes[256], huffman.litlenLengths[256]);
+}
+
+void writeStored(BitWriter& writer, const uint8_t* data, size_t size, bool final) {
+    do {
+        const size_t chunk = std::min<size_t>(size, 65535);
+        const bool last = final && chunk == size;
+        writer.put(last ? 1 : 0, 3);
+        writer.align();
+        const uint16_t length = static_cast<uint16_t>(chunk);
+        const uint16_t inverse = static_cast<uint16_t>(~length);
+        const uint8_t header[4] = {static_cast<uint8_t>(length), static_cast<uint8_t>(length >> 8), static_cast<uint8_t>(inverse), static_cast<uint8_t>(inverse >> 8)};
+        writer.append(header, 4);
+        writer.append(data, chunk);
+        data += chunk;
+        size -= chunk;
+    } while (size > 0);
+}
+
+/**
+ * @brief Writes a block with the cheapest of dynamic Huffman, fixed Huffman or stored encoding.
+ */
+void writeBlock(BitWriter& writer, const std::vector<Token>& tokens, const uint8_t* data, size_t size, bool final) {
+    uint32_t litlenFrequencies[288] = {};
+    uint32_t distanceFrequencies[32] = {};
+    for (const auto& token : tokens) {
+        if (token.distance == 0) {
+            litlenFrequencies[token.length]++;
+        } else {
+            litlenFrequencies[257 + TABLES.lengthCode[token.length]]++;
+            distanceFrequencies[TABLES.getDistanceCode(token.distance)]++;
+        }
+    }
+    litlenFrequencies[256] = 1;
+
+    Huffman dynamic;
+    buildLengths(litlenFrequencies, LITLEN_SYMBOLS, 15, dynamic.litlenLengths);
+    buildLengths(distanceFrequencies, DISTANCE_SYMBOLS, 15, dynamic.distanceLengths);
+    if (std::all_of(dynamic.distanceLengths, dynamic.distanceLengths + DISTANCE_SYMBOLS, [](uint8_t length) { return length == 0; }))
+        dynamic.distanceLengths[0] = 1; // Some decoders reject an empty distance tree
+    buildCodes(dynamic.litlenLengths, LITLEN_SYMBOLS, dynamic.litlenCodes);
+    buildCodes(dynamic.distanceLengths, DISTANCE_SYMBOLS, dynamic.distanceCodes);
+
+    int litlenCount = LITLEN_SYMBOLS, distanceCount = DISTANCE_SYMBOLS;
+    while (litlenCount > 257 && dynamic.litlenLengths[litlenCount - 1] == 0) litlenCount--;
+    while (distanceCount > 1 && dynamic.distanceLengths[distanceCount - 1] == 0) distanceCount--;
+
+    // Run length encode the code lengths with the symbols 16 (repeat previous), 17 and 18 (repeat zero)
+    std::vector<uint8_t> lengths(dynamic.litlenLengths, dynamic.litlenLengths + litlenCount);
+    lengths.insert(lengths.end(), dynamic.distanceLengths, dynamic.distanceLengths + distanceCount);
+    std::vector<std::pair<uint8_t, uint8_t>> runs; // Symbol and extra bits
+    uint32_t codelengthFrequencies[CODELENGTH_SYMBOLS] = {};
+    for (size_t i = 0; i < lengths.size();) {
+        const uint8_t length = lengths[i];
+        size_t run = 1;
+        while (i + run < lengths.size() && lengths[i + run] == length) run++;
+        if (length == 0 && run >= 3) {
+            run = std::min<size_t>(run, 138);
+            runs.push_back(run >= 11 ? std::make_pair(uint8_t(18), static_cast<uint8_t>(run - 11)) : std::make_pair(uint8_t(17), static_cast<uint8_t>(run - 3)));
+        } else if (length != 0 && run >= 4) {
+            runs.push_back({length, 0});
+            run = std::min<size_t>(run - 1, 6);
+            runs.push_back({16, static_cast<uint8_t>(run - 3)});
+            run++;
+        } else {
+            run = 1;
+            runs.push_back({length, 0});
+        }
+        i += run;
+    }
+    for (const auto& run : runs) codelengthFrequencies[run.first]++;
+    uint8_t codelengthLengths[CODELENGTH_SYMBOLS];
+    uint16_t codelengthCodes[CODELENGTH_SYMBOLS] = {};
+    buildLengths(codelengthFrequencies, CODELENGTH_SYMBOLS, 7, codelengthLengths);
+    buildCodes(codelengthLengths, CODELENGTH_SYMBOLS, codelengthCodes);
+    int codelengthCount = CODELENGTH_SYMBOLS;
+    while (codelengthCount > 4 && codelengthLengths[CODELENGTH_ORDER[codelengthCount - 1]] == 0) codelengthCount--;
+
+    uint64_t dynamicBits = 3 + 14 + 3 * codelengthCount + countTokenBits(dynamic, litlenFrequencies, distanceFrequencies);
+    for (const auto& run : runs) dynamicBits += codelengthLengths[run.first] + (run.first == 16 ? 2 : run.first == 17 ? 3 : run.first == 18 ? 7 : 0);
+
+    Huffman fixed;
+    for (int i = 0; i < 288; i++) fixed.litlenLengths[i] = i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8;
+    for (int i = 0; i < 32; i++) fixed.distanceLengths[i] = 5;
+    const uint64_t fixedBits = 3 + countTokenBits(fixed, litlenFrequencies, distanceFrequencies);
+    const uint64_t storedBits = (size / 65535 + 1) * 40 + 8 * static_cast<uint64_t>(size);
+
+    writer.reserve(std::min(dynamicBits, fixedBits) / 8 + 64);
+    if (storedBits < dynamicBits && storedBits < fixedBits) {
+        writeStored(writer, data, size, final);
+    } else if (fixedBits <= dynamicBits) {
+        buildCodes(fixed.litlenLengths, 288, fixed.litlenCodes);
+        buildCodes(fixed.distanceLengths, 32, fixed.distanceCodes);
+        writer.put(final ? 1 : 0, 1);
+        writer.put(1, 2);
+        writeTokens(writer, fixed, tokens);
+    } else {
+        writer.put(final ? 1 : 0, 1);
+        writer.put(2, 2);
+        writer.put(litlenCount - 257, 5);
+        writer.put(distanceCount - 1, 5);
+        writer.put(codelengthCount - 4, 4);
+        for (int i = 0; i < codelengthCount; i++) writer.put(codelengthLengths[CODELENGTH_ORDER[i]], 3);
+        for (const auto& run : runs) {
+            writer.put(codelengthCodes[run.first], codelengthLengths[run.first]);
+            if (run.first == 16) writer.put(run.second, 2);
+            else if (run.first == 17) writer.put(run.second, 3);
+            else if (run.first == 18) writer.put(run.second, 7);
+        }
+        writeTokens(writer, dynamic, tokens);
+    }
+}
+
+uint32_t load32(const uint8_t* data) {
+    uint32_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+uint32_t hash(uint32_t value) {
+    return (value * 2654435761u) >> (32 - HASH_BITS);
+}
+
+size_t matchLength(const uint8_t* a, const uint8_t* b, size_t maxLength) {
+    size_t length = 0;
+    // Compare eight bytes at a time, the first differing byte is found from the trailing zeros of the xor
+    while (length + 8 <= maxLength) {
+        uint64_t x, y;
+        std::memcpy(&x, a + length, 8);
+        std::memcpy(&y, b + length, 8);
+        if (uint64_t difference = x ^ y) {
+    #if defined(__GNUC__) || defined(__clang__)
+            return length + (__builtin_ctzll(difference) >> 3);
+    #else
+            while ((difference & 0xFF) == 0) {
+                difference >>= 8;
+                length++;
+            }
+            return length;
+    #endif
+        }
+        length += 8;
+    }
+    while (length < maxLength && a[length] == b[length]) length++;
+    return length;
+}
+
+}
+
+void Deflate::compress(const uint8_t* data, size_t size, bool final, std::vector<uint8_t>& out) {
+    BitWriter writer(out);
+    std::vector<uint32_t> table(size_t(1) << HASH_BITS, 0); // Position + 1 of the last occurrence of each hash
+    std::vector<Token> tokens;
+    tokens.reserve(BLOCK_TOKENS + MAX_MATCH);
+    size_t blockStart = 0, position = 0;
+    size_t misses = 0;
+
+    auto flush = [&](bool last) {
+        writeBlock(writer, tokens, data + blockStart, position - blockStart, last);
+        tokens.clear();
+        blockStart = position;
+    };
+
+    while (position < size) {
+        if (position + MIN_MATCH <= size) {
+            const uint32_t value = load32(data + position);
+            const uint32_t h = hash(value);
+            const size_t candidate = table[h];
+            table[h] = static_cast<uint32_t>(position + 1);
+            if (candidate && position + 1 - candidate <= WINDOW_SIZE && load32(data + candidate - 1) == value) {
+                const size_t match = candidate - 1;
+                const size_t length = MIN_MATCH + matchLength(data + match + MIN_MATCH, data + position + MIN_MATCH, std::min(MAX_MATCH, size - position) - MIN_MATCH);
+                tokens.push_back({static_cast<uint16_t>(length), static_cast<uint16_t>(position - match)});
+                // Index the positions inside short matches, long matches are mostly runs that are found again anyway
+                const size_t end = position + length;
+                if (length <= 32)
+                    for (size_t p = position + 1; p + MIN_MATCH <= size && p < end; p++) table[hash(load32(data + p))] = static_cast<uint32_t>(p + 1);
+                position = end;
+                misses = 0;
+            } else {
+                // Skip faster through incompressible data
+                const size_t step = 1 + (misses++ >> 6);
+                for (size_t i = 0; i < step && position < size; i++) tokens.push_back({data[position++], 0});
+            }
+        } else {
+            tokens.push_back({data[position++], 0});
+        }
+        if (tokens.size() >= BLOCK_TOKENS) flush(final && position == size);
+    }
+
+    if (!tokens.empty() || (final && blockStart == 0 && size == 0)) flush(final);
+    if (!final) {
+        // Sync flush, an empty stored block that ends on a byte boundary
+        writer.reserve(8);
+        writer.put(0, 3);
+        writer.align();
+        const uint8_t marker[4] = {0x00, 0x00, 0xFF, 0xFF};
+        writer.append(marker, 4);
+    } else {
+        writer.reserve(8);
+        writer.align();
+    }
+}
+
+std::vector<uint8_t> Deflate::compressZlib(const uint8_t* data, size_t size) {
+    const size_t bands = std::max<size_t>(1, (size + ZLIB_BAND_SIZE - 1) / ZLIB_BAND_SIZE);
+    std::vector<std::vector<uint8_t>> outputs(bands);
+    std::vector<uint32_t> checksums(bands);
+    ThreadPool::global().parallelFor(0, bands, [&](size_t band) {
+        const size_t begin = band * ZLIB_BAND_SIZE, end = std::min(size, begin + ZLIB_BAND_SIZE);
+        compress(data + begin, end - begin, band + 1 == bands, outputs[band]);
+        checksums[band] = adler32(data + begin, end - begin);
+    });
+
+    std::vector<uint8_t> result = {0x78, 0x01}; // Deflate with a 32 KiB window, fastest compression level
+    uint32_t adler = 1;
+    for (size_t band = 0; band < bands; band++) {
+        result.insert(result.end(), outputs[band].begin(), outputs[band].end());
+        const size_t begin = band * ZLIB_BAND_SIZE;
+        adler = adler32Combine(adler, checksums[band], std::min(size, begin + ZLIB_BAND_SIZE) - begin);
+    }
+    for (int shift = 24; shift >= 0; shift -= 8) result.push_back(static_cast<uint8_t>(adler >> shift));
+    return result;
+}
+
+uint32_t Deflate::adler32(const uint8_t* data, size_t size, uint32_t adler) {
+    constexpr uint32_t BASE = 65521;
+    constexpr size_t NMAX = 5552; // The largest n such that the sums cannot overflow before the modulo
+    uint32_t s1 = adler & 0xFFFF, s2 = adler >> 16;
+    while (size > 0) {
+        size_t chunk = std::min(size, NMAX);
+        size -= chunk;
+#ifdef DEFLATE_SSE2
+        // Per 16 bytes: s2 += 16 * s1 + sum((16 - k) * byte[k]) and s1 += sum(byte[k])
+        const size_t vectorBytes = chunk & ~size_t(15);
+        if (vectorBytes) {
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i weightsLow = _mm_setr_epi16(16, 15, 14, 13, 12, 11, 10, 9);
+            const __m128i weightsHigh = _mm_setr_epi16(8, 7, 6, 5, 4, 3, 2, 1);
+            __m128i sum1 = zero, sum2 = zero, previousSum1 = zero;
+            for (size_t i = 0; i < vectorBytes; i += 16) {
+                const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+                previousSum1 = _mm_add_epi32(previousSum1, sum1);
+                sum1 = _mm_add_epi32(sum1, _mm_sad_epu8(bytes, zero));
+                sum2 = _mm_add_epi32(sum2, _mm_madd_epi16(_mm_unpacklo_epi8(bytes, zero), weightsLow));
+                sum2 = _mm_add_epi32(sum2, _mm_madd_epi16(_mm_unpackhi_epi8(bytes, zero), weightsHigh));
+            }
+            alignas(16) uint32_t lanes1[4], lanes2[4], lanesPrevious[4];
+            _mm_store_si128(reinterpret_cast<__m128i*>(lanes1), sum1);
+            _mm_store_si128(reinterpret_cast<__m128i*>(lanes2), sum2);
+            _mm_store_si128(reinterpret_cast<__m128i*>(lanesPrevious), previousSum1);
+            const uint64_t bytesSum = static_cast<uint64_t>(lanes1[0]) + lanes1[2];
+            const uint64_t weightedSum = static_cast<uint64_t>(lanes2[0]) + lanes2[1] + lanes2[2] + lanes2[3];
+            const uint64_t previousSum = static_cast<uint64_t>(lanesPrevious[0]) + lanesPrevious[2];
+            s2 = static_cast<uint32_t>((s2 + static_cast<uint64_t>(s1) * vectorBytes + 16 * previousSum + weightedSum) % BASE);
+            s1 = static_cast<uint32_t>((s1 + bytesSum) % BASE);
+            data += vectorBytes;
+            chunk -= vectorBytes;
+        }
+#endif
+        for (size_t i = 0; i < chunk; i++) {
+            s1 += data[i];
+            s2 += s1;
+        }
+        data += chunk;
+        s1 %= BASE;
+        s2 %= BASE;
+    }
+    return s1 | (s2 << 16);
+}
+
+uint32_t Deflate::adler32Combine(uint32_t adler1, uint32_t adler2, size_t size2) {
+    // See adler32_combine in zlib
+    constexpr uint64_t BASE = 65521;
+    const uint64_t remainder = size2 % BASE;
+    uint64_t sum1 = adler1 & 0xFFFF;
+    uint64_t sum2 = (remainder * sum1) % BASE;
+    sum1 += (adler2 & 0xFFFF) + BASE - 1;
+    sum2 += (adler1 >> 16) + (adler2 >> 16) + BASE - remainder;
+    sum1 %= BASE;
+    sum2 %= BASE;
+    return static_cast<uint32_t>(sum1 | (sum2 << 16));
+}
+
+uint32_t Deflate::crc32(const uint8_t* data, size_t size, uint32_t crc) {
+    const auto& table = TABLES.crc;
+    uint32_t c = ~crc;
+    while (size >= 8) {
+        uint32_t low = load32(data) ^ c, high = load32(data + 4);
+        c = table[7][low & 0xFF] ^ table[6][(low >> 8) & 0xFF] ^ table[5][(low >> 16) & 0xFF] ^ table[4][low >> 24]
+            ^ table[3][high & 0xFF] ^ table[2][(high >> 8) & 0xFF] ^ table[1][(high >> 16) & 0xFF] ^ table[0][high >> 24];
+        data += 8;
+        size -= 8;
+    }
+    while (size--) c = table[0][(c ^ *data++) & 0xFF] ^ (c >> 8);
+    return ~c;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @file deflate.hpp
+ * @brief Defines a fast deflate compressor and the checksums used by PNG and zlib streams.
+ */
+
+/**
+ * @brief A fast deflate (RFC 1951) compressor tuned for image data, with greedy LZ77 matching and dynamic Huffman blocks.
+ * Streams produced from independent pieces of the input can be concatenated, which allows compressing large images in parallel bands,
+ * see `compress` with `final = false` and `adler32Combine`.
+ */
+namespace Deflate {
+
+    /**
+     * @brief Appends the raw deflate blocks of `data` to `out`.
+     * @param final Whether these are the last blocks of the stream. Otherwise they end with an empty stored block (a sync flush),
+     * so the next piece of the stream starts at a byte boundary and can be compressed independently.
+     */
+    void compress(const uint8_t* data, size_t size, bool final, std::vector<uint8_t>& out);
+
+    /**
+     * @brief Compresses data into a zlib (RFC 1950) stream, in parallel bands for large inputs.
+     */
+    std::vector<uint8_t> compressZlib(const uint8_t* data, size_t size);
+
+    /**
+     * @brief Updates an Adler-32 checksum as used by zlib, start with 1.
+     */
+    uint32_t adler32(const uint8_t* data, size_t size, uint32_t adler = 1);
+
+    /**
+     * @brief Combines the Adler-32 checksums of two consecutive pieces of data into the checksum of the whole.
+     * @param size2 The size of the second piece.
+     */
+    uint32_t adler32Combine(uint32_t adler1, uint32_t adler2, size_t size2);
+
+    /**
+     * @brief Updates a CRC-32 checksum as used by PNG, start with 0.
+     */
+    uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0);
+
+}
@@ -0,0 +1,168 @@
+#include "dynamicresolution.hpp"
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+
+#include "gl/state.hpp"
+
+using namespace glm;
+
+namespace {
+    const char* UPSCALE_VERTEX_SHADER = R"(#version 330 core
+layout (location = 0) in vec3 _position;
+out vec2 vUV;
+void main() {
+    vUV = _position.xy * 0.5 + 0.5;
+    gl_Position = vec4(_position, 1.0);
+}
+)";
+
+    const char* UPSCALE_FRAGMENT_SHADER = R"(#version 330 core
+in vec2 vUV;
+out vec4 fragColor;
+uniform sampler2D tColor;
+uniform vec2 uUVScale; // The rendered part of the target
+uniform vec2 uUVMax; // Center of the last rendered texel, the texels beyond hold older frames
+uniform vec2 uTexelSize;
+uniform float uSharpness;
+
+vec3 fetch(vec2 uv) {
+    return texture(tColor, min(uv, uUVMax)).rgb;
+}
+
+void main() {
+    vec2 uv = vUV * uUVScale;
+    vec3 center = fetch(uv);
+    if (uSharpness > 0.0) {
+        vec3 north = fetch(uv + vec2(0.0, uTexelSize.y));
+        vec3 south = fetch(uv - vec2(0.0, uTexelSize.y));
+        vec3 east = fetch(uv + vec2(uTexelSize.x, 0.0));
+        vec3 west = fetch(uv - vec2(uTexelSize.x, 0.0));
+        vec3 neighborhoodMin = min(min(min(north, south), min(east, west)), center);
+        vec3 neighborhoodMax = max(max(max(north, south), max(east, west)), center);
+        // Unsharp mask, clamped so that edges do not ring
+        vec3 blurred = (north + south + east + west) * 0.25;
+        center = clamp(center + uSharpness * (center - blurred), neighborhoodMin, neighborhoodMax);
+    }
+    fragColor = vec4(center, 1.0);
+}
+)";
+
+    /** Measurements of frames that took several times the budget, e.g. while shaders compile, are limited so they do not throw the scale to the minimum */
+    constexpr float MAX_ERROR = 1.0f;
+}
+
+DynamicResolution::DynamicResolution(GLenum colorFormat, GLenum depthFormat) : colorFormat(colorFormat), depthFormat(depthFormat) {
+    fullscreenTriangle.load(Mesh::FULLSCREEN_VERTICES, Mesh::FULLSCREEN_INDICES);
+    shader.loadSource(UPSCALE_VERTEX_SHADER, UPSCALE_FRAGMENT_SHADER);
+    shader.bindTextureUnit("tColor", 0);
+    uvScaleLocation = shader.uniform("uUVScale");
+    uvMaxLocation = shader.uniform("uUVMax");
+    texelSizeLocation = shader.uniform("uTexelSize");
+    sharpnessLocation = shader.uniform("uSharpness");
+}
+
+void DynamicResolution::resize(const ivec2& resolution) {
+    this->resolution = max(resolution, ivec2(1));
+    allocated = max(ivec2(vec2(this->resolution) * maxScale + 0.5f), ivec2(1));
+    scale = std::min(scale, maxScale);
+    // Immutable storage cannot be resized, so the textures are recreated
+    color = Texture<GL_TEXTURE_2D>();
+    color.allocate2D(colorFormat, allocated.x, allocated.y);
+    color.set(GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    color.set(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    color.set(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    color.set(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    depth = Texture<GL_TEXTURE_2D>();
+    depth.allocate2D(depthFormat, allocated.x, allocated.y);
+    depth.set(GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    depth.set(GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    framebuffer.attach(GL_COLOR_ATTACHMENT0, color);
+    framebuffer.attach(GL_DEPTH_ATTACHMENT, depth);
+    framebuffer.setDrawBuffers({GL_COLOR_ATTACHMENT0});
+    framebuffer.checkStatus();
+}
+
+void DynamicResolution::begin() {
+    // From the oldest to the newest query, without waiting for the ones that have not arrived
+    for (size_t i = 1; i <= QUERIES_IN_FLIGHT; i++) {
+        auto& measurement = measurements[(current + i) % QUERIES_IN_FLIGHT];
+        if (!measurement.pending || !measurement.query.isResultAvailable()) continue;
+        measurement.pending = false;
+        update(static_cast<float>(measurement.query.getResult64()) * 1e-6f, measurement.scale);
+    }
+    if (!enabled) scale = maxScale;
+
+    framebuffer.bind();
+    const ivec2 renderResolution = getRenderResolution();
+    GLState::viewport(0, 0, renderResolution.x, renderResolution.y);
+
+    // If the GPU is so far behind that every query is still pending, this frame is not measured
+    const size_t next = (current + 1) % QUERIES_IN_FLIGHT;
+    measuring = !measurements[next].pending;
+    if (!measuring) return;
+    current = next;
+    measurements[current].scale = scale;
+    measurements[current].pending = true;
+    measurements[current].query.begin(GL_TIME_ELAPSED);
+}
+
+void DynamicResolution::end() {
+    // The upscale runs at the window resolution whatever the scale, so it is not part of the measurement
+    if (measuring) measurements[current].query.endAsync(GL_TIME_ELAPSED);
+    measuring = false;
+
+    Framebuffer::bindDefault();
+    GLState::viewport(0, 0, resolution.x, resolution.y);
+    GLState::disable(GL_DEPTH_TEST);
+    GLState::depthMask(false);
+
+    const vec2 renderResolution(getRenderResolution());
+    const vec2 texelSize = 1.0f / vec2(allocated);
+    shader.use();
+    color.bindTextureUnit(0);
+    shader.set(uvScaleLocation, renderResolution * texelSize);
+    shader.set(uvMaxLocation, (renderResolution - 0.5f) * texelSize);
+    shader.set(texelSizeLocation, texelSize);
+    shader.set(sharpnessLocation, filter == Filter::Sharpened ? sharpness : 0.0f);
+    fullscreenTriangle.draw();
+
+    GLState::enable(GL_DEPTH_TEST);
+    GLState::depthMask(true);
+}
+
+void DynamicResolution::update(float milliseconds, float measuredScale) {
+    gpuMilliseconds = milliseconds;
+    if (!enabled) return;
+    // The time is roughly proportional to the number of pixels, so it is extrapolated from the scale the frame was rendered with
+    const float ratio = scale / measuredScale;
+    const float predicted = milliseconds * ratio * ratio;
+    const float error = std::clamp((targetMilliseconds - predicted) / targetMilliseconds, -MAX_ERROR, MAX_ERROR);
+    // Velocity form of the PID controller, which changes the scale by a step instead of setting it, so clamping it does not wind up the integral
+    const float step = proportionalGain * (error - lastError) + integralGain * error + derivativeGain * (error - 2.0f * lastError + secondLastError);
+    scale = std::clamp(scale + step, minScale, maxScale);
+    secondLastError = lastError;
+    lastError = error;
+}
+
+float DynamicResolution::getScale() const {
+    return scale;
+}
+
+ivec2 DynamicResolution::getRenderResolution() const {
+    return clamp(ivec2(vec2(resolution) * scale + 0.5f), ivec2(1), allocated);
+}
+
+float DynamicResolution::getGPUMilliseconds() const {
+    return gpuMilliseconds;
+}
+
+Texture<GL_TEXTURE_2D>& DynamicResolution::getColorTexture() {
+    return color;
+}
+
+Texture<GL_TEXTURE_2D>& DynamicResolution::getDepthTexture() {
+    return depth;
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstddef>
+
+#include "mesh.hpp"
+#include "gl/framebuffer.hpp"
+#include "gl/program.hpp"
+#include "gl/query.hpp"
+#include "gl/texture.hpp"
+
+/**
+ * @file dynamicresolution.hpp
+ * @brief Defines DynamicResolution, which adapts the resolution of the scene to a budget of GPU time.
+ */
+
+/**
+ * @class DynamicResolution
+ * @brief Renders the scene into an offscreen framebuffer at a fraction of the window resolution and upscales it to the default framebuffer.
+ * The GPU time between `begin` and `end` is measured with timer queries that are read without stalling, a PID controller then adjusts the scale so that the time meets the budget.
+ * The targets are allocated once at the largest scale in `resize` and smaller scales render into a part of them, so changing the scale never allocates.
+ * Example:
+ * ```cpp
+ * void resizeCallback(const vec2& resolution) override {
+ *     dynamicResolution.resize(ivec2(resolution));
+ * }
+ * void render() override {
+ *     dynamicResolution.begin(); // Binds the offscreen framebuffer with the viewport of the current scale
+ *     ... // Render the scene at dynamicResolution.getRenderResolution()
+ *     dynamicResolution.end(); // Upscales to the default framebuffer
+ * }
+ * ```
+ */
+class DynamicResolution {
+   public:
+    /**
+     * @brief The filter used to upscale to the window.
+     */
+    enum class Filter {
+        Bilinear,
+        /** Bilinear with an unsharp mask that is clamped to the neighborhood, restores some of the detail lost by the lower resolution */
+        Sharpened
+    };
+
+    /**
+     * @brief The number of timer queries, results arrive a few frames late and a query is only reused once its result was read.
+     */
+    static constexpr size_t QUERIES_IN_FLIGHT = 4;
+
+    /** Scale of the width and height, the number of pixels scales with its square */
+    float minScale = 0.5f;
+    float maxScale = 1.0f;
+    /** GPU time between `begin` and `end` that the controller aims for */
+    float targetMilliseconds = 12.0f;
+    /** Gains of the PID controller, the integral term moves the scale by `integralGain` per frame at an error of 100% */
+    float proportionalGain = 0.1f;
+    float integralGain = 0.03f;
+    float derivativeGain = 0.02f;
+    /** Keeps the scale fixed at `maxScale` if disabled */
+    bool enabled = true;
+    Filter filter = Filter::Sharpened;
+    /** Strength of `Filter::Sharpened`, 0 is bilinear */
+    float sharpness = 0.5f;
+
+    /**
+     * @brief Creates the upscaling shader.
+     * @param colorFormat The format of the offscreen color target, with `GL_SRGB8_ALPHA8` the output is encoded like the default framebuffer.
+     * @param depthFormat The format of the offscreen depth target.
+     */
+    explicit DynamicResolution(GLenum colorFormat = GL_SRGB8_ALPHA8, GLenum depthFormat = GL_DEPTH_COMPONENT32F);
+
+    /**
+     * @brief Allocates the targets for a window resolution, called from `App::resizeCallback`.
+     */
+    void resize(const glm::ivec2& resolution);
+
+    /**
+     * @brief Reads the timer queries that have arrived, updates the scale, then binds the offscreen framebuffer, sets the viewport and starts the measurement.
+     * Color and depth are not cleared.
+     */
+    void begin();
+
+    /**
+     * @brief Ends the measurement and upscales to the default framebuffer, which is bound afterwards with depth testing and writing enabled.
+     * @note The color texture is bound to texture unit 0.
+     */
+    void end();
+
+    /**
+     * @brief Gets the current scale of the width and height.
+     */
+    float getScale() const;
+
+    /**
+     * @brief Gets the size of the viewport the scene is rendered with in this frame.
+     */
+    glm::ivec2 getRenderResolution() const;
+
+    /**
+     * @brief Gets the GPU time of the last frame whose measurement arrived.
+     */
+    float getGPUMilliseconds() const;
+
+    Texture<GL_TEXTURE_2D>& getColorTexture();
+    Texture<GL_TEXTURE_2D>& getDepthTexture();
+
+   private:
+    void update(float milliseconds, float measuredScale);
+
+    struct Measurement {
+        Query query;
+        /** The scale the frame was rendered with, the time is extrapolated to the current scale */
+        float scale = 1.0f;
+        bool pending = false;
+    };
+
+    GLenum colorFormat;
+    GLenum depthFormat;
+    glm::ivec2 resolution = glm::ivec2(0);
+    /** The size of the targets, `resolution * maxScale` when they were allocated */
+    glm::ivec2 allocated = glm::ivec2(0);
+    float scale = 1.0f;
+    float gpuMilliseconds = 0.0f;
+    /** Errors of the last two measurements for the derivative */
+    float lastError = 0.0f;
+    float secondLastError = 0.0f;
+    std::array<Measurement, QUERIES_IN_FLIGHT> measurements;
+    size_t current = 0;
+    bool measuring = false;
+    Texture<GL_TEXTURE_2D> color;
+    Texture<GL_TEXTURE_2D> depth;
+    Framebuffer framebuffer;
+    Mesh fullscreenTriangle;
+    Program shader;
+    GLint uvScaleLocation = -1;
+    GLint uvMaxLocation = -1;
+    GLint texelSizeLocation = -1;
+    GLint sharpnessLocation = -1;
+};
@@ -0,0 +1,199 @@
+#include "exr.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "deflate.hpp"
+#include "pixelconvert.hpp"
+#include "threadpool.hpp"
+
+namespace {
+
+constexpr uint32_t MAGIC = 20000630;
+constexpr uint32_t VERSION = 2; // Single part scanline file without long names
+constexpr size_t BLOCK_HEADER_SIZE = 8; // The y coordinate and the data size of every block
+
+// OpenEXR files are little endian, like every platform the framework runs on
+template <typename T>
+void put(std::vector<uint8_t>& out, T value) {
+    const size_t offset = out.size();
+    out.resize(offset + sizeof(T));
+    std::memcpy(out.data() + offset, &value, sizeof(T));
+}
+
+void putAttribute(std::vector<uint8_t>& out, std::string_view name, std::string_view type, const std::vector<uint8_t>& value) {
+    out.insert(out.end(), name.begin(), name.end());
+    out.push_back(0);
+    out.insert(out.end(), type.begin(), type.end());
+    out.push_back(0);
+    put<int32_t>(out, static_cast<int32_t>(value.size()));
+    out.insert(out.end(), value.begin(), value.end());
+}
+
+int getLinesPerBlock(EXR::Compression compression) {
+    return compression == EXR::Compression::ZIP ? 16 : 1;
+}
+
+/**
+ * @brief Reorders the bytes into the even and then the odd ones and replaces them with their differences, the preprocessing of RLE and ZIP.
+ * This moves the exponent bytes of halfs and floats together and turns smooth gradients into long runs.
+ */
+void interleaveAndPredict(const uint8_t* in, size_t size, uint8_t* out) {
+    const size_t half = (size + 1) / 2;
+    for (size_t i = 0; i < half; i++) out[i] = in[2 * i];
+    for (size_t i = 0; i < size / 2; i++) out[half + i] = in[2 * i + 1];
+    // Backwards so the difference uses the previous input byte
+    for (size_t i = size - 1; i > 0; i--) out[i] = static_cast<uint8_t>(out[i] - out[i - 1] + 128);
+}
+
+/**
+ * @brief Run length encodes the bytes like OpenEXR, a positive count byte `n` repeats the next byte `n + 1` times and a negative `-n` copies `n` literal bytes.
+ */
+void compressRLE(const uint8_t* in, size_t size, std::vector<uint8_t>& out) {
+    constexpr ptrdiff_t MIN_RUN = 3, MAX_RUN = 127;
+    const uint8_t* end = in + size;
+    const uint8_t* runStart = in;
+    while (runStart < end) {
+        const uint8_t* runEnd = runStart + 1;
+        while (runEnd < end && *runEnd == *runStart && runEnd - runStart <= MAX_RUN) runEnd++;
+        if (runEnd - runStart >= MIN_RUN) {
+            out.push_back(static_cast<uint8_t>(runEnd - runStart - 1));
+            out.push_back(*runStart);
+        } else {
+            // Extend the literals until the next run of three equal bytes starts
+            while (runEnd < end && runEnd - runStart < MAX_RUN
+                   && (runEnd + 2 >= end || runEnd[0] != runEnd[1] || runEnd[1] != runEnd[2])) runEnd++;
+            out.push_back(static_cast<uint8_t>(-(runEnd - runStart)));
+            out.insert(out.end(), runStart, runEnd);
+        }
+        runStart = runEnd;
+    }
+}
+
+std::vector<std::vector<uint8_t>> encodeParts(const float* pixels, int width, int height, std::string_view channels,
+                                              EXR::PixelType type, EXR::Compression compression, bool bottomUp) {
+    if (channels.empty()) throw std::runtime_error("EXR images need at least one channel");
+    if (width <= 0 || height <= 0) throw std::runtime_error("EXR images cannot be empty");
+
+    // The channels are stored sorted by name
+    std::vector<size_t> order(channels.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return channels[a] < channels[b]; });
+    for (size_t i = 1; i < order.size(); i++) {
+        if (channels[order[i]] == channels[order[i - 1]]) throw std::runtime_error("EXR channel names must be unique");
+    }
+
+    std::vector<uint8_t> header;
+    put<uint32_t>(header, MAGIC);
+    put<uint32_t>(header, VERSION);
+
+    std::vector<uint8_t> value;
+    for (size_t channel : order) {
+        value.push_back(static_cast<uint8_t>(channels[channel]));
+        value.push_back(0);
+        put<int32_t>(value, static_cast<int32_t>(type));
+        put<uint32_t>(value, 0); // Not perceptually linear and reserved bytes
+        put<int32_t>(value, 1); // No subsampling
+        put<int32_t>(value, 1);
+    }
+    value.push_back(0);
+    putAttribute(header, "channels", "chlist", value);
+    putAttribute(header, "compression", "compression", {static_cast<uint8_t>(compression)});
+    value.clear();
+    for (int32_t coordinate : {0, 0, width - 1, height - 1}) put<int32_t>(value, coordinate);
+    putAttribute(header, "dataWindow", "box2i", value);
+    putAttribute(header, "displayWindow", "box2i", value);
+    putAttribute(header, "lineOrder", "lineOrder", {0}); // Increasing y
+    value.clear();
+    put<float>(value, 1.0f);
+    putAttribute(header, "pixelAspectRatio", "float", value);
+    putAttribute(header, "screenWindowWidth", "float", value);
+    value.clear();
+    put<float>(value, 0.0f);
+    put<float>(value, 0.0f);
+    putAttribute(header, "screenWindowCenter", "v2f", value);
+    header.push_back(0);
+
+    const int linesPerBlock = getLinesPerBlock(compression);
+    const size_t blocks = (height + linesPerBlock - 1) / linesPerBlock;
+    const size_t channelCount = channels.size();
+    const size_t valueSize = type == EXR::PixelType::HALF ? 2 : 4;
+    const size_t lineSize = width * channelCount * valueSize;
+
+    std::vector<std::vector<uint8_t>> parts(blocks + 1);
+    ThreadPool::global().parallelFor(0, blocks, [&](size_t block) {
+        const int firstLine = static_cast<int>(block) * linesPerBlock;
+        const int lines = std::min(linesPerBlock, height - firstLine);
+        const size_t rawSize = lines * lineSize;
+
+        // Scanlines store every channel contiguously
+        std::vector<uint8_t> raw(rawSize);
+        std::vector<float> channelLine(width);
+        for (int line = 0; line < lines; line++) {
+            const int y = firstLine + line;
+            const float* row = pixels + static_cast<size_t>(bottomUp ? height - 1 - y : y) * width * channelCount;
+            for (size_t i = 0; i < channelCount; i++) {
+                const size_t channel = order[i];
+                for (int x = 0; x < width; x++) channelLine[x] = row[x * channelCount + channel];
+                uint8_t* destination = raw.data() + line * lineSize + i * width * valueSize;
+                if (type == EXR::PixelType::HALF) PixelConvert::floatToHalf(channelLine.data(), reinterpret_cast<uint16_t*>(destination), width);
+                else std::memcpy(destination, channelLine.data(), width * sizeof(float));
+            }
+        }
+
+        std::vector<uint8_t> compressed;
+        if (compression != EXR::Compression::NONE) {
+            std::vector<uint8_t> predicted(rawSize);
+            interleaveAndPredict(raw.data(), rawSize, predicted.data());
+            if (compression == EXR::Compression::RLE) compressRLE(predicted.data(), rawSize, compressed);
+            else compressed = Deflate::compressZlib(predicted.data(), rawSize);
+        }
+        // Readers treat blocks that are not smaller than the raw data as uncompressed
+        const auto& data = !compressed.empty() && compressed.size() < rawSize ? compressed : raw;
+
+        auto& part = parts[block + 1];
+        part.reserve(BLOCK_HEADER_SIZE + data.size());
+        put<int32_t>(part, firstLine);
+        put<int32_t>(part, static_cast<int32_t>(data.size()));
+        part.insert(part.end(), data.begin(), data.end());
+    }, std::max(1, 16 / linesPerBlock));
+
+    uint64_t offset = header.size() + blocks * sizeof(uint64_t);
+    for (size_t block = 0; block < blocks; block++) {
+        put<uint64_t>(header, offset);
+        offset += parts[block + 1].size();
+    }
+    parts[0] = std::move(header);
+    return parts;
+}
+
+}
+
+std::vector<uint8_t> EXR::encode(const float* pixels, int width, int height, std::string_view channels,
+                                 PixelType type, Compression compression, bool bottomUp) {
+    auto parts = encodeParts(pixels, width, height, channels, type, compression, bottomUp);
+    size_t size = 0;
+    for (const auto& part : parts) size += part.size();
+    std::vector<uint8_t> result = std::move(parts[0]);
+    result.reserve(size);
+    for (size_t i = 1; i < parts.size(); i++) result.insert(result.end(), parts[i].begin(), parts[i].end());
+    return result;
+}
+
+bool EXR::write(const std::filesystem::path& filepath, const float* pixels, int width, int height, std::string_view channels,
+                PixelType type, Compression compression, bool bottomUp) {
+    auto parts = encodeParts(pixels, width, height, channels, type, compression, bottomUp);
+    std::ofstream file(filepath, std::ios::binary);
+    if (!file) return false;
+    for (const auto& part : parts) file.write(reinterpret_cast<const char*>(part.data()), static_cast<std::streamsize>(part.size()));
+    return static_cast<bool>(file);
+}
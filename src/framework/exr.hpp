@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+/**
+ * @file exr.hpp
+ * @brief Defines a dependency-light OpenEXR writer for lossless dumps of float render targets.
+ */
+
+/**
+ * @brief Writes single part scanline OpenEXR images with half or float channels.
+ * The image is split into blocks of scanlines as the compression method requires, the blocks are converted and compressed in parallel.
+ */
+namespace EXR {
+
+    /**
+     * @brief The type stored for every channel, `HALF` is exact for `GL_*16F` formats, `FLOAT` for `GL_*32F` and depth formats.
+     */
+    enum class PixelType {
+        HALF = 1,
+        FLOAT = 2,
+    };
+
+    /**
+     * @brief The lossless compression methods of the writer, the values match the OpenEXR compression attribute.
+     * `RLE` compresses one scanline per block and is fastest, `ZIP` compresses blocks of 16 scanlines with deflate and gives the smallest files.
+     */
+    enum class Compression {
+        NONE = 0,
+        RLE = 1,
+        ZIP = 3,
+    };
+
+    /**
+     * @brief Encodes an image into an OpenEXR file in memory.
+     * @param pixels The interleaved float pixels, `channels.size()` values per pixel.
+     * @param channels The name of every channel as a single letter, e.g. `"RGBA"`, `"RGB"`, `"Y"` for luminance or `"Z"` for depth.
+     * @param bottomUp Whether the first row of `pixels` is the bottom row of the image, as returned by `glReadPixels`.
+     * @throw `std::runtime_error` if there are no channels or a channel name is repeated.
+     */
+    std::vector<uint8_t> encode(const float* pixels, int width, int height, std::string_view channels,
+                                PixelType type = PixelType::HALF, Compression compression = Compression::ZIP, bool bottomUp = false);
+
+    /**
+     * @brief Encodes an image and writes it to an OpenEXR file, see `encode`.
+     * @return True if the file was written successfully.
+     */
+    bool write(const std::filesystem::path& filepath, const float* pixels, int width, int height, std::string_view channels,
+               PixelType type = PixelType::HALF, Compression compression = Compression::ZIP, bool bottomUp = false);
+
+}
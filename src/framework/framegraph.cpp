@@ -0,0 +1,334 @@
+#include "framegraph.hpp"
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "gl/state.hpp"
+
+////////////////////////////////////////// Builder //////////////////////////////////////////
+
+FrameGraphResource FrameGraph::Builder::create(const std::string& name, const FrameGraphTextureDesc& desc) {
+    graph.resources.push_back({name, desc});
+    graph.nodes.push_back({static_cast<uint32_t>(graph.resources.size() - 1)});
+    return static_cast<FrameGraphResource>(graph.nodes.size() - 1);
+}
+
+FrameGraphResource FrameGraph::Builder::read(FrameGraphResource resource) {
+    if (resource >= graph.nodes.size()) throw std::runtime_error("FrameGraph: Invalid resource handle");
+    auto& reads = graph.passes[pass].reads;
+    if (std::find(reads.begin(), reads.end(), resource) == reads.end()) reads.push_back(resource);
+    return resource;
+}
+
+FrameGraphResource FrameGraph::Builder::write(FrameGraphResource resource) {
+    if (resource >= graph.nodes.size()) throw std::runtime_error("FrameGraph: Invalid resource handle");
+    // Copied, since adding the new version below can reallocate the nodes
+    const auto node = graph.nodes[resource];
+    auto& passNode = graph.passes[pass];
+    if (node.producer >= 0) {
+        // Writing on top of existing content depends on the previous version
+        read(resource);
+    } else {
+        // Whether the target is cleared is decided at execution, so `setBackbufferClear` also applies to passes added before
+        passNode.firstWrites.push_back(resource);
+    }
+    graph.nodes.push_back({node.resource, static_cast<int32_t>(pass)});
+    auto version = static_cast<FrameGraphResource>(graph.nodes.size() - 1);
+    passNode.writes.push_back(version);
+    if (graph.resources[node.resource].imported) passNode.writesBackbuffer = true;
+    return version;
+}
+
+void FrameGraph::Builder::setSideEffect() {
+    graph.passes[pass].sideEffect = true;
+}
+
+////////////////////////////////////////// Resources //////////////////////////////////////////
+
+Texture<GL_TEXTURE_2D>& FrameGraph::Resources::getTexture(FrameGraphResource resource) const {
+    const auto& entry = graph.resources.at(graph.nodes.at(resource).resource);
+    if (entry.physical < 0) throw std::runtime_error("FrameGraph: Resource " + entry.name + " has no texture");
+    return graph.physicalTextures[entry.physical]->texture;
+}
+
+glm::ivec2 FrameGraph::Resources::getSize(FrameGraphResource resource) const {
+    return graph.resources.at(graph.nodes.at(resource).resource).size;
+}
+
+////////////////////////////////////////// FrameGraph //////////////////////////////////////////
+
+FrameGraph::FrameGraph() {
+    reset();
+}
+
+void FrameGraph::reset() {
+    passes.clear();
+    nodes.clear();
+    resources.clear();
+    physicalTextures.clear();
+    ResourceEntry entry;
+    entry.name = "Backbuffer";
+    entry.imported = true;
+    resources.push_back(entry);
+    nodes.push_back({0});
+    backbuffer = 0;
+    compiled = false;
+}
+
+void FrameGraph::addPass(const std::string& name, const SetupFunction& setup, const ExecuteFunction& execute) {
+    passes.emplace_back();
+    passes.back().name = name;
+    passes.back().execute = execute;
+    Builder builder(*this, static_cast<uint32_t>(passes.size() - 1));
+    setup(builder);
+    compiled = false;
+}
+
+FrameGraphResource FrameGraph::getBackbuffer() const {
+    return backbuffer;
+}
+
+void FrameGraph::setBackbufferClear(bool clear, const glm::vec4& color, float depth) {
+    auto& desc = resources[0].desc;
+    desc.clear = clear;
+    desc.clearColor = color;
+    desc.clearDepth = depth;
+}
+
+void FrameGraph::resize(const glm::vec2& newResolution) {
+    if (newResolution == resolution) return;
+    resolution = newResolution;
+    compiled = false;
+}
+
+static size_t textureBytes(GLenum internalFormat, glm::ivec2 size, GLint mipmaps) {
+    size_t bytes = 0;
+    for (GLint level = 0; level <= mipmaps; level++) {
+        bytes += static_cast<size_t>(size.x) * size.y * getBytesPerPixel(internalFormat);
+        size = glm::max(size / 2, glm::ivec2(1));
+    }
+    return bytes;
+}
+
+glm::ivec2 FrameGraph::resolveSize(const FrameGraphTextureDesc& desc) const {
+    if (desc.size.x > 0 && desc.size.y > 0) return desc.size;
+    return glm::max(glm::ivec2(resolution * desc.scale), glm::ivec2(1));
+}
+
+void FrameGraph::cull() {
+    for (auto& node : nodes) node.refCount = 0;
+    for (auto& pass : passes) {
+        // Passes without any writes only survive if they have side effects, the reads of culled passes do not keep their producers alive
+        pass.culled = pass.writes.empty() && !pass.sideEffect;
+        pass.refCount = static_cast<uint32_t>(pass.writes.size());
+        if (pass.culled) continue;
+        for (auto read : pass.reads) nodes[read].refCount++;
+    }
+
+    // Passes writing to the backbuffer or with side effects are the roots that keep the graph alive
+    std::vector<FrameGraphResource> unreferenced;
+    for (FrameGraphResource i = 0; i < nodes.size(); i++) {
+        if (nodes[i].refCount == 0 && nodes[i].producer >= 0 && !resources[nodes[i].resource].imported) unreferenced.push_back(i);
+    }
+    while (!unreferenced.empty()) {
+        auto node = unreferenced.back();
+        unreferenced.pop_back();
+        auto& producer = passes[nodes[node].producer];
+        if (--producer.refCount > 0 || producer.sideEffect || producer.writesBackbuffer) continue;
+        producer.culled = true;
+        for (auto read : producer.reads) {
+            if (--nodes[read].refCount == 0 && nodes[read].producer >= 0 && !resources[nodes[read].resource].imported) unreferenced.push_back(read);
+        }
+    }
+}
+
+void FrameGraph::computeLifetimes() {
+    for (auto& entry : resources) {
+        entry.firstPass = UINT32_MAX;
+        entry.lastPass = 0;
+        entry.physical = -1;
+        entry.size = entry.imported ? glm::ivec2(resolution) : resolveSize(entry.desc);
+    }
+    for (uint32_t i = 0; i < passes.size(); i++) {
+        if (passes[i].culled) continue;
+        auto touch = [&](FrameGraphResource resource) {
+            auto& entry = resources[nodes[resource].resource];
+            entry.firstPass = std::min(entry.firstPass, i);
+            entry.lastPass = std::max(entry.lastPass, i);
+        };
+        for (auto read : passes[i].reads) touch(read);
+        for (auto write : passes[i].writes) touch(write);
+    }
+}
+
+void FrameGraph::allocate() {
+    physicalTextures.clear();
+
+    // Resources are assigned in order of their first use, a physical texture can be reused as soon as its last user has executed
+    std::vector<uint32_t> order;
+    for (uint32_t i = 0; i < resources.size(); i++) {
+        if (!resources[i].imported && resources[i].firstPass != UINT32_MAX) order.push_back(i);
+    }
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return resources[a].firstPass < resources[b].firstPass; });
+
+    for (auto i : order) {
+        auto& entry = resources[i];
+        for (size_t p = 0; p < physicalTextures.size(); p++) {
+            auto& physical = *physicalTextures[p];
+            if (physical.lastPass < entry.firstPass && physical.internalFormat == entry.desc.internalFormat
+                && physical.size == entry.size && physical.mipmaps == entry.desc.mipmaps) {
+                entry.physical = static_cast<int32_t>(p);
+                physical.lastPass = entry.lastPass;
+                break;
+            }
+        }
+        if (entry.physical >= 0) continue;
+
+        auto physical = std::make_unique<PhysicalTexture>();
+        physical->internalFormat = entry.desc.internalFormat;
+        physical->size = entry.size;
+        physical->mipmaps = entry.desc.mipmaps;
+        physical->lastPass = entry.lastPass;
+        physical->texture.allocate2D(entry.desc.internalFormat, entry.size.x, entry.size.y, entry.desc.mipmaps);
+        physical->texture.set(GL_TEXTURE_MIN_FILTER, entry.desc.mipmaps > 0 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+        physical->texture.set(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        physical->texture.set(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        physical->texture.set(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        entry.physical = static_cast<int32_t>(physicalTextures.size());
+        physicalTextures.push_back(std::move(physical));
+    }
+}
+
+void FrameGraph::createFramebuffers() {
+    for (auto& pass : passes) {
+        pass.framebuffer.reset();
+        pass.viewport = glm::ivec2(resolution);
+        if (pass.culled || pass.writesBackbuffer || pass.writes.empty()) continue;
+
+        pass.framebuffer = std::make_unique<Framebuffer>();
+        std::vector<GLenum> drawBuffers;
+        bool first = true;
+        for (auto write : pass.writes) {
+            const auto& entry = resources[nodes[write].resource];
+            if (first) pass.viewport = entry.size;
+            else if (pass.viewport != entry.size) throw std::runtime_error("FrameGraph: Pass " + pass.name + " writes resources of different sizes");
+            first = false;
+
+            const auto& texture = physicalTextures[entry.physical]->texture;
+            GLenum attachment = getAttachment(entry.desc.internalFormat);
+            if (attachment == GL_COLOR_ATTACHMENT0) {
+                attachment += static_cast<GLenum>(drawBuffers.size());
+                drawBuffers.push_back(attachment);
+            }
+            pass.framebuffer->attach(attachment, texture);
+        }
+        if (drawBuffers.empty()) drawBuffers.push_back(GL_NONE);
+        pass.framebuffer->setDrawBuffers(drawBuffers);
+        pass.framebuffer->checkStatus();
+    }
+}
+
+void FrameGraph::compile() {
+    for (const auto& pass : passes) {
+        if (pass.writesBackbuffer && pass.writes.size() > 1)
+            throw std::runtime_error("FrameGraph: Pass " + pass.name + " writes to the backbuffer and to render targets");
+    }
+    cull();
+    computeLifetimes();
+    allocate();
+    createFramebuffers();
+    compiled = true;
+}
+
+void FrameGraph::clearTargets(const PassNode& pass) {
+    if (pass.firstWrites.empty()) return;
+#ifdef MODERN_GL
+    GLuint framebuffer = pass.framebuffer ? pass.framebuffer->handle : 0;
+#endif
+
+    // Clears respect the write masks
+    GLState::depthMask(true);
+    GLState::colorMask(true, true, true, true);
+
+    GLint drawBuffer = 0;
+    for (auto write : pass.writes) {
+        const auto& entry = resources[nodes[write].resource];
+        bool clear = entry.desc.clear && std::find_if(pass.firstWrites.begin(), pass.firstWrites.end(), [&](FrameGraphResource first) {
+            return nodes[first].resource == nodes[write].resource;
+        }) != pass.firstWrites.end();
+
+        if (entry.imported) {
+            if (!clear) continue;
+#ifdef MODERN_GL
+            glClearNamedFramebufferfv(framebuffer, GL_COLOR, 0, &entry.desc.clearColor[0]);
+            glClearNamedFramebufferfv(framebuffer, GL_DEPTH, 0, &entry.desc.clearDepth);
+#else
+            glClearBufferfv(GL_COLOR, 0, &entry.desc.clearColor[0]);
+            glClearBufferfv(GL_DEPTH, 0, &entry.desc.clearDepth);
+#endif
+        } else if (getAttachment(entry.desc.internalFormat) != GL_COLOR_ATTACHMENT0) {
+            if (!clear) continue;
+            bool stencil = getAttachment(entry.desc.internalFormat) == GL_DEPTH_STENCIL_ATTACHMENT;
+#ifdef MODERN_GL
+            if (stencil) glClearNamedFramebufferfi(framebuffer, GL_DEPTH_STENCIL, 0, entry.desc.clearDepth, 0);
+            else glClearNamedFramebufferfv(framebuffer, GL_DEPTH, 0, &entry.desc.clearDepth);
+#else
+            if (stencil) glClearBufferfi(GL_DEPTH_STENCIL, 0, entry.desc.clearDepth, 0);
+            else glClearBufferfv(GL_DEPTH, 0, &entry.desc.clearDepth);
+#endif
+        } else {
+            if (clear) {
+#ifdef MODERN_GL
+                glClearNamedFramebufferfv(framebuffer, GL_COLOR, drawBuffer, &entry.desc.clearColor[0]);
+#else
+                glClearBufferfv(GL_COLOR, drawBuffer, &entry.desc.clearColor[0]);
+#endif
+            }
+            drawBuffer++;
+        }
+    }
+}
+
+void FrameGraph::execute() {
+    if (!compiled) compile();
+
+    Resources access(*this);
+    for (const auto& pass : passes) {
+        if (pass.culled) continue;
+        if (pass.framebuffer) pass.framebuffer->bind();
+        else if (!pass.writes.empty()) Framebuffer::bindDefault();
+        if (!pass.writes.empty()) GLState::viewport(0, 0, pass.viewport.x, pass.viewport.y);
+        clearTargets(pass);
+        pass.execute(access);
+    }
+    Framebuffer::bindDefault();
+    GLState::viewport(0, 0, static_cast<GLsizei>(resolution.x), static_cast<GLsizei>(resolution.y));
+}
+
+size_t FrameGraph::numActivePasses() const {
+    return std::count_if(passes.begin(), passes.end(), [](const PassNode& pass) { return !pass.culled; });
+}
+
+size_t FrameGraph::numPhysicalTextures() const {
+    return physicalTextures.size();
+}
+
+size_t FrameGraph::physicalTextureBytes() const {
+    size_t bytes = 0;
+    for (const auto& physical : physicalTextures) bytes += textureBytes(physical->internalFormat, physical->size, physical->mipmaps);
+    return bytes;
+}
+
+size_t FrameGraph::virtualTextureBytes() const {
+    size_t bytes = 0;
+    for (const auto& entry : resources) {
+        if (entry.imported || entry.firstPass == UINT32_MAX) continue;
+        bytes += textureBytes(entry.desc.internalFormat, entry.size, entry.desc.mipmaps);
+    }
+    return bytes;
+}
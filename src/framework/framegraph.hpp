@@ -0,0 +1,247 @@
+#pragma once
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gl/framebuffer.hpp"
+#include "gl/texture.hpp"
+
+/**
+ * @file framegraph.hpp
+ * @brief Defines a FrameGraph that derives render targets, execution order and memory aliasing from declared pass dependencies.
+ */
+
+/**
+ * @brief Handle of a version of a virtual resource in a FrameGraph.
+ * Every write creates a new version, so a handle always refers to the content after a specific pass.
+ */
+using FrameGraphResource = uint32_t;
+
+/**
+ * @brief Describes a transient 2D render target of a FrameGraph.
+ */
+struct FrameGraphTextureDesc {
+    /** The internal format, depth formats are attached as depth (stencil) attachment, all others as color attachment */
+    GLenum internalFormat = GL_RGBA8;
+    /** Size relative to the resolution of the graph, only used if `size` is zero */
+    float scale = 1.0f;
+    /** Absolute size in pixels, zero to use the scaled resolution */
+    glm::ivec2 size = glm::ivec2(0);
+    /** The number of mipmaps to allocate in addition to the base level */
+    GLint mipmaps = 0;
+    /** Whether the first write clears the target, disable for passes that overwrite every pixel */
+    bool clear = true;
+    /** Clear value of color targets */
+    glm::vec4 clearColor = glm::vec4(0.0f);
+    /** Clear value of depth targets */
+    float clearDepth = 1.0f;
+};
+
+/**
+ * @class FrameGraph
+ * @brief Declarative description of a frame as passes that read and write virtual render targets.
+ * Passes are declared once with a setup function that declares the resources they create, read and write, and an execute function that issues the draw calls.
+ * When compiled, the graph
+ * - culls passes whose results are never read and that do not write to the backbuffer,
+ * - allocates one physical texture per group of resources with equal format and non-overlapping lifetimes (aliasing),
+ * - creates a framebuffer per pass from its written resources,
+ * - only clears a target on its first write.
+ * The graph recompiles lazily after `resize`, so render targets follow the window size automatically.
+ * Example:
+ * ```cpp
+ * FrameGraphResource gbuffer;
+ * graph.addPass("GBuffer", [&](FrameGraph::Builder& builder) {
+ *     gbuffer = builder.write(builder.create("Albedo", {GL_RGBA8}));
+ *     builder.write(builder.create("Depth", {GL_DEPTH_COMPONENT32F}));
+ * }, [&](const FrameGraph::Resources&) { mesh.draw(); });
+ * graph.addPass("Composite", [&](FrameGraph::Builder& builder) {
+ *     builder.read(gbuffer);
+ *     builder.write(graph.getBackbuffer());
+ * }, [&](const FrameGraph::Resources& resources) {
+ *     resources.getTexture(gbuffer).bindTextureUnit(0);
+ *     fullscreenTriangle.draw();
+ * });
+ * graph.resize(resolution);
+ * graph.execute(); // Every frame
+ * ```
+ */
+class FrameGraph {
+   public:
+    /**
+     * @brief Declares the resources used by a pass, passed to the setup function of `addPass`.
+     */
+    class Builder {
+       public:
+        /**
+         * @brief Creates a new transient render target, it has to be written before it can be read.
+         */
+        FrameGraphResource create(const std::string& name, const FrameGraphTextureDesc& desc);
+
+        /**
+         * @brief Declares that the pass samples the resource.
+         */
+        FrameGraphResource read(FrameGraphResource resource);
+
+        /**
+         * @brief Declares that the pass renders into the resource.
+         * @return The new version of the resource that later passes have to read.
+         */
+        FrameGraphResource write(FrameGraphResource resource);
+
+        /**
+         * @brief Marks the pass as having side effects, e.g. writing a file, so it is never culled.
+         */
+        void setSideEffect();
+
+       private:
+        friend class FrameGraph;
+        Builder(FrameGraph& graph, uint32_t pass) : graph(graph), pass(pass) {}
+        FrameGraph& graph;
+        uint32_t pass;
+    };
+
+    /**
+     * @brief Gives the execute function of a pass access to the physical resources.
+     */
+    class Resources {
+       public:
+        /**
+         * @brief Gets the physical texture of a resource, only valid during the execution of the pass.
+         * @throw `std::runtime_error` for the backbuffer, which has no texture.
+         */
+        Texture<GL_TEXTURE_2D>& getTexture(FrameGraphResource resource) const;
+
+        /**
+         * @brief Gets the size of a resource in pixels.
+         */
+        glm::ivec2 getSize(FrameGraphResource resource) const;
+
+       private:
+        friend class FrameGraph;
+        explicit Resources(const FrameGraph& graph) : graph(graph) {}
+        const FrameGraph& graph;
+    };
+
+    using SetupFunction = std::function<void(Builder&)>;
+    using ExecuteFunction = std::function<void(const Resources&)>;
+
+    FrameGraph();
+
+    /**
+     * @brief Adds a pass, the setup function is called immediately.
+     * Passes are executed in the order they are added, which is always a valid order as a pass can only read resources that were declared before.
+     */
+    void addPass(const std::string& name, const SetupFunction& setup, const ExecuteFunction& execute);
+
+    /**
+     * @brief Gets the handle of the default framebuffer, passes writing to it are never culled.
+     */
+    FrameGraphResource getBackbuffer() const;
+
+    /**
+     * @brief Sets whether and how the first pass writing to the backbuffer clears its color and depth, takes effect on the next `execute`.
+     */
+    void setBackbufferClear(bool clear, const glm::vec4& color = glm::vec4(0.0f), float depth = 1.0f);
+
+    /**
+     * @brief Sets the resolution that relative render target sizes are based on, the graph is recompiled on the next `execute`.
+     */
+    void resize(const glm::vec2& resolution);
+
+    /**
+     * @brief Culls passes, computes lifetimes, allocates the aliased physical textures and creates the framebuffers.
+     * Called automatically by `execute` when the graph changed.
+     */
+    void compile();
+
+    /**
+     * @brief Executes all passes that were not culled.
+     */
+    void execute();
+
+    /**
+     * @brief Removes all passes and resources and frees the physical textures.
+     */
+    void reset();
+
+    /**
+     * @brief The number of passes that are executed.
+     */
+    size_t numActivePasses() const;
+
+    /**
+     * @brief The number of physical textures after aliasing.
+     */
+    size_t numPhysicalTextures() const;
+
+    /**
+     * @brief The number of bytes of all physical textures, see `numPhysicalTextures`.
+     */
+    size_t physicalTextureBytes() const;
+
+    /**
+     * @brief The number of bytes all virtual resources would occupy without aliasing.
+     */
+    size_t virtualTextureBytes() const;
+
+   private:
+    struct ResourceEntry {
+        std::string name;
+        FrameGraphTextureDesc desc;
+        bool imported = false;
+        glm::ivec2 size = glm::ivec2(0);
+        uint32_t firstPass = UINT32_MAX;
+        uint32_t lastPass = 0;
+        int32_t physical = -1;
+    };
+
+    struct ResourceNode {
+        uint32_t resource;
+        int32_t producer = -1;
+        uint32_t refCount = 0;
+    };
+
+    struct PassNode {
+        std::string name;
+        ExecuteFunction execute;
+        std::vector<FrameGraphResource> reads;
+        std::vector<FrameGraphResource> writes;
+        /** Resources whose first write is in this pass, cleared if their description asks for it */
+        std::vector<FrameGraphResource> firstWrites;
+        bool sideEffect = false;
+        bool culled = false;
+        uint32_t refCount = 0;
+        bool writesBackbuffer = false;
+        std::unique_ptr<Framebuffer> framebuffer;
+        glm::ivec2 viewport = glm::ivec2(0);
+    };
+
+    struct PhysicalTexture {
+        GLenum internalFormat;
+        glm::ivec2 size;
+        GLint mipmaps;
+        uint32_t lastPass;
+        Texture<GL_TEXTURE_2D> texture;
+    };
+
+    glm::ivec2 resolveSize(const FrameGraphTextureDesc& desc) const;
+    void cull();
+    void computeLifetimes();
+    void allocate();
+    void createFramebuffers();
+    void clearTargets(const PassNode& pass);
+
+    std::vector<ResourceEntry> resources;
+    std::vector<ResourceNode> nodes;
+    std::vector<PassNode> passes;
+    std::vector<std::unique_ptr<PhysicalTexture>> physicalTextures;
+    FrameGraphResource backbuffer;
+    glm::vec2 resolution = glm::vec2(1.0f);
+    bool compiled = false;
+};
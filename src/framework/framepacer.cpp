@@ -0,0 +1,108 @@
+#include "framepacer.hpp"
+
+#include <glad/gl.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+#include "trace.hpp"
+
+namespace {
+    /** The waits are split into slices of a second so a lost context does not block forever */
+    constexpr GLuint64 WAIT_TIMEOUT = 1000000000;
+
+    /**
+     * @brief Waits until the fence is signaled, with a zero timeout only checks it.
+     * @return false if the fence has not been signaled before the timeout.
+     */
+    bool waitFence(GLsync fence, bool block) {
+        while (true) {
+            const GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, block ? WAIT_TIMEOUT : 0);
+            if (result != GL_TIMEOUT_EXPIRED) return true; // Signaled or failed, in both cases there is nothing left to wait for
+            if (!block) return false;
+        }
+    }
+
+    double milliseconds(std::chrono::steady_clock::duration duration) {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    }
+}
+
+FramePacer::~FramePacer() {
+    finish();
+}
+
+void FramePacer::beginFrame() {
+    auto start = Clock::now();
+    {
+        TRACE_ZONE("Wait for GPU");
+        // Frames that completed are dropped without waiting
+        while (!fences.empty() && waitFence(fences.front(), false)) {
+            glDeleteSync(fences.front());
+            fences.pop_front();
+        }
+        framesInFlight = fences.size();
+        while (maxFramesInFlight > 0 && fences.size() >= maxFramesInFlight) {
+            waitFence(fences.front(), true);
+            glDeleteSync(fences.front());
+            fences.pop_front();
+        }
+    }
+    auto end = Clock::now();
+    gpuWaits.push(milliseconds(end - start));
+
+    start = end;
+    if (maxFramesPerSecond > 0.0f) {
+        TRACE_ZONE("Frame rate cap");
+        const auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / maxFramesPerSecond));
+        if (start > deadline + period) {
+            // More than a frame late, e.g. after a stall, so the following frames do not catch up in a burst
+            deadline = start;
+        } else {
+            const auto spin = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(spinMilliseconds));
+            std::this_thread::sleep_until(deadline - spin);
+            while (Clock::now() < deadline) std::this_thread::yield();
+        }
+        deadline += period;
+        end = Clock::now();
+    }
+    capWaits.push(milliseconds(end - start));
+}
+
+void FramePacer::markInputSampled() {
+    inputSampled = Clock::now();
+}
+
+void FramePacer::endFrame() {
+    fences.push_back(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+    const auto now = Clock::now();
+    latencies.push(milliseconds(now - inputSampled));
+    if (lastSwap != Clock::time_point()) {
+        const double interval = milliseconds(now - lastSwap);
+        intervals.push(interval);
+        squaredIntervals.push(interval * interval);
+    }
+    lastSwap = now;
+}
+
+void FramePacer::finish() {
+    for (const auto fence : fences) {
+        waitFence(fence, true);
+        glDeleteSync(fence);
+    }
+    fences.clear();
+}
+
+FramePacer::Stats FramePacer::getStats() const {
+    Stats stats;
+    stats.inputLatency = static_cast<float>(latencies.avg);
+    stats.frameTime = static_cast<float>(intervals.avg);
+    // The variance is the mean of the squares minus the square of the mean, rounding can make it slightly negative
+    stats.jitter = static_cast<float>(std::sqrt(std::max(0.0, squaredIntervals.avg - intervals.avg * intervals.avg)));
+    stats.gpuWait = static_cast<float>(gpuWaits.avg);
+    stats.capWait = static_cast<float>(capWaits.avg);
+    stats.framesInFlight = framesInFlight;
+    return stats;
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <glad/gl.h>
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+
+#include "series.hpp"
+
+/**
+ * @file framepacer.hpp
+ * @brief Defines FramePacer, which limits how far the CPU runs ahead of the GPU and the frame rate.
+ */
+
+/**
+ * @class FramePacer
+ * @brief Paces the frames of `App::run` and measures the latency from input to submission and the jitter of the frame intervals.
+ * Without a limit the driver queues several frames, so the input of a frame is shown a few frames after it was sampled.
+ * A fence after every swap lets `beginFrame` wait until at most `maxFramesInFlight - 1` earlier frames are still pending on the GPU.
+ * The waits happen before the events are polled, so the input is sampled as late as possible before the frame is rendered.
+ * Example:
+ * ```cpp
+ * while (running) {
+ *     pacer.beginFrame(); // Waits for the GPU and the frame rate cap
+ *     glfwPollEvents();
+ *     pacer.markInputSampled();
+ *     ... // Render
+ *     glfwSwapBuffers(window);
+ *     pacer.endFrame(); // Inserts the fence of this frame
+ * }
+ * ```
+ */
+class FramePacer {
+   public:
+    /** Number of frames the statistics are averaged over */
+    static constexpr size_t STATISTICS_FRAMES = 120;
+
+    struct Stats {
+        /** Average time in milliseconds from polling the events to the return of the swap */
+        float inputLatency = 0.0f;
+        /** Average time in milliseconds between the swaps of two frames */
+        float frameTime = 0.0f;
+        /** Standard deviation of the time between swaps in milliseconds */
+        float jitter = 0.0f;
+        /** Average time in milliseconds `beginFrame` waited for the GPU */
+        float gpuWait = 0.0f;
+        /** Average time in milliseconds `beginFrame` waited for the frame rate cap */
+        float capWait = 0.0f;
+        /** Frames submitted but not yet completed by the GPU when the last frame started */
+        size_t framesInFlight = 0;
+    };
+
+    /** The number of frames that may be queued on the GPU, including the one being rendered, 0 does not limit */
+    unsigned int maxFramesInFlight = 2;
+    /** Caps the frame rate if greater than zero */
+    float maxFramesPerSecond = 0.0f;
+    /** The cap sleeps until this long before the start of the frame and spins for the rest, since sleeps overshoot by up to the timer resolution of the OS */
+    float spinMilliseconds = 2.0f;
+
+    FramePacer() = default;
+
+    FramePacer(const FramePacer&) = delete;
+    FramePacer& operator=(const FramePacer&) = delete;
+    FramePacer(FramePacer&&) = delete;
+    FramePacer& operator=(FramePacer&&) = delete;
+
+    /**
+     * @brief Calls `finish`, the context must still be current.
+     */
+    ~FramePacer();
+
+    /**
+     * @brief Waits until the number of frames in flight is below `maxFramesInFlight`, then until the start of the frame allowed by `maxFramesPerSecond`.
+     */
+    void beginFrame();
+
+    /**
+     * @brief Marks the time the input of the frame was sampled, called after polling the events.
+     */
+    void markInputSampled();
+
+    /**
+     * @brief Inserts a fence after the commands of the frame and records its latency and interval, called after swapping the buffers.
+     */
+    void endFrame();
+
+    /**
+     * @brief Waits for the frames in flight and deletes their fences, called before the context is destroyed.
+     */
+    void finish();
+
+    Stats getStats() const;
+
+   private:
+    using Clock = std::chrono::steady_clock;
+
+    /** Fences of the frames in flight, oldest first */
+    std::deque<GLsync> fences;
+    size_t framesInFlight = 0;
+    /** The earliest start of the next frame under the frame rate cap */
+    Clock::time_point deadline;
+    Clock::time_point inputSampled;
+    Clock::time_point lastSwap;
+    Series<double, STATISTICS_FRAMES> latencies;
+    Series<double, STATISTICS_FRAMES> intervals;
+    /** Squares of the intervals for their variance */
+    Series<double, STATISTICS_FRAMES> squaredIntervals;
+    Series<double, STATISTICS_FRAMES> gpuWaits;
+    Series<double, STATISTICS_FRAMES> capWaits;
+};
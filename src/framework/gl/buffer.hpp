@@ -2,8 +2,12 @@
 
 #include <glad/gl.h>
 
+#include <string>
 #include <vector>
 
+#include "gpumemory.hpp"
+#include "state.hpp"
+
 /**
  * @file buffer.hpp
  * @brief Defines a Buffer class wrapper around the OpenGL buffer object.
@@ -12,6 +16,7 @@
 /**
  * @class Buffer
  * @brief RAII wrapper for OpenGL buffer with helper functions for loading and setting data.
+ * The size of the data store is recorded in the `GPUMemory` registry.
  * See https://www.khronos.org/opengl/wiki/Buffer_Object for more information.
  * @tparam target The target/type for which the buffer should be created, e.g. `GL_ARRAY_BUFFER`, `GL_ELEMENT_ARRAY_BUFFER`, `GL_UNIFORM_BUFFER`, `GL_SHADER_STORAGE_BUFFER`.
  */
@@ -137,6 +142,11 @@ class Buffer {
      */
     void allocate(GLsizeiptr size, GLenum usage = GL_STATIC_DRAW);
 
+    /**
+     * @brief Sets the name of the buffer shown in the `GPUMemory` statistics and in OpenGL debuggers.
+     */
+    void setLabel(const std::string& label);
+
     /**
      * @brief The unique handle that identifies the buffer object on the GPU.
      */
@@ -178,7 +188,11 @@ Buffer<target>::~Buffer() {
 
 template <GLenum target>
 void Buffer<target>::release() {
-    if (handle) glDeleteBuffers(1, &handle);
+    if (handle) {
+        GLState::forgetBuffer(handle);
+        GPUMemory::releaseBuffer(handle);
+        glDeleteBuffers(1, &handle);
+    }
 }
 /////////////////////////////////////////////////////////////
 
@@ -189,7 +203,7 @@ void Buffer<target>::bind() {
 
 template <GLenum target>
 void Buffer<target>::bind(GLuint index) {
-    glBindBufferBase(target, index, handle);
+    GLState::bindBufferBase(target, index, handle);
 }
 
 template <GLenum target>
@@ -200,6 +214,7 @@ void Buffer<target>::_load(GLsizeiptr size, const GLvoid* data, GLenum usage) {
     bind();
     glBufferData(target, size, data, usage);
 #endif
+    GPUMemory::recordBuffer(handle, target, size, usage);
 }
 
 template <GLenum target>
@@ -220,6 +235,12 @@ void Buffer<target>::allocate(GLsizeiptr size, GLenum usage) {
     bind();
     glBufferData(target, size, nullptr, usage);
 #endif
+    GPUMemory::recordBuffer(handle, target, size, usage);
+}
+
+template <GLenum target>
+void Buffer<target>::setLabel(const std::string& label) {
+    GPUMemory::setLabel(GL_BUFFER, handle, label);
 }
 
 template <GLenum target>
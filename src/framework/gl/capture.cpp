@@ -0,0 +1,729 @@
+#include "capture.hpp"
+
+#include <glad/gl.h>
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "framework/common.hpp"
+#include "framework/gl/validation.hpp"
+
+namespace {
+    const char MAGIC[] = "GLCAPTURE";
+    constexpr uint32_t VERSION = 1;
+
+    /** Records start with a tag, tags from `FIRST_CALL` on are calls of the function defined with `tag - FIRST_CALL` */
+    enum Tag : uint16_t { FRAME, DEFINE, FIRST_CALL };
+
+    constexpr uint32_t NULL_DATA = 0xFFFFFFFF;
+    /** Data is aligned in the file so that the replay can pass it to the driver without copies */
+    constexpr size_t DATA_ALIGNMENT = 8;
+
+    /** Padding at `offset` so that the data after a prefix of `prefix` bytes is aligned */
+    size_t getPadding(size_t offset, size_t prefix) {
+        return (DATA_ALIGNMENT - (offset + prefix) % DATA_ALIGNMENT) % DATA_ALIGNMENT;
+    }
+    constexpr size_t MAX_ARGUMENTS = 16;
+
+    /**
+     * Each character of a signature describes one argument:
+     * 'i' 32-bit integer or enum, 'f' float, 'l' 64-bit integer, 'o' pointer kept as its value, e.g. an offset into a bound buffer,
+     * 'b' pointer to data whose size is given by `Function::size`, 'c' shader source strings with their count in the previous argument,
+     * 'a' array of names of `Function::names` with their count in the previous argument, and upper case letters are names of objects.
+     */
+    constexpr std::string_view OBJECT_KINDS = "BTFVQPRY"; // Buffer, texture, framebuffer, vertex array, query, shader or program, renderbuffer, sync
+
+    int getObjectKind(char code) {
+        const auto index = OBJECT_KINDS.find(code);
+        return index == std::string_view::npos ? -1 : static_cast<int>(index);
+    }
+
+    /** The decoded arguments of a call on replay */
+    struct Call {
+        const uint64_t* arguments;
+        std::string_view signature;
+        char names;
+        std::vector<std::vector<uint64_t>>& objects;
+
+        GLuint i(size_t n) const { return static_cast<GLuint>(arguments[n]); }
+        GLfloat f(size_t n) const {
+            GLfloat value;
+            const auto bits = static_cast<uint32_t>(arguments[n]);
+            std::memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+        int64_t l(size_t n) const { return static_cast<int64_t>(arguments[n]); }
+        const void* p(size_t n) const { return reinterpret_cast<const void*>(arguments[n]); }
+        template<typename T> const T* array(size_t n) const { return static_cast<const T*>(p(n)); }
+        /** The size of a data argument, stored in front of its data */
+        uint32_t size(size_t n) const {
+            uint32_t size;
+            std::memcpy(&size, static_cast<const char*>(p(n)) - sizeof(size), sizeof(size));
+            return size;
+        }
+        uint64_t result() const { return arguments[signature.size()]; }
+
+        /** Names without a mapping are passed through, e.g. 0 or objects created outside of the capture */
+        uint64_t map(char kind, uint64_t recorded) const {
+            const auto& mapping = objects[getObjectKind(kind)];
+            return recorded < mapping.size() && mapping[recorded] ? mapping[recorded] : recorded;
+        }
+        GLuint h(size_t n) const { return static_cast<GLuint>(map(signature[n], arguments[n])); }
+        /** Unlike names, syncs without a mapping are null, e.g. fences recorded as unknown or already deleted */
+        GLsync sync(size_t n) const {
+            const auto& mapping = objects[getObjectKind('Y')];
+            return reinterpret_cast<GLsync>(arguments[n] < mapping.size() ? mapping[arguments[n]] : 0);
+        }
+        void bind(char kind, uint64_t recorded, uint64_t actual) const {
+            auto& mapping = objects[getObjectKind(kind)];
+            if (recorded >= mapping.size()) mapping.resize(recorded + 1, 0);
+            mapping[recorded] = actual;
+        }
+    };
+
+    /** Calls `glGen*` or `glCreate*` for the names in argument `n` and maps them to the ones created now */
+    template<typename F>
+    void generate(const Call& call, size_t n, F function) {
+        const GLsizei count = static_cast<GLsizei>(call.i(n - 1));
+        std::vector<GLuint> created(count);
+        function(count, created.data());
+        const auto recorded = call.array<GLuint>(n);
+        for (GLsizei i = 0; i < count; i++) call.bind(call.names, recorded[i], created[i]);
+    }
+
+    /** Calls `glDelete*` for the mapped names in argument `n` */
+    template<typename F>
+    void remove(const Call& call, size_t n, F function) {
+        const GLsizei count = static_cast<GLsizei>(call.i(n - 1));
+        std::vector<GLuint> mapped(count);
+        const auto recorded = call.array<GLuint>(n);
+        for (GLsizei i = 0; i < count; i++) mapped[i] = static_cast<GLuint>(call.map(call.names, recorded[i]));
+        function(count, mapped.data());
+    }
+
+    struct Function {
+        const char* name;
+        std::string_view signature;
+        void (*replay)(const Call& call);
+        /** Bytes read by the data argument `index` given all arguments */
+        size_t (*size)(const uint64_t* arguments, size_t index) = nullptr;
+        /** Kind of the names in an 'a' argument */
+        char names = 0;
+        /** Kind of the name returned by the function */
+        char result = 0;
+    };
+
+    GLint unpackAlignment = 4;
+
+    size_t getPixelSize(GLenum format, GLenum type) {
+        switch (type) {
+            case GL_UNSIGNED_BYTE_3_3_2:
+            case GL_UNSIGNED_BYTE_2_3_3_REV:
+                return 1;
+            case GL_UNSIGNED_SHORT_5_6_5:
+            case GL_UNSIGNED_SHORT_5_6_5_REV:
+            case GL_UNSIGNED_SHORT_4_4_4_4:
+            case GL_UNSIGNED_SHORT_4_4_4_4_REV:
+            case GL_UNSIGNED_SHORT_5_5_5_1:
+            case GL_UNSIGNED_SHORT_1_5_5_5_REV:
+                return 2;
+            case GL_UNSIGNED_INT_8_8_8_8:
+            case GL_UNSIGNED_INT_8_8_8_8_REV:
+            case GL_UNSIGNED_INT_10_10_10_2:
+            case GL_UNSIGNED_INT_2_10_10_10_REV:
+            case GL_UNSIGNED_INT_24_8:
+            case GL_UNSIGNED_INT_10F_11F_11F_REV:
+            case GL_UNSIGNED_INT_5_9_9_9_REV:
+                return 4;
+            case GL_FLOAT_32_UNSIGNED_INT_24_8_REV:
+                return 8;
+        }
+        size_t components;
+        switch (format) {
+            case GL_RG:
+            case GL_RG_INTEGER:
+            case GL_DEPTH_STENCIL:
+                components = 2;
+                break;
+            case GL_RGB:
+            case GL_BGR:
+            case GL_RGB_INTEGER:
+            case GL_BGR_INTEGER:
+                components = 3;
+                break;
+            case GL_RGBA:
+            case GL_BGRA:
+            case GL_RGBA_INTEGER:
+            case GL_BGRA_INTEGER:
+                components = 4;
+                break;
+            default:
+                components = 1;
+        }
+        switch (type) {
+            case GL_UNSIGNED_SHORT:
+            case GL_SHORT:
+            case GL_HALF_FLOAT:
+                return components * 2;
+            case GL_UNSIGNED_INT:
+            case GL_INT:
+            case GL_FLOAT:
+                return components * 4;
+            default:
+                return components;
+        }
+    }
+
+    /** Rows are padded to `GL_UNPACK_ALIGNMENT` except the last one, which is not read beyond its pixels */
+    size_t getImageSize(uint64_t width, uint64_t height, uint64_t depth, uint64_t format, uint64_t type) {
+        const size_t rows = height * depth;
+        if (width == 0 || rows == 0) return 0;
+        const size_t row = width * getPixelSize(static_cast<GLenum>(format), static_cast<GLenum>(type));
+        const size_t alignment = static_cast<size_t>(unpackAlignment);
+        const size_t stride = (row + alignment - 1) / alignment * alignment;
+        return (rows - 1) * stride + row;
+    }
+
+    template<size_t COMPONENTS>
+    size_t uniformSize(const uint64_t* a, size_t) { return a[2] * COMPONENTS * sizeof(GLfloat); }
+
+    template<size_t COUNT>
+    size_t argumentSize(const uint64_t* a, size_t) { return a[COUNT]; }
+
+    size_t clearValueSize(GLenum buffer) { return buffer == GL_COLOR ? 4 * sizeof(GLfloat) : sizeof(GLfloat); }
+
+    // Signatures follow the OpenGL 4.6 core profile, only functions the framework uses and a few companions are supported
+    const Function FUNCTIONS[] = {
+        // State
+        {"glEnable", "i", [](const Call& c) { glEnable(c.i(0)); }},
+        {"glDisable", "i", [](const Call& c) { glDisable(c.i(0)); }},
+        {"glViewport", "iiii", [](const Call& c) { glViewport(c.i(0), c.i(1), c.i(2), c.i(3)); }},
+        {"glDepthMask", "i", [](const Call& c) { glDepthMask(static_cast<GLboolean>(c.i(0))); }},
+        {"glDepthFunc", "i", [](const Call& c) { glDepthFunc(c.i(0)); }},
+        {"glCullFace", "i", [](const Call& c) { glCullFace(c.i(0)); }},
+        {"glColorMask", "iiii", [](const Call& c) { glColorMask(static_cast<GLboolean>(c.i(0)), static_cast<GLboolean>(c.i(1)), static_cast<GLboolean>(c.i(2)), static_cast<GLboolean>(c.i(3))); }},
+        {"glBlendFunc", "ii", [](const Call& c) { glBlendFunc(c.i(0), c.i(1)); }},
+        {"glClear", "i", [](const Call& c) { glClear(c.i(0)); }},
+        {"glPixelStorei", "ii", [](const Call& c) { glPixelStorei(c.i(0), c.i(1)); }},
+        {"glActiveTexture", "i", [](const Call& c) { glActiveTexture(c.i(0)); }},
+        {"glReadBuffer", "i", [](const Call& c) { glReadBuffer(c.i(0)); }},
+        {"glFlush", "", [](const Call&) { glFlush(); }},
+        {"glFinish", "", [](const Call&) { glFinish(); }},
+        // Buffers
+        {"glGenBuffers", "ia", [](const Call& c) { generate(c, 1, glGenBuffers); }, nullptr, 'B'},
+        {"glCreateBuffers", "ia", [](const Call& c) { generate(c, 1, glCreateBuffers); }, nullptr, 'B'},
+        {"glDeleteBuffers", "ia", [](const Call& c) { remove(c, 1, glDeleteBuffers); }, nullptr, 'B'},
+        {"glBindBuffer", "iB", [](const Call& c) { glBindBuffer(c.i(0), c.h(1)); }},
+        {"glBindBufferBase", "iiB", [](const Call& c) { glBindBufferBase(c.i(0), c.i(1), c.h(2)); }},
+        {"glBindBufferRange", "iiBll", [](const Call& c) { glBindBufferRange(c.i(0), c.i(1), c.h(2), c.l(3), c.l(4)); }},
+        {"glBufferData", "ilbi", [](const Call& c) { glBufferData(c.i(0), c.l(1), c.p(2), c.i(3)); }, argumentSize<1>},
+        {"glNamedBufferData", "Blbi", [](const Call& c) { glNamedBufferData(c.h(0), c.l(1), c.p(2), c.i(3)); }, argumentSize<1>},
+        {"glBufferSubData", "illb", [](const Call& c) { glBufferSubData(c.i(0), c.l(1), c.l(2), c.p(3)); }, argumentSize<2>},
+        {"glNamedBufferSubData", "Bllb", [](const Call& c) { glNamedBufferSubData(c.h(0), c.l(1), c.l(2), c.p(3)); }, argumentSize<2>},
+        // Vertex arrays
+        {"glGenVertexArrays", "ia", [](const Call& c) { generate(c, 1, glGenVertexArrays); }, nullptr, 'V'},
+        {"glCreateVertexArrays", "ia", [](const Call& c) { generate(c, 1, glCreateVertexArrays); }, nullptr, 'V'},
+        {"glDeleteVertexArrays", "ia", [](const Call& c) { remove(c, 1, glDeleteVertexArrays); }, nullptr, 'V'},
+        {"glBindVertexArray", "V", [](const Call& c) { glBindVertexArray(c.h(0)); }},
+        {"glEnableVertexAttribArray", "i", [](const Call& c) { glEnableVertexAttribArray(c.i(0)); }},
+        {"glVertexAttribPointer", "iiiiio", [](const Call& c) { glVertexAttribPointer(c.i(0), c.i(1), c.i(2), static_cast<GLboolean>(c.i(3)), c.i(4), c.p(5)); }},
+        {"glEnableVertexArrayAttrib", "Vi", [](const Call& c) { glEnableVertexArrayAttrib(c.h(0), c.i(1)); }},
+        {"glVertexArrayAttribFormat", "Viiiii", [](const Call& c) { glVertexArrayAttribFormat(c.h(0), c.i(1), c.i(2), c.i(3), static_cast<GLboolean>(c.i(4)), c.i(5)); }},
+        {"glVertexArrayAttribBinding", "Vii", [](const Call& c) { glVertexArrayAttribBinding(c.h(0), c.i(1), c.i(2)); }},
+        {"glVertexArrayVertexBuffer", "ViBli", [](const Call& c) { glVertexArrayVertexBuffer(c.h(0), c.i(1), c.h(2), c.l(3), c.i(4)); }},
+        {"glVertexArrayElementBuffer", "VB", [](const Call& c) { glVertexArrayElementBuffer(c.h(0), c.h(1)); }},
+        // Draws
+        {"glDrawArrays", "iii", [](const Call& c) { glDrawArrays(c.i(0), c.i(1), c.i(2)); }},
+        {"glDrawElements", "iiio", [](const Call& c) { glDrawElements(c.i(0), c.i(1), c.i(2), c.p(3)); }},
+        {"glDrawElementsInstanced", "iiioi", [](const Call& c) { glDrawElementsInstanced(c.i(0), c.i(1), c.i(2), c.p(3), c.i(4)); }},
+        {"glMultiDrawElements", "ibibi", [](const Call& c) { glMultiDrawElements(c.i(0), c.array<GLsizei>(1), c.i(2), c.array<const void*>(3), c.i(4)); },
+            [](const uint64_t* a, size_t index) { return a[4] * (index == 1 ? sizeof(GLsizei) : sizeof(const void*)); }},
+        {"glMultiDrawElementsIndirect", "iioii", [](const Call& c) { glMultiDrawElementsIndirect(c.i(0), c.i(1), c.p(2), c.i(3), c.i(4)); }},
+        // Textures
+        {"glGenTextures", "ia", [](const Call& c) { generate(c, 1, glGenTextures); }, nullptr, 'T'},
+        {"glCreateTextures", "iia", [](const Call& c) { generate(c, 2, [&](GLsizei n, GLuint* textures) { glCreateTextures(c.i(0), n, textures); }); }, nullptr, 'T'},
+        {"glDeleteTextures", "ia", [](const Call& c) { remove(c, 1, glDeleteTextures); }, nullptr, 'T'},
+        {"glBindTexture", "iT", [](const Call& c) { glBindTexture(c.i(0), c.h(1)); }},
+        {"glBindTextureUnit", "iT", [](const Call& c) { glBindTextureUnit(c.i(0), c.h(1)); }},
+        {"glTexParameteri", "iii", [](const Call& c) { glTexParameteri(c.i(0), c.i(1), c.i(2)); }},
+        {"glTextureParameteri", "Tii", [](const Call& c) { glTextureParameteri(c.h(0), c.i(1), c.i(2)); }},
+        {"glTexImage2D", "iiiiiiiib", [](const Call& c) { glTexImage2D(c.i(0), c.i(1), c.i(2), c.i(3), c.i(4), c.i(5), c.i(6), c.i(7), c.p(8)); },
+            [](const uint64_t* a, size_t) { return getImageSize(a[3], a[4], 1, a[6], a[7]); }},
+        {"glTexImage3D", "iiiiiiiiib", [](const Call& c) { glTexImage3D(c.i(0), c.i(1), c.i(2), c.i(3), c.i(4), c.i(5), c.i(6), c.i(7), c.i(8), c.p(9)); },
+            [](const uint64_t* a, size_t) { return getImageSize(a[3], a[4], a[5], a[7], a[8]); }},
+        {"glTexImage2DMultisample", "iiiiii", [](const Call& c) { glTexImage2DMultisample(c.i(0), c.i(1), c.i(2), c.i(3), c.i(4), static_cast<GLboolean>(c.i(5))); }},
+        {"glTexStorage2D", "iiiii", [](const Call& c) { glTexStorage2D(c.i(0), c.i(1), c.i(2), c.i(3), c.i(4)); }},
+        {"glTextureStorage2D", "Tiiii", [](const Call& c) { glTextureStorage2D(c.h(0), c.i(1), c.i(2), c.i(3), c.i(4)); }},
+        {"glTextureStorage3D", "Tiiiii", [](const Call& c) { glTextureStorage3D(c.h(0), c.i(1), c.i(2), c.i(3), c.i(4), c.i(5)); }},
+        {"glTextureStorage2DMultisample", "Tiiiii", [](const Call& c) { glTextureStorage2DMultisample(c.h(0), c.i(1), c.i(2), c.i(3), c.i(4), static_cast<GLboolean>(c.i(5))); }},
+        {"glTexSubImage2D", "iiiiiiiib", [](const Call& c) { glTexSubImage2D(c.i(0), c.i(1), c.i(2), c.i(3), c.i(4), c.i(5), c.i(6), c.i(7), c.p(8)); },
+            [](const uint64_t* a, size_t) { return getImageSize(a[4], a[5], 1, a[6], a[7]); }},
+        {"glTexSubImage3D", "iiiiiiiiiib", [](const Call& c) { glTexSubImage3D(c.i(0), c.i(1), c.i(2), c.i(3), c.i(4), c.i(5), c.i(6), c.i(7), c.i(8), c.i(9), c.p(10)); },
+            [](const uint64_t* a, size_t) { return getImageSize(a[5], a[6], a[7], a[8], a[9]); }},
+        {"glTextureSubImage2D", "Tiiiiiiib", [](const Call& c) { glTextureSubImage2D(c.h(0), c.i(1), c.i(2), c.i(3), c.i(4), c.i(5), c.i(6), c.i(7), c.p(8)); },
+            [](const uint64_t* a, size_t) { return getImageSize(a[4], a[5], 1, a[6], a[7]); }},
+        {"glTextureSubImage3D", "Tiiiiiiiiib", [](const Call& c) { glTextureSubImage3D(c.h(0), c.i(1), c.i(2), c.i(3), c.i(4), c.i(5), c.i(6), c.i(7), c.i(8), c.i(9), c.p(10)); },
+            [](const uint64_t* a, size_t) { return getImageSize(a[5], a[6], a[7], a[8], a[9]); }},
+        {"glCompressedTexImage2D", "iiiiiiib", [](const Call& c) { glCompressedTexImage2D(c.i(0), c.i(1), c.i(2), c.i(3), c.i(4), c.i(5), c.i(6), c.p(7)); }, argumentSize<6>},
+        {"glCompressedTexImage3D", "iiiiiiiib", [](const Call& c) { glCompressedTexImage3D(c.i(0), c.i(1), c.i(2), c.i(3), c.i(4), c.i(5), c.i(6), c.i(7), c.p(8)); }, argumentSize<7>},
+        {"glCompressedTexSubImage3D", "iiiiiiiiiib", [](const Call& c) { glCompressedTexSubImage3D(c.i(0), c.i(1), c.i(2), c.i(3), c.i(4), c.i(5), c.i(6), c.i(7), c.i(8), c.i(9), c.p(10)); }, argumentSize<9>},
+        {"glCompressedTextureSubImage2D", "Tiiiiiiib", [](const Call& c) { glCompressedTextureSubImage2D(c.h(0), c.i(1), c.i(2), c.i(3), c.i(4), c.i(5), c.i(6), c.i(7), c.p(8)); }, argumentSize<7>},
+        {"glCompressedTextureSubImage3D", "Tiiiiiiiiib", [](const Call& c) { glCompressedTextureSubImage3D(c.h(0), c.i(1), c.i(2), c.i(3), c.i(4), c.i(5), c.i(6), c.i(7), c.i(8), c.i(9), c.p(10)); }, argumentSize<9>},
+        {"glGenerateMipmap", "i", [](const Call& c) { glGenerateMipmap(c.i(0)); }},
+        {"glGenerateTextureMipmap", "T", [](const Call& c) { glGenerateTextureMipmap(c.h(0)); }},
+        // Framebuffers
+        {"glGenFramebuffers", "ia", [](const Call& c) { generate(c, 1, glGenFramebuffers); }, nullptr, 'F'},
+        {"glCreateFramebuffers", "ia", [](const Call& c) { generate(c, 1, glCreateFramebuffers); }, nullptr, 'F'},
+        {"glDeleteFramebuffers", "ia", [](const Call& c) { remove(c, 1, glDeleteFramebuffers); }, nullptr, 'F'},
+        {"glBindFramebuffer", "iF", [](const Call& c) { glBindFramebuffer(c.i(0), c.h(1)); }},
+        {"glBindRenderbuffer", "iR", [](const Call& c) { glBindRenderbuffer(c.i(0), c.h(1)); }},
+        {"glFramebufferTexture", "iiTi", [](const Call& c) { glFramebufferTexture(c.i(0), c.i(1), c.h(2), c.i(3)); }},
+        {"glNamedFramebufferTexture", "FiTi", [](const Call& c) { glNamedFramebufferTexture(c.h(0), c.i(1), c.h(2), c.i(3)); }},
+        {"glDrawBuffers", "ib", [](const Call& c) { glDrawBuffers(c.i(0), c.array<GLenum>(1)); },
+            [](const uint64_t* a, size_t) { return a[0] * sizeof(GLenum); }},
+        {"glNamedFramebufferDrawBuffers", "Fib", [](const Call& c) { glNamedFramebufferDrawBuffers(c.h(0), c.i(1), c.array<GLenum>(2)); },
+            [](const uint64_t* a, size_t) { return a[1] * sizeof(GLenum); }},
+        {"glNamedFramebufferReadBuffer", "Fi", [](const Call& c) { glNamedFramebufferReadBuffer(c.h(0), c.i(1)); }},
+        {"glClearBufferfv", "iib", [](const Call& c) { glClearBufferfv(c.i(0), c.i(1), c.array<GLfloat>(2)); },
+            [](const uint64_t* a, size_t) { return clearValueSize(static_cast<GLenum>(a[0])); }},
+        {"glClearNamedFramebufferfv", "Fiib", [](const Call& c) { glClearNamedFramebufferfv(c.h(0), c.i(1), c.i(2), c.array<GLfloat>(3)); },
+            [](const uint64_t* a, size_t) { return clearValueSize(static_cast<GLenum>(a[1])); }},
+        {"glClearBufferfi", "iifi", [](const Call& c) { glClearBufferfi(c.i(0), c.i(1), c.f(2), c.i(3)); }},
+        {"glClearNamedFramebufferfi", "Fiifi", [](const Call& c) { glClearNamedFramebufferfi(c.h(0), c.i(1), c.i(2), c.f(3), c.i(4)); }},
+        {"glBlitFramebuffer", "iiiiiiiiii", [](const Call& c) { glBlitFramebuffer(c.i(0), c.i(1), c.i(2), c.i(3), c.i(4), c.i(5), c.i(6), c.i(7), c.i(8), c.i(9)); }},
+        {"glBlitNamedFramebuffer", "FFiiiiiiiiii", [](const Call& c) { glBlitNamedFramebuffer(c.h(0), c.h(1), c.i(2), c.i(3), c.i(4), c.i(5), c.i(6), c.i(7), c.i(8), c.i(9), c.i(10), c.i(11)); }},
+        // Shaders and programs
+        {"glCreateShader", "i", [](const Call& c) { c.bind('P', c.result(), glCreateShader(c.i(0))); }, nullptr, 0, 'P'},
+        {"glShaderSource", "Pico", [](const Call& c) {
+            const auto source = c.array<GLchar>(2);
+            const auto length = static_cast<GLint>(c.size(2));
+            glShaderSource(c.h(0), 1, &source, &length);
+        }},
+        {"glCompileShader", "P", [](const Call& c) { glCompileShader(c.h(0)); }},
+        {"glDeleteShader", "P", [](const Call& c) { glDeleteShader(c.h(0)); }},
+        {"glCreateProgram", "", [](const Call& c) { c.bind('P', c.result(), glCreateProgram()); }, nullptr, 0, 'P'},
+        {"glAttachShader", "PP", [](const Call& c) { glAttachShader(c.h(0), c.h(1)); }},
+        {"glLinkProgram", "P", [](const Call& c) { glLinkProgram(c.h(0)); }},
+        {"glUseProgram", "P", [](const Call& c) { glUseProgram(c.h(0)); }},
+        {"glDeleteProgram", "P", [](const Call& c) { glDeleteProgram(c.h(0)); }},
+        {"glUniformBlockBinding", "Pii", [](const Call& c) { glUniformBlockBinding(c.h(0), c.i(1), c.i(2)); }},
+        {"glProgramUniform1i", "Pii", [](const Call& c) { glProgramUniform1i(c.h(0), c.i(1), c.i(2)); }},
+        {"glProgramUniform1ui", "Pii", [](const Call& c) { glProgramUniform1ui(c.h(0), c.i(1), c.i(2)); }},
+        {"glProgramUniform1f", "Pif", [](const Call& c) { glProgramUniform1f(c.h(0), c.i(1), c.f(2)); }},
+        {"glProgramUniform1iv", "Piib", [](const Call& c) { glProgramUniform1iv(c.h(0), c.i(1), c.i(2), c.array<GLint>(3)); }, uniformSize<1>},
+        {"glProgramUniform2iv", "Piib", [](const Call& c) { glProgramUniform2iv(c.h(0), c.i(1), c.i(2), c.array<GLint>(3)); }, uniformSize<2>},
+        {"glProgramUniform3iv", "Piib", [](const Call& c) { glProgramUniform3iv(c.h(0), c.i(1), c.i(2), c.array<GLint>(3)); }, uniformSize<3>},
+        {"glProgramUniform4iv", "Piib", [](const Call& c) { glProgramUniform4iv(c.h(0), c.i(1), c.i(2), c.array<GLint>(3)); }, uniformSize<4>},
+        {"glProgramUniform1uiv", "Piib", [](const Call& c) { glProgramUniform1uiv(c.h(0), c.i(1), c.i(2), c.array<GLuint>(3)); }, uniformSize<1>},
+        {"glProgramUniform1fv", "Piib", [](const Call& c) { glProgramUniform1fv(c.h(0), c.i(1), c.i(2), c.array<GLfloat>(3)); }, uniformSize<1>},
+        {"glProgramUniform2fv", "Piib", [](const Call& c) { glProgramUniform2fv(c.h(0), c.i(1), c.i(2), c.array<GLfloat>(3)); }, uniformSize<2>},
+        {"glProgramUniform3fv", "Piib", [](const Call& c) { glProgramUniform3fv(c.h(0), c.i(1), c.i(2), c.array<GLfloat>(3)); }, uniformSize<3>},
+        {"glProgramUniform4fv", "Piib", [](const Call& c) { glProgramUniform4fv(c.h(0), c.i(1), c.i(2), c.array<GLfloat>(3)); }, uniformSize<4>},
+        {"glProgramUniformMatrix2fv", "Piiib", [](const Call& c) { glProgramUniformMatrix2fv(c.h(0), c.i(1), c.i(2), static_cast<GLboolean>(c.i(3)), c.array<GLfloat>(4)); }, uniformSize<4>},
+        {"glProgramUniformMatrix3fv", "Piiib", [](const Call& c) { glProgramUniformMatrix3fv(c.h(0), c.i(1), c.i(2), static_cast<GLboolean>(c.i(3)), c.array<GLfloat>(4)); }, uniformSize<9>},
+        {"glProgramUniformMatrix4fv", "Piiib", [](const Call& c) { glProgramUniformMatrix4fv(c.h(0), c.i(1), c.i(2), static_cast<GLboolean>(c.i(3)), c.array<GLfloat>(4)); }, uniformSize<16>},
+        // Queries
+        {"glGenQueries", "ia", [](const Call& c) { generate(c, 1, glGenQueries); }, nullptr, 'Q'},
+        {"glDeleteQueries", "ia", [](const Call& c) { remove(c, 1, glDeleteQueries); }, nullptr, 'Q'},
+        {"glBeginQuery", "iQ", [](const Call& c) { glBeginQuery(c.i(0), c.h(1)); }},
+        {"glEndQuery", "i", [](const Call& c) { glEndQuery(c.i(0)); }},
+        {"glQueryCounter", "Qi", [](const Call& c) { glQueryCounter(c.h(0), c.i(1)); }},
+        {"glBeginConditionalRender", "Qi", [](const Call& c) { glBeginConditionalRender(c.h(0), c.i(1)); }},
+        {"glEndConditionalRender", "", [](const Call&) { glEndConditionalRender(); }},
+        // Synchronization
+        {"glFenceSync", "ii", [](const Call& c) { c.bind('Y', c.result(), reinterpret_cast<uint64_t>(glFenceSync(c.i(0), c.i(1)))); }, nullptr, 0, 'Y'},
+        {"glClientWaitSync", "Yil", [](const Call& c) {
+            if (const auto sync = c.sync(0)) glClientWaitSync(sync, c.i(1), static_cast<GLuint64>(c.l(2)));
+        }},
+        {"glWaitSync", "Yil", [](const Call& c) {
+            if (const auto sync = c.sync(0)) glWaitSync(sync, c.i(1), static_cast<GLuint64>(c.l(2)));
+        }},
+        {"glDeleteSync", "Y", [](const Call& c) {
+            if (const auto sync = c.sync(0)) glDeleteSync(sync);
+            c.bind('Y', c.arguments[0], 0);
+        }},
+    };
+
+    /** Functions without effect on the rendered frames, they are skipped without a warning */
+    bool isIgnored(std::string_view name) {
+        static const std::unordered_set<std::string_view> IGNORED = {
+            "glCheckFramebufferStatus", "glCheckNamedFramebufferStatus", "glReadPixels",
+            "glDebugMessageCallback", "glDebugMessageControl", "glObjectLabel", "glPushDebugGroup", "glPopDebugGroup",
+        };
+        return name.rfind("glGet", 0) == 0 || name.rfind("glIs", 0) == 0 || IGNORED.count(name) > 0;
+    }
+
+    const Function* findFunction(std::string_view name) {
+        for (const auto& function : FUNCTIONS)
+            if (name == function.name) return &function;
+        return nullptr;
+    }
+
+    /** Only used on the thread of the OpenGL context */
+    struct Recorder {
+        std::ofstream file;
+        std::vector<char> buffer;
+        /** Bytes already written to the file */
+        size_t written = 0;
+        unsigned int frames = 0;
+        unsigned int recordedFrames = 0;
+        bool started = false;
+        /** The recorded functions by the address of their name, glad passes the same string literal for every call */
+        std::unordered_map<const char*, std::pair<int, const Function*>> functions;
+        int nextId = 0;
+        /** Sync objects are pointers, they are recorded as small ids instead */
+        std::unordered_map<GLsync, uint32_t> syncs;
+        uint32_t nextSync = 1;
+
+        template<typename T>
+        void put(T value) {
+            const auto offset = buffer.size();
+            buffer.resize(offset + sizeof(T));
+            std::memcpy(buffer.data() + offset, &value, sizeof(T));
+        }
+
+        void pad(size_t prefix) {
+            buffer.resize(buffer.size() + getPadding(written + buffer.size(), prefix), 0);
+        }
+
+        void putData(const void* data, size_t size) {
+            pad(sizeof(uint32_t));
+            if (!data) {
+                put(NULL_DATA);
+                return;
+            }
+            put(static_cast<uint32_t>(size));
+            const auto offset = buffer.size();
+            buffer.resize(offset + size);
+            if (size > 0) std::memcpy(buffer.data() + offset, data, size);
+        }
+
+        void flush() {
+            file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            written += buffer.size();
+            buffer.clear();
+        }
+
+        /** Gets the id of a function and defines it on its first call, `nullptr` if it is not recorded */
+        std::pair<int, const Function*> getFunction(const char* name) {
+            if (const auto it = functions.find(name); it != functions.end()) return it->second;
+            int id = -1;
+            const auto function = findFunction(name);
+            if (function) {
+                id = nextId++;
+                put(static_cast<uint16_t>(DEFINE));
+                put(static_cast<uint16_t>(id));
+                const auto length = static_cast<uint8_t>(std::strlen(function->name));
+                put(length);
+                buffer.insert(buffer.end(), function->name, function->name + length);
+            } else if (!isIgnored(name)) {
+                std::cerr << "GLCapture: " << name << " is not supported and missing from the capture" << std::endl;
+            }
+            functions.emplace(name, std::make_pair(id, function));
+            return {id, function};
+        }
+
+        uint32_t getSync(GLsync sync) const {
+            const auto it = syncs.find(sync);
+            return it != syncs.end() ? it->second : 0;
+        }
+    };
+
+    Recorder& getRecorder() {
+        static Recorder recorder;
+        return recorder;
+    }
+
+    /** Reads the arguments of a call with their promoted types, pointers are kept as their value */
+    void readArguments(std::string_view signature, va_list args, uint64_t values[MAX_ARGUMENTS]) {
+        for (size_t n = 0; n < signature.size(); n++) {
+            switch (signature[n]) {
+                case 'f': {
+                    const auto value = static_cast<float>(va_arg(args, double));
+                    uint32_t bits;
+                    std::memcpy(&bits, &value, sizeof(bits));
+                    values[n] = bits;
+                    break;
+                }
+                case 'l': values[n] = va_arg(args, uint64_t); break;
+                case 'o':
+                case 'b':
+                case 'c':
+                case 'a':
+                case 'Y': values[n] = reinterpret_cast<uint64_t>(va_arg(args, const void*)); break;
+                default: values[n] = va_arg(args, GLuint);
+            }
+        }
+    }
+
+    void record(void* result, const char* name, int argumentCount, va_list args) {
+        auto& recorder = getRecorder();
+        const auto [id, recorded] = recorder.getFunction(name);
+        if (!recorded) return;
+        const auto& function = *recorded;
+        const auto& signature = function.signature;
+
+        // The arguments are read first, as the sizes of data can depend on later arguments
+        uint64_t values[MAX_ARGUMENTS] = {};
+        readArguments(signature, args, values);
+
+        recorder.put(static_cast<uint16_t>(FIRST_CALL + id));
+        for (size_t n = 0; n < signature.size(); n++) {
+            const auto pointer = reinterpret_cast<const void*>(values[n]);
+            switch (signature[n]) {
+                case 'l':
+                case 'o': recorder.put(values[n]); break;
+                case 'b': recorder.putData(pointer, function.size(values, n)); break;
+                case 'c': {
+                    const auto strings = static_cast<const GLchar* const*>(pointer);
+                    const auto lengths = reinterpret_cast<const GLint*>(values[n + 1]);
+                    std::string source;
+                    for (GLuint i = 0; i < static_cast<GLuint>(values[n - 1]); i++)
+                        source.append(strings[i], lengths && lengths[i] >= 0 ? static_cast<size_t>(lengths[i]) : std::strlen(strings[i]));
+                    recorder.putData(source.data(), source.size());
+                    break;
+                }
+                case 'a': {
+                    const auto names = static_cast<const GLuint*>(pointer);
+                    recorder.pad(0);
+                    for (GLuint i = 0; i < static_cast<GLuint>(values[n - 1]); i++) recorder.put(names[i]);
+                    break;
+                }
+                case 'Y': recorder.put(recorder.getSync(reinterpret_cast<GLsync>(values[n]))); break;
+                default: recorder.put(static_cast<uint32_t>(values[n]));
+            }
+        }
+        if (function.result == 'Y') {
+            const auto sync = *static_cast<GLsync*>(result);
+            recorder.syncs[sync] = recorder.nextSync;
+            recorder.put(recorder.nextSync++);
+        } else if (function.result) {
+            recorder.put(*static_cast<GLuint*>(result));
+        }
+
+        // State that decides the sizes of later data
+        if (function.name == std::string_view("glPixelStorei") && values[0] == GL_UNPACK_ALIGNMENT) unpackAlignment = static_cast<GLint>(values[1]);
+        else if (function.name == std::string_view("glDeleteSync")) recorder.syncs.erase(reinterpret_cast<GLsync>(values[0]));
+    }
+
+    /** Reads the records of a capture and fails on truncated files */
+    class Reader {
+       public:
+        Reader(const std::vector<char>& data) : data(data) {}
+
+        template<typename T>
+        T get() {
+            need(sizeof(T));
+            T value;
+            std::memcpy(&value, data.data() + offset, sizeof(T));
+            offset += sizeof(T);
+            return value;
+        }
+
+        /** Skips data and returns a pointer to it, the size is stored in front of it */
+        const char* skip(size_t size) {
+            need(size);
+            const char* pointer = data.data() + offset;
+            offset += size;
+            return pointer;
+        }
+
+        void skipPadding(size_t prefix) {
+            skip(getPadding(offset, prefix));
+        }
+
+        bool atEnd() const { return offset == data.size(); }
+
+       private:
+        void need(size_t size) const {
+            if (offset + size > data.size()) throw std::runtime_error("GLCapture: Truncated capture");
+        }
+
+        const std::vector<char>& data;
+        size_t offset = 0;
+    };
+}
+
+void GLCapture::start(const std::filesystem::path& path, unsigned int frames) {
+    auto& recorder = getRecorder();
+    if (recorder.started) stop();
+    recorder = Recorder();
+    recorder.file.open(path, std::ios::binary);
+    if (!recorder.file) throw std::runtime_error("Could not open file: " + std::filesystem::absolute(path).string());
+    recorder.file.write(MAGIC, sizeof(MAGIC));
+    recorder.file.write(reinterpret_cast<const char*>(&VERSION), sizeof(VERSION));
+    recorder.written = sizeof(MAGIC) + sizeof(VERSION);
+    recorder.frames = frames;
+    recorder.started = true;
+    unpackAlignment = 4;
+    GLValidation::setCallHook(record);
+}
+
+void GLCapture::newFrame(const glm::ivec2& resolution) {
+    auto& recorder = getRecorder();
+    if (!recorder.started) return;
+    if (recorder.recordedFrames == recorder.frames) {
+        stop();
+        return;
+    }
+    recorder.put(static_cast<uint16_t>(FRAME));
+    recorder.put(static_cast<int32_t>(resolution.x));
+    recorder.put(static_cast<int32_t>(resolution.y));
+    recorder.recordedFrames++;
+    recorder.flush();
+}
+
+void GLCapture::stop() {
+    auto& recorder = getRecorder();
+    if (!recorder.started) return;
+    GLValidation::setCallHook(nullptr);
+    recorder.flush();
+    recorder.file.close();
+    recorder.started = false;
+    std::cout << "GLCapture: Recorded " << recorder.recordedFrames << " frames" << std::endl;
+}
+
+bool GLCapture::printArguments(std::ostream& stream, const char* name, va_list args) {
+    const auto function = findFunction(name);
+    if (!function) return false;
+    const auto& signature = function->signature;
+    uint64_t values[MAX_ARGUMENTS] = {};
+    readArguments(signature, args, values);
+    for (size_t n = 0; n < signature.size(); n++) {
+        if (n > 0) stream << ", ";
+        switch (signature[n]) {
+            case 'f': {
+                float value;
+                const auto bits = static_cast<uint32_t>(values[n]);
+                std::memcpy(&value, &bits, sizeof(value));
+                stream << value;
+                break;
+            }
+            case 'l': stream << static_cast<int64_t>(values[n]); break;
+            case 'o':
+            case 'b':
+            case 'c':
+            case 'a':
+            case 'Y': stream << reinterpret_cast<const void*>(values[n]); break;
+            default: stream << static_cast<GLint>(values[n]);
+        }
+    }
+    return true;
+}
+
+bool GLCapture::isCapturing() {
+    return getRecorder().started;
+}
+
+GLCapture::Replay::Replay(const std::filesystem::path& path) : data(Common::readBinaryFile(path)), names(OBJECT_KINDS.size()) {
+    Reader reader(data);
+    const char* magic = reader.skip(sizeof(MAGIC));
+    if (std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0) throw std::runtime_error("GLCapture: Not a capture " + path.string());
+    if (reader.get<uint32_t>() != VERSION) throw std::runtime_error("GLCapture: Unsupported version of " + path.string());
+
+    // The sizes of images depend on the unpack alignment at the time of the call, tracked like while recording
+    unpackAlignment = 4;
+    std::vector<uint32_t> functions;
+    while (!reader.atEnd()) {
+        const auto tag = reader.get<uint16_t>();
+        if (tag == FRAME) {
+            const auto width = reader.get<int32_t>();
+            const auto height = reader.get<int32_t>();
+            if (frames.empty()) resolution = glm::ivec2(width, height);
+            frames.push_back(commands.size());
+            continue;
+        }
+        if (tag == DEFINE) {
+            const auto id = reader.get<uint16_t>();
+            const auto length = reader.get<uint8_t>();
+            const std::string_view name(reader.skip(length), length);
+            const auto function = findFunction(name);
+            if (!function) throw std::runtime_error("GLCapture: Cannot replay " + std::string(name));
+            if (functions.size() <= id) functions.resize(id + 1);
+            functions[id] = static_cast<uint32_t>(function - FUNCTIONS);
+            continue;
+        }
+        const size_t id = tag - FIRST_CALL;
+        if (id >= functions.size()) throw std::runtime_error("GLCapture: Call of an undefined function");
+        const auto& function = FUNCTIONS[functions[id]];
+        const auto firstArgument = arguments.size();
+        commands.push_back({functions[id], static_cast<uint32_t>(firstArgument)});
+        uint32_t sizes[MAX_ARGUMENTS] = {};
+        for (size_t n = 0; n < function.signature.size(); n++) {
+            switch (function.signature[n]) {
+                case 'l':
+                case 'o': arguments.push_back(reader.get<uint64_t>()); break;
+                case 'b':
+                case 'c': {
+                    reader.skipPadding(sizeof(uint32_t));
+                    sizes[n] = reader.get<uint32_t>();
+                    arguments.push_back(sizes[n] == NULL_DATA ? 0 : reinterpret_cast<uint64_t>(reader.skip(sizes[n])));
+                    break;
+                }
+                case 'a': {
+                    const auto count = static_cast<size_t>(arguments.back());
+                    reader.skipPadding(0);
+                    arguments.push_back(reinterpret_cast<uint64_t>(reader.skip(count * sizeof(GLuint))));
+                    break;
+                }
+                default: arguments.push_back(reader.get<uint32_t>());
+            }
+        }
+        if (function.result) arguments.push_back(reader.get<uint32_t>());
+
+        // The driver reads as many bytes as the other arguments ask for, whatever the capture stored
+        const uint64_t* values = arguments.data() + firstArgument;
+        for (size_t n = 0; n < function.signature.size(); n++) {
+            if (function.signature[n] != 'b' || sizes[n] == NULL_DATA || sizes[n] == function.size(values, n)) continue;
+            throw std::runtime_error("GLCapture: The data of " + std::string(function.name) + " does not match its size arguments");
+        }
+        if (function.name == std::string_view("glPixelStorei") && values[0] == GL_UNPACK_ALIGNMENT) unpackAlignment = static_cast<GLint>(values[1]);
+    }
+    frames.push_back(commands.size());
+}
+
+void GLCapture::Replay::run(size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+        const auto& function = FUNCTIONS[commands[i].function];
+        function.replay({arguments.data() + commands[i].firstArgument, function.signature, function.names, names});
+    }
+}
+
+void GLCapture::Replay::runSetup() {
+    run(0, frames.front());
+}
+
+void GLCapture::Replay::runFrame(size_t frame) {
+    run(frames[frame], frames[frame + 1]);
+}
+
+void GLCapture::Replay::deleteSyncs() {
+    for (auto& sync : names[getObjectKind('Y')]) {
+        if (sync) glDeleteSync(reinterpret_cast<GLsync>(sync));
+        sync = 0;
+    }
+}
+
+size_t GLCapture::Replay::getFrameCount() const {
+    return frames.size() - 1;
+}
+
+glm::ivec2 GLCapture::Replay::getResolution() const {
+    return resolution;
+}
+
+size_t GLCapture::Replay::getSetupCallCount() const {
+    return frames.front();
+}
+
+size_t GLCapture::Replay::getFrameCallCount(size_t frame) const {
+    return frames[frame + 1] - frames[frame];
+}
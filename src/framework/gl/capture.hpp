@@ -0,0 +1,123 @@
+#pragma once
+
+#include <glad/gl.h>
+
+#include <glm/glm.hpp>
+
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <ostream>
+#include <vector>
+
+/**
+ * @file capture.hpp
+ * @brief Defines a capture of the OpenGL call stream into a binary file and its replay without the application.
+ */
+
+/**
+ * @brief Records every OpenGL call issued through glad with its arguments and the buffer, texture and shader data it reads.
+ * The capture starts before the context is created, so the file contains everything needed to recreate the resources, followed by the calls of each frame.
+ * Object names are recorded as created and remapped on replay, uniform locations are replayed as recorded, which holds on the same driver.
+ * Queries of state (`glGet*`, `glIs*`, `glReadPixels`, ...) are skipped, so a replay measures the submission of the frames without the stalls of the application.
+ * Calls issued by other loaders, e.g. the ImGui backend, are not seen.
+ * Example:
+ * ```cpp
+ * GLCapture::start("frames.glcapture", 100); // Before the App is constructed
+ * MainApp app;
+ * app.run(); // Writes the file after 100 frames
+ * ```
+ */
+namespace GLCapture {
+
+    /**
+     * @brief Starts recording the calls into a file, the hook of `GLValidation` is installed until `frames` frames have been recorded.
+     * @throws std::runtime_error if the file cannot be opened.
+     */
+    void start(const std::filesystem::path& path, unsigned int frames);
+
+    /**
+     * @brief Marks the start of a frame, called by `App::run`, the capture is finished at the start of the frame after the last one.
+     * @param resolution The size of the default framebuffer, used by the replay for its window.
+     */
+    void newFrame(const glm::ivec2& resolution);
+
+    /**
+     * @brief Writes the remaining calls and closes the file, called by the destructor of `App` if the application exits early.
+     */
+    void stop();
+
+    bool isCapturing();
+
+    /**
+     * @brief Prints the arguments of a call seen by a `GLValidation::CallHook`, decoded with the signature of the function in the capture.
+     * @return False if the capture does not know the function, nothing is read from `args` then.
+     */
+    bool printArguments(std::ostream& stream, const char* name, va_list args);
+
+    /**
+     * @class Replay
+     * @brief Loads a capture and issues its calls again on the current context.
+     * The calls are decoded once when loading, so replaying a frame only remaps object names and calls the driver.
+     */
+    class Replay {
+       public:
+        /**
+         * @brief Loads and decodes a capture.
+         * @throws std::runtime_error if the file cannot be read, is truncated or contains a function this version cannot replay.
+         */
+        explicit Replay(const std::filesystem::path& path);
+
+        Replay(const Replay&) = delete;
+        Replay& operator=(const Replay&) = delete;
+        Replay(Replay&&) = delete;
+        Replay& operator=(Replay&&) = delete;
+
+        /**
+         * @brief Issues the calls before the first frame, which create the resources.
+         */
+        void runSetup();
+
+        /**
+         * @brief Issues the calls of a frame, frames can be repeated in any order after `runSetup`.
+         */
+        void runFrame(size_t frame);
+
+        /**
+         * @brief Deletes the fences that the replayed frames created but did not delete yet, called after the last frame of a loop.
+         * The fences of the last frames are deleted by frames after the end of the capture, waits on them in the next loop are skipped.
+         */
+        void deleteSyncs();
+
+        size_t getFrameCount() const;
+
+        /**
+         * @brief Gets the size of the default framebuffer during the first frame.
+         */
+        glm::ivec2 getResolution() const;
+
+        size_t getSetupCallCount() const;
+
+        size_t getFrameCallCount(size_t frame) const;
+
+       private:
+        struct Command {
+            uint32_t function;
+            /** Index of the first argument in `arguments`, the result follows the arguments */
+            uint32_t firstArgument;
+        };
+
+        void run(size_t begin, size_t end);
+
+        /** The file contents, the data arguments point into it */
+        std::vector<char> data;
+        std::vector<Command> commands;
+        std::vector<uint64_t> arguments;
+        /** Index of the first command of each frame followed by the end of the last one */
+        std::vector<size_t> frames;
+        glm::ivec2 resolution = glm::ivec2(0);
+        /** The recorded object names mapped to the ones created by the replay, per kind of object */
+        std::vector<std::vector<uint64_t>> names;
+    };
+}
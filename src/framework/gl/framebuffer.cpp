@@ -2,9 +2,16 @@
 
 #include <unordered_map>
 
+#include <stb_image_write.h>
+
 #include <glad/gl.h>
 
+#include "framework/gl/gpumemory.hpp"
 #include "framework/gl/texture.hpp"
+#include "framework/gl/state.hpp"
+#include "framework/exr.hpp"
+#include "framework/pixelconvert.hpp"
+#include "framework/png.hpp"
 
 /////////////////////// RAII behavior ///////////////////////
 Framebuffer::Framebuffer() {
@@ -33,16 +40,19 @@ Framebuffer::~Framebuffer() {
 }
 
 void Framebuffer::release() {
-    if (handle) glDeleteFramebuffers(1, &handle);
+    if (handle) {
+        GLState::forgetFramebuffer(handle);
+        glDeleteFramebuffers(1, &handle);
+    }
 }
 /////////////////////////////////////////////////////////////
 
 void Framebuffer::bind(GLenum target) {
-    glBindFramebuffer(target, handle);
+    GLState::bindFramebuffer(target, handle);
 }
 
 void Framebuffer::bindDefault(GLenum target) {
-    glBindFramebuffer(target, 0);
+    GLState::bindFramebuffer(target, 0);
 }
 
 void Framebuffer::attach(GLenum attachment, GLuint texture, GLint level) {
@@ -51,6 +61,16 @@ void Framebuffer::attach(GLenum attachment, GLuint texture, GLint level) {
 #else
     bind(GL_DRAW_FRAMEBUFFER);
     glFramebufferTexture(GL_DRAW_FRAMEBUFFER, attachment, texture, level);
+#endif
+    if (texture) GPUMemory::markRenderTarget(texture);
+}
+
+void Framebuffer::setDrawBuffers(const std::vector<GLenum>& attachments) {
+#ifdef MODERN_GL
+    glNamedFramebufferDrawBuffers(handle, static_cast<GLsizei>(attachments.size()), attachments.data());
+#else
+    bind(GL_DRAW_FRAMEBUFFER);
+    glDrawBuffers(static_cast<GLsizei>(attachments.size()), attachments.data());
 #endif
 }
 
@@ -90,8 +110,11 @@ bool Framebuffer::writeToFile(const std::filesystem::path &path, GLenum attachme
     GLsizei width, height;
     GLint type, internalFormat;
     GLint texture;
+    // Depth and stencil attachments are read without selecting a read buffer
+    bool colorAttachment = attachment != GL_DEPTH_ATTACHMENT && attachment != GL_STENCIL_ATTACHMENT && attachment != GL_DEPTH_STENCIL_ATTACHMENT;
 #ifdef MODERN_GL
-    glNamedFramebufferReadBuffer(handle, attachment);
+    bind(GL_READ_FRAMEBUFFER);
+    if (colorAttachment) glNamedFramebufferReadBuffer(handle, attachment);
     glGetNamedFramebufferAttachmentParameteriv(handle, attachment, GL_FRAMEBUFFER_ATTACHMENT_OBJECT_TYPE, &type);
     glGetNamedFramebufferAttachmentParameteriv(handle, attachment, GL_FRAMEBUFFER_ATTACHMENT_OBJECT_NAME, &texture);
     switch (type) {
@@ -109,13 +132,13 @@ bool Framebuffer::writeToFile(const std::filesystem::path &path, GLenum attachme
             throw std::runtime_error("Unknown framebuffer attachment type");
     }
 #else
-    glBindFramebuffer(GL_READ_FRAMEBUFFER, handle);
-    glReadBuffer(attachment);
+    bind(GL_READ_FRAMEBUFFER);
+    if (colorAttachment) glReadBuffer(attachment);
     glGetFramebufferAttachmentParameteriv(GL_READ_FRAMEBUFFER, attachment, GL_FRAMEBUFFER_ATTACHMENT_OBJECT_TYPE, &type);
     glGetFramebufferAttachmentParameteriv(GL_READ_FRAMEBUFFER, attachment, GL_FRAMEBUFFER_ATTACHMENT_OBJECT_NAME, &texture);
     switch (type) {
         case GL_TEXTURE:
-            glBindTexture(GL_TEXTURE_2D, texture);
+            GLState::bindTexture(GL_TEXTURE_2D, texture);
             glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
             glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
             glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &internalFormat);
@@ -130,11 +153,20 @@ bool Framebuffer::writeToFile(const std::filesystem::path &path, GLenum attachme
             throw std::runtime_error("Unknown framebuffer attachment type");
     }
 #endif
-    GLenum dataType = getDataType(internalFormat);
     GLenum baseFormat = getBaseFormat(internalFormat);
+
+    if (path.extension() == ".exr") {
+        // Depth is stored as the Z channel
+        bool depth = baseFormat == GL_DEPTH_COMPONENT || baseFormat == GL_DEPTH_STENCIL;
+        int channels = depth ? 1 : getChannels(baseFormat);
+        auto floatData = std::make_unique<float[]>(width * height * channels);
+        glReadPixels(0, 0, width, height, depth ? GL_DEPTH_COMPONENT : baseFormat, GL_FLOAT, floatData.get());
+        auto channelNames = depth ? std::string_view("Z") : std::string_view("RGBA").substr(0, channels);
+        return EXR::write(path, floatData.get(), width, height, channelNames, getEXRPixelType(internalFormat), EXR::Compression::ZIP, true);
+    }
+
+    GLenum dataType = getDataType(internalFormat);
     int channels = getChannels(baseFormat);
-    
-    stbi_flip_vertically_on_write(true);
 
     if (dataType == GL_UNSIGNED_BYTE || dataType == GL_BYTE) {
         auto ubyteData = std::make_unique<unsigned char[]>(width * height * channels);
@@ -142,13 +174,14 @@ bool Framebuffer::writeToFile(const std::filesystem::path &path, GLenum attachme
 
         // Convert from signed to unsigned byte
         if (dataType == GL_BYTE)
-            for (int i = 0; i < width * height * channels; i++)
-                ubyteData[i] += 128;
+            PixelConvert::signedToUnsigned(reinterpret_cast<int8_t*>(ubyteData.get()), ubyteData.get(), static_cast<size_t>(width) * height * channels);
 
         auto ext = path.extension();
         if (ext == ".png")
-            return stbi_write_png(path.string().c_str(), width, height, channels, ubyteData.get(), width * channels);
-        else if (ext == ".bmp")
+            return PNG::write(path, ubyteData.get(), width, height, channels, true);
+
+        PixelConvert::flipRows(ubyteData.get(), width * channels, height);
+        if (ext == ".bmp")
             return stbi_write_bmp(path.string().c_str(), width, height, channels, ubyteData.get());
         else if (ext == ".tga")
             return stbi_write_tga(path.string().c_str(), width, height, channels, ubyteData.get());
@@ -159,6 +192,7 @@ bool Framebuffer::writeToFile(const std::filesystem::path &path, GLenum attachme
     } else if (dataType == GL_FLOAT) {
         auto floatData = std::make_unique<float[]>(width * height * channels);
         glReadPixels(0, 0, width, height, baseFormat, dataType, floatData.get());
+        PixelConvert::flipRows(floatData.get(), width * channels * sizeof(float), height);
         return stbi_write_hdr(path.string().c_str(), width, height, channels, floatData.get());
     } else throw std::runtime_error("Unsupported data type");
 }
\ No newline at end of file
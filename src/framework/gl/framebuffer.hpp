@@ -3,6 +3,7 @@
 #include <glad/gl.h>
 
 #include <filesystem>
+#include <vector>
 
 #include "framework/gl/texture.hpp"
 
@@ -76,7 +77,8 @@ class Framebuffer {
     static void bindDefault(GLenum target = GL_FRAMEBUFFER);
 
     /**
-     * @brief Writes a color attachment of the framebuffer to a file.
+     * @brief Writes an attachment of the framebuffer to a file.
+     * Float, half and depth attachments are written losslessly to `.exr` files, depth as the Z channel.
      * @param path The path to write the image to.
      * @param attachment The attachment point, e.g. `GL_COLOR_ATTACHMENT0`, `GL_DEPTH_ATTACHMENT`, ...
      */
@@ -92,13 +94,19 @@ class Framebuffer {
     void attach(GLenum attachment, const Texture<target>& texture, GLint level = 0);
 
     /**
-     * @brief Attaches a texture to the framebuffer.
+     * @brief Attaches a texture to the framebuffer, its memory is counted as render target by `GPUMemory`.
      * @param attachment The attachment point, e.g. `GL_COLOR_ATTACHMENT0`, `GL_DEPTH_ATTACHMENT`, `GL_STENCIL_ATTACHMENT`.
      * @param texture The texture to attach.
      * @param level The mipmap level to attach.
      */
     void attach(GLenum attachment, GLuint texture, GLint level = 0);
 
+    /**
+     * @brief Selects the color attachments that fragment shader outputs are written to.
+     * @param attachments The attachment for each fragment shader output location, e.g. `{GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1}`, or `GL_NONE` for depth-only framebuffers.
+     */
+    void setDrawBuffers(const std::vector<GLenum>& attachments);
+
     /**
      * @brief Checks the status of the framebuffer.
      * @throws std::runtime_error if the framebuffer is incomplete.
@@ -0,0 +1,200 @@
+#include "gpumemory.hpp"
+
+#include <glad/gl.h>
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+
+#include "framework/gl/texture.hpp"
+
+// Not part of the core profile headers
+#ifndef GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX
+    #define GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX 0x9047
+    #define GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX 0x9049
+#endif
+#ifndef GL_TEXTURE_FREE_MEMORY_ATI
+    #define GL_TEXTURE_FREE_MEMORY_ATI 0x87FC
+#endif
+
+namespace {
+    enum class DriverQuery { Unknown, None, NVX, ATI };
+
+    /** Buffers and textures have separate names, so they are kept apart */
+    struct Registry {
+        std::mutex mutex;
+        std::unordered_map<GLuint, GPUMemory::Allocation> buffers;
+        std::unordered_map<GLuint, GPUMemory::Allocation> textures;
+        size_t budget = 0;
+        DriverQuery driverQuery = DriverQuery::Unknown;
+    };
+
+    Registry& getRegistry() {
+        static Registry registry;
+        return registry;
+    }
+
+    /** Finds the entry of an object, objects that are labeled or attached before their storage is allocated get an empty one */
+    GPUMemory::Allocation& find(std::unordered_map<GLuint, GPUMemory::Allocation>& map, GLuint handle, GPUMemory::Category category) {
+        auto [it, inserted] = map.try_emplace(handle);
+        if (inserted) {
+            it->second.handle = handle;
+            it->second.category = category;
+        }
+        return it->second;
+    }
+
+    /** Replaces the previous storage of an object but keeps its label and category */
+    void insert(std::unordered_map<GLuint, GPUMemory::Allocation>& map, GPUMemory::Allocation&& allocation) {
+        auto& entry = find(map, allocation.handle, allocation.category);
+        allocation.label = std::move(entry.label);
+        allocation.category = entry.category;
+        entry = std::move(allocation);
+    }
+
+    DriverQuery detectDriverQuery() {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; i++) {
+            const auto name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+            if (!name) continue;
+            if (std::strcmp(name, "GL_NVX_gpu_memory_info") == 0) return DriverQuery::NVX;
+            if (std::strcmp(name, "GL_ATI_meminfo") == 0) return DriverQuery::ATI;
+        }
+        return DriverQuery::None;
+    }
+}
+
+void GPUMemory::recordBuffer(GLuint handle, GLenum target, size_t bytes, GLenum usage) {
+    Allocation allocation;
+    allocation.handle = handle;
+    allocation.category = Category::Buffer;
+    allocation.target = target;
+    allocation.format = usage;
+    allocation.bytes = bytes;
+    auto& registry = getRegistry();
+    std::lock_guard lock(registry.mutex);
+    insert(registry.buffers, std::move(allocation));
+}
+
+void GPUMemory::recordTexture(GLuint handle, GLenum target, GLenum internalFormat, GLsizei width, GLsizei height, GLsizei layers, GLint levels, GLsizei samples) {
+    Allocation allocation;
+    allocation.handle = handle;
+    allocation.category = Category::Texture;
+    allocation.target = target;
+    allocation.format = internalFormat;
+    allocation.width = width;
+    allocation.height = height;
+    allocation.layers = layers;
+    allocation.levels = levels;
+    allocation.samples = samples;
+    allocation.bytes = getTextureSize(internalFormat, width, height, layers, levels, samples);
+    auto& registry = getRegistry();
+    std::lock_guard lock(registry.mutex);
+    insert(registry.textures, std::move(allocation));
+}
+
+void GPUMemory::releaseBuffer(GLuint handle) {
+    auto& registry = getRegistry();
+    std::lock_guard lock(registry.mutex);
+    registry.buffers.erase(handle);
+}
+
+void GPUMemory::releaseTexture(GLuint handle) {
+    auto& registry = getRegistry();
+    std::lock_guard lock(registry.mutex);
+    registry.textures.erase(handle);
+}
+
+void GPUMemory::markRenderTarget(GLuint texture) {
+    auto& registry = getRegistry();
+    std::lock_guard lock(registry.mutex);
+    find(registry.textures, texture, Category::Texture).category = Category::RenderTarget;
+}
+
+void GPUMemory::setLabel(GLenum identifier, GLuint handle, const std::string& label) {
+#ifdef MODERN_GL
+    glObjectLabel(identifier, handle, static_cast<GLsizei>(label.size()), label.data());
+#endif
+    auto& registry = getRegistry();
+    std::lock_guard lock(registry.mutex);
+    if (identifier == GL_TEXTURE) find(registry.textures, handle, Category::Texture).label = label;
+    else find(registry.buffers, handle, Category::Buffer).label = label;
+}
+
+std::vector<GPUMemory::Allocation> GPUMemory::getAllocations() {
+    std::vector<Allocation> allocations;
+    {
+        auto& registry = getRegistry();
+        std::lock_guard lock(registry.mutex);
+        allocations.reserve(registry.buffers.size() + registry.textures.size());
+        for (const auto& [handle, allocation] : registry.buffers) allocations.push_back(allocation);
+        for (const auto& [handle, allocation] : registry.textures) allocations.push_back(allocation);
+    }
+    std::sort(allocations.begin(), allocations.end(), [](const Allocation& a, const Allocation& b) { return a.bytes > b.bytes; });
+    return allocations;
+}
+
+std::array<size_t, static_cast<size_t>(GPUMemory::Category::COUNT)> GPUMemory::getTotals() {
+    std::array<size_t, static_cast<size_t>(Category::COUNT)> totals = {};
+    auto& registry = getRegistry();
+    std::lock_guard lock(registry.mutex);
+    for (const auto& [handle, allocation] : registry.buffers) totals[static_cast<size_t>(allocation.category)] += allocation.bytes;
+    for (const auto& [handle, allocation] : registry.textures) totals[static_cast<size_t>(allocation.category)] += allocation.bytes;
+    return totals;
+}
+
+size_t GPUMemory::getTotal() {
+    size_t total = 0;
+    for (const auto bytes : getTotals()) total += bytes;
+    return total;
+}
+
+GPUMemory::DriverInfo GPUMemory::queryDriver() {
+    auto& registry = getRegistry();
+    DriverQuery query;
+    {
+        std::lock_guard lock(registry.mutex);
+        if (registry.driverQuery == DriverQuery::Unknown) registry.driverQuery = detectDriverQuery();
+        query = registry.driverQuery;
+    }
+    DriverInfo info;
+    // Both extensions report kilobytes
+    if (query == DriverQuery::NVX) {
+        GLint dedicated = 0, available = 0;
+        glGetIntegerv(GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX, &dedicated);
+        glGetIntegerv(GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX, &available);
+        info.extension = "GL_NVX_gpu_memory_info";
+        info.dedicated = static_cast<size_t>(dedicated) * 1024;
+        info.available = static_cast<size_t>(available) * 1024;
+    } else if (query == DriverQuery::ATI) {
+        // Total free, largest free block, total free auxiliary, largest free auxiliary block
+        GLint free[4] = {};
+        glGetIntegerv(GL_TEXTURE_FREE_MEMORY_ATI, free);
+        info.extension = "GL_ATI_meminfo";
+        info.available = static_cast<size_t>(free[0]) * 1024;
+    }
+    return info;
+}
+
+void GPUMemory::setBudget(size_t bytes) {
+    auto& registry = getRegistry();
+    std::lock_guard lock(registry.mutex);
+    registry.budget = bytes;
+}
+
+size_t GPUMemory::getBudget() {
+    auto& registry = getRegistry();
+    std::lock_guard lock(registry.mutex);
+    return registry.budget;
+}
+
+size_t GPUMemory::getTextureSize(GLenum internalFormat, GLsizei width, GLsizei height, GLsizei layers, GLint levels, GLsizei samples) {
+    size_t bytes = 0;
+    for (GLint level = 0; level < levels; level++) {
+        const GLsizei w = std::max(width >> level, 1), h = std::max(height >> level, 1);
+        bytes += isCompressedFormat(internalFormat) ? getCompressedSize(internalFormat, w, h) : static_cast<size_t>(w) * h * getBytesPerPixel(internalFormat);
+    }
+    return bytes * std::max(layers, 1) * std::max(samples, 1);
+}
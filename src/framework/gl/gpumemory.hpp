@@ -0,0 +1,125 @@
+#pragma once
+
+#include <glad/gl.h>
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @file gpumemory.hpp
+ * @brief Defines a registry of the GPU memory allocated by the wrapper classes.
+ */
+
+/**
+ * @brief Thread-safe registry of the memory allocated by `Buffer` and `Texture`, recorded when the storage is allocated and removed when the object is released.
+ * Sizes are computed from the dimensions and formats, so they are estimates that ignore alignment and driver overhead.
+ * The totals reported by the driver are available through `GL_NVX_gpu_memory_info` on NVIDIA and `GL_ATI_meminfo` on AMD.
+ */
+namespace GPUMemory {
+
+    enum class Category {
+        Buffer,
+        Texture,
+        /** Textures attached to a `Framebuffer` */
+        RenderTarget,
+        COUNT
+    };
+
+    inline constexpr std::array<std::string_view, static_cast<size_t>(Category::COUNT)> CATEGORY_NAMES = {"Buffers", "Textures", "Render targets"};
+
+    /**
+     * @brief A single buffer or texture.
+     */
+    struct Allocation {
+        GLuint handle = 0;
+        Category category = Category::Buffer;
+        /** The target of the wrapper, e.g. `GL_ARRAY_BUFFER` or `GL_TEXTURE_2D` */
+        GLenum target = 0;
+        /** The internal format of textures, the usage of buffers */
+        GLenum format = 0;
+        GLsizei width = 0;
+        GLsizei height = 0;
+        /** Layers of array textures and faces of cubemaps */
+        GLsizei layers = 1;
+        GLint levels = 1;
+        GLsizei samples = 1;
+        size_t bytes = 0;
+        std::string label;
+    };
+
+    /**
+     * @brief The memory reported by the driver in bytes, zero where the query is not supported.
+     */
+    struct DriverInfo {
+        /** `GL_NVX_gpu_memory_info`, `GL_ATI_meminfo` or empty */
+        std::string_view extension;
+        size_t dedicated = 0;
+        size_t available = 0;
+    };
+
+    /**
+     * @brief Records the data store of a buffer, replacing its previous one.
+     */
+    void recordBuffer(GLuint handle, GLenum target, size_t bytes, GLenum usage);
+
+    /**
+     * @brief Records the storage of a texture including all mip levels, replacing its previous one.
+     */
+    void recordTexture(GLuint handle, GLenum target, GLenum internalFormat, GLsizei width, GLsizei height, GLsizei layers, GLint levels, GLsizei samples = 1);
+
+    /**
+     * @brief Removes a buffer, called when it is deleted.
+     */
+    void releaseBuffer(GLuint handle);
+
+    /**
+     * @brief Removes a texture, called when it is deleted.
+     */
+    void releaseTexture(GLuint handle);
+
+    /**
+     * @brief Moves a texture to `Category::RenderTarget`, called when it is attached to a framebuffer.
+     */
+    void markRenderTarget(GLuint texture);
+
+    /**
+     * @brief Sets the label shown in the statistics, on the modern path it is also passed to `glObjectLabel` for debuggers.
+     * @param identifier `GL_BUFFER` or `GL_TEXTURE`.
+     */
+    void setLabel(GLenum identifier, GLuint handle, const std::string& label);
+
+    /**
+     * @brief Gets a copy of all allocations, largest first.
+     */
+    std::vector<Allocation> getAllocations();
+
+    /**
+     * @brief Gets the bytes allocated per category.
+     */
+    std::array<size_t, static_cast<size_t>(Category::COUNT)> getTotals();
+
+    /**
+     * @brief Gets the bytes allocated in all categories.
+     */
+    size_t getTotal();
+
+    /**
+     * @brief Queries the memory reported by the driver, the supported extension is detected on the first call.
+     */
+    DriverInfo queryDriver();
+
+    /**
+     * @brief Sets the budget the registry is compared against in the statistics, 0 disables it.
+     */
+    void setBudget(size_t bytes);
+
+    size_t getBudget();
+
+    /**
+     * @brief Gets the number of bytes of a texture with all its mip levels.
+     */
+    size_t getTextureSize(GLenum internalFormat, GLsizei width, GLsizei height, GLsizei layers, GLint levels, GLsizei samples = 1);
+}
@@ -10,6 +10,8 @@ using namespace glm;
 #include <array>
 
 #include "shader.hpp"
+#include "state.hpp"
+#include "framework/trace.hpp"
 
 /////////////////////// RAII behavior ///////////////////////
 Program::Program() : handle(glCreateProgram()) {}
@@ -32,7 +34,10 @@ Program::~Program() {
 }
 
 void Program::release() {
-    if (handle) glDeleteProgram(handle);
+    if (handle) {
+        GLState::forgetProgram(handle);
+        glDeleteProgram(handle);
+    }
 }
 /////////////////////////////////////////////////////////////
 
@@ -42,6 +47,12 @@ void Program::load(const std::filesystem::path& vs, const std::filesystem::path&
     link();
 }
 
+void Program::load(const std::filesystem::path& vs, const std::filesystem::path& fs, const std::vector<std::string>& defines) {
+    attach<GL_VERTEX_SHADER>(vs, defines);
+    attach<GL_FRAGMENT_SHADER>(fs, defines);
+    link();
+}
+
 void Program::loadSource(const std::string& vs, const std::string& fs) {
     attachSource<GL_VERTEX_SHADER>(vs);
     attachSource<GL_FRAGMENT_SHADER>(fs);
@@ -53,6 +64,7 @@ void Program::attach(GLuint shader) {
 }
 
 void Program::link() {
+    TRACE_ZONE("Program::link");
     glLinkProgram(handle);
     GLint success;
     glGetProgramiv(handle, GL_LINK_STATUS, &success);
@@ -64,7 +76,7 @@ void Program::link() {
 }
 
 void Program::use() {
-    glUseProgram(handle);
+    GLState::useProgram(handle);
 }
 
 GLint Program::uniform(const std::string& name) {
@@ -6,6 +6,7 @@
 
 #include <string>
 #include <filesystem>
+#include <vector>
 
 #include "buffer.hpp"
 #include "shader.hpp"
@@ -72,6 +73,15 @@ class Program {
      */
     void load(const std::filesystem::path& vs, const std::filesystem::path& fs);
 
+    /**
+     * @brief Loads and links the vertex and fragment shaders from the specified file paths with additional preprocessor definitions.
+     * @throw `std::runtime_error` when the shaders could not be loaded or linked.
+     * @param vs The file path to the vertex shader source code.
+     * @param fs The file path to the fragment shader source code.
+     * @param defines The definitions injected after the `#version` directive of both shaders, either `NAME` or `NAME VALUE`.
+     */
+    void load(const std::filesystem::path& vs, const std::filesystem::path& fs, const std::vector<std::string>& defines);
+
     /**
      * @brief Loads and links the vertex and fragment shaders from the specified source code.
      * @throw `std::runtime_error` when the shaders could not be loaded or linked. 
@@ -94,6 +104,16 @@ class Program {
     template <GLenum type>
     void attach(const std::filesystem::path& filepath);
 
+    /**
+     * @brief Attaches a shader with additional preprocessor definitions to the program.
+     * @throw `std::runtime_error` when the shader could not be loaded.
+     * @param filepath The file path to the shader source code.
+     * @param defines The definitions injected after the `#version` directive, either `NAME` or `NAME VALUE`.
+     * @tparam type The type of shader, e.g. `GL_VERTEX_SHADER`, `GL_FRAGMENT_SHADER`, `GL_COMPUTE_SHADER`.
+     */
+    template <GLenum type>
+    void attach(const std::filesystem::path& filepath, const std::vector<std::string>& defines);
+
     /**
      * @brief Attaches a shader to the program.
      * Internally, this function creates a Shader object, calls Shader::load, attaches it to the program, and deletes the Shader object as it is no longer needed.
@@ -215,6 +235,13 @@ void Program::attach(const std::filesystem::path& filepath) {
     attach(shader);
 }
 
+template <GLenum type>
+void Program::attach(const std::filesystem::path& filepath, const std::vector<std::string>& defines) {
+    Shader<type> shader;
+    shader.load(filepath, defines);
+    attach(shader);
+}
+
 template <GLenum type>
 void Program::attachSource(const std::string& source) {
     Shader<type> shader;
@@ -0,0 +1,87 @@
+#include "programvariants.hpp"
+
+#include <glad/gl.h>
+
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "program.hpp"
+#include "shader.hpp"
+
+void ProgramVariants::load(const std::filesystem::path& vs, const std::filesystem::path& fs, const std::vector<std::string>& options, SetupFunction setup) {
+    if (options.size() > MAX_OPTIONS)
+        throw std::runtime_error("ProgramVariants supports at most " + std::to_string(MAX_OPTIONS) + " options");
+
+    // Resolve includes only once, variants only differ in the injected definitions
+    PathSet vsIncluded, fsIncluded;
+    vsPath = vs;
+    fsPath = fs;
+    vsSource = readShader(vs, vsIncluded);
+    fsSource = readShader(fs, fsIncluded);
+    this->options = options;
+    this->setup = std::move(setup);
+    variants.clear();
+}
+
+Program& ProgramVariants::get(Mask mask) {
+    auto cached = variants.find(mask);
+    if (cached != variants.end()) return cached->second;
+
+    const auto defines = getDefines(mask);
+    const std::string vs = injectDefines(vsSource, defines), fs = injectDefines(fsSource, defines);
+    // Every variant is written to its own file, e.g. `mesh.3.frag` for the mask 3
+    const auto variantName = [&](const std::filesystem::path& path) {
+        return path.stem().string() + "." + std::to_string(mask) + path.extension().string();
+    };
+    writeComposedShader(vs, variantName(vsPath));
+    writeComposedShader(fs, variantName(fsPath));
+    Program program;
+    program.attachSource<GL_VERTEX_SHADER>(vs);
+    program.attachSource<GL_FRAGMENT_SHADER>(fs);
+    program.link();
+    if (setup) setup(program);
+    return variants.emplace(mask, std::move(program)).first->second;
+}
+
+void ProgramVariants::use(Mask mask) {
+    get(mask).use();
+}
+
+void ProgramVariants::precompile(const std::vector<Mask>& masks) {
+    for (const auto mask : masks) get(mask);
+}
+
+ProgramVariants::Mask ProgramVariants::bit(const std::string& name) const {
+    for (size_t i = 0; i < options.size(); i++) {
+        if (options[i].substr(0, options[i].find(' ')) == name) return Mask(1) << i;
+    }
+    throw std::runtime_error("Unknown shader variant option " + name);
+}
+
+ProgramVariants::Mask ProgramVariants::mask(const std::vector<std::string>& names) const {
+    Mask result = 0;
+    for (const auto& name : names) result |= bit(name);
+    return result;
+}
+
+std::vector<std::string> ProgramVariants::getDefines(Mask mask) const {
+    std::vector<std::string> defines;
+    for (size_t i = 0; i < options.size(); i++) {
+        if (mask & (Mask(1) << i)) defines.push_back(options[i]);
+    }
+    return defines;
+}
+
+bool ProgramVariants::isCompiled(Mask mask) const {
+    return variants.count(mask) > 0;
+}
+
+size_t ProgramVariants::size() const {
+    return variants.size();
+}
+
+void ProgramVariants::clear() {
+    variants.clear();
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <glad/gl.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "program.hpp"
+
+/**
+ * @file programvariants.hpp
+ * @brief Defines a ProgramVariants class that manages specialized permutations of a Program.
+ */
+
+/**
+ * @class ProgramVariants
+ * @brief Cache of Program permutations that differ only in a set of preprocessor definitions.
+ * Every option is assigned one bit of a `ProgramVariants::Mask`, the variant for a mask is compiled with all options whose bit is set defined.
+ * Variants are compiled lazily on first use and cached, so fully specialized shaders can be selected at draw time instead of branching inside an uber-shader.
+ * Example:
+ * ```cpp
+ * variants.load("shaders/projection.vert", "shaders/debug.frag", {"DEBUG", "USE_NORMAL_MAP"}, [](Program& p) {
+ *     p.bindUBO("WorldBuffer", 0);
+ * });
+ * variants.use(variants.mask({"DEBUG"}));
+ * ```
+ */
+class ProgramVariants {
+   public:
+    /**
+     * @brief Bitmask selecting a variant, bit `i` enables option `i`.
+     */
+    using Mask = uint32_t;
+
+    /**
+     * @brief Function called once for every newly compiled variant, e.g. to bind uniform blocks and texture units.
+     */
+    using SetupFunction = std::function<void(Program&)>;
+
+    /**
+     * @brief The maximum number of options, limited by the width of `ProgramVariants::Mask`.
+     */
+    static constexpr size_t MAX_OPTIONS = sizeof(Mask) * 8;
+
+    /**
+     * @brief Reads the vertex and fragment shader sources and resolves their includes, no variant is compiled yet.
+     * Clears all previously compiled variants.
+     * @throw `std::runtime_error` when the shaders could not be read or there are more than `MAX_OPTIONS` options.
+     * @param vs The file path to the vertex shader source code.
+     * @param fs The file path to the fragment shader source code.
+     * @param options The definitions toggled by the bits of a mask, either `NAME` or `NAME VALUE`.
+     * @param setup Function called once for every newly compiled variant.
+     */
+    void load(const std::filesystem::path& vs, const std::filesystem::path& fs, const std::vector<std::string>& options, SetupFunction setup = nullptr);
+
+    /**
+     * @brief Returns the variant for the given mask, compiling and linking it if it is not cached yet.
+     * @throw `std::runtime_error` when the variant could not be compiled or linked.
+     */
+    Program& get(Mask mask);
+
+    /**
+     * @brief Uses the variant for the given mask for rendering, compiling it first if necessary.
+     */
+    void use(Mask mask);
+
+    /**
+     * @brief Compiles the given variants ahead of time to avoid hitches on first use.
+     */
+    void precompile(const std::vector<Mask>& masks);
+
+    /**
+     * @brief Gets the bit of an option by its name (the part before the first space).
+     * @throw `std::runtime_error` when the option does not exist.
+     */
+    Mask bit(const std::string& name) const;
+
+    /**
+     * @brief Combines the bits of multiple options into a mask.
+     * @throw `std::runtime_error` when an option does not exist.
+     */
+    Mask mask(const std::vector<std::string>& names) const;
+
+    /**
+     * @brief Gets the definitions that are injected for the given mask.
+     */
+    std::vector<std::string> getDefines(Mask mask) const;
+
+    /**
+     * @brief Whether the variant for the given mask is already compiled.
+     */
+    bool isCompiled(Mask mask) const;
+
+    /**
+     * @brief The number of compiled variants.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Deletes all compiled variants, they are recompiled on next use.
+     */
+    void clear();
+
+   private:
+    std::filesystem::path vsPath;
+    std::filesystem::path fsPath;
+    std::string vsSource;
+    std::string fsSource;
+    std::vector<std::string> options;
+    SetupFunction setup;
+    std::unordered_map<Mask, Program> variants;
+};
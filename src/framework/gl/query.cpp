@@ -38,4 +38,38 @@ GLuint Query::end(GLenum target) {
     GLuint result;
     glGetQueryObjectuiv(handle, GL_QUERY_RESULT, &result);
     return result;
+}
+
+void Query::endAsync(GLenum target) {
+    glEndQuery(target);
+}
+
+bool Query::isResultAvailable() const {
+    GLuint available;
+    glGetQueryObjectuiv(handle, GL_QUERY_RESULT_AVAILABLE, &available);
+    return available == GL_TRUE;
+}
+
+GLuint Query::getResult() const {
+    GLuint result;
+    glGetQueryObjectuiv(handle, GL_QUERY_RESULT, &result);
+    return result;
+}
+
+void Query::timestamp() {
+    glQueryCounter(handle, GL_TIMESTAMP);
+}
+
+GLuint64 Query::getResult64() const {
+    GLuint64 result;
+    glGetQueryObjectui64v(handle, GL_QUERY_RESULT, &result);
+    return result;
+}
+
+void Query::beginConditionalRender(GLenum mode) const {
+    glBeginConditionalRender(handle, mode);
+}
+
+void Query::endConditionalRender() {
+    glEndConditionalRender();
 }
\ No newline at end of file
@@ -9,7 +9,7 @@
 
 /**
  * @class Query
- * @brief RAII wrapper for OpenGL query with helper functions for timing queries.
+ * @brief RAII wrapper for OpenGL query with helper functions for timing queries and conditional rendering.
  * See https://www.khronos.org/opengl/wiki/Query_Object for more information.
  */
 class Query {
@@ -68,6 +68,47 @@ class Query {
      */
     GLuint end(GLenum target);
 
+    /**
+     * @brief Ends the query for the specified target without waiting for the result.
+     * The result can be polled with `isResultAvailable` or consumed on the GPU with `beginConditionalRender`.
+     *
+     * @param target The target for which the query should end, e.g. `GL_ANY_SAMPLES_PASSED`.
+     */
+    void endAsync(GLenum target);
+
+    /**
+     * @brief Checks whether the result of the last query is available, never stalls.
+     */
+    bool isResultAvailable() const;
+
+    /**
+     * @brief Gets the `GL_QUERY_RESULT` of the last query as unsigned integer, stalls until the GPU has finished it.
+     */
+    GLuint getResult() const;
+
+    /**
+     * @brief Records the GPU time once all previous commands have completed, read it with `getResult64`.
+     */
+    void timestamp();
+
+    /**
+     * @brief Gets the `GL_QUERY_RESULT` of the last query as 64 bit unsigned integer, e.g. the nanoseconds of `timestamp`, stalls until the GPU has finished it.
+     */
+    GLuint64 getResult64() const;
+
+    /**
+     * @brief Begins conditional rendering, draw calls until `endConditionalRender` are discarded on the GPU if the query passed no samples.
+     * See https://www.khronos.org/opengl/wiki/Conditional_Rendering for more information.
+     *
+     * @param mode How the GPU waits for the result, e.g. `GL_QUERY_NO_WAIT` draws anyway while the result is not available.
+     */
+    void beginConditionalRender(GLenum mode) const;
+
+    /**
+     * @brief Ends conditional rendering.
+     */
+    static void endConditionalRender();
+
     /**
      * @brief The unique handle that identifies the query object on the GPU.
      */
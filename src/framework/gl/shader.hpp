@@ -4,13 +4,16 @@
 
 #include <regex>
 #include <unordered_set>
+#include <vector>
 #include <stdexcept>
 #include <string>
 #include <filesystem>
 #include <array>
+#include <algorithm>
 
 #include "framework/common.hpp"
 #include "framework/context.hpp"
+#include "framework/trace.hpp"
 
 /**
  * @file shader.hpp
@@ -74,6 +77,15 @@ class Shader {
      */
     void load(const std::filesystem::path& filepath);
 
+    /**
+     * @brief Loads and compiles the shader source code from a file with additional preprocessor definitions.
+     * The definitions are injected directly after the `#version` directive, see `injectDefines`.
+     * @throw `std::runtime_error` when the file could not be parsed or the shader could not be compiled.
+     * @param filepath The path to the file containing the shader source code.
+     * @param defines The definitions to inject, either `NAME` or `NAME VALUE`.
+     */
+    void load(const std::filesystem::path& filepath, const std::vector<std::string>& defines);
+
     /**
      * @brief Loads and compiles shader source code.
      * @throw `std::runtime_error` when the shader could not be compiled.
@@ -163,13 +175,57 @@ inline std::string readShader(const std::filesystem::path& filepath, PathSet& in
     return source;
 }
 
+/**
+ * @brief Injects preprocessor definitions into GLSL source code directly after the `#version` directive.
+ * A `#line` directive is appended so that compiler messages still refer to the line numbers of the original source.
+ * @param source The shader source code.
+ * @param defines The definitions to inject, either `NAME` or `NAME VALUE`.
+ * @return The source code with the definitions injected.
+ */
+inline std::string injectDefines(const std::string& source, const std::vector<std::string>& defines) {
+    if (defines.empty()) return source;
+
+    // #version has to be the first directive, so everything has to be inserted after it
+    size_t insertAt = 0;
+    const size_t version = source.find("#version");
+    if (version != std::string::npos) {
+        const size_t lineEnd = source.find('\n', version);
+        insertAt = lineEnd == std::string::npos ? source.size() : lineEnd + 1;
+    }
+    const size_t nextLine = std::count(source.begin(), source.begin() + insertAt, '\n') + 1;
+
+    std::string injected;
+    for (const auto& define : defines) injected += "#define " + define + "\n";
+    injected += "#line " + std::to_string(nextLine) + "\n";
+
+    std::string result = source.substr(0, insertAt);
+    if (!result.empty() && result.back() != '\n') result += '\n';
+    return result + injected + source.substr(insertAt);
+}
+
+/**
+ * @brief Writes a composed shader source as it is compiled, including the injected definitions, to `Context::COMPOSED_SHADER_DIR`.
+ * Does nothing unless `COMPOSE_SHADERS` is defined.
+ * @param source The composed source code.
+ * @param filename The name of the file in the directory, e.g. the name of the original shader file.
+ */
+inline void writeComposedShader(const std::string& source, const std::filesystem::path& filename) {
+#ifdef COMPOSE_SHADERS
+    Common::writeToFile(source, Context::COMPOSED_SHADER_DIR / filename);
+#endif
+}
+
 template <GLenum type>
 void Shader<type>::load(const std::filesystem::path& filepath) {
+    load(filepath, {});
+}
+
+template <GLenum type>
+void Shader<type>::load(const std::filesystem::path& filepath, const std::vector<std::string>& defines) {
+    TRACE_ZONE_TEXT("Shader::load", filepath.string());
     PathSet included;
-    std::string source = readShader(filepath, included);
-#ifdef COMPOSE_SHADERS
-    Common::writeToFile(source, Context::COMPOSED_SHADER_DIR / filepath.filepath);
-#endif
+    const std::string source = injectDefines(readShader(filepath, included), defines);
+    writeComposedShader(source, filepath.filename());
     loadSource(source);
 }
 
@@ -182,6 +238,7 @@ void Shader<type>::loadSource(const std::string& source) {
 
 template <GLenum type>
 void Shader<type>::compile() {
+    TRACE_ZONE("Shader::compile");
     glCompileShader(handle);
     int success;
     glGetShaderiv(handle, GL_COMPILE_STATUS, &success);
@@ -0,0 +1,228 @@
+#include "state.hpp"
+
+#include <glad/gl.h>
+
+#include <array>
+#include <unordered_map>
+
+namespace {
+    constexpr GLuint UNKNOWN = ~0u;
+
+    /** A unit has a binding per target, only the last one is cached so binding another target is never skipped */
+    struct TextureBinding {
+        GLenum target = GL_NONE;
+        GLuint texture = UNKNOWN;
+    };
+
+    struct BufferBinding {
+        GLuint buffer = UNKNOWN;
+        GLintptr offset = 0;
+        GLsizeiptr size = 0;
+    };
+
+    struct State {
+        GLuint program = UNKNOWN;
+        GLuint vao = UNKNOWN;
+        GLuint activeUnit = UNKNOWN;
+        std::array<TextureBinding, GLState::MAX_CACHED_TEXTURE_UNITS> textures;
+        std::array<BufferBinding, GLState::MAX_CACHED_BUFFER_INDICES> uniformBuffers;
+        std::array<BufferBinding, GLState::MAX_CACHED_BUFFER_INDICES> storageBuffers;
+        GLuint readFramebuffer = UNKNOWN;
+        GLuint drawFramebuffer = UNKNOWN;
+        std::unordered_map<GLenum, bool> capabilities;
+        int depthMask = -1;
+        int colorMask = -1;
+        GLenum depthFunc = GL_NONE;
+        GLenum cullFace = GL_NONE;
+        GLenum blendSrc = GL_NONE;
+        GLenum blendDst = GL_NONE;
+        std::array<GLint, 4> viewport = {-1, -1, -1, -1};
+    };
+
+    inline bool operator==(const TextureBinding& a, const TextureBinding& b) {
+        return a.target == b.target && a.texture == b.texture;
+    }
+
+    inline bool operator==(const BufferBinding& a, const BufferBinding& b) {
+        return a.buffer == b.buffer && a.offset == b.offset && a.size == b.size;
+    }
+
+    thread_local State state;
+    thread_local GLState::Statistics current;
+    thread_local GLState::Statistics lastFrame;
+
+    /* Updates the cached value and counts the change, returns whether the OpenGL call has to be issued */
+    template <typename T>
+    inline bool change(T& cached, const T& value) {
+        if (cached == value) {
+            current.elided++;
+            return false;
+        }
+        cached = value;
+        current.issued++;
+        return true;
+    }
+
+    inline BufferBinding* getBufferBinding(GLenum target, GLuint index) {
+        if (index >= GLState::MAX_CACHED_BUFFER_INDICES) return nullptr;
+        switch (target) {
+            case GL_UNIFORM_BUFFER: return &state.uniformBuffers[index];
+            case GL_SHADER_STORAGE_BUFFER: return &state.storageBuffers[index];
+            default: return nullptr;
+        }
+    }
+}
+
+void GLState::invalidate() {
+    state = State();
+}
+
+void GLState::newFrame() {
+    lastFrame = current;
+    current = Statistics();
+    invalidate();
+}
+
+const GLState::Statistics& GLState::getLastFrameStatistics() {
+    return lastFrame;
+}
+
+const GLState::Statistics& GLState::getCurrentStatistics() {
+    return current;
+}
+
+void GLState::useProgram(GLuint program) {
+    if (change(state.program, program)) glUseProgram(program);
+}
+
+void GLState::bindVertexArray(GLuint vao) {
+    if (change(state.vao, vao)) glBindVertexArray(vao);
+}
+
+void GLState::activeTexture(GLuint unit) {
+    if (change(state.activeUnit, unit)) glActiveTexture(GL_TEXTURE0 + unit);
+}
+
+void GLState::bindTexture(GLenum target, GLuint texture) {
+    if (state.activeUnit < MAX_CACHED_TEXTURE_UNITS) {
+        if (change(state.textures[state.activeUnit], TextureBinding{target, texture})) glBindTexture(target, texture);
+    } else {
+        // The binding changes on whichever unit OpenGL has active, so none of the cached units can be trusted anymore
+        state.textures.fill(TextureBinding());
+        current.issued++;
+        glBindTexture(target, texture);
+    }
+}
+
+void GLState::bindTextureUnit(GLuint unit, GLenum target, GLuint texture) {
+    if (unit < MAX_CACHED_TEXTURE_UNITS && !change(state.textures[unit], TextureBinding{target, texture})) return;
+    if (unit >= MAX_CACHED_TEXTURE_UNITS) current.issued++;
+#ifdef MODERN_GL
+    glBindTextureUnit(unit, texture);
+#else
+    activeTexture(unit);
+    glBindTexture(target, texture);
+#endif
+}
+
+void GLState::bindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+    BufferBinding* cached = getBufferBinding(target, index);
+    if (cached && !change(*cached, BufferBinding{buffer, 0, 0})) return;
+    if (!cached) current.issued++;
+    glBindBufferBase(target, index, buffer);
+}
+
+void GLState::bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+    BufferBinding* cached = getBufferBinding(target, index);
+    if (cached && !change(*cached, BufferBinding{buffer, offset, size})) return;
+    if (!cached) current.issued++;
+    glBindBufferRange(target, index, buffer, offset, size);
+}
+
+void GLState::bindFramebuffer(GLenum target, GLuint framebuffer) {
+    switch (target) {
+        case GL_READ_FRAMEBUFFER:
+            if (change(state.readFramebuffer, framebuffer)) glBindFramebuffer(target, framebuffer);
+            break;
+        case GL_DRAW_FRAMEBUFFER:
+            if (change(state.drawFramebuffer, framebuffer)) glBindFramebuffer(target, framebuffer);
+            break;
+        default:
+            if (state.readFramebuffer == framebuffer && state.drawFramebuffer == framebuffer) {
+                current.elided++;
+            } else {
+                state.readFramebuffer = state.drawFramebuffer = framebuffer;
+                current.issued++;
+                glBindFramebuffer(target, framebuffer);
+            }
+    }
+}
+
+void GLState::setEnabled(GLenum capability, bool enabled) {
+    auto cached = state.capabilities.find(capability);
+    if (cached != state.capabilities.end() && cached->second == enabled) {
+        current.elided++;
+        return;
+    }
+    state.capabilities[capability] = enabled;
+    current.issued++;
+    if (enabled) glEnable(capability);
+    else glDisable(capability);
+}
+
+void GLState::depthMask(bool enabled) {
+    if (change(state.depthMask, static_cast<int>(enabled))) glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+}
+
+void GLState::colorMask(bool red, bool green, bool blue, bool alpha) {
+    const int mask = red | green << 1 | blue << 2 | alpha << 3;
+    if (change(state.colorMask, mask)) glColorMask(red, green, blue, alpha);
+}
+
+void GLState::depthFunc(GLenum func) {
+    if (change(state.depthFunc, func)) glDepthFunc(func);
+}
+
+void GLState::cullFace(GLenum mode) {
+    if (change(state.cullFace, mode)) glCullFace(mode);
+}
+
+void GLState::blendFunc(GLenum sfactor, GLenum dfactor) {
+    if (state.blendSrc == sfactor && state.blendDst == dfactor) {
+        current.elided++;
+        return;
+    }
+    state.blendSrc = sfactor;
+    state.blendDst = dfactor;
+    current.issued++;
+    glBlendFunc(sfactor, dfactor);
+}
+
+void GLState::viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+    if (change(state.viewport, std::array<GLint, 4>{x, y, width, height})) glViewport(x, y, width, height);
+}
+
+void GLState::forgetProgram(GLuint program) {
+    if (state.program == program) state.program = UNKNOWN;
+}
+
+void GLState::forgetVertexArray(GLuint vao) {
+    if (state.vao == vao) state.vao = UNKNOWN;
+}
+
+void GLState::forgetTexture(GLuint texture) {
+    for (auto& bound : state.textures)
+        if (bound.texture == texture) bound = TextureBinding();
+}
+
+void GLState::forgetBuffer(GLuint buffer) {
+    for (auto& binding : state.uniformBuffers)
+        if (binding.buffer == buffer) binding = BufferBinding();
+    for (auto& binding : state.storageBuffers)
+        if (binding.buffer == buffer) binding = BufferBinding();
+}
+
+void GLState::forgetFramebuffer(GLuint framebuffer) {
+    if (state.readFramebuffer == framebuffer) state.readFramebuffer = UNKNOWN;
+    if (state.drawFramebuffer == framebuffer) state.drawFramebuffer = UNKNOWN;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <glad/gl.h>
+
+/**
+ * @file state.hpp
+ * @brief Defines a shadow copy of the OpenGL state that filters out redundant state changes.
+ */
+
+/**
+ * @brief Thread-local cache of the OpenGL binding and pipeline state.
+ * Every function compares the requested state with the last known state and only issues the OpenGL call if it differs.
+ * The wrapper classes (`Program`, `VertexArray`, `Texture`, `Buffer`, `Framebuffer`) route their binds through these functions.
+ * @note State changed with raw OpenGL calls is not tracked. Either use these functions or call `GLState::invalidate()` afterwards.
+ * The cache is invalidated at the beginning of every frame by `App::run`, so untracked changes can at most leak into the current frame.
+ */
+namespace GLState {
+
+    /** Number of texture units whose bindings are cached, higher units are always bound. */
+    constexpr GLuint MAX_CACHED_TEXTURE_UNITS = 32;
+
+    /** Number of indexed uniform and shader storage buffer bindings that are cached, higher indices are always bound. */
+    constexpr GLuint MAX_CACHED_BUFFER_INDICES = 32;
+
+    /**
+     * @brief Counts state changes that were passed to OpenGL and those that were skipped because they were redundant.
+     */
+    struct Statistics {
+        unsigned int issued = 0;
+        unsigned int elided = 0;
+    };
+
+    /**
+     * @brief Forgets the complete cached state, the next change of every state will be issued.
+     */
+    void invalidate();
+
+    /**
+     * @brief Ends the statistics of the current frame and invalidates the cache.
+     * Called by `App::run` once per frame.
+     */
+    void newFrame();
+
+    /**
+     * @brief Gets the statistics of the last completed frame.
+     */
+    const Statistics& getLastFrameStatistics();
+
+    /**
+     * @brief Gets the statistics of the frame in progress.
+     */
+    const Statistics& getCurrentStatistics();
+
+    /** @brief Cached `glUseProgram`. */
+    void useProgram(GLuint program);
+
+    /** @brief Cached `glBindVertexArray`. */
+    void bindVertexArray(GLuint vao);
+
+    /** @brief Cached `glActiveTexture`, `unit` is the index of the texture unit, not `GL_TEXTUREi`. */
+    void activeTexture(GLuint unit);
+
+    /** @brief Cached `glBindTexture` on the currently active texture unit. */
+    void bindTexture(GLenum target, GLuint texture);
+
+    /** @brief Cached `glBindTextureUnit` (or `glActiveTexture` + `glBindTexture` on OpenGL 4.1). */
+    void bindTextureUnit(GLuint unit, GLenum target, GLuint texture);
+
+    /** @brief Cached `glBindBufferBase`, only `GL_UNIFORM_BUFFER` and `GL_SHADER_STORAGE_BUFFER` bindings are cached. */
+    void bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+
+    /** @brief Cached `glBindBufferRange`, only `GL_UNIFORM_BUFFER` and `GL_SHADER_STORAGE_BUFFER` bindings are cached. */
+    void bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+
+    /** @brief Cached `glBindFramebuffer`, `GL_FRAMEBUFFER` sets both the read and the draw binding. */
+    void bindFramebuffer(GLenum target, GLuint framebuffer);
+
+    /** @brief Cached `glEnable`/`glDisable`. */
+    void setEnabled(GLenum capability, bool enabled);
+
+    /** @brief Cached `glEnable`. */
+    inline void enable(GLenum capability) { setEnabled(capability, true); }
+
+    /** @brief Cached `glDisable`. */
+    inline void disable(GLenum capability) { setEnabled(capability, false); }
+
+    /** @brief Cached `glDepthMask`. */
+    void depthMask(bool enabled);
+
+    /** @brief Cached `glColorMask`. */
+    void colorMask(bool red, bool green, bool blue, bool alpha);
+
+    /** @brief Cached `glDepthFunc`. */
+    void depthFunc(GLenum func);
+
+    /** @brief Cached `glCullFace`. */
+    void cullFace(GLenum mode);
+
+    /** @brief Cached `glBlendFunc`. */
+    void blendFunc(GLenum sfactor, GLenum dfactor);
+
+    /** @brief Cached `glViewport`. */
+    void viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+    /**
+     * @brief Removes a deleted object from the cache.
+     * OpenGL unbinds objects on deletion and may reuse their names, so the cache must not assume they are still bound.
+     * Called by the destructors of the wrapper classes.
+     */
+    void forgetProgram(GLuint program);
+    void forgetVertexArray(GLuint vao);
+    void forgetTexture(GLuint texture);
+    void forgetBuffer(GLuint buffer);
+    void forgetFramebuffer(GLuint framebuffer);
+}
@@ -0,0 +1,441 @@
+#include "texture.hpp"
+
+#include <stb_image.h>
+#include <stb_image_write.h>
+
+#include <glad/gl.h>
+
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "framework/context.hpp"
+#include "framework/dds.hpp"
+#include "framework/exr.hpp"
+#include "framework/ibl.hpp"
+#include "framework/pixelconvert.hpp"
+#include "framework/png.hpp"
+#include "framework/texturecache.hpp"
+#include "framework/trace.hpp"
+
+EXR::PixelType getEXRPixelType(GLenum internalFormat) {
+    switch (getBaseFormat(internalFormat)) {
+        case GL_DEPTH_COMPONENT:
+        case GL_DEPTH_STENCIL:
+            return EXR::PixelType::FLOAT;
+        default: break;
+    }
+    switch (getDataType(internalFormat)) {
+        case GL_UNSIGNED_BYTE:
+        case GL_BYTE:
+        case GL_HALF_FLOAT:
+            return EXR::PixelType::HALF;
+        default:
+            return EXR::PixelType::FLOAT;
+    }
+}
+
+template<GLenum target>
+void Texture<target>::_load2D(GLenum texTarget, GLenum internalFormat, const std::filesystem::path& filepath) {
+    GLsizei width, height, channelsInFile;
+    GLenum baseFormat = getBaseFormat(internalFormat);
+    GLsizei channels = getChannels(baseFormat);
+    GLenum dataType = getSTBPreferredDataType(internalFormat);
+    void* data;
+
+    // Load image from file and read format
+    Context::setWorkingDirectory(); // Ensure that the working directory is set correctly
+    TRACE_ZONE_TEXT("stb decode and upload", filepath.string());
+    switch (dataType) {
+        case GL_UNSIGNED_BYTE:
+            data = stbi_load(filepath.string().c_str(), &width, &height, &channelsInFile, channels);
+            break;
+        case GL_BYTE:
+            data = stbi_load(filepath.string().c_str(), &width, &height, &channelsInFile, channels);
+            // Convert from unsigned to signed bytes
+            if (data) PixelConvert::unsignedToSigned(static_cast<uint8_t*>(data), static_cast<int8_t*>(data), static_cast<size_t>(width) * height * channels);
+            break;
+        case GL_FLOAT:
+            data = stbi_loadf(filepath.string().c_str(), &width, &height, &channelsInFile, channels);
+            // Half float formats are converted on the CPU, which halves the upload and skips the driver conversion
+            if (data && getDataType(internalFormat) == GL_HALF_FLOAT) {
+                PixelConvert::floatToHalf(static_cast<float*>(data), static_cast<uint16_t*>(data), static_cast<size_t>(width) * height * channels);
+                dataType = GL_HALF_FLOAT;
+            }
+            break;
+        default: throw std::runtime_error("Unsupported texture format");
+    }
+
+    if (!data) throw std::runtime_error("Failed to parse image " + filepath.string() + ": " + stbi_failure_reason());
+
+    _load2D(texTarget, internalFormat, width, height, data, baseFormat, dataType);
+
+    // Free image data
+    stbi_image_free(data);
+}
+
+template<GLenum target>
+void Texture<target>::_load3D(GLint zindex, GLenum internalFormat, const std::filesystem::path& filepath) {
+    GLsizei width, height, channelsInFile;
+    GLenum baseFormat = getBaseFormat(internalFormat);
+    GLsizei channels = getChannels(baseFormat);
+    GLenum dataType = getSTBPreferredDataType(internalFormat);
+    void* data;
+
+    // Load image from file and read format
+    Context::setWorkingDirectory(); // Ensure that the working directory is set correctly
+    TRACE_ZONE_TEXT("stb decode and upload", filepath.string());
+    switch (dataType) {
+        case GL_UNSIGNED_BYTE:
+            data = stbi_load(filepath.string().c_str(), &width, &height, &channelsInFile, channels);
+            break;
+        case GL_BYTE:
+            data = stbi_load(filepath.string().c_str(), &width, &height, &channelsInFile, channels);
+            // Convert from unsigned to signed bytes
+            if (data) PixelConvert::unsignedToSigned(static_cast<uint8_t*>(data), static_cast<int8_t*>(data), static_cast<size_t>(width) * height * channels);
+            break;
+        case GL_FLOAT:
+            data = stbi_loadf(filepath.string().c_str(), &width, &height, &channelsInFile, channels);
+            // Half float formats are converted on the CPU, which halves the upload and skips the driver conversion
+            if (data && getDataType(internalFormat) == GL_HALF_FLOAT) {
+                PixelConvert::floatToHalf(static_cast<float*>(data), static_cast<uint16_t*>(data), static_cast<size_t>(width) * height * channels);
+                dataType = GL_HALF_FLOAT;
+            }
+            break;
+        default: throw std::runtime_error("Unsupported texture format");
+    }
+
+    if (!data) throw std::runtime_error("Failed to parse image " + filepath.string() + ": " + stbi_failure_reason());
+
+    _load3D(zindex, internalFormat, width, height, data, baseFormat, dataType);
+
+    // Free image data
+    stbi_image_free(data);
+}
+
+template<GLenum target>
+void Texture<target>::_loadCompressed(GLenum texTarget, GLint zindex, const TextureCache::CompressedImage& image) {
+    GLsizei width = image.width, height = image.height;
+    for (size_t level = 0; level < image.levels.size(); level++) {
+        const auto& blocks = image.levels[level];
+    #ifdef MODERN_GL
+        if constexpr (target == GL_TEXTURE_2D)
+            glCompressedTextureSubImage2D(handle, level, 0, 0, width, height, image.internalFormat, blocks.size(), blocks.data());
+        else
+            glCompressedTextureSubImage3D(handle, level, 0, 0, zindex, width, height, 1, image.internalFormat, blocks.size(), blocks.data());
+    #else
+        glCompressedTexImage2D(texTarget, level, image.internalFormat, width, height, 0, blocks.size(), blocks.data());
+    #endif
+        width = std::max(width / 2, 1);
+        height = std::max(height / 2, 1);
+    }
+}
+
+template<GLenum target>
+void Texture<target>::loadDDS(const std::filesystem::path& filepath) {
+    TRACE_ZONE_TEXT("Texture::loadDDS", filepath.string());
+    static_assert(target == GL_TEXTURE_2D || target == GL_TEXTURE_CUBE_MAP || target == GL_TEXTURE_2D_ARRAY, "loadDDS supports 2D, cubemap and 2D array textures");
+    Context::setWorkingDirectory(); // Ensure that the working directory is set correctly
+    const auto image = DDS::load(filepath);
+    if ((target == GL_TEXTURE_CUBE_MAP) != image.cubemap || (target == GL_TEXTURE_2D && image.layers != 1) || (target == GL_TEXTURE_CUBE_MAP && image.layers != 6))
+        throw std::runtime_error("The layout of " + filepath.string() + " does not match the texture target");
+    const bool compressed = image.isCompressed();
+
+#ifdef MODERN_GL
+    if constexpr (target == GL_TEXTURE_2D_ARRAY)
+        glTextureStorage3D(handle, image.levels, image.internalFormat, image.width, image.height, image.layers);
+    else
+        glTextureStorage2D(handle, image.levels, image.internalFormat, image.width, image.height);
+#else
+    bind();
+    glTexParameteri(target, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, image.levels - 1);
+#endif
+    GPUMemory::recordTexture(handle, target, image.internalFormat, image.width, image.height, image.layers, image.levels);
+    setLabel(filepath.filename().string());
+    if constexpr (target == GL_TEXTURE_CUBE_MAP) {
+        glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+        set(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        set(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        set(GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    }
+
+    // Rows of uncompressed surfaces are tightly packed
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (GLint level = 0; level < image.levels; level++) {
+    #ifndef MODERN_GL
+        if constexpr (target == GL_TEXTURE_2D_ARRAY) {
+            // Legacy array textures have to be allocated per level before the layers can be uploaded
+            const auto& first = image.getSurface(0, level);
+            if (compressed) glCompressedTexImage3D(target, level, image.internalFormat, first.width, first.height, image.layers, 0, static_cast<GLsizei>(first.size * image.layers), nullptr);
+            else glTexImage3D(target, level, image.internalFormat, first.width, first.height, image.layers, 0, image.baseFormat, image.dataType, nullptr);
+        }
+    #endif
+        for (GLint layer = 0; layer < image.layers; layer++) {
+            const auto& surface = image.getSurface(layer, level);
+            const auto size = static_cast<GLsizei>(surface.size);
+        #ifdef MODERN_GL
+            if constexpr (target == GL_TEXTURE_2D) {
+                if (compressed) glCompressedTextureSubImage2D(handle, level, 0, 0, surface.width, surface.height, image.internalFormat, size, surface.data);
+                else glTextureSubImage2D(handle, level, 0, 0, surface.width, surface.height, image.baseFormat, image.dataType, surface.data);
+            } else {
+                if (compressed) glCompressedTextureSubImage3D(handle, level, 0, 0, layer, surface.width, surface.height, 1, image.internalFormat, size, surface.data);
+                else glTextureSubImage3D(handle, level, 0, 0, layer, surface.width, surface.height, 1, image.baseFormat, image.dataType, surface.data);
+            }
+        #else
+            if constexpr (target == GL_TEXTURE_2D_ARRAY) {
+                if (compressed) glCompressedTexSubImage3D(target, level, 0, 0, layer, surface.width, surface.height, 1, image.internalFormat, size, surface.data);
+                else glTexSubImage3D(target, level, 0, 0, layer, surface.width, surface.height, 1, image.baseFormat, image.dataType, surface.data);
+            } else {
+                GLenum texTarget = target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + layer : target;
+                if (compressed) glCompressedTexImage2D(texTarget, level, image.internalFormat, surface.width, surface.height, 0, size, surface.data);
+                else glTexImage2D(texTarget, level, image.internalFormat, surface.width, surface.height, 0, image.baseFormat, image.dataType, surface.data);
+            }
+        #endif
+        }
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+template<GLenum target>
+void Texture<target>::load(GLenum internalFormat, const std::filesystem::path& filepath, GLint mipmaps) {
+    TRACE_ZONE_TEXT("Texture::load", filepath.string());
+    if constexpr (target == GL_TEXTURE_2D) {
+        if (filepath.extension() == ".dds") {
+            loadDDS(filepath);
+            return;
+        }
+    }
+
+    if (isCompressedFormat(internalFormat)) {
+        // Compressed formats cannot be rendered to, so the mipmaps are generated and encoded on the CPU
+        auto image = TextureCache::load(internalFormat, filepath, mipmaps, true);
+        GLint levels = static_cast<GLint>(image.levels.size());
+    #ifdef MODERN_GL
+        glTextureStorage2D(handle, levels, internalFormat, image.width, image.height);
+    #else
+        bind();
+        glTexParameteri(target, GL_TEXTURE_BASE_LEVEL, 0);
+        glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, levels - 1);
+    #endif
+        GPUMemory::recordTexture(handle, target, internalFormat, image.width, image.height, 1, levels);
+        setLabel(filepath.filename().string());
+        _loadCompressed(target, 0, image);
+        return;
+    }
+
+    stbi_set_flip_vertically_on_load(true); // OpenGL expects the origin to be at the bottom left
+
+    GLsizei width, height, channels;
+    Context::setWorkingDirectory(); // Ensure that the working directory is set correctly
+    if (!stbi_info(filepath.string().c_str(), &width, &height, &channels))
+        throw std::runtime_error("Failed to parse image " + filepath.string() + ": " + stbi_failure_reason());
+    GPUMemory::recordTexture(handle, target, internalFormat, width, height, 1, mipmaps + 1);
+    setLabel(filepath.filename().string());
+#ifdef MODERN_GL
+    glTextureStorage2D(handle, mipmaps + 1, internalFormat, width, height);
+#else
+    bind();
+    glTexParameteri(target, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, mipmaps); // Must be set to avoid crashes on some drivers
+#endif
+
+    _load2D(target, internalFormat, filepath);
+
+    // Generate mipmaps
+#ifdef MODERN_GL
+    if (mipmaps) glGenerateTextureMipmap(handle);
+#else
+    if (mipmaps) glGenerateMipmap(target);
+#endif
+}
+
+template<GLenum target>
+void Texture<target>::loadCubemap(GLenum internalFormat, const std::array<std::filesystem::path, 6>& filepaths, GLint mipmaps) {
+    TRACE_ZONE_TEXT("Texture::loadCubemap", filepaths[0].parent_path().string());
+    // For seamless cubemaps, call glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS)
+    glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+    stbi_set_flip_vertically_on_load(false); // Do not flip cubemap faces
+
+    if (isCompressedFormat(internalFormat)) {
+        std::array<TextureCache::CompressedImage, 6> faces;
+        for (size_t i = 0; i < faces.size(); i++) faces[i] = TextureCache::load(internalFormat, filepaths[i], mipmaps, false);
+        GLint levels = static_cast<GLint>(faces[0].levels.size());
+        GPUMemory::recordTexture(handle, target, internalFormat, faces[0].width, faces[0].height, 6, levels);
+        setLabel(filepaths[0].parent_path().filename().string());
+    #ifdef MODERN_GL
+        glTextureParameteri(handle, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTextureParameteri(handle, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTextureParameteri(handle, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        glTextureStorage2D(handle, levels, internalFormat, faces[0].width, faces[0].height);
+    #else
+        bind();
+        glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(target, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        glTexParameteri(target, GL_TEXTURE_BASE_LEVEL, 0);
+        glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, levels - 1);
+    #endif
+        for (size_t i = 0; i < faces.size(); i++) _loadCompressed(GL_TEXTURE_CUBE_MAP_POSITIVE_X + static_cast<GLenum>(i), static_cast<GLint>(i), faces[i]);
+        return;
+    }
+
+    GLsizei width, height, channels;
+    Context::setWorkingDirectory(); // Ensure that the working directory is set correctly
+    if (!stbi_info(filepaths[0].string().c_str(), &width, &height, &channels))
+        throw std::runtime_error("Failed to parse image " + filepaths[0].string() + ": " + stbi_failure_reason());
+    GPUMemory::recordTexture(handle, target, internalFormat, width, height, 6, mipmaps + 1);
+    setLabel(filepaths[0].parent_path().filename().string());
+#ifdef MODERN_GL
+    // Should always be set for cubemaps, see https://www.khronos.org/opengl/wiki_opengl/index.php?title=Common_Mistakes&section=14#Creating_a_Cubemap_Texture
+    glTextureParameteri(handle, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(handle, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(handle, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glTextureStorage2D(handle, mipmaps + 1, internalFormat, width, height);
+    for (int i = 0; i < filepaths.size(); i++) {
+        _load3D(i, internalFormat, filepaths[i]);
+    }
+#else
+    bind();
+    // Should always be set for cubemaps, see https://www.khronos.org/opengl/wiki_opengl/index.php?title=Common_Mistakes&section=14#Creating_a_Cubemap_Texture
+    glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(target, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glTexParameteri(target, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, mipmaps); // Must be set to avoid crashes on some drivers
+    _load2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X, internalFormat, filepaths[0]);
+    _load2D(GL_TEXTURE_CUBE_MAP_NEGATIVE_X, internalFormat, filepaths[1]);
+    _load2D(GL_TEXTURE_CUBE_MAP_POSITIVE_Y, internalFormat, filepaths[2]);
+    _load2D(GL_TEXTURE_CUBE_MAP_NEGATIVE_Y, internalFormat, filepaths[3]);
+    _load2D(GL_TEXTURE_CUBE_MAP_POSITIVE_Z, internalFormat, filepaths[4]);
+    _load2D(GL_TEXTURE_CUBE_MAP_NEGATIVE_Z, internalFormat, filepaths[5]);
+#endif
+
+    // Generate mipmaps
+#ifdef MODERN_GL
+    if (mipmaps) glGenerateTextureMipmap(handle);
+#else
+    if (mipmaps) glGenerateMipmap(target);
+#endif
+}
+
+template<GLenum target>
+void Texture<target>::loadCubemap(GLenum internalFormat, const std::filesystem::path& directory, GLint mipmaps) {
+    if constexpr (target == GL_TEXTURE_CUBE_MAP) {
+        if (directory.extension() == ".dds") {
+            loadDDS(directory);
+            return;
+        }
+        Context::setWorkingDirectory(); // Ensure that the working directory is set correctly
+        if (std::filesystem::is_regular_file(directory)) {
+            loadDDS(IBL::convertToCubemap(directory));
+            return;
+        }
+    }
+    std::array<std::filesystem::path, 6> filepaths = {
+        directory / "px.hdr",
+        directory / "nx.hdr",
+        directory / "py.hdr",
+        directory / "ny.hdr",
+        directory / "pz.hdr",
+        directory / "nz.hdr"
+    };
+    loadCubemap(internalFormat, filepaths, mipmaps);
+}
+
+template<GLenum target>
+bool Texture<target>::writeToFile(const std::filesystem::path& filepath) {
+    GLint width, height;
+    GLint internalFormat;
+
+#ifdef MODERN_GL
+    glGetTextureLevelParameteriv(handle, 0, GL_TEXTURE_WIDTH, &width);
+    glGetTextureLevelParameteriv(handle, 0, GL_TEXTURE_HEIGHT, &height);
+    glGetTextureLevelParameteriv(handle, 0, GL_TEXTURE_INTERNAL_FORMAT, &internalFormat);
+#else
+    bind();
+    glGetTexLevelParameteriv(target, 0, GL_TEXTURE_WIDTH, &width);
+    glGetTexLevelParameteriv(target, 0, GL_TEXTURE_HEIGHT, &height);
+    glGetTexLevelParameteriv(target, 0, GL_TEXTURE_INTERNAL_FORMAT, &internalFormat);
+#endif
+
+    GLenum baseFormat = getBaseFormat(internalFormat);
+
+    if (filepath.extension() == ".exr") {
+        // Depth is stored as the Z channel
+        bool depth = baseFormat == GL_DEPTH_COMPONENT || baseFormat == GL_DEPTH_STENCIL;
+        GLenum readFormat = depth ? GL_DEPTH_COMPONENT : baseFormat;
+        int channels = depth ? 1 : getChannels(baseFormat);
+        auto floatData = std::make_unique<float[]>(width * height * channels);
+
+    #ifdef MODERN_GL
+        glGetTextureImage(handle, 0, readFormat, GL_FLOAT, width * height * channels * sizeof(float), floatData.get());
+    #else
+        glGetTexImage(target, 0, readFormat, GL_FLOAT, floatData.get());
+    #endif
+
+        auto channelNames = depth ? std::string_view("Z") : std::string_view("RGBA").substr(0, channels);
+        return EXR::write(filepath, floatData.get(), width, height, channelNames, getEXRPixelType(internalFormat), EXR::Compression::ZIP, true);
+    }
+
+    GLenum dataType = getSTBPreferredDataType(internalFormat);
+    int channels = 4; // glTexImage2D always returns 4 channels
+
+    if (dataType == GL_FLOAT) {
+        auto floatData = std::make_unique<float[]>(width * height * channels);
+
+    #ifdef MODERN_GL
+        glGetTextureImage(handle, 0, baseFormat, dataType, width * height * channels * sizeof(float), floatData.get());
+    #else
+        glGetTexImage(target, 0, baseFormat, dataType, floatData.get());
+    #endif
+
+        PixelConvert::flipRows(floatData.get(), width * channels * sizeof(float), height);
+        return stbi_write_hdr(filepath.string().c_str(), width, height, channels, floatData.get());
+    } else if (dataType == GL_UNSIGNED_BYTE || dataType == GL_BYTE) {
+        auto byteData = std::make_unique<unsigned char[]>(width * height * channels);
+
+    #ifdef MODERN_GL
+        glGetTextureImage(handle, 0, baseFormat, dataType, width * height * channels * sizeof(unsigned char), byteData.get());
+    #else
+        glGetTexImage(target, 0, baseFormat, dataType, byteData.get());
+    #endif
+
+        // Convert from signed to unsigned bytes
+        if (dataType == GL_BYTE)
+            PixelConvert::signedToUnsigned(reinterpret_cast<int8_t*>(byteData.get()), byteData.get(), static_cast<size_t>(width) * height * channels);
+
+        auto ext = filepath.extension();
+        if (ext == ".png")
+            return PNG::write(filepath, byteData.get(), width, height, channels, true);
+
+        PixelConvert::flipRows(byteData.get(), width * channels, height);
+        if (ext == ".bmp")
+            return stbi_write_bmp(filepath.string().c_str(), width, height, channels, byteData.get());
+        else if (ext == ".tga")
+            return stbi_write_tga(filepath.string().c_str(), width, height, channels, byteData.get());
+        else if (ext == ".jpg" || ext == ".jpeg")
+            return stbi_write_jpg(filepath.string().c_str(), width, height, channels, byteData.get(), 95);
+        else
+            throw std::runtime_error("Unsupported image format");
+    } else throw std::runtime_error("Unsupported texture format");
+}
+
+// The loaders are only compiled here, for the targets that can be loaded from files
+#define INSTANTIATE_TEXTURE_LOADERS(target) \
+    template void Texture<target>::_load2D(GLenum, GLenum, const std::filesystem::path&); \
+    template void Texture<target>::_load3D(GLint, GLenum, const std::filesystem::path&); \
+    template void Texture<target>::_loadCompressed(GLenum, GLint, const TextureCache::CompressedImage&); \
+    template void Texture<target>::loadDDS(const std::filesystem::path&); \
+    template void Texture<target>::load(GLenum, const std::filesystem::path&, GLint); \
+    template void Texture<target>::loadCubemap(GLenum, const std::array<std::filesystem::path, 6>&, GLint); \
+    template void Texture<target>::loadCubemap(GLenum, const std::filesystem::path&, GLint); \
+    template bool Texture<target>::writeToFile(const std::filesystem::path&);
+
+INSTANTIATE_TEXTURE_LOADERS(GL_TEXTURE_2D)
+INSTANTIATE_TEXTURE_LOADERS(GL_TEXTURE_2D_ARRAY)
+INSTANTIATE_TEXTURE_LOADERS(GL_TEXTURE_CUBE_MAP)
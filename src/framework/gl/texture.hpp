@@ -5,19 +5,40 @@
 #include <string>
 #include <stdexcept>
 
-#include <stb_image.h>
-#include <stb_image_write.h>
-
 #include <glad/gl.h>
 
 #include "framework/common.hpp"
 #include "framework/context.hpp"
+#include "framework/gl/gpumemory.hpp"
+#include "framework/gl/state.hpp"
 
 /**
  * @file texture.hpp
  * @brief Defines a Texture class wrapper around the OpenGL texture object.
  */
 
+// The image codecs are only used by the loaders in texture.cpp, so they are not included by every user of `Texture`
+namespace EXR {
+    enum class PixelType;
+}
+namespace TextureCache {
+    struct CompressedImage;
+}
+
+// S3TC formats are only defined by EXT_texture_compression_s3tc, but are supported by every desktop driver
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+    #define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+    #define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+    #define GL_COMPRESSED_RGBA_S3TC_DXT3_EXT 0x83F2
+    #define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+    #define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+    #define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT 0x8C4D
+    #define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT 0x8C4E
+    #define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+
  /**
  * @brief Gets the number of channels from a base format, e.g. `GL_RED` returns 1, `GL_RGB` returns 3, etc.
  * @note See: https://gist.github.com/Kos/4739337
@@ -99,6 +120,26 @@ constexpr GLenum getBaseFormat(GLenum internalFormat) {
         case GL_DEPTH24_STENCIL8:
         case GL_DEPTH32F_STENCIL8:
             return GL_DEPTH_STENCIL;
+        case GL_COMPRESSED_RED_RGTC1:
+        case GL_COMPRESSED_SIGNED_RED_RGTC1:
+            return GL_RED;
+        case GL_COMPRESSED_RG_RGTC2:
+        case GL_COMPRESSED_SIGNED_RG_RGTC2:
+            return GL_RG;
+        case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT:
+        case GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
+            return GL_RGB;
+        case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT:
+        case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+        case GL_COMPRESSED_RGBA_BPTC_UNORM:
+        case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+            return GL_RGBA;
         default: throw std::runtime_error("getBaseFormat got unsupported internal format");
     }
     return GL_NONE;
@@ -209,16 +250,115 @@ constexpr GLenum getSTBPreferredDataType(GLenum internalFormat) {
     return GL_NONE;
 }
 
+/**
+ * @brief Gets the EXR pixel type that stores an internal format without loss, `HALF` for half float and 8 bit formats and `FLOAT` for everything else including depth.
+ */
+EXR::PixelType getEXRPixelType(GLenum internalFormat);
+
+/**
+ * @brief Gets the number of bytes of a 4x4 block of a block compressed internal format, e.g. `GL_COMPRESSED_RGB_S3TC_DXT1_EXT` (BC1) returns 8, `GL_COMPRESSED_RGBA_BPTC_UNORM` (BC7) returns 16.
+ * @return 0 for uncompressed formats.
+ */
+constexpr GLsizei getBlockBytes(GLenum internalFormat) {
+    switch (internalFormat) {
+        case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_RED_RGTC1:
+        case GL_COMPRESSED_SIGNED_RED_RGTC1:
+            return 8;
+        case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT:
+        case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+        case GL_COMPRESSED_RG_RGTC2:
+        case GL_COMPRESSED_SIGNED_RG_RGTC2:
+        case GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT:
+        case GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
+        case GL_COMPRESSED_RGBA_BPTC_UNORM:
+        case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+            return 16;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @brief Checks whether an internal format is block compressed (BC1-BC7), such textures are uploaded with `glCompressedTextureSubImage2D`.
+ */
+constexpr bool isCompressedFormat(GLenum internalFormat) {
+    return getBlockBytes(internalFormat) > 0;
+}
+
+/**
+ * @brief Gets the number of bytes of one mip level of a block compressed internal format.
+ */
+constexpr size_t getCompressedSize(GLenum internalFormat, GLsizei width, GLsizei height) {
+    return static_cast<size_t>((width + 3) / 4) * static_cast<size_t>((height + 3) / 4) * getBlockBytes(internalFormat);
+}
+
+/**
+ * @brief Gets the number of bytes per pixel of an uncompressed internal format, e.g. `GL_RGBA8` returns 4, `GL_RGBA16F` returns 8, etc.
+ * Unknown formats are assumed to have 4 bytes, so the result is only suitable for memory statistics.
+ */
+constexpr size_t getBytesPerPixel(GLenum internalFormat) {
+    switch (internalFormat) {
+        case GL_R8: case GL_R8_SNORM:
+            return 1;
+        case GL_RG8: case GL_RG8_SNORM: case GL_R16F: case GL_DEPTH_COMPONENT16:
+            return 2;
+        case GL_RGB8: case GL_RGB8_SNORM: case GL_SRGB8:
+            return 3;
+        case GL_RGBA8: case GL_RGBA8_SNORM: case GL_SRGB8_ALPHA8: case GL_RG16F: case GL_R32F: case GL_R11F_G11F_B10F: case GL_RGB10_A2:
+        case GL_DEPTH_COMPONENT24: case GL_DEPTH_COMPONENT32: case GL_DEPTH_COMPONENT32F: case GL_DEPTH24_STENCIL8:
+            return 4;
+        case GL_RGB16F:
+            return 6;
+        case GL_RGBA16F: case GL_RG32F: case GL_DEPTH32F_STENCIL8:
+            return 8;
+        case GL_RGB32F:
+            return 12;
+        case GL_RGBA32F:
+            return 16;
+        default:
+            return 4;
+    }
+}
+
+/**
+ * @brief Gets the framebuffer attachment point of an internal format, e.g. `GL_DEPTH_COMPONENT32F` returns `GL_DEPTH_ATTACHMENT`, color formats return `GL_COLOR_ATTACHMENT0`.
+ */
+constexpr GLenum getAttachment(GLenum internalFormat) {
+    // Does not use `getBaseFormat`, which throws for color formats that are valid render targets, e.g. integer formats
+    switch (internalFormat) {
+        case GL_DEPTH_COMPONENT:
+        case GL_DEPTH_COMPONENT16:
+        case GL_DEPTH_COMPONENT24:
+        case GL_DEPTH_COMPONENT32:
+        case GL_DEPTH_COMPONENT32F:
+            return GL_DEPTH_ATTACHMENT;
+        case GL_DEPTH_STENCIL:
+        case GL_DEPTH24_STENCIL8:
+        case GL_DEPTH32F_STENCIL8:
+            return GL_DEPTH_STENCIL_ATTACHMENT;
+        default:
+            return GL_COLOR_ATTACHMENT0;
+    }
+}
+
 /**
  * @class Texture
  * @brief RAII wrapper for OpenGL texture with helper functions for loading 2D textures and cubemaps.
  * For OpenGL 4.1 the textures are mutable, mutable texture creation with `glTexImage2D` though should be avoided because it is slower and more error-prone.
  * Thus with OpenGL 4.6 (`#define MODERN_GL`) this code uses immutable textures with `glTextureStorage2D` and DSA functions (https://www.khronos.org/opengl/wiki/Direct_State_Access).
+ * The size of the storage is recorded in the `GPUMemory` registry, loaded textures are labeled with the name of their file.
  * See https://www.khronos.org/opengl/wiki/Texture for more information.
  * @tparam target The target/type for which the texture should be created, e.g. `GL_TEXTURE_2D`, `GL_TEXTURE_3D`, `GL_TEXTURE_CUBE_MAP`, etc.
  * In legacy OpenGL (< 4.5) the texture is bound to a target to interact with it.
  * In this versions a target is like a slot that can hold exactly one object.
  * Thankfully, since 4.5 this design choice was superseded by https://www.khronos.org/opengl/wiki/Direct_State_Access.
+ * The functions that read or write files are defined in texture.cpp and instantiated for `GL_TEXTURE_2D`, `GL_TEXTURE_2D_ARRAY` and `GL_TEXTURE_CUBE_MAP`.
  */
 template<GLenum target>
 class Texture {
@@ -284,6 +424,15 @@ class Texture {
      */
     void allocate2D(GLenum internalFormat, GLint width, GLint height, GLint mipmaps = 0);
 
+    /**
+     * @brief Allocates storage for a multisampled 2D texture, only valid for `GL_TEXTURE_2D_MULTISAMPLE`.
+     * @param internalFormat The internal format of the texture.
+     * @param width The width of the texture.
+     * @param height The height of the texture.
+     * @param samples The number of samples per pixel.
+     */
+    void allocate2DMultisample(GLenum internalFormat, GLint width, GLint height, GLsizei samples);
+
     /**
      * @brief Loads a 2D texture from memory.
      * @note Prefer `Texture::load`, as this function is incomplete and requires the texture first to be bound.
@@ -356,8 +505,28 @@ class Texture {
      */
     void _load3D(GLint zindex, GLenum format, const std::filesystem::path& filepath);
 
+    /**
+     * @brief Uploads all mip levels of a block compressed image, the storage has to be allocated already.
+     * @note Prefer `Texture::load`, as this function is incomplete and requires the texture first to be bound.
+     * @param texTarget The target texture type to load the texture into, cubemaps require special targets per face.
+     * @param zindex The layer or cubemap face to upload to, ignored for 2D textures.
+     * @param image The compressed image, see `TextureCache::load`.
+     */
+    void _loadCompressed(GLenum texTarget, GLint zindex, const TextureCache::CompressedImage& image);
+
+    /**
+     * @brief Loads a texture with all its mip levels, cubemap faces or array layers from a DDS file, see `DDS::load`.
+     * The surfaces are uploaded straight from the memory mapped file without decoding or generating mipmaps.
+     * Supported targets are `GL_TEXTURE_2D`, `GL_TEXTURE_CUBE_MAP` and `GL_TEXTURE_2D_ARRAY`, such files can be created with the `texconv` tool.
+     * @throw `std::runtime_error` when the file could not be parsed or does not match the target.
+     * @param filepath The path to the DDS file.
+     */
+    void loadDDS(const std::filesystem::path& filepath);
+
     /**
      * @brief Loads a texture from a file.
+     * Compressed formats (see `isCompressedFormat`) are encoded on the CPU on first use and read from the `TextureCache` afterwards.
+     * `.dds` files are loaded with `loadDDS`, in that case the format and mipmaps stored in the file are used.
      * @throw `std::runtime_error` when the file could not be parsed.
      * @param format The format of the texture. E.g. for standard color use `GL_SRGB8_ALPHA8`, for HDR use `GL_RGBA32F` or `GL_RGBA16F` and for normal maps `GL_RGB8_SNORM`. See https://www.khronos.org/opengl/wiki/Image_Format for more information.
      * @param filepath The path to the image file.
@@ -383,7 +552,8 @@ class Texture {
      * You can find free cubemaps at https://hdri-haven.com
      * @throw `std::runtime_error` when the file could not be parsed.
      * @param format The format of the texture. E.g. for standard color use `GL_SRGB8_ALPHA8`, for HDR use `GL_RGBA32F` or `GL_RGBA16F` and for normal maps `GL_RGB8_SNORM`. See https://www.khronos.org/opengl/wiki/Image_Format for more information.
-     * @param directory The path to the directory containing the image files as `px.hdr`, `nx.hdr`, `py.hdr`, `ny.hdr`, `pz.hdr`, and `nz.hdr`.
+     * @param directory The path to the directory containing the image files as `px.hdr`, `nx.hdr`, `py.hdr`, `ny.hdr`, `pz.hdr`, and `nz.hdr`, or a `.dds` cubemap which is loaded with `loadDDS`.
+     * A single panorama image (equirectangular or vertical cross) is converted with `IBL::convertToCubemap` and cached as a `GL_RGBA16F` DDS file with a full mip chain.
      * @param mipmaps The number of mipmaps to generate (default is 0, which means to generate no mipmaps).
      * @note You may have to flip the cubemap by accessing it with `texture(tCubemap, rayDir * vec3(-1, 1, 1)).rgb;`
      */
@@ -391,6 +561,7 @@ class Texture {
 
     /**
      * @brief Writes the texture data to a file.
+     * Float, half and depth textures are written losslessly to `.exr` files, see `getEXRPixelType`, or as RGBE to `.hdr` files.
      * @param filepath The path to the output file.
      * @return True if the write operation was successful, false otherwise.
      */
@@ -420,6 +591,11 @@ class Texture {
      */
     GLint get(GLenum parameter, GLint level);
 
+    /**
+     * @brief Sets the name of the texture shown in the `GPUMemory` statistics and in OpenGL debuggers.
+     */
+    void setLabel(const std::string& label);
+
     /**
      * @brief The unique handle that identifies the texture object on the GPU.
      */
@@ -464,24 +640,23 @@ Texture<target>::~Texture() {
 
 template<GLenum target>
 void Texture<target>::release() {
-    if (handle) glDeleteTextures(1, &handle);
+    if (handle) {
+        GLState::forgetTexture(handle);
+        GPUMemory::releaseTexture(handle);
+        glDeleteTextures(1, &handle);
+    }
 }
 /////////////////////////////////////////////////////////////
 
 template<GLenum target>
 void Texture<target>::bind() {
-    glBindTexture(target, handle);
+    GLState::bindTexture(target, handle);
 }
 
 template<GLenum target>
 void Texture<target>::bindTextureUnit(GLuint index) {
-#ifdef MODERN_GL
-    // On OpenGL 4.5+ one would use the DSA version glBindTextureUnit
-    glBindTextureUnit(index, handle);
-#else
-    glActiveTexture(GL_TEXTURE0 + index);
-    glBindTexture(target, handle);
-#endif
+    // On OpenGL 4.5+ this uses the DSA version glBindTextureUnit
+    GLState::bindTextureUnit(index, target, handle);
 }
 
 template<GLenum target>
@@ -496,6 +671,19 @@ void Texture<target>::allocate2D(GLenum internalFormat, GLint width, GLint heigh
         glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, mipmaps); // Must be set to avoid crashes on some drivers
         glTexImage2D(target, 0, internalFormat, width, height, 0, baseFormat, dataType, nullptr);
     #endif
+    GPUMemory::recordTexture(handle, target, internalFormat, width, height, 1, mipmaps + 1);
+}
+
+template<GLenum target>
+void Texture<target>::allocate2DMultisample(GLenum internalFormat, GLint width, GLint height, GLsizei samples) {
+    static_assert(target == GL_TEXTURE_2D_MULTISAMPLE, "allocate2DMultisample requires GL_TEXTURE_2D_MULTISAMPLE");
+    #ifdef MODERN_GL
+        glTextureStorage2DMultisample(handle, samples, internalFormat, width, height, GL_TRUE);
+    #else
+        bind();
+        glTexImage2DMultisample(target, samples, internalFormat, width, height, GL_TRUE);
+    #endif
+    GPUMemory::recordTexture(handle, target, internalFormat, width, height, 1, 1, samples);
 }
 
 template<GLenum target>
@@ -511,40 +699,6 @@ void Texture<target>::_load2D(GLenum texTarget, GLenum internalFormat, GLint wid
     #endif
 }
 
-template<GLenum target>
-void Texture<target>::_load2D(GLenum texTarget, GLenum internalFormat, const std::filesystem::path& filepath) {
-    GLsizei width, height, channelsInFile;
-    GLenum baseFormat = getBaseFormat(internalFormat);
-    GLsizei channels = getChannels(baseFormat);
-    GLenum dataType = getSTBPreferredDataType(internalFormat);
-    void* data;
-
-    // Load image from file and read format
-    Context::setWorkingDirectory(); // Ensure that the working directory is set correctly
-    switch (dataType) {
-        case GL_UNSIGNED_BYTE:
-            data = stbi_load(filepath.string().c_str(), &width, &height, &channelsInFile, channels);
-            break;
-        case GL_BYTE:
-            data = stbi_load(filepath.string().c_str(), &width, &height, &channelsInFile, channels);
-            // Convert from unsigned to signed bytes
-            for (int i = 0; i < width * height * channels; i++) static_cast<char*>(data)[i] -= 128;
-            break;
-        case GL_FLOAT:
-            data = stbi_loadf(filepath.string().c_str(), &width, &height, &channelsInFile, channels);
-            dataType = GL_FLOAT; // stbi_loadf returns float, but OpenGL expects half float
-            break;
-        default: throw std::runtime_error("Unsupported texture format");
-    }
-
-    if (!data) throw std::runtime_error("Failed to parse image " + filepath.string() + ": " + stbi_failure_reason());
-
-    _load2D(texTarget, internalFormat, width, height, data, baseFormat, dataType);
-
-    // Free image data
-    stbi_image_free(data);
-}
-
 template<GLenum target>
 void Texture<target>::_load3D(GLint zindex, GLenum internalFormat, GLint width, GLint height, void* data, GLenum baseFormat, GLenum dataType) {
     #ifdef MODERN_GL
@@ -554,181 +708,6 @@ void Texture<target>::_load3D(GLint zindex, GLenum internalFormat, GLint width,
     #endif
 }
 
-template<GLenum target>
-void Texture<target>::_load3D(GLint zindex, GLenum internalFormat, const std::filesystem::path& filepath) {
-    GLsizei width, height, channelsInFile;
-    GLenum baseFormat = getBaseFormat(internalFormat);
-    GLsizei channels = getChannels(baseFormat);
-    GLenum dataType = getSTBPreferredDataType(internalFormat);
-    void* data;
-
-    // Load image from file and read format
-    Context::setWorkingDirectory(); // Ensure that the working directory is set correctly
-    switch (dataType) {
-        case GL_UNSIGNED_BYTE:
-            data = stbi_load(filepath.string().c_str(), &width, &height, &channelsInFile, channels);
-            break;
-        case GL_BYTE:
-            data = stbi_load(filepath.string().c_str(), &width, &height, &channelsInFile, channels);
-            // Convert from unsigned to signed bytes
-            for (int i = 0; i < width * height * channels; i++) static_cast<char*>(data)[i] -= 128;
-            break;
-        case GL_FLOAT:
-            data = stbi_loadf(filepath.string().c_str(), &width, &height, &channelsInFile, channels);
-            break;
-        default: throw std::runtime_error("Unsupported texture format");
-    }
-
-    if (!data) throw std::runtime_error("Failed to parse image " + filepath.string() + ": " + stbi_failure_reason());
-
-    _load3D(zindex, internalFormat, width, height, data, baseFormat, dataType);
-
-    // Free image data
-    stbi_image_free(data);
-}
-
-template<GLenum target>
-void Texture<target>::load(GLenum internalFormat, const std::filesystem::path& filepath, GLint mipmaps) {
-    stbi_set_flip_vertically_on_load(true); // OpenGL expects the origin to be at the bottom left
-
-#ifdef MODERN_GL
-    GLsizei width, height, channels;
-    Context::setWorkingDirectory(); // Ensure that the working directory is set correctly
-    if (!stbi_info(filepath.string().c_str(), &width, &height, &channels))
-        throw std::runtime_error("Failed to parse image " + filepath.string() + ": " + stbi_failure_reason());
-    glTextureStorage2D(handle, mipmaps + 1, internalFormat, width, height);
-#else
-    bind();
-    glTexParameteri(target, GL_TEXTURE_BASE_LEVEL, 0);
-    glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, mipmaps); // Must be set to avoid crashes on some drivers
-#endif
-
-    _load2D(target, internalFormat, filepath);
-
-    // Generate mipmaps
-#ifdef MODERN_GL
-    if (mipmaps) glGenerateTextureMipmap(handle);
-#else
-    if (mipmaps) glGenerateMipmap(target);
-#endif
-}
-
-template<GLenum target>
-void Texture<target>::loadCubemap(GLenum internalFormat, const std::array<std::filesystem::path, 6>& filepaths, GLint mipmaps) {
-    // For seamless cubemaps, call glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS)
-    glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
-    stbi_set_flip_vertically_on_load(false); // Do not flip cubemap faces
-
-#ifdef MODERN_GL
-    // Should always be set for cubemaps, see https://www.khronos.org/opengl/wiki_opengl/index.php?title=Common_Mistakes&section=14#Creating_a_Cubemap_Texture
-    glTextureParameteri(handle, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTextureParameteri(handle, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTextureParameteri(handle, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-    GLsizei width, height, channels;
-    Context::setWorkingDirectory(); // Ensure that the working directory is set correctly
-    if (!stbi_info(filepaths[0].string().c_str(), &width, &height, &channels))
-        throw std::runtime_error("Failed to parse image " + filepaths[0].string() + ": " + stbi_failure_reason());
-    glTextureStorage2D(handle, mipmaps + 1, internalFormat, width, height);
-    for (int i = 0; i < filepaths.size(); i++) {
-        _load3D(i, internalFormat, filepaths[i]);
-    }
-#else
-    bind();
-    // Should always be set for cubemaps, see https://www.khronos.org/opengl/wiki_opengl/index.php?title=Common_Mistakes&section=14#Creating_a_Cubemap_Texture
-    glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(target, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-    glTexParameteri(target, GL_TEXTURE_BASE_LEVEL, 0);
-    glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, mipmaps); // Must be set to avoid crashes on some drivers
-    _load2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X, internalFormat, filepaths[0]);
-    _load2D(GL_TEXTURE_CUBE_MAP_NEGATIVE_X, internalFormat, filepaths[1]);
-    _load2D(GL_TEXTURE_CUBE_MAP_POSITIVE_Y, internalFormat, filepaths[2]);
-    _load2D(GL_TEXTURE_CUBE_MAP_NEGATIVE_Y, internalFormat, filepaths[3]);
-    _load2D(GL_TEXTURE_CUBE_MAP_POSITIVE_Z, internalFormat, filepaths[4]);
-    _load2D(GL_TEXTURE_CUBE_MAP_NEGATIVE_Z, internalFormat, filepaths[5]);
-#endif
-
-    // Generate mipmaps
-#ifdef MODERN_GL
-    if (mipmaps) glGenerateTextureMipmap(handle);
-#else
-    if (mipmaps) glGenerateMipmap(target);
-#endif
-}
-
-template<GLenum target>
-void Texture<target>::loadCubemap(GLenum internalFormat, const std::filesystem::path& directory, GLint mipmaps) {
-    std::array<std::filesystem::path, 6> filepaths = {
-        directory / "px.hdr",
-        directory / "nx.hdr",
-        directory / "py.hdr",
-        directory / "ny.hdr",
-        directory / "pz.hdr",
-        directory / "nz.hdr"
-    };
-    loadCubemap(internalFormat, filepaths, mipmaps);
-}
-
-template<GLenum target>
-bool Texture<target>::writeToFile(const std::filesystem::path& filepath) {
-    GLint width, height;
-    GLint internalFormat;
-
-#ifdef MODERN_GL
-    glGetTextureLevelParameteriv(handle, 0, GL_TEXTURE_WIDTH, &width);
-    glGetTextureLevelParameteriv(handle, 0, GL_TEXTURE_HEIGHT, &height);
-    glGetTextureLevelParameteriv(handle, 0, GL_TEXTURE_INTERNAL_FORMAT, &internalFormat);
-#else
-    bind();
-    glGetTexLevelParameteriv(target, 0, GL_TEXTURE_WIDTH, &width);
-    glGetTexLevelParameteriv(target, 0, GL_TEXTURE_HEIGHT, &height);
-    glGetTexLevelParameteriv(target, 0, GL_TEXTURE_INTERNAL_FORMAT, &internalFormat);
-#endif
-
-    GLenum baseFormat = getBaseFormat(internalFormat);
-    GLenum dataType = getSTBPreferredDataType(internalFormat);
-    int channels = 4; // glTexImage2D always returns 4 channels
-    
-    stbi_flip_vertically_on_write(true);
-
-    if (dataType == GL_FLOAT) {
-        auto floatData = std::make_unique<float[]>(width * height * channels);
-
-    #ifdef MODERN_GL
-        glGetTextureImage(handle, 0, baseFormat, dataType, width * height * channels * sizeof(float), floatData.get());
-    #else
-        glGetTexImage(target, 0, baseFormat, dataType, floatData.get());
-    #endif
-
-        return stbi_write_hdr(filepath.string().c_str(), width, height, channels, floatData.get());
-    } else if (dataType == GL_UNSIGNED_BYTE || dataType == GL_BYTE) {
-        auto byteData = std::make_unique<unsigned char[]>(width * height * channels);
-
-    #ifdef MODERN_GL
-        glGetTextureImage(handle, 0, baseFormat, dataType, width * height * channels * sizeof(unsigned char), byteData.get());
-    #else
-        glGetTexImage(target, 0, baseFormat, dataType, byteData.get());
-    #endif
-
-        // Convert from signed to unsigned bytes
-        if (dataType == GL_BYTE)
-            for (int i = 0; i < width * height * channels; i++)
-                byteData[i] += 128;
-        
-        auto ext = filepath.extension();
-        if (ext == ".bmp")
-            return stbi_write_bmp(filepath.string().c_str(), width, height, channels, byteData.get());
-        else if (ext == ".tga")
-            return stbi_write_tga(filepath.string().c_str(), width, height, channels, byteData.get());
-        else if (ext == ".jpg" || ext == ".jpeg")
-            return stbi_write_jpg(filepath.string().c_str(), width, height, channels, byteData.get(), 95);
-        else if (ext == ".png")
-            return stbi_write_png(filepath.string().c_str(), width, height, channels, byteData.get(), width * channels);
-        else
-            throw std::runtime_error("Unsupported image format");
-    } else throw std::runtime_error("Unsupported texture format");
-}
-
 template<GLenum target>
 void Texture<target>::set(GLenum parameter, GLenum value) {
 #ifdef MODERN_GL
@@ -759,4 +738,9 @@ GLint Texture<target>::get(GLenum parameter, GLint level) {
     glGetTexLevelParameteriv(target, level, parameter, &value);
 #endif
     return value;
+}
+
+template<GLenum target>
+void Texture<target>::setLabel(const std::string& label) {
+    GPUMemory::setLabel(GL_TEXTURE, handle, label);
 }
\ No newline at end of file
@@ -0,0 +1,154 @@
+#include "validation.hpp"
+
+#include <glad/gl.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdarg>
+#include <iostream>
+#include <unordered_map>
+
+#include "framework/gl/capture.hpp"
+
+namespace {
+    /** Only used on the thread of the OpenGL context, like the hooks of glad */
+    struct State {
+        GLValidation::Level level = GLValidation::Level::Off;
+        const bool* logCalls = nullptr;
+        bool profiling = false;
+        GLValidation::CallHook hook = nullptr;
+        /** Start of the call in progress, OpenGL calls do not nest */
+        std::chrono::steady_clock::time_point callStart;
+        /** glad passes the same string literal for every call of a function, so its address is the key */
+        std::unordered_map<const char*, size_t> indices;
+        std::vector<GLValidation::CallStats> current;
+        std::vector<GLValidation::CallStats> lastFrame;
+    };
+
+    State& getState() {
+        static State state;
+        return state;
+    }
+
+    void printCall(const char* name, int argumentCount, va_list args) {
+        std::cerr << name << "(";
+        // glad does not pass the types, reading an argument with the wrong one is undefined, so only functions with a known signature print their arguments
+        if (!GLCapture::printArguments(std::cerr, name, args) && argumentCount > 0) std::cerr << argumentCount << " arguments";
+        std::cerr << ")";
+    }
+
+    void preCallback(const char* name, GLADapiproc funcptr, int argumentCount, ...) {
+        auto& state = getState();
+        if (state.profiling) state.callStart = std::chrono::steady_clock::now();
+    }
+
+    void postCallback(void* ret, const char* name, GLADapiproc funcptr, int argumentCount, ...) {
+        auto& state = getState();
+        if (state.profiling) {
+            const auto time = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - state.callStart).count());
+            auto [it, inserted] = state.indices.try_emplace(name, state.current.size());
+            if (inserted) state.current.push_back({name, 0, 0});
+            auto& stats = state.current[it->second];
+            stats.count++;
+            stats.time += time;
+        }
+        if (state.hook) {
+            va_list args;
+            va_start(args, argumentCount);
+            state.hook(ret, name, argumentCount, args);
+            va_end(args);
+        }
+        if (state.level != GLValidation::Level::CallChecks) return;
+        const GLenum error = glad_glGetError();
+        const bool log = state.logCalls && *state.logCalls;
+        if (error == GL_NO_ERROR && !log) return;
+        va_list args;
+        va_start(args, argumentCount);
+        if (error != GL_NO_ERROR) std::cerr << "OpenGL Error: " << GLValidation::errorToString(error) << " in ";
+        printCall(name, argumentCount, args);
+        std::cerr << std::endl;
+        va_end(args);
+    }
+
+    /** Installs the hooks of glad only while they are needed, otherwise every call goes directly to the driver */
+    void updateHooks() {
+        const auto& state = getState();
+        if (state.level == GLValidation::Level::CallChecks || state.profiling || state.hook) {
+            gladSetGLPreCallback(preCallback);
+            gladSetGLPostCallback(postCallback);
+            gladInstallGLDebug();
+        } else {
+            gladUninstallGLDebug();
+        }
+    }
+}
+
+void GLValidation::setLevel(Level level) {
+    getState().level = level;
+    updateHooks();
+#ifdef MODERN_GL
+    if (level == Level::Off) glDisable(GL_DEBUG_OUTPUT);
+    else glEnable(GL_DEBUG_OUTPUT);
+    if (level == Level::SynchronousDebugOutput || level == Level::CallChecks) glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+    else glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+#endif
+}
+
+GLValidation::Level GLValidation::getLevel() {
+    return getState().level;
+}
+
+void GLValidation::setCallLogging(const bool* enabled) {
+    getState().logCalls = enabled;
+}
+
+void GLValidation::setProfiling(bool enabled) {
+    auto& state = getState();
+    state.profiling = enabled;
+    if (!enabled) {
+        state.indices.clear();
+        state.current.clear();
+        state.lastFrame.clear();
+    }
+    updateHooks();
+}
+
+bool GLValidation::isProfiling() {
+    return getState().profiling;
+}
+
+void GLValidation::setCallHook(CallHook hook) {
+    getState().hook = hook;
+    updateHooks();
+}
+
+void GLValidation::newFrame() {
+    auto& state = getState();
+    if (!state.profiling) return;
+    state.lastFrame.clear();
+    for (auto& stats : state.current) {
+        if (stats.count > 0) state.lastFrame.push_back(stats);
+        stats.count = 0;
+        stats.time = 0;
+    }
+    std::sort(state.lastFrame.begin(), state.lastFrame.end(), [](const CallStats& a, const CallStats& b) { return a.time > b.time; });
+}
+
+const std::vector<GLValidation::CallStats>& GLValidation::getFrameCalls() {
+    return getState().lastFrame;
+}
+
+std::string_view GLValidation::errorToString(GLenum error) {
+    switch (error) {
+        case GL_NO_ERROR: return "GL_NO_ERROR";
+        case GL_INVALID_ENUM: return "GL_INVALID_ENUM";
+        case GL_INVALID_VALUE: return "GL_INVALID_VALUE";
+        case GL_INVALID_OPERATION: return "GL_INVALID_OPERATION";
+        case GL_INVALID_FRAMEBUFFER_OPERATION: return "GL_INVALID_FRAMEBUFFER_OPERATION";
+        case GL_CONTEXT_LOST: return "GL_CONTEXT_LOST";
+        case GL_OUT_OF_MEMORY: return "GL_OUT_OF_MEMORY";
+        case GL_STACK_OVERFLOW: return "GL_STACK_OVERFLOW";
+        case GL_STACK_UNDERFLOW: return "GL_STACK_UNDERFLOW";
+        default: return "Unknown";
+    }
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <glad/gl.h>
+
+#include <cstdarg>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+/**
+ * @file validation.hpp
+ * @brief Defines the levels of OpenGL error checking and a per-function histogram of the OpenGL calls.
+ */
+
+/**
+ * @brief Selects how much OpenGL validation runs, from none to checking `glGetError` after every call.
+ * The per-call hooks of glad are only installed while `Level::CallChecks`, profiling or a call hook is active, otherwise glad calls the driver directly without overhead.
+ * Debug output requires OpenGL 4.3, so on the legacy path the two debug output levels behave like `Level::Off`.
+ */
+namespace GLValidation {
+
+    enum class Level {
+        /** No checks, for release builds */
+        Off,
+        /** `GL_DEBUG_OUTPUT`, messages may arrive later on another thread */
+        DebugOutput,
+        /** `GL_DEBUG_OUTPUT_SYNCHRONOUS`, messages arrive in the call that caused them */
+        SynchronousDebugOutput,
+        /** Synchronous debug output and `glGetError` after every call, errors are printed with the function and its arguments */
+        CallChecks
+    };
+
+    /** `Level::Off` in builds with `NDEBUG`, otherwise the strictest level that is not per call on the modern path */
+#ifdef NDEBUG
+    inline constexpr Level DEFAULT_LEVEL = Level::Off;
+#elif defined(MODERN_GL)
+    inline constexpr Level DEFAULT_LEVEL = Level::SynchronousDebugOutput;
+#else
+    inline constexpr Level DEFAULT_LEVEL = Level::CallChecks;
+#endif
+
+    /**
+     * @brief The calls to one OpenGL function in a frame.
+     */
+    struct CallStats {
+        const char* name = nullptr;
+        uint32_t count = 0;
+        /** CPU time in nanoseconds spent in the driver, including the overhead of the hook */
+        uint64_t time = 0;
+    };
+
+    /**
+     * @brief Observes every OpenGL call after it returned, e.g. `GLCapture`.
+     * @param result Points to the return value, `nullptr` for functions without one.
+     * @param args The arguments with the types of the function, promoted like all variadic arguments.
+     */
+    using CallHook = void (*)(void* result, const char* name, int argumentCount, va_list args);
+
+    /**
+     * @brief Sets the validation level, requires a current context.
+     */
+    void setLevel(Level level);
+
+    Level getLevel();
+
+    /**
+     * @brief Prints every call with its arguments while `*enabled` is true and the level is `Level::CallChecks`.
+     * @param enabled Read on every call so it can be toggled around a section, e.g. `App::traceOpenGLCalls`, or `nullptr` to disable.
+     */
+    void setCallLogging(const bool* enabled);
+
+    /**
+     * @brief Enables counting and timing every OpenGL call, independent of the validation level.
+     */
+    void setProfiling(bool enabled);
+
+    bool isProfiling();
+
+    /**
+     * @brief Sets a hook that is called after every OpenGL call independent of the validation level, `nullptr` removes it.
+     * Can be set before the context is created, e.g. to see the calls of the initialization.
+     */
+    void setCallHook(CallHook hook);
+
+    /**
+     * @brief Finishes the histogram of the current frame, called once per frame by `App::run`.
+     */
+    void newFrame();
+
+    /**
+     * @brief Gets the calls of the last finished frame, most expensive first.
+     */
+    const std::vector<CallStats>& getFrameCalls();
+
+    /**
+     * @brief Converts an error code returned by `glGetError` to its name.
+     */
+    std::string_view errorToString(GLenum error);
+}
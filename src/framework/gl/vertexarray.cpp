@@ -2,6 +2,8 @@
 
 #include <glad/gl.h>
 
+#include "state.hpp"
+
 /////////////////////// RAII behavior ///////////////////////
 VertexArray::VertexArray() {
 #ifdef MODERN_GL
@@ -29,10 +31,13 @@ VertexArray::~VertexArray() {
 }
 
 void VertexArray::release() {
-    if (handle) glDeleteVertexArrays(1, &handle);
+    if (handle) {
+        GLState::forgetVertexArray(handle);
+        glDeleteVertexArrays(1, &handle);
+    }
 }
 /////////////////////////////////////////////////////////////
 
 void VertexArray::bind() {
-    glBindVertexArray(handle);
+    GLState::bindVertexArray(handle);
 }
\ No newline at end of file
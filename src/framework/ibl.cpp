@@ -0,0 +1,470 @@
+#include "ibl.hpp"
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <stb_image.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "common.hpp"
+#include "dds.hpp"
+#include "framework/context.hpp"
+#include "pixelconvert.hpp"
+#include "texturecache.hpp"
+#include "threadpool.hpp"
+
+using namespace glm;
+
+namespace {
+
+constexpr uint32_t SH_MAGIC = 0x39485349; // "ISH9"
+constexpr uint32_t CACHE_VERSION = 1;
+constexpr float PI = 3.14159265358979f;
+
+/**
+ * @brief Gets the direction through the center of a texel in the face layout of OpenGL.
+ */
+vec3 texelToDirection(int face, GLsizei size, GLsizei x, GLsizei y) {
+    float u = 2.0f * (x + 0.5f) / size - 1.0f;
+    float v = 2.0f * (y + 0.5f) / size - 1.0f;
+    switch (face) {
+        case 0: return normalize(vec3(1.0f, -v, -u));
+        case 1: return normalize(vec3(-1.0f, -v, u));
+        case 2: return normalize(vec3(u, 1.0f, v));
+        case 3: return normalize(vec3(u, -1.0f, -v));
+        case 4: return normalize(vec3(u, -v, 1.0f));
+        default: return normalize(vec3(-u, -v, -1.0f));
+    }
+}
+
+/**
+ * @brief Gets the face and the coordinates in [0, 1] on the face for a direction, inverse of `texelToDirection`.
+ */
+int directionToFace(const vec3& direction, float& s, float& t) {
+    vec3 a = abs(direction);
+    int face;
+    float sc, tc, ma;
+    if (a.x >= a.y && a.x >= a.z) {
+        face = direction.x > 0.0f ? 0 : 1;
+        sc = direction.x > 0.0f ? -direction.z : direction.z;
+        tc = -direction.y;
+        ma = a.x;
+    } else if (a.y >= a.z) {
+        face = direction.y > 0.0f ? 2 : 3;
+        sc = direction.x;
+        tc = direction.y > 0.0f ? direction.z : -direction.z;
+        ma = a.y;
+    } else {
+        face = direction.z > 0.0f ? 4 : 5;
+        sc = direction.z > 0.0f ? direction.x : -direction.x;
+        tc = -direction.y;
+        ma = a.z;
+    }
+    s = 0.5f * (sc / ma + 1.0f);
+    t = 0.5f * (tc / ma + 1.0f);
+    return face;
+}
+
+/**
+ * @brief Gets the solid angle of a texel, see https://www.rorydriscoll.com/2012/01/15/cubemap-texel-solid-angle/
+ */
+float texelSolidAngle(GLsizei size, GLsizei x, GLsizei y) {
+    auto areaElement = [](float u, float v) { return std::atan2(u * v, std::sqrt(u * u + v * v + 1.0f)); };
+    float u0 = 2.0f * x / size - 1.0f, u1 = 2.0f * (x + 1) / size - 1.0f;
+    float v0 = 2.0f * y / size - 1.0f, v1 = 2.0f * (y + 1) / size - 1.0f;
+    return areaElement(u0, v0) - areaElement(u0, v1) - areaElement(u1, v0) + areaElement(u1, v1);
+}
+
+std::array<float, 9> shBasis(const vec3& n) {
+    return {
+        0.282095f,
+        0.488603f * n.y,
+        0.488603f * n.z,
+        0.488603f * n.x,
+        1.092548f * n.x * n.y,
+        1.092548f * n.y * n.z,
+        0.315392f * (3.0f * n.z * n.z - 1.0f),
+        1.092548f * n.x * n.z,
+        0.546274f * (n.x * n.x - n.y * n.y),
+    };
+}
+
+vec3 sampleEquirect(const float* rgb, GLsizei width, GLsizei height, const vec3& direction) {
+    float u = 0.5f + std::atan2(direction.x, -direction.z) / (2.0f * PI);
+    float v = std::acos(std::clamp(direction.y, -1.0f, 1.0f)) / PI;
+    float x = u * width - 0.5f, y = std::clamp(v * height - 0.5f, 0.0f, height - 1.0f);
+    GLsizei x0 = static_cast<GLsizei>(std::floor(x)), y0 = static_cast<GLsizei>(y);
+    float fx = x - x0, fy = y - y0;
+    GLsizei y1 = std::min(y0 + 1, height - 1);
+    // Wrap around horizontally
+    x0 = (x0 % width + width) % width;
+    GLsizei x1 = (x0 + 1) % width;
+    auto at = [&](GLsizei px, GLsizei py) { return make_vec3(rgb + (static_cast<size_t>(py) * width + px) * 3); };
+    return mix(mix(at(x0, y0), at(x1, y0), fx), mix(at(x0, y1), at(x1, y1), fx), fy);
+}
+
+float radicalInverse(uint32_t bits) {
+    bits = (bits << 16u) | (bits >> 16u);
+    bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+    bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+    bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+    bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+    return static_cast<float>(bits) * 2.3283064365386963e-10f;
+}
+
+struct Sample {
+    vec3 direction; // In tangent space with the normal along z
+    float weight;
+    float lod;
+};
+
+/**
+ * @brief Importance samples the GGX distribution for the view along the normal, the usual split sum assumption.
+ */
+std::vector<Sample> sampleGGX(float roughness, int samples, GLsizei sourceSize) {
+    const float alpha2 = std::pow(std::max(roughness * roughness, 1e-4f), 2.0f);
+    const float texelSolidAngle = 4.0f * PI / (6.0f * sourceSize * sourceSize);
+    std::vector<Sample> result;
+    for (int i = 0; i < samples; i++) {
+        float phi = 2.0f * PI * (i + 0.5f) / samples;
+        float xi = radicalInverse(static_cast<uint32_t>(i));
+        float cosTheta = std::sqrt((1.0f - xi) / (1.0f + (alpha2 - 1.0f) * xi));
+        float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+        vec3 h(sinTheta * std::cos(phi), sinTheta * std::sin(phi), cosTheta);
+        vec3 l = 2.0f * cosTheta * h - vec3(0.0f, 0.0f, 1.0f);
+        if (l.z <= 0.0f) continue;
+        // With the view along the normal the pdf of the reflected direction is D / 4
+        float denominator = cosTheta * cosTheta * (alpha2 - 1.0f) + 1.0f;
+        float pdf = alpha2 / (PI * denominator * denominator) / 4.0f;
+        float sampleSolidAngle = 1.0f / (samples * pdf);
+        float lod = std::max(0.5f * std::log2(sampleSolidAngle / texelSolidAngle) + 1.0f, 0.0f);
+        result.push_back({l, l.z, lod});
+    }
+    return result;
+}
+
+std::filesystem::path getCachePath(const std::filesystem::path& filepath, const std::string& suffix, size_t key) {
+    std::stringstream name;
+    name << filepath.stem().string() << "_" << std::hex << key << suffix;
+    return TextureCache::getDirectory() / name.str();
+}
+
+size_t getSourceKey(const std::filesystem::path& filepath) {
+    size_t key = 0;
+    Common::hash_combine(key, std::filesystem::absolute(filepath).string(), static_cast<uint64_t>(std::filesystem::file_size(filepath)),
+                         static_cast<int64_t>(std::filesystem::last_write_time(filepath).time_since_epoch().count()), CACHE_VERSION);
+    return key;
+}
+
+bool readSH(const std::filesystem::path& filepath, std::vector<vec3>& sh) {
+    std::ifstream file(filepath, std::ios::binary);
+    uint32_t header[2];
+    if (!file || !file.read(reinterpret_cast<char*>(header), sizeof(header))) return false;
+    if (header[0] != SH_MAGIC || header[1] != CACHE_VERSION) return false;
+    sh.resize(9);
+    return static_cast<bool>(file.read(reinterpret_cast<char*>(sh.data()), sizeof(vec3) * sh.size()));
+}
+
+void writeSH(const std::filesystem::path& filepath, const std::vector<vec3>& sh) {
+    std::ofstream file(filepath, std::ios::binary);
+    if (!file) throw std::runtime_error("Could not write " + filepath.string());
+    uint32_t header[2] = {SH_MAGIC, CACHE_VERSION};
+    file.write(reinterpret_cast<const char*>(header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(sh.data()), sizeof(vec3) * sh.size());
+}
+
+}
+
+vec3 IBL::Cubemap::sample(const vec3& direction, GLint level) const {
+    level = std::clamp(level, 0, static_cast<GLint>(levels.size()) - 1);
+    const GLsizei levelSize = std::max(size >> level, 1);
+    float s, t;
+    const auto& texels = levels[level][directionToFace(direction, s, t)];
+    // Bilinear filtering clamped to the face, seams are small enough for lighting
+    float x = std::clamp(s * levelSize - 0.5f, 0.0f, levelSize - 1.0f), y = std::clamp(t * levelSize - 0.5f, 0.0f, levelSize - 1.0f);
+    GLsizei x0 = static_cast<GLsizei>(x), y0 = static_cast<GLsizei>(y);
+    GLsizei x1 = std::min(x0 + 1, levelSize - 1), y1 = std::min(y0 + 1, levelSize - 1);
+    float fx = x - x0, fy = y - y0;
+    auto at = [&](GLsizei px, GLsizei py) { return make_vec3(texels.data() + (static_cast<size_t>(py) * levelSize + px) * 4); };
+    return mix(mix(at(x0, y0), at(x1, y0), fx), mix(at(x0, y1), at(x1, y1), fx), fy);
+}
+
+vec3 IBL::Cubemap::sampleLod(const vec3& direction, float lod) const {
+    lod = std::clamp(lod, 0.0f, static_cast<float>(levels.size() - 1));
+    GLint level = static_cast<GLint>(lod);
+    float fraction = lod - level;
+    if (fraction == 0.0f) return sample(direction, level);
+    return mix(sample(direction, level), sample(direction, level + 1), fraction);
+}
+
+void IBL::Cubemap::generateMipmaps() {
+    levels.resize(1);
+    // Odd sizes round down, e.g. 125 to 62, so the stride of the previous level is kept instead of derived from the new one
+    GLsizei sourceSize = size;
+    for (GLsizei levelSize = size / 2; levelSize >= 1; sourceSize = levelSize, levelSize /= 2) {
+        std::array<std::vector<float>, 6> faces;
+        for (int face = 0; face < 6; face++) {
+            const auto& source = levels.back()[face];
+            auto& texels = faces[face];
+            texels.resize(static_cast<size_t>(levelSize) * levelSize * 4);
+            for (GLsizei y = 0; y < levelSize; y++) {
+                for (GLsizei x = 0; x < levelSize; x++) {
+                    for (int c = 0; c < 4; c++) {
+                        auto at = [&](GLsizei sx, GLsizei sy) { return source[(static_cast<size_t>(std::min(sy, sourceSize - 1)) * sourceSize + std::min(sx, sourceSize - 1)) * 4 + c]; };
+                        texels[(static_cast<size_t>(y) * levelSize + x) * 4 + c] =
+                            0.25f * (at(2 * x, 2 * y) + at(2 * x + 1, 2 * y) + at(2 * x, 2 * y + 1) + at(2 * x + 1, 2 * y + 1));
+                    }
+                }
+            }
+        }
+        levels.push_back(std::move(faces));
+    }
+}
+
+IBL::Cubemap IBL::equirectToCubemap(const float* rgb, GLsizei width, GLsizei height, GLsizei size) {
+    if (size <= 0) size = width / 4;
+    Cubemap cubemap;
+    cubemap.size = size;
+    cubemap.levels.resize(1);
+    for (auto& face : cubemap.levels[0]) face.resize(static_cast<size_t>(size) * size * 4);
+    ThreadPool::global().parallelFor(0, static_cast<size_t>(6 * size), [&](size_t row) {
+        const int face = static_cast<int>(row / size);
+        const GLsizei y = static_cast<GLsizei>(row % size);
+        float* texels = cubemap.levels[0][face].data() + static_cast<size_t>(y) * size * 4;
+        for (GLsizei x = 0; x < size; x++) {
+            // Mirror x to match the orientation of the cross layout
+            vec3 direction = texelToDirection(face, size, x, y) * vec3(-1.0f, 1.0f, 1.0f);
+            vec3 color = sampleEquirect(rgb, width, height, direction);
+            texels[4 * x + 0] = color.x;
+            texels[4 * x + 1] = color.y;
+            texels[4 * x + 2] = color.z;
+            texels[4 * x + 3] = 1.0f;
+        }
+    });
+    return cubemap;
+}
+
+IBL::Cubemap IBL::crossToCubemap(const float* rgb, GLsizei width, GLsizei height) {
+    const GLsizei size = width / 3;
+    // Position of each face in the cross in units of faces, -Z is upside down, see textures/cubemap_convert.sh
+    struct Placement {
+        GLsizei column, row;
+        bool rotate;
+    };
+    constexpr Placement PLACEMENTS[6] = {{2, 1, false}, {0, 1, false}, {1, 0, false}, {1, 2, false}, {1, 1, false}, {1, 3, true}};
+    Cubemap cubemap;
+    cubemap.size = size;
+    cubemap.levels.resize(1);
+    for (int face = 0; face < 6; face++) {
+        const auto& placement = PLACEMENTS[face];
+        auto& texels = cubemap.levels[0][face];
+        texels.resize(static_cast<size_t>(size) * size * 4);
+        for (GLsizei y = 0; y < size; y++) {
+            for (GLsizei x = 0; x < size; x++) {
+                GLsizei sx = placement.rotate ? size - 1 - x : x, sy = placement.rotate ? size - 1 - y : y;
+                const float* source = rgb + (static_cast<size_t>(placement.row * size + sy) * width + placement.column * size + sx) * 3;
+                float* texel = texels.data() + (static_cast<size_t>(y) * size + x) * 4;
+                texel[0] = source[0];
+                texel[1] = source[1];
+                texel[2] = source[2];
+                texel[3] = 1.0f;
+            }
+        }
+    }
+    return cubemap;
+}
+
+IBL::Cubemap IBL::loadPanorama(const std::filesystem::path& filepath, GLsizei size) {
+    Context::setWorkingDirectory(); // Ensure that the working directory is set correctly
+    stbi_set_flip_vertically_on_load(false);
+    GLsizei width, height, channelsInFile;
+    float* data = stbi_loadf(filepath.string().c_str(), &width, &height, &channelsInFile, 3);
+    if (!data) throw std::runtime_error("Failed to parse image " + filepath.string() + ": " + stbi_failure_reason());
+
+    Cubemap cubemap;
+    if (width == 2 * height) {
+        cubemap = equirectToCubemap(data, width, height, size);
+    } else if (3 * height == 4 * width) {
+        cubemap = crossToCubemap(data, width, height);
+    } else {
+        stbi_image_free(data);
+        throw std::runtime_error("Unknown panorama layout of " + filepath.string() + ", expected an equirectangular image or a vertical cross");
+    }
+    stbi_image_free(data);
+    cubemap.generateMipmaps();
+    return cubemap;
+}
+
+IBL::Cubemap IBL::loadCubemap(const std::filesystem::path& path, GLsizei size) {
+    Context::setWorkingDirectory(); // Ensure that the working directory is set correctly
+    if (std::filesystem::is_regular_file(path)) return loadPanorama(path, size);
+
+    // The same face files as `Texture::loadCubemap`
+    const std::array<const char*, 6> names = {"px.hdr", "nx.hdr", "py.hdr", "ny.hdr", "pz.hdr", "nz.hdr"};
+    stbi_set_flip_vertically_on_load(false);
+    Cubemap cubemap;
+    cubemap.levels.resize(1);
+    for (int face = 0; face < 6; face++) {
+        const std::filesystem::path filepath = path / names[face];
+        GLsizei width, height, channelsInFile;
+        float* data = stbi_loadf(filepath.string().c_str(), &width, &height, &channelsInFile, 4);
+        if (!data) throw std::runtime_error("Failed to parse image " + filepath.string() + ": " + stbi_failure_reason());
+        if (face == 0) cubemap.size = width;
+        if (width != height || width != cubemap.size) {
+            stbi_image_free(data);
+            throw std::runtime_error("Cubemap face " + filepath.string() + " is not square or differs in size from the other faces");
+        }
+        cubemap.levels[0][face].assign(data, data + static_cast<size_t>(width) * height * 4);
+        stbi_image_free(data);
+    }
+    cubemap.generateMipmaps();
+    return cubemap;
+}
+
+std::vector<vec3> IBL::computeIrradianceSH(const Cubemap& cubemap) {
+    // The irradiance is very smooth, so a small mip level is enough for the projection
+    GLint level = 0;
+    while ((cubemap.size >> level) > 64 && level + 1 < static_cast<GLint>(cubemap.levels.size())) level++;
+    const GLsizei size = std::max(cubemap.size >> level, 1);
+
+    std::vector<std::array<vec3, 9>> rows(6 * static_cast<size_t>(size));
+    ThreadPool::global().parallelFor(0, rows.size(), [&](size_t row) {
+        const int face = static_cast<int>(row / size);
+        const GLsizei y = static_cast<GLsizei>(row % size);
+        std::array<vec3, 9> sum{};
+        for (GLsizei x = 0; x < size; x++) {
+            vec3 direction = texelToDirection(face, size, x, y);
+            vec3 color = make_vec3(cubemap.levels[level][face].data() + (static_cast<size_t>(y) * size + x) * 4);
+            auto basis = shBasis(direction);
+            float solidAngle = texelSolidAngle(size, x, y);
+            for (int i = 0; i < 9; i++) sum[i] += color * (basis[i] * solidAngle);
+        }
+        rows[row] = sum;
+    });
+
+    std::vector<vec3> sh(9, vec3(0.0f));
+    for (const auto& row : rows)
+        for (int i = 0; i < 9; i++) sh[i] += row[i];
+    // Convolve with the clamped cosine lobe and divide by pi to get the outgoing radiance of a white Lambertian surface
+    const float BAND_FACTORS[3] = {1.0f, 2.0f / 3.0f, 1.0f / 4.0f};
+    for (int i = 0; i < 9; i++) sh[i] *= BAND_FACTORS[i == 0 ? 0 : i < 4 ? 1 : 2];
+    return sh;
+}
+
+vec3 IBL::evaluateSH(const std::vector<vec3>& sh, const vec3& normal) {
+    auto basis = shBasis(normal);
+    vec3 result(0.0f);
+    for (int i = 0; i < 9; i++) result += sh[i] * basis[i];
+    return max(result, vec3(0.0f));
+}
+
+IBL::Cubemap IBL::prefilterGGX(const Cubemap& cubemap, GLsizei size, GLint levels, int samples) {
+    levels = std::clamp(levels, 1, static_cast<GLint>(std::log2(size)) + 1);
+    Cubemap result;
+    result.size = size;
+    result.levels.resize(levels);
+    const float baseLod = std::max(std::log2(static_cast<float>(cubemap.size) / size), 0.0f);
+    for (GLint level = 0; level < levels; level++) {
+        const GLsizei levelSize = std::max(size >> level, 1);
+        const float roughness = levels > 1 ? static_cast<float>(level) / (levels - 1) : 0.0f;
+        const auto sampleSet = level == 0 ? std::vector<Sample>() : sampleGGX(roughness, samples, cubemap.size);
+        for (auto& face : result.levels[level]) face.resize(static_cast<size_t>(levelSize) * levelSize * 4);
+
+        ThreadPool::global().parallelFor(0, static_cast<size_t>(6 * levelSize), [&](size_t row) {
+            const int face = static_cast<int>(row / levelSize);
+            const GLsizei y = static_cast<GLsizei>(row % levelSize);
+            float* texels = result.levels[level][face].data() + static_cast<size_t>(y) * levelSize * 4;
+            for (GLsizei x = 0; x < levelSize; x++) {
+                vec3 normal = texelToDirection(face, levelSize, x, y);
+                vec3 color;
+                if (level == 0) {
+                    // The base level is a mirror, only resample the cubemap
+                    color = cubemap.sampleLod(normal, baseLod);
+                } else {
+                    vec3 up = std::abs(normal.z) < 0.999f ? vec3(0.0f, 0.0f, 1.0f) : vec3(1.0f, 0.0f, 0.0f);
+                    vec3 tangent = normalize(cross(up, normal));
+                    vec3 bitangent = cross(normal, tangent);
+                    vec3 sum(0.0f);
+                    float weight = 0.0f;
+                    for (const auto& sample : sampleSet) {
+                        vec3 direction = tangent * sample.direction.x + bitangent * sample.direction.y + normal * sample.direction.z;
+                        sum += cubemap.sampleLod(direction, sample.lod) * sample.weight;
+                        weight += sample.weight;
+                    }
+                    color = weight > 0.0f ? sum / weight : vec3(0.0f);
+                }
+                texels[4 * x + 0] = color.x;
+                texels[4 * x + 1] = color.y;
+                texels[4 * x + 2] = color.z;
+                texels[4 * x + 3] = 1.0f;
+            }
+        });
+    }
+    return result;
+}
+
+void IBL::writeDDS(const std::filesystem::path& filepath, const Cubemap& cubemap) {
+    std::vector<std::vector<std::vector<uint8_t>>> layers(6);
+    for (int face = 0; face < 6; face++) {
+        for (const auto& level : cubemap.levels) {
+            const auto& texels = level[face];
+            std::vector<uint8_t> halfs(texels.size() * sizeof(uint16_t));
+            PixelConvert::floatToHalf(texels.data(), reinterpret_cast<uint16_t*>(halfs.data()), texels.size());
+            layers[face].push_back(std::move(halfs));
+        }
+    }
+    // Write to a temporary file first, so an interrupted run never leaves a truncated cache entry behind
+    std::error_code error;
+    std::filesystem::create_directories(filepath.parent_path(), error);
+    auto temporary = filepath;
+    temporary += ".tmp";
+    DDS::write(temporary, GL_RGBA16F, cubemap.size, cubemap.size, true, layers);
+    std::filesystem::rename(temporary, filepath);
+}
+
+std::filesystem::path IBL::convertToCubemap(const std::filesystem::path& filepath, GLsizei size) {
+    Context::setWorkingDirectory(); // Ensure that the working directory is set correctly
+    size_t key = getSourceKey(filepath);
+    Common::hash_combine(key, size);
+    auto cachePath = getCachePath(filepath, "_cubemap.dds", key);
+    if (std::filesystem::exists(cachePath)) return cachePath;
+
+    std::cout << "Converting " << std::filesystem::absolute(filepath) << " to a cubemap" << std::endl;
+    writeDDS(cachePath, loadPanorama(filepath, size));
+    return cachePath;
+}
+
+IBL::Environment IBL::load(const std::filesystem::path& filepath, GLsizei size, GLsizei specularSize, GLint specularLevels) {
+    Context::setWorkingDirectory(); // Ensure that the working directory is set correctly
+    size_t key = getSourceKey(filepath);
+    Common::hash_combine(key, size);
+    size_t specularKey = key;
+    Common::hash_combine(specularKey, specularSize, specularLevels);
+
+    Environment environment;
+    environment.cubemap = getCachePath(filepath, "_cubemap.dds", key);
+    environment.specular = getCachePath(filepath, "_specular.dds", specularKey);
+    environment.specularLevels = std::clamp(specularLevels, 1, static_cast<GLint>(std::log2(specularSize)) + 1);
+    auto shPath = getCachePath(filepath, "_sh.bin", key);
+    if (std::filesystem::exists(environment.cubemap) && std::filesystem::exists(environment.specular) && readSH(shPath, environment.irradianceSH))
+        return environment;
+
+    std::cout << "Precomputing image-based lighting for " << std::filesystem::absolute(filepath) << std::endl;
+    Cubemap cubemap = loadPanorama(filepath, size);
+    if (!std::filesystem::exists(environment.cubemap)) writeDDS(environment.cubemap, cubemap);
+    writeDDS(environment.specular, prefilterGGX(cubemap, specularSize, specularLevels));
+    environment.irradianceSH = computeIrradianceSH(cubemap);
+    writeSH(shPath, environment.irradianceSH);
+    return environment;
+}
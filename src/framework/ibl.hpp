@@ -0,0 +1,127 @@
+#pragma once
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include <array>
+#include <filesystem>
+#include <vector>
+
+/**
+ * @file ibl.hpp
+ * @brief Defines the precomputation of image-based lighting from a single panorama image.
+ */
+
+/**
+ * @brief Converts panoramas into cubemaps and precomputes image-based lighting on the CPU.
+ * Supported panoramas are equirectangular images (aspect ratio 2:1) and vertical crosses (aspect ratio 3:4, e.g. `textures/stpeters.hdr`).
+ * All results are cached as DDS files in the `TextureCache` directory, keyed by the source and the parameters and invalidated when the source changes,
+ * so after the first run loading an environment only costs reading the files.
+ * The faces use the same orientation as the faces cut by `textures/cubemap_convert.sh`, i.e. sample them with `texture(tCubemap, dir * vec3(-1, 1, 1))`,
+ * the spherical harmonics are given in the same mirrored space. `shaders/ibl.glsl` contains the matching lookups.
+ */
+namespace IBL {
+
+    /**
+     * @brief A cubemap with its mip chain in linear RGBA floats.
+     */
+    struct Cubemap {
+        GLsizei size = 0;
+        /** The RGBA texels of each face per mip level, faces in the order +X, -X, +Y, -Y, +Z, -Z, rows starting at the top of the face */
+        std::vector<std::array<std::vector<float>, 6>> levels;
+
+        /**
+         * @brief Bilinearly samples a mip level in a direction, using the face layout of OpenGL.
+         */
+        glm::vec3 sample(const glm::vec3& direction, GLint level = 0) const;
+        /**
+         * @brief Trilinearly samples a fractional mip level.
+         */
+        glm::vec3 sampleLod(const glm::vec3& direction, float lod) const;
+        /**
+         * @brief Fills the mip chain below the base level with a box filter.
+         */
+        void generateMipmaps();
+    };
+
+    /**
+     * @brief The cached results of `load`.
+     */
+    struct Environment {
+        /** The cubemap as an `GL_RGBA16F` DDS file with a full mip chain, load it with `Texture::loadDDS` */
+        std::filesystem::path cubemap;
+        /** The GGX prefiltered cubemap as an `GL_RGBA16F` DDS file, the roughness of level `i` is `i / (levels - 1)` */
+        std::filesystem::path specular;
+        /** The number of mip levels of the prefiltered cubemap */
+        GLint specularLevels = 0;
+        /** Nine RGB spherical harmonics coefficients of the diffuse irradiance divided by pi, set them as a `vec3[9]` uniform */
+        std::vector<glm::vec3> irradianceSH;
+    };
+
+    /**
+     * @brief Converts an equirectangular RGB float image into a cubemap, parallelized over the rows of the faces.
+     */
+    Cubemap equirectToCubemap(const float* rgb, GLsizei width, GLsizei height, GLsizei size);
+
+    /**
+     * @brief Cuts a vertical cross RGB float image into a cubemap.
+     */
+    Cubemap crossToCubemap(const float* rgb, GLsizei width, GLsizei height);
+
+    /**
+     * @brief Loads a panorama and converts it into a cubemap including its mip chain, the layout is detected from the aspect ratio.
+     * @param size The face size for equirectangular images, 0 uses a quarter of the width. Crosses keep their face size.
+     * @throw `std::runtime_error` when the file could not be parsed or has an unknown layout.
+     */
+    Cubemap loadPanorama(const std::filesystem::path& filepath, GLsizei size = 0);
+
+    /**
+     * @brief Loads the same cubemap as `Texture::loadCubemap` into memory, e.g. for rendering on the CPU.
+     * @param path A directory with the faces `px.hdr`, `nx.hdr`, `py.hdr`, `ny.hdr`, `pz.hdr` and `nz.hdr` or a panorama, see `loadPanorama`.
+     * @throw `std::runtime_error` when a file could not be parsed or the faces are not square and equally sized.
+     */
+    Cubemap loadCubemap(const std::filesystem::path& path, GLsizei size = 0);
+
+    /**
+     * @brief Projects the cosine convolved radiance of a cubemap onto the first three bands of spherical harmonics.
+     * @return Nine RGB coefficients which `evaluateSH` turns into the diffuse radiance of a white Lambertian surface.
+     */
+    std::vector<glm::vec3> computeIrradianceSH(const Cubemap& cubemap);
+
+    /**
+     * @brief Evaluates the irradiance spherical harmonics in a normal direction.
+     */
+    glm::vec3 evaluateSH(const std::vector<glm::vec3>& sh, const glm::vec3& normal);
+
+    /**
+     * @brief Prefilters a cubemap with the GGX distribution for increasing roughness per mip level.
+     * Uses importance sampling with samples taken from the mip level that matches their solid angle (filtered importance sampling),
+     * so few samples are enough for a noise-free result.
+     * @param size The face size of the base level, which is the unfiltered cubemap.
+     * @param levels The number of mip levels, the roughness of level `i` is `i / (levels - 1)`.
+     * @param samples The number of samples per texel.
+     */
+    Cubemap prefilterGGX(const Cubemap& cubemap, GLsizei size, GLint levels, int samples = 128);
+
+    /**
+     * @brief Writes a cubemap with all its levels as a `GL_RGBA16F` DDS file.
+     */
+    void writeDDS(const std::filesystem::path& filepath, const Cubemap& cubemap);
+
+    /**
+     * @brief Converts a panorama into a cubemap DDS file or returns the cached one.
+     * @param size The face size for equirectangular images, see `loadPanorama`.
+     */
+    std::filesystem::path convertToCubemap(const std::filesystem::path& filepath, GLsizei size = 0);
+
+    /**
+     * @brief Precomputes the image-based lighting of a panorama or loads it from the cache.
+     * @param filepath The path to the equirectangular or cross panorama.
+     * @param size The face size of the cubemap for equirectangular images, see `loadPanorama`.
+     * @param specularSize The face size of the base level of the prefiltered cubemap.
+     * @param specularLevels The number of roughness levels of the prefiltered cubemap.
+     * @throw `std::runtime_error` when the file could not be parsed.
+     */
+    Environment load(const std::filesystem::path& filepath, GLsizei size = 0, GLsizei specularSize = 128, GLint specularLevels = 6);
+
+}
@@ -9,6 +9,9 @@
 #include <vector>
 
 #include "series.hpp"
+#include "gl/gpumemory.hpp"
+#include "gl/state.hpp"
+#include "gl/validation.hpp"
 
 using namespace glm;
 
@@ -21,10 +24,103 @@ void ImGui::StatisticsWindow(float frametime, const vec2& resolution) {
     ImGui::PushStyleColor(ImGuiCol_WindowBg, ImVec4(0.0f, 0.0f, 0.0f, 0.5f));
     ImGui::Begin("Statistics", nullptr, ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoInputs | ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoSavedSettings);
     ImGui::Text("%2.1ffps (%2.1ffps) | %2.1fms (%2.1fms) | %.0fx%.0f", 1.0f / avg, 1.0f / frametime, avg * 1000.0f, frametime * 1000.0f, resolution.x, resolution.y);
+    const auto& state = GLState::getLastFrameStatistics();
+    ImGui::Text("GL state changes: %u issued | %u elided", state.issued, state.elided);
     ImGui::PopStyleColor();
     ImGui::End();
 }
 
+void ImGui::GPUMemoryWindow(size_t topConsumers) {
+    constexpr float MB = 1024.0f * 1024.0f;
+    ImGui::Begin("GPU Memory", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+    const auto totals = GPUMemory::getTotals();
+    const size_t total = GPUMemory::getTotal();
+    const size_t budget = GPUMemory::getBudget();
+    if (budget > 0) {
+        const std::string overlay = std::to_string(static_cast<int>(total / MB)) + " / " + std::to_string(static_cast<int>(budget / MB)) + " MB";
+        ImGui::ProgressBar(static_cast<float>(total) / static_cast<float>(budget), ImVec2(-1.0f, 0.0f), overlay.c_str());
+    } else {
+        ImGui::Text("Recorded: %.1f MB", total / MB);
+    }
+    for (size_t i = 0; i < totals.size(); i++) ImGui::Text("%s: %.1f MB", GPUMemory::CATEGORY_NAMES[i].data(), totals[i] / MB);
+    const auto driver = GPUMemory::queryDriver();
+    if (!driver.extension.empty()) {
+        if (driver.dedicated > 0) ImGui::Text("Driver (%s): %.0f of %.0f MB available", driver.extension.data(), driver.available / MB, driver.dedicated / MB);
+        else ImGui::Text("Driver (%s): %.0f MB available", driver.extension.data(), driver.available / MB);
+    }
+
+    const auto allocations = GPUMemory::getAllocations();
+    if (ImGui::BeginTable("Allocations", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+        ImGui::TableSetupColumn("Label");
+        ImGui::TableSetupColumn("Category");
+        ImGui::TableSetupColumn("Size");
+        ImGui::TableSetupColumn("Layout");
+        ImGui::TableHeadersRow();
+        for (size_t i = 0; i < std::min(topConsumers, allocations.size()); i++) {
+            const auto& allocation = allocations[i];
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            if (allocation.label.empty()) ImGui::Text("#%u", allocation.handle);
+            else ImGui::TextUnformatted(allocation.label.c_str());
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(GPUMemory::CATEGORY_NAMES[static_cast<size_t>(allocation.category)].data());
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f MB", allocation.bytes / MB);
+            ImGui::TableNextColumn();
+            if (allocation.category == GPUMemory::Category::Buffer) ImGui::Text("usage 0x%04X", allocation.format);
+            else ImGui::Text("%dx%dx%d, %d levels, format 0x%04X", allocation.width, allocation.height, allocation.layers, allocation.levels, allocation.format);
+        }
+        ImGui::EndTable();
+    }
+    ImGui::End();
+}
+
+void ImGui::GLValidationWindow(size_t topFunctions) {
+    ImGui::Begin("OpenGL Validation", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+    auto level = GLValidation::getLevel();
+    if (ImGui::Combo("Level", &level, {
+        {GLValidation::Level::Off, "Off"},
+        {GLValidation::Level::DebugOutput, "Debug output"},
+        {GLValidation::Level::SynchronousDebugOutput, "Synchronous debug output"},
+        {GLValidation::Level::CallChecks, "Check every call"}
+    })) GLValidation::setLevel(level);
+    bool profiling = GLValidation::isProfiling();
+    if (ImGui::Checkbox("Profile calls", &profiling)) GLValidation::setProfiling(profiling);
+
+    const auto& calls = GLValidation::getFrameCalls();
+    if (profiling && ImGui::BeginTable("Calls", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+        ImGui::TableSetupColumn("Function");
+        ImGui::TableSetupColumn("Calls");
+        ImGui::TableSetupColumn("CPU time");
+        ImGui::TableHeadersRow();
+        for (size_t i = 0; i < std::min(topFunctions, calls.size()); i++) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(calls[i].name);
+            ImGui::TableNextColumn();
+            ImGui::Text("%u", calls[i].count);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f ms", calls[i].time * 1e-6);
+        }
+        ImGui::EndTable();
+    }
+    ImGui::End();
+}
+
+void ImGui::FramePacingWindow(FramePacer& pacer) {
+    ImGui::Begin("Frame Pacing", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+    int framesInFlight = static_cast<int>(pacer.maxFramesInFlight);
+    if (ImGui::SliderInt("Max frames in flight", &framesInFlight, 0, 4, framesInFlight == 0 ? "Unlimited" : "%d")) pacer.maxFramesInFlight = static_cast<unsigned int>(framesInFlight);
+    ImGui::SliderFloat("Frame rate cap", &pacer.maxFramesPerSecond, 0.0f, 240.0f, pacer.maxFramesPerSecond > 0.0f ? "%.0f fps" : "Off");
+    if (pacer.maxFramesPerSecond > 0.0f) ImGui::SliderFloat("Spin before frame", &pacer.spinMilliseconds, 0.0f, 5.0f, "%.1f ms");
+    const auto stats = pacer.getStats();
+    ImGui::Text("Input to submit latency: %.2f ms", stats.inputLatency);
+    ImGui::Text("Frame time: %.2f ms, jitter %.2f ms", stats.frameTime, stats.jitter);
+    ImGui::Text("Waited for GPU: %.2f ms with %zu frames in flight", stats.gpuWait, stats.framesInFlight);
+    ImGui::Text("Waited for cap: %.2f ms", stats.capWait);
+    ImGui::End();
+}
+
 bool ImGui::SphericalSlider(const char* label, vec3& cart) {
     vec2 sph = vec2(asin(cart.y), atan(cart.x, cart.z));
     ImGui::PushID(label);
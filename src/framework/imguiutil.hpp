@@ -10,6 +10,8 @@
 #include <unordered_map>
 #include <algorithm>
 
+#include "framepacer.hpp"
+
 /**
  * @file imguiutil.hpp
  * @brief Defines common ImGui elements missing from the main library.
@@ -21,10 +23,27 @@ namespace ImGui {
     const unsigned int FRAMETIME_SMOOTHING = 60;
 
     /**
-     * @brief Draws a window with average frame time, frames per second, and resolution.
+     * @brief Draws a window with average frame time, frames per second, resolution and the number of issued and elided OpenGL state changes of the last frame.
      */
     void StatisticsWindow(float frametime, const glm::vec2& resolution);
 
+    /**
+     * @brief Draws a window with the GPU memory recorded by `GPUMemory` per category and against the budget, the memory reported by the driver and the largest allocations.
+     * @param topConsumers The number of allocations that are listed.
+     */
+    void GPUMemoryWindow(size_t topConsumers = 10);
+
+    /**
+     * @brief Draws a window to select the `GLValidation` level and to profile the OpenGL calls, listing the most expensive functions of the last frame.
+     * @param topFunctions The number of functions that are listed.
+     */
+    void GLValidationWindow(size_t topFunctions = 15);
+
+    /**
+     * @brief Draws a window to set the frames in flight and the frame rate cap of a `FramePacer`, with its input latency, frame time and jitter.
+     */
+    void FramePacingWindow(FramePacer& pacer);
+
     /**
      * @brief Slider to select a vector on the unit sphere using two angles.
      */
@@ -3,20 +3,65 @@
 #include <glad/gl.h>
 #include <glm/glm.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
 #include <filesystem>
 #include <vector>
 
+#include "camera.hpp"
 #include "common.hpp"
 #include "framework/context.hpp"
+#include "meshlod.hpp"
 #include "objparser.hpp"
 
 using namespace glm;
 
+namespace {
+
+template <typename Vertex>
+std::vector<vec3> extractPositions(const std::vector<Vertex>& vertices) {
+    std::vector<vec3> positions(vertices.size());
+    for (size_t i = 0; i < vertices.size(); i++) positions[i] = vertices[i].position;
+    return positions;
+}
+
+std::vector<vec3> extractPositions(const std::vector<float>& vertices, size_t stride) {
+    std::vector<vec3> positions(vertices.size() / stride);
+    for (size_t i = 0; i < positions.size(); i++) positions[i] = vec3(vertices[i * stride], vertices[i * stride + 1], vertices[i * stride + 2]);
+    return positions;
+}
+
+/**
+ * @brief Describes the vertices of an OBJ file for simplification. Texture coordinates and normals are weighted, so collapses that distort the texture or cross creases come last.
+ */
+template <typename Vertex>
+MeshLOD::Vertices describeVertices(const std::vector<Vertex>& vertices) {
+    static_assert(sizeof(Vertex) % sizeof(float) == 0 && offsetof(Vertex, position) == 0, "Vertices have to be interleaved floats starting with the position");
+    MeshLOD::Vertices description;
+    description.data = reinterpret_cast<const float*>(vertices.data());
+    description.count = vertices.size();
+    description.stride = sizeof(Vertex) / sizeof(float);
+    description.attributeWeights = {0.01f, 0.01f, 0.001f, 0.001f, 0.001f}; // Texture coordinates and normals, tangents follow the texture coordinates
+    return description;
+}
+
+std::vector<unsigned int> concatenate(const std::vector<MeshLOD::Level>& chain) {
+    std::vector<unsigned int> indices;
+    for (const auto& level : chain) indices.insert(indices.end(), level.indices.begin(), level.indices.end());
+    return indices;
+}
+
+}
+
 ////////////////////////// Manual mesh loading //////////////////////////
 
 void Mesh::load(const std::vector<float>& vertices, const std::vector<unsigned int>& indices) {
     // Load data into buffers
     numIndices = indices.size();
+    positions = extractPositions(vertices, 3);
+    this->indices = indices;
+    updateBounds();
 #ifndef MODERN_GL
     vao.bind();
 #endif
@@ -43,6 +88,7 @@ void Mesh::load(const std::vector<float>& vertices, const std::vector<unsigned i
 void Mesh::load(const std::vector<float>& vertices, const std::vector<unsigned int>& attributeSizes, const std::vector<unsigned int>& indices) {
     // Load data into buffers
     numIndices = indices.size();
+    this->indices = indices;
 #ifndef MODERN_GL
     vao.bind(); // NOTE: Bind VAO first as Core Profile requires a VAO to be bound when loading buffers
 #endif
@@ -54,6 +100,10 @@ void Mesh::load(const std::vector<float>& vertices, const std::vector<unsigned i
     for (const auto attributeSize : attributeSizes) {
         stride += attributeSize * sizeof(float);
     }
+    // The first attribute is the position
+    if (!attributeSizes.empty() && attributeSizes[0] == 3) positions = extractPositions(vertices, stride / sizeof(float));
+    else positions.clear();
+    updateBounds();
 
 #ifdef MODERN_GL
     GLuint offset = 0;
@@ -82,6 +132,9 @@ void Mesh::load(const std::vector<float>& vertices, const std::vector<unsigned i
 void Mesh::load(const std::vector<VertexPC>& vertices, const std::vector<unsigned int>& indices) {
     // Load data into buffers
     numIndices = indices.size();
+    positions = extractPositions(vertices);
+    this->indices = indices;
+    updateBounds();
 #ifndef MODERN_GL
     vao.bind(); // NOTE: Bind VAO first as Core Profile requires a VAO to be bound when loading buffers
 #endif
@@ -116,6 +169,9 @@ void Mesh::load(const std::vector<VertexPC>& vertices, const std::vector<unsigne
 void Mesh::load(const std::vector<VertexPTN>& vertices, const std::vector<unsigned int>& indices) {
     // Load data into buffers
     numIndices = indices.size();
+    positions = extractPositions(vertices);
+    this->indices = indices;
+    updateBounds();
 #ifndef MODERN_GL
     vao.bind(); // NOTE: Bind VAO first as Core Profile requires a VAO to be bound when loading buffers
 #endif
@@ -156,6 +212,9 @@ void Mesh::load(const std::vector<VertexPTN>& vertices, const std::vector<unsign
 void Mesh::load(const std::vector<VertexPTNT>& vertices, const std::vector<unsigned int>& indices) {
     // Load data into buffers
     numIndices = indices.size();
+    positions = extractPositions(vertices);
+    this->indices = indices;
+    updateBounds();
 #ifndef MODERN_GL
     vao.bind(); // NOTE: Bind VAO first as Core Profile requires a VAO to be bound when loading buffers
 #endif
@@ -199,18 +258,67 @@ void Mesh::load(const std::vector<VertexPTNT>& vertices, const std::vector<unsig
 #endif
 }
 
-void Mesh::load(const std::filesystem::path& filepath) {
+void Mesh::load(const std::filesystem::path& filepath, int levels) {
     std::vector<VertexPTN> vertices;
     std::vector<unsigned int> indices;
     ObjParser::parse(filepath, vertices, indices);
-    load(vertices, indices);
+    if (levels <= 1) {
+        load(vertices, indices);
+    } else {
+        // All levels share the vertex buffer and are appended to the index buffer
+        const auto chain = MeshLOD::load(filepath, describeVertices(vertices), indices, levels);
+        load(vertices, concatenate(chain));
+        setLODs(chain);
+    }
+    setLabel(filepath.filename().string());
 }
 
-void Mesh::loadWithTangents(const std::filesystem::path& filepath) {
+void Mesh::loadWithTangents(const std::filesystem::path& filepath, int levels) {
     std::vector<VertexPTNT> vertices;
     std::vector<unsigned int> indices;
     ObjParser::parse(filepath, vertices, indices);
-    load(vertices, indices);
+    if (levels <= 1) {
+        load(vertices, indices);
+    } else {
+        const auto chain = MeshLOD::load(filepath, describeVertices(vertices), indices, levels);
+        load(vertices, concatenate(chain));
+        setLODs(chain);
+    }
+    setLabel(filepath.filename().string());
+}
+
+void Mesh::setLabel(const std::string& label) {
+    vbo.setLabel(label + " vertices");
+    ebo.setLabel(label + " indices");
+}
+
+void Mesh::updateBounds() {
+    lods = {{0, numIndices, 0.0f}};
+    if (positions.empty()) {
+        boundingSphere = vec4(0.0f);
+        return;
+    }
+    vec3 minimum = positions[0], maximum = positions[0];
+    for (const auto& position : positions) {
+        minimum = min(minimum, position);
+        maximum = max(maximum, position);
+    }
+    const vec3 center = (minimum + maximum) * 0.5f;
+    float radius = 0.0f;
+    for (const auto& position : positions) radius = std::max(radius, length(position - center));
+    boundingSphere = vec4(center, radius);
+}
+
+void Mesh::setLODs(const std::vector<MeshLOD::Level>& chain) {
+    // Ray queries and `draw` only use the full resolution
+    numIndices = static_cast<GLsizei>(chain[0].indices.size());
+    indices = chain[0].indices;
+    lods.clear();
+    GLsizei first = 0;
+    for (const auto& level : chain) {
+        lods.push_back({first, static_cast<GLsizei>(level.indices.size()), level.error});
+        first += static_cast<GLsizei>(level.indices.size());
+    }
 }
 
 ///////////////////////////// Mesh drawing /////////////////////////////
@@ -223,4 +331,25 @@ void Mesh::draw() {
 void Mesh::draw(GLsizei instances) {
     vao.bind();
     glDrawElementsInstanced(GL_TRIANGLES, numIndices, GL_UNSIGNED_INT, nullptr, instances);
+}
+
+size_t Mesh::selectLOD(const Camera& camera, const mat4& localToWorld, float viewportHeight, float threshold) const {
+    if (lods.size() <= 1 || boundingSphere.w <= 0.0f) return 0;
+    const vec3 center = vec3(camera.viewMatrix * localToWorld * vec4(vec3(boundingSphere), 1.0f));
+    const float scale = std::sqrt(std::max(dot(vec3(localToWorld[0]), vec3(localToWorld[0])), std::max(dot(vec3(localToWorld[1]), vec3(localToWorld[1])), dot(vec3(localToWorld[2]), vec3(localToWorld[2])))));
+    const float radius = boundingSphere.w * scale;
+    const float distance = length(center) - radius;
+    if (distance <= camera.near) return 0; // The camera is inside of or close to the bounds
+
+    // The radius of the sphere on screen in pixels, the focal length is the vertical scale of the projection
+    const float projectedRadius = radius * camera.projectionMatrix[1][1] * 0.5f * viewportHeight / distance;
+    size_t lod = 0;
+    while (lod + 1 < lods.size() && lods[lod + 1].error / boundingSphere.w * projectedRadius <= threshold) lod++;
+    return lod;
+}
+
+void Mesh::drawLOD(size_t lod) {
+    const LOD& level = lods[std::min(lod, lods.size() - 1)];
+    vao.bind();
+    glDrawElements(GL_TRIANGLES, level.count, GL_UNSIGNED_INT, reinterpret_cast<void*>(static_cast<size_t>(level.first) * sizeof(unsigned int)));
 }
\ No newline at end of file
@@ -4,8 +4,11 @@
 #include <glm/glm.hpp>
 
 #include <filesystem>
+#include <string>
 #include <vector>
 
+#include "camera.hpp"
+#include "meshlod.hpp"
 #include "gl/buffer.hpp"
 #include "gl/vertexarray.hpp"
 
@@ -55,18 +58,76 @@ class Mesh {
         glm::vec3 tangent;
     };
 
+    /**
+     * @brief A level of detail, a range of the shared index buffer that uses the same vertices as the full resolution mesh.
+     */
+    struct LOD {
+        GLsizei first = 0;
+        GLsizei count = 0;
+        /** The largest deviation from the full resolution mesh in object space units */
+        float error = 0.0f;
+    };
+
     void load(const std::vector<float>& vertices, const std::vector<unsigned int>& indices);
     void load(const std::vector<float>& vertices, const std::vector<unsigned int>& attributeSizes, const std::vector<unsigned int>& indices);
     void load(const std::vector<VertexPC>& vertices, const std::vector<unsigned int>& indices);
     void load(const std::vector<VertexPTN>& vertices, const std::vector<unsigned int>& indices);
     void load(const std::vector<VertexPTNT>& vertices, const std::vector<unsigned int>& indices);
-    void load(const std::filesystem::path& filepath);
-    void loadWithTangents(const std::filesystem::path& filepath);
+
+    /**
+     * @brief Loads an OBJ file.
+     * @param levels The number of levels of detail including the full resolution, see `MeshLOD::load`. Simplification runs on the thread pool and is cached on disk.
+     */
+    void load(const std::filesystem::path& filepath, int levels = 1);
+    void loadWithTangents(const std::filesystem::path& filepath, int levels = 1);
+
+    /**
+     * @brief Labels the vertex and index buffers for the `GPUMemory` statistics, OBJ files are labeled with their file name.
+     */
+    void setLabel(const std::string& label);
+
     void draw();
     void draw(GLsizei instances);
-    
+
+    /**
+     * @brief Selects the coarsest level of detail whose error projects to at most `threshold` pixels.
+     * The error is scaled by the projected size of the bounding sphere, which is derived from the focal length in `Camera::projectionMatrix`.
+     * @param viewportHeight The height of the viewport in pixels.
+     */
+    size_t selectLOD(const Camera& camera, const glm::mat4& localToWorld, float viewportHeight, float threshold = 1.0f) const;
+
+    /**
+     * @brief Draws a level of detail, see `selectLOD`.
+     */
+    void drawLOD(size_t lod);
+
     GLsizei numIndices = 0;
+
+    /**
+     * @brief The levels of detail from full resolution to coarsest, meshes loaded without levels have a single one.
+     */
+    std::vector<LOD> lods;
+
+    /**
+     * @brief The bounding sphere of `positions` with the center in xyz and the radius in w.
+     */
+    glm::vec4 boundingSphere = glm::vec4(0.0f);
+
+    /**
+     * @brief Vertex positions kept on the CPU for ray queries and other geometry processing, see `BVH`.
+     */
+    std::vector<glm::vec3> positions;
+
+    /**
+     * @brief Triangle indices into `positions`, kept on the CPU like the positions.
+     */
+    std::vector<unsigned int> indices;
+
     VertexArray vao;
     Buffer<GL_ARRAY_BUFFER> vbo;
     Buffer<GL_ELEMENT_ARRAY_BUFFER> ebo;
+
+   private:
+    void updateBounds();
+    void setLODs(const std::vector<MeshLOD::Level>& chain);
 };
@@ -0,0 +1,287 @@
+#include "meshlet.hpp"
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <vector>
+
+#include "camera.hpp"
+#include "mesh.hpp"
+#include "gl/buffer.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define MESHLET_SSE2
+    #include <emmintrin.h>
+#endif
+
+using namespace glm;
+
+namespace {
+
+/** How many new vertices a triangle may cost for a normal that is perpendicular to the meshlet, trades vertex reuse for tighter cones */
+constexpr float CONE_WEIGHT = 0.5f;
+
+/** How many of the following unused triangles are considered when a meshlet has no unused neighbors left */
+constexpr size_t SEED_LOOKAHEAD = 32;
+
+/** Normal cones with a triangle further than about 84 degrees from the axis are never culled */
+constexpr float MIN_CONE_DOT = 0.1f;
+
+}
+
+std::vector<Meshlets::Meshlet> Meshlets::build(const std::vector<vec3>& positions, std::vector<unsigned int>& indices) {
+    const size_t triangleCount = indices.size() / 3, vertexCount = positions.size();
+    std::vector<Meshlet> result;
+    if (triangleCount == 0) return result;
+
+    // Triangles around each vertex
+    std::vector<uint32_t> offsets(vertexCount + 1), adjacency(triangleCount * 3);
+    for (size_t i = 0; i < triangleCount * 3; i++) offsets[indices[i] + 1]++;
+    for (size_t i = 0; i < vertexCount; i++) offsets[i + 1] += offsets[i];
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < triangleCount * 3; i++) adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+
+    std::vector<vec3> normals(triangleCount), centroids(triangleCount);
+    for (size_t t = 0; t < triangleCount; t++) {
+        const vec3 &p0 = positions[indices[t * 3]], &p1 = positions[indices[t * 3 + 1]], &p2 = positions[indices[t * 3 + 2]];
+        const vec3 normal = cross(p1 - p0, p2 - p0);
+        const float area = length(normal);
+        normals[t] = area > 0.0f ? normal / area : vec3(0.0f);
+        centroids[t] = (p0 + p1 + p2) / 3.0f;
+    }
+
+    std::vector<unsigned int> reordered;
+    reordered.reserve(indices.size());
+    std::vector<uint8_t> used(triangleCount);
+    std::vector<uint8_t> inMeshlet(vertexCount);
+    std::vector<uint32_t> vertices, triangles;
+    vec3 normalSum(0.0f), centroidSum(0.0f);
+
+    const auto newVertices = [&](size_t t) {
+        return static_cast<size_t>(!inMeshlet[indices[t * 3]]) + !inMeshlet[indices[t * 3 + 1]] + !inMeshlet[indices[t * 3 + 2]];
+    };
+    const auto add = [&](size_t t) {
+        used[t] = 1;
+        triangles.push_back(static_cast<uint32_t>(t));
+        for (int k = 0; k < 3; k++) {
+            const unsigned int vertex = indices[t * 3 + k];
+            reordered.push_back(vertex);
+            if (!inMeshlet[vertex]) {
+                inMeshlet[vertex] = 1;
+                vertices.push_back(vertex);
+            }
+        }
+        normalSum += normals[t];
+        centroidSum += centroids[t];
+    };
+    const auto finish = [&]() {
+        Meshlet meshlet;
+        meshlet.firstIndex = static_cast<uint32_t>(reordered.size() - triangles.size() * 3);
+        meshlet.triangleCount = static_cast<uint32_t>(triangles.size());
+        meshlet.vertexCount = static_cast<uint32_t>(vertices.size());
+
+        vec3 minimum = positions[vertices[0]], maximum = minimum;
+        for (uint32_t vertex : vertices) {
+            minimum = min(minimum, positions[vertex]);
+            maximum = max(maximum, positions[vertex]);
+        }
+        meshlet.center = (minimum + maximum) * 0.5f;
+        for (uint32_t vertex : vertices) meshlet.radius = std::max(meshlet.radius, length(positions[vertex] - meshlet.center));
+
+        // The cone around the mean normal contains all triangle normals
+        const float axisLength = length(normalSum);
+        float minDot = axisLength > 0.0f ? 1.0f : -1.0f;
+        if (axisLength > 0.0f) {
+            meshlet.coneAxis = normalSum / axisLength;
+            for (uint32_t t : triangles) minDot = std::min(minDot, dot(meshlet.coneAxis, normals[t]));
+        }
+        meshlet.coneCutoff = minDot <= MIN_CONE_DOT ? 1.0f : std::sqrt(1.0f - minDot * minDot);
+        result.push_back(meshlet);
+
+        for (uint32_t vertex : vertices) inMeshlet[vertex] = 0;
+        vertices.clear();
+        triangles.clear();
+        normalSum = centroidSum = vec3(0.0f);
+    };
+
+    size_t next = 0;
+    while (true) {
+        while (next < triangleCount && used[next]) next++;
+        if (next == triangleCount) break;
+        add(next);
+
+        while (triangles.size() < MAX_TRIANGLES) {
+            const vec3 axis = length(normalSum) > 0.0f ? normalize(normalSum) : vec3(0.0f);
+            size_t best = triangleCount;
+            float bestScore = std::numeric_limits<float>::max();
+            const auto consider = [&](size_t t) {
+                if (used[t]) return;
+                const size_t added = newVertices(t);
+                if (vertices.size() + added > MAX_VERTICES) return;
+                const float score = static_cast<float>(added) + CONE_WEIGHT * (1.0f - dot(axis, normals[t]));
+                if (score < bestScore) {
+                    bestScore = score;
+                    best = t;
+                }
+            };
+            for (uint32_t vertex : vertices) {
+                for (uint32_t i = offsets[vertex]; i < offsets[vertex + 1]; i++) consider(adjacency[i]);
+            }
+
+            // Continue with the closest of the following triangles if the meshlet has no free neighbors, e.g. at split normals
+            if (best == triangleCount) {
+                const vec3 center = centroidSum / static_cast<float>(triangles.size());
+                float bestDistance = std::numeric_limits<float>::max();
+                for (size_t t = next, seen = 0; t < triangleCount && seen < SEED_LOOKAHEAD; t++) {
+                    if (used[t] || vertices.size() + newVertices(t) > MAX_VERTICES) continue;
+                    seen++;
+                    const vec3 offset = centroids[t] - center;
+                    if (dot(offset, offset) < bestDistance) {
+                        bestDistance = dot(offset, offset);
+                        best = t;
+                    }
+                }
+            }
+            if (best == triangleCount) break;
+            add(best);
+        }
+        finish();
+    }
+
+    indices = std::move(reordered);
+    return result;
+}
+
+void Meshlets::build(Mesh& mesh) {
+    meshlets = build(mesh.positions, mesh.indices);
+    // The full resolution level is at the start of the index buffer, other levels of detail are unchanged
+#ifndef MODERN_GL
+    mesh.vao.bind(); // NOTE: Binding the element buffer changes the bound VAO
+#endif
+    mesh.ebo.set(mesh.indices);
+    updateBounds();
+}
+
+void Meshlets::updateBounds() {
+    const size_t padded = (meshlets.size() + 3) & ~size_t(3);
+    for (auto* array : {&centerX, &centerY, &centerZ, &radius, &axisX, &axisY, &axisZ, &cutoff}) array->assign(padded, 0.0f);
+    for (size_t i = 0; i < meshlets.size(); i++) {
+        const Meshlet& meshlet = meshlets[i];
+        centerX[i] = meshlet.center.x;
+        centerY[i] = meshlet.center.y;
+        centerZ[i] = meshlet.center.z;
+        radius[i] = meshlet.radius;
+        axisX[i] = meshlet.coneAxis.x;
+        axisY[i] = meshlet.coneAxis.y;
+        axisZ[i] = meshlet.coneAxis.z;
+        cutoff[i] = meshlet.coneCutoff;
+    }
+}
+
+size_t Meshlets::cull(const Camera& camera, const mat4& localToWorld) {
+    const vec3 cameraPosition = vec3(inverse(localToWorld) * vec4(camera.worldPosition, 1.0f));
+    return cull(camera.projectionMatrix * camera.viewMatrix * localToWorld, cameraPosition);
+}
+
+size_t Meshlets::cull(const mat4& localToClip, const vec3& cameraPosition) {
+    if (centerX.size() != ((meshlets.size() + 3) & ~size_t(3))) updateBounds();
+
+    // Frustum planes in the space of the mesh, see Gribb and Hartmann, "Fast Extraction of Viewing Frustum Planes from the World-View-Projection Matrix"
+    vec4 planes[6];
+    const vec4 row0(localToClip[0][0], localToClip[1][0], localToClip[2][0], localToClip[3][0]);
+    const vec4 row1(localToClip[0][1], localToClip[1][1], localToClip[2][1], localToClip[3][1]);
+    const vec4 row2(localToClip[0][2], localToClip[1][2], localToClip[2][2], localToClip[3][2]);
+    const vec4 row3(localToClip[0][3], localToClip[1][3], localToClip[2][3], localToClip[3][3]);
+    planes[0] = row3 + row0;
+    planes[1] = row3 - row0;
+    planes[2] = row3 + row1;
+    planes[3] = row3 - row1;
+    planes[4] = row3 + row2;
+    planes[5] = row3 - row2;
+    for (auto& plane : planes) plane /= length(vec3(plane));
+
+    stats = Stats();
+    commands.clear();
+    const auto emit = [&](size_t i, bool frustumVisible, bool backfacing) {
+        const Meshlet& meshlet = meshlets[i];
+        stats.totalTriangles += meshlet.triangleCount;
+        if (!frustumVisible) {
+            stats.frustumCulled++;
+            return;
+        }
+        if (backfacing) {
+            stats.backfaceCulled++;
+            return;
+        }
+        stats.visibleMeshlets++;
+        stats.visibleTriangles += meshlet.triangleCount;
+        // Neighboring meshlets are contiguous in the index buffer and share one command
+        if (!commands.empty() && commands.back().firstIndex + commands.back().count == meshlet.firstIndex) {
+            commands.back().count += meshlet.triangleCount * 3;
+        } else {
+            DrawElementsIndirectCommand command;
+            command.count = meshlet.triangleCount * 3;
+            command.firstIndex = meshlet.firstIndex;
+            commands.push_back(command);
+        }
+    };
+
+    for (size_t i = 0; i < meshlets.size(); i += 4) {
+        int frustumMask = 0, backfaceMask = 0;
+#if defined(MESHLET_SSE2)
+        const __m128 cx = _mm_loadu_ps(&centerX[i]), cy = _mm_loadu_ps(&centerY[i]), cz = _mm_loadu_ps(&centerZ[i]), r = _mm_loadu_ps(&radius[i]);
+        const __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), r);
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (const auto& plane : planes) {
+            const __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.x), cx), _mm_mul_ps(_mm_set1_ps(plane.y), cy)),
+                                               _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.z), cz), _mm_set1_ps(plane.w)));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+        }
+        frustumMask = _mm_movemask_ps(inside);
+
+        // All triangles face away if the camera lies in the negative cone, dot(center - camera, axis) >= cutoff * |center - camera| + radius
+        const __m128 vx = _mm_sub_ps(cx, _mm_set1_ps(cameraPosition.x)), vy = _mm_sub_ps(cy, _mm_set1_ps(cameraPosition.y)), vz = _mm_sub_ps(cz, _mm_set1_ps(cameraPosition.z));
+        const __m128 distance = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz)));
+        const __m128 projected = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, _mm_loadu_ps(&axisX[i])), _mm_mul_ps(vy, _mm_loadu_ps(&axisY[i]))), _mm_mul_ps(vz, _mm_loadu_ps(&axisZ[i])));
+        backfaceMask = _mm_movemask_ps(_mm_cmpge_ps(projected, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&cutoff[i]), distance), r)));
+#else
+        for (int lane = 0; lane < 4; lane++) {
+            const vec3 center(centerX[i + lane], centerY[i + lane], centerZ[i + lane]);
+            bool inside = true;
+            for (const auto& plane : planes) inside &= dot(vec3(plane), center) + plane.w >= -radius[i + lane];
+            frustumMask |= inside << lane;
+            const vec3 view = center - cameraPosition;
+            const vec3 axis(axisX[i + lane], axisY[i + lane], axisZ[i + lane]);
+            backfaceMask |= (dot(view, axis) >= cutoff[i + lane] * length(view) + radius[i + lane]) << lane;
+        }
+#endif
+        for (size_t lane = 0; lane < 4 && i + lane < meshlets.size(); lane++) emit(i + lane, frustumMask >> lane & 1, backfaceMask >> lane & 1);
+    }
+    return stats.visibleTriangles;
+}
+
+void Meshlets::draw(Mesh& mesh) {
+    if (commands.empty()) return;
+    mesh.vao.bind();
+#ifdef MODERN_GL
+    if (!indirectBuffer) indirectBuffer.emplace();
+    indirectBuffer->load(commands, GL_STREAM_DRAW);
+    indirectBuffer->bind();
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, static_cast<GLsizei>(commands.size()), 0);
+#else
+    // OpenGL 4.1 has no indirect multi draws, the commands are passed as arrays instead
+    std::vector<GLsizei> counts(commands.size());
+    std::vector<const void*> offsets(commands.size());
+    for (size_t i = 0; i < commands.size(); i++) {
+        counts[i] = static_cast<GLsizei>(commands[i].count);
+        offsets[i] = reinterpret_cast<const void*>(static_cast<size_t>(commands[i].firstIndex) * sizeof(unsigned int));
+    }
+    glMultiDrawElements(GL_TRIANGLES, counts.data(), GL_UNSIGNED_INT, offsets.data(), static_cast<GLsizei>(commands.size()));
+#endif
+}
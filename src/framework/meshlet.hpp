@@ -0,0 +1,126 @@
+#pragma once
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "camera.hpp"
+#include "mesh.hpp"
+#include "gl/buffer.hpp"
+
+using namespace glm;
+
+/**
+ * @file meshlet.hpp
+ * @brief Defines Meshlets, which split meshes into small clusters of triangles that are culled individually.
+ */
+
+/**
+ * @brief The layout of the commands of `glMultiDrawElementsIndirect`.
+ */
+struct DrawElementsIndirectCommand {
+    GLuint count = 0;
+    GLuint instanceCount = 1;
+    GLuint firstIndex = 0;
+    GLint baseVertex = 0;
+    GLuint baseInstance = 0;
+};
+
+/**
+ * @class Meshlets
+ * @brief Partitions the triangles of a mesh into meshlets of at most 64 vertices and 124 triangles and culls them against the view every frame.
+ * Building reorders the full resolution triangles of the mesh so that every meshlet is a contiguous range of the index buffer.
+ * Culling tests the bounding sphere of each meshlet against the frustum and its normal cone against the camera position,
+ * four meshlets at a time with SSE2, and merges the ranges of neighboring visible meshlets into indirect draw commands.
+ * Example:
+ * ```cpp
+ * Meshlets meshlets;
+ * meshlets.build(mesh); // Before building a BVH of the mesh, as the triangle order changes
+ * meshlets.cull(cam, localToWorld);
+ * meshlets.draw(mesh);
+ * ```
+ */
+class Meshlets {
+   public:
+    static constexpr size_t MAX_VERTICES = 64;
+    static constexpr size_t MAX_TRIANGLES = 124;
+
+    /**
+     * @brief A cluster of triangles with the bounds used for culling, in the space of the mesh.
+     */
+    struct Meshlet {
+        vec3 center = vec3(0.0f);
+        float radius = 0.0f;
+        /** The mean normal of the triangles */
+        vec3 coneAxis = vec3(0.0f, 0.0f, 1.0f);
+        /** The sine of the largest angle between the axis and a triangle normal, 1 if the cone cannot be culled */
+        float coneCutoff = 1.0f;
+        uint32_t firstIndex = 0;
+        uint32_t triangleCount = 0;
+        uint32_t vertexCount = 0;
+    };
+
+    /**
+     * @brief The results of the last `cull`.
+     */
+    struct Stats {
+        size_t visibleMeshlets = 0;
+        size_t visibleTriangles = 0;
+        size_t totalTriangles = 0;
+        /** Meshlets outside of the frustum */
+        size_t frustumCulled = 0;
+        /** Meshlets inside of the frustum whose triangles all face away from the camera */
+        size_t backfaceCulled = 0;
+    };
+
+    /**
+     * @brief Partitions triangles into meshlets and reorders the indices so each meshlet is contiguous.
+     * Triangles are added greedily to the current meshlet, preferring neighbors that add few vertices and have a similar normal.
+     */
+    static std::vector<Meshlet> build(const std::vector<vec3>& positions, std::vector<unsigned int>& indices);
+
+    /**
+     * @brief Builds the meshlets of the full resolution level of a mesh and uploads the reordered indices.
+     */
+    void build(Mesh& mesh);
+
+    /**
+     * @brief Culls the meshlets and records the draw commands of the visible ones. The cone test assumes the transformation has a uniform scale.
+     * @return The number of visible triangles.
+     */
+    size_t cull(const Camera& camera, const mat4& localToWorld);
+
+    /**
+     * @brief Culls the meshlets in the space of the mesh, see `cull`.
+     * @param localToClip The transformation from the space of the mesh to clip space, which defines the frustum.
+     * @param cameraPosition The position of the camera in the space of the mesh.
+     */
+    size_t cull(const mat4& localToClip, const vec3& cameraPosition);
+
+    /**
+     * @brief Draws the visible meshlets of the last `cull`, with `glMultiDrawElementsIndirect` on the modern path and `glMultiDrawElements` otherwise.
+     */
+    void draw(Mesh& mesh);
+
+    std::vector<Meshlet> meshlets;
+
+    /**
+     * @brief The draw commands of the last `cull`.
+     */
+    std::vector<DrawElementsIndirectCommand> commands;
+
+    Stats stats;
+
+   private:
+    void updateBounds();
+
+    /** The culling bounds in structure of arrays layout, padded to a multiple of four */
+    std::vector<float> centerX, centerY, centerZ, radius;
+    std::vector<float> axisX, axisY, axisZ, cutoff;
+    /** Created on the first draw, so meshlets can be built and culled without an OpenGL context */
+    std::optional<Buffer<GL_DRAW_INDIRECT_BUFFER>> indirectBuffer;
+};
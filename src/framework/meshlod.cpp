@@ -0,0 +1,298 @@
+#include "meshlod.hpp"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <sstream>
+#include <vector>
+
+#include "common.hpp"
+#include "framework/context.hpp"
+#include "texturecache.hpp"
+#include "threadpool.hpp"
+
+using namespace glm;
+
+namespace {
+
+constexpr uint32_t CACHE_MAGIC = 0x444F4C4D; // "MLOD"
+constexpr uint32_t CACHE_VERSION = 2;
+
+struct CacheHeader {
+    uint32_t vertexCount;
+    uint32_t levels;
+};
+
+/**
+ * @brief The symmetric 4x4 matrix that sums the squared distances to a set of planes, weighted by the areas of their triangles.
+ */
+struct Quadric {
+    double a2 = 0.0, ab = 0.0, ac = 0.0, ad = 0.0, b2 = 0.0, bc = 0.0, bd = 0.0, c2 = 0.0, cd = 0.0, d2 = 0.0;
+    double weight = 0.0;
+
+    /** The quadric of the plane through a triangle, the normal is unnormalized with the length of twice the area */
+    static Quadric triangle(const vec3& normal, const vec3& point) {
+        Quadric q;
+        const double length = std::sqrt(static_cast<double>(dot(normal, normal)));
+        if (length == 0.0) return q;
+        const double a = normal.x / length, b = normal.y / length, c = normal.z / length;
+        const double d = -(a * point.x + b * point.y + c * point.z);
+        const double w = 0.5 * length;
+        q.a2 = w * a * a, q.ab = w * a * b, q.ac = w * a * c, q.ad = w * a * d;
+        q.b2 = w * b * b, q.bc = w * b * c, q.bd = w * b * d;
+        q.c2 = w * c * c, q.cd = w * c * d;
+        q.d2 = w * d * d;
+        q.weight = w;
+        return q;
+    }
+
+    Quadric& operator+=(const Quadric& other) {
+        a2 += other.a2, ab += other.ab, ac += other.ac, ad += other.ad, b2 += other.b2;
+        bc += other.bc, bd += other.bd, c2 += other.c2, cd += other.cd, d2 += other.d2;
+        weight += other.weight;
+        return *this;
+    }
+
+    /** The area weighted mean of the squared distances of a point to the planes */
+    double evaluate(const vec3& p) const {
+        if (weight == 0.0) return 0.0;
+        const double x = p.x, y = p.y, z = p.z;
+        const double sum = a2 * x * x + 2.0 * ab * x * y + 2.0 * ac * x * z + 2.0 * ad * x
+                         + b2 * y * y + 2.0 * bc * y * z + 2.0 * bd * y
+                         + c2 * z * z + 2.0 * cd * z + d2;
+        return std::max(sum / weight, 0.0);
+    }
+};
+
+struct Collapse {
+    uint32_t from;
+    uint32_t to;
+    float cost;
+};
+
+bool readCache(std::istream& file, size_t vertexCount, std::vector<MeshLOD::Level>& levels) {
+    CacheHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+    if (header.vertexCount != vertexCount) return false;
+
+    levels.resize(header.levels);
+    for (auto& level : levels) {
+        uint32_t count;
+        if (!file.read(reinterpret_cast<char*>(&level.error), sizeof(level.error))) return false;
+        if (!file.read(reinterpret_cast<char*>(&count), sizeof(count))) return false;
+        level.indices.resize(count);
+        if (!file.read(reinterpret_cast<char*>(level.indices.data()), static_cast<std::streamsize>(count * sizeof(unsigned int)))) return false;
+        if (std::any_of(level.indices.begin(), level.indices.end(), [&](unsigned int index) { return index >= vertexCount; })) return false;
+    }
+    return true;
+}
+
+void writeCache(std::ostream& file, size_t vertexCount, const std::vector<MeshLOD::Level>& levels) {
+    CacheHeader header = {static_cast<uint32_t>(vertexCount), static_cast<uint32_t>(levels.size())};
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const auto& level : levels) {
+        const uint32_t count = static_cast<uint32_t>(level.indices.size());
+        file.write(reinterpret_cast<const char*>(&level.error), sizeof(level.error));
+        file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+        file.write(reinterpret_cast<const char*>(level.indices.data()), static_cast<std::streamsize>(count * sizeof(unsigned int)));
+    }
+}
+
+}
+
+std::vector<unsigned int> MeshLOD::simplify(const Vertices& vertices, const std::vector<unsigned int>& indices, size_t targetIndexCount, float* error) {
+    if (error) *error = 0.0f;
+    const size_t vertexCount = vertices.count, stride = vertices.stride;
+    if (indices.size() <= targetIndexCount || vertexCount == 0) return indices;
+
+    // Positions are normalized to the unit cube, so errors and attribute weights do not depend on the scale of the mesh
+    std::vector<vec3> positions(vertexCount);
+    vec3 minimum(std::numeric_limits<float>::max()), maximum(-std::numeric_limits<float>::max());
+    for (size_t i = 0; i < vertexCount; i++) {
+        positions[i] = vec3(vertices.data[i * stride], vertices.data[i * stride + 1], vertices.data[i * stride + 2]);
+        minimum = min(minimum, positions[i]);
+        maximum = max(maximum, positions[i]);
+    }
+    const vec3 size = maximum - minimum;
+    const float extent = std::max(size.x, std::max(size.y, size.z));
+    const float scale = extent > 0.0f ? 1.0f / extent : 1.0f;
+    for (auto& position : positions) position = (position - minimum) * scale;
+
+    // Vertices with the same position form a group, groups of several vertices lie on an attribute seam
+    std::vector<uint32_t> order(vertexCount), group(vertexCount), groupSizes;
+    std::iota(order.begin(), order.end(), 0u);
+    const auto less = [&](uint32_t a, uint32_t b) {
+        const vec3 &p = positions[a], &q = positions[b];
+        return p.x != q.x ? p.x < q.x : p.y != q.y ? p.y < q.y : p.z < q.z;
+    };
+    std::sort(order.begin(), order.end(), less);
+    for (size_t i = 0; i < vertexCount; i++) {
+        if (i == 0 || less(order[i - 1], order[i])) groupSizes.push_back(0);
+        group[order[i]] = static_cast<uint32_t>(groupSizes.size() - 1);
+        groupSizes.back()++;
+    }
+    std::vector<uint8_t> lockedGroups(groupSizes.size());
+    for (size_t g = 0; g < groupSizes.size(); g++) lockedGroups[g] = groupSizes[g] > 1;
+
+    // Edges between groups that are not shared by exactly two triangles are open borders or non-manifold
+    std::vector<uint64_t> edges;
+    edges.reserve(indices.size());
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        for (int e = 0; e < 3; e++) {
+            const uint64_t a = group[indices[i + e]], b = group[indices[i + (e + 1) % 3]];
+            if (a != b) edges.push_back(std::min(a, b) << 32 | std::max(a, b));
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    for (size_t i = 0; i < edges.size();) {
+        size_t j = i;
+        while (j < edges.size() && edges[j] == edges[i]) j++;
+        if (j - i != 2) lockedGroups[edges[i] >> 32] = lockedGroups[edges[i] & 0xFFFFFFFFu] = 1;
+        i = j;
+    }
+    std::vector<uint8_t> locked(vertexCount);
+    for (size_t i = 0; i < vertexCount; i++) locked[i] = lockedGroups[group[i]];
+
+    std::vector<Quadric> quadrics(vertexCount);
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        const vec3 &p0 = positions[indices[i]], &p1 = positions[indices[i + 1]], &p2 = positions[indices[i + 2]];
+        const Quadric q = Quadric::triangle(cross(p1 - p0, p2 - p0), p0);
+        for (int k = 0; k < 3; k++) quadrics[indices[i + k]] += q;
+    }
+
+    const size_t attributes = std::min(stride - 3, vertices.attributeWeights.size());
+    const auto cost = [&](uint32_t from, uint32_t to) {
+        Quadric q = quadrics[from];
+        q += quadrics[to];
+        double sum = q.evaluate(positions[to]);
+        for (size_t k = 0; k < attributes; k++) {
+            const double difference = vertices.data[from * stride + 3 + k] - vertices.data[to * stride + 3 + k];
+            sum += vertices.attributeWeights[k] * difference * difference;
+        }
+        return static_cast<float>(sum);
+    };
+
+    std::vector<unsigned int> current = indices;
+    std::vector<uint32_t> triangleOffsets(vertexCount + 1), triangles;
+    std::vector<uint32_t> remap(vertexCount);
+    std::iota(remap.begin(), remap.end(), 0u);
+    std::vector<uint8_t> touched(vertexCount);
+    std::vector<Collapse> candidates;
+    // Only the distance to the planes counts towards the error, the attribute terms of the cost are not in object space units
+    double maxDistance = 0.0;
+
+    // Checks whether moving a vertex onto another one turns any of its remaining triangles around
+    const auto flips = [&](uint32_t from, uint32_t to) {
+        for (uint32_t t = triangleOffsets[from]; t < triangleOffsets[from + 1]; t++) {
+            const unsigned int* triangle = &current[triangles[t] * 3];
+            if (triangle[0] == to || triangle[1] == to || triangle[2] == to) continue; // Collapses to a line and is removed
+            vec3 p[3], q[3];
+            for (int k = 0; k < 3; k++) {
+                p[k] = positions[triangle[k]];
+                q[k] = triangle[k] == from ? positions[to] : p[k];
+            }
+            if (dot(cross(p[1] - p[0], p[2] - p[0]), cross(q[1] - q[0], q[2] - q[0])) <= 0.0f) return true;
+        }
+        return false;
+    };
+
+    // Every pass collapses the cheapest edges whose neighborhoods do not overlap, then rewrites the indices
+    while (current.size() > targetIndexCount) {
+        std::fill(triangleOffsets.begin(), triangleOffsets.end(), 0u);
+        for (unsigned int index : current) triangleOffsets[index + 1]++;
+        for (size_t i = 0; i < vertexCount; i++) triangleOffsets[i + 1] += triangleOffsets[i];
+        triangles.resize(current.size());
+        std::vector<uint32_t> fill(triangleOffsets.begin(), triangleOffsets.end() - 1);
+        for (size_t i = 0; i < current.size(); i++) triangles[fill[current[i]]++] = static_cast<uint32_t>(i / 3);
+
+        candidates.clear();
+        for (size_t i = 0; i < current.size(); i += 3) {
+            for (int e = 0; e < 3; e++) {
+                const uint32_t a = current[i + e], b = current[i + (e + 1) % 3];
+                if (!locked[a]) candidates.push_back({a, b, cost(a, b)});
+                if (!locked[b]) candidates.push_back({b, a, cost(b, a)});
+            }
+        }
+        std::sort(candidates.begin(), candidates.end(), [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+        // An interior collapse removes two triangles
+        const size_t limit = std::max<size_t>((current.size() - targetIndexCount) / 6, 1);
+        std::fill(touched.begin(), touched.end(), 0);
+        std::vector<uint32_t> collapsed;
+        for (const auto& collapse : candidates) {
+            if (collapsed.size() >= limit) break;
+            if (touched[collapse.from] || touched[collapse.to] || flips(collapse.from, collapse.to)) continue;
+            remap[collapse.from] = collapse.to;
+            quadrics[collapse.to] += quadrics[collapse.from];
+            maxDistance = std::max(maxDistance, quadrics[collapse.to].evaluate(positions[collapse.to]));
+            collapsed.push_back(collapse.from);
+            for (uint32_t vertex : {collapse.from, collapse.to}) {
+                for (uint32_t t = triangleOffsets[vertex]; t < triangleOffsets[vertex + 1]; t++) {
+                    for (int k = 0; k < 3; k++) touched[current[triangles[t] * 3 + k]] = 1;
+                }
+            }
+        }
+        if (collapsed.empty()) break;
+
+        size_t count = 0;
+        for (size_t i = 0; i < current.size(); i += 3) {
+            const unsigned int a = remap[current[i]], b = remap[current[i + 1]], c = remap[current[i + 2]];
+            if (a == b || b == c || c == a) continue;
+            current[count++] = a;
+            current[count++] = b;
+            current[count++] = c;
+        }
+        current.resize(count);
+        for (uint32_t vertex : collapsed) remap[vertex] = vertex;
+    }
+
+    if (error) *error = static_cast<float>(std::sqrt(maxDistance)) * extent;
+    return current;
+}
+
+std::vector<MeshLOD::Level> MeshLOD::generate(const Vertices& vertices, const std::vector<unsigned int>& indices, int levels, ThreadPool& pool) {
+    std::vector<Level> simplified(std::max(levels, 1));
+    simplified[0].indices = indices;
+    pool.parallelFor(1, simplified.size(), [&](size_t level) {
+        const size_t target = (indices.size() / 3 >> level) * 3;
+        simplified[level].indices = simplify(vertices, indices, target, &simplified[level].error);
+    });
+
+    std::vector<Level> chain;
+    chain.push_back(std::move(simplified[0]));
+    for (size_t level = 1; level < simplified.size(); level++) {
+        auto& next = simplified[level];
+        if (next.indices.empty() || next.indices.size() * 5 > chain.back().indices.size() * 4) continue;
+        next.error = std::max(next.error, chain.back().error); // Coarser levels are never selected before finer ones
+        chain.push_back(std::move(next));
+    }
+    return chain;
+}
+
+std::filesystem::path MeshLOD::getCachePath(const std::filesystem::path& filepath, const Vertices& vertices, int levels) {
+    size_t hash = 0;
+    Common::hash_combine(hash, std::filesystem::absolute(filepath).string(), vertices.count, vertices.stride, levels);
+    for (float weight : vertices.attributeWeights) Common::hash_combine(hash, weight);
+    std::stringstream name;
+    name << filepath.stem().string() << "_" << std::hex << hash << ".mlod";
+    return TextureCache::getDirectory() / name.str();
+}
+
+std::vector<MeshLOD::Level> MeshLOD::load(const std::filesystem::path& filepath, const Vertices& vertices, const std::vector<unsigned int>& indices, int levels) {
+    Context::setWorkingDirectory(); // Ensure that the working directory is set correctly
+    auto cachePath = getCachePath(filepath, vertices, levels);
+    std::vector<Level> chain;
+    const auto read = [&](std::istream& file) { return readCache(file, vertices.count, chain); };
+    if (TextureCache::readEntry(cachePath, filepath, CACHE_MAGIC, CACHE_VERSION, read) && !chain.empty() && chain[0].indices == indices) return chain;
+
+    std::cout << "Simplifying " << std::filesystem::absolute(filepath) << std::endl;
+    chain = generate(vertices, indices, levels);
+    TextureCache::writeEntry(cachePath, filepath, CACHE_MAGIC, CACHE_VERSION, [&](std::ostream& file) { writeCache(file, vertices.count, chain); });
+    return chain;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <vector>
+
+#include "threadpool.hpp"
+
+/**
+ * @file meshlod.hpp
+ * @brief Defines the MeshLOD functions, which simplify meshes into chains of levels of detail with a quadric error metric.
+ */
+
+/**
+ * @brief Simplifies triangle meshes by collapsing edges onto existing vertices, so every level of detail is just another index buffer into the same vertices.
+ * The cost of a collapse is the quadric error of the planes around both vertices (Garland and Heckbert, "Surface Simplification Using Quadric Error Metrics")
+ * plus the weighted squared difference of the vertex attributes.
+ * Vertices on attribute seams (several vertices at the same position) and on open borders are locked, so the silhouette and the texture layout stay intact.
+ * Used by `Mesh::load` and `Mesh::loadWithTangents`.
+ */
+namespace MeshLOD {
+
+    /**
+     * @brief The indices of one level of detail.
+     */
+    struct Level {
+        std::vector<unsigned int> indices;
+        /** The largest geometric deviation from the original mesh in object space units */
+        float error = 0.0f;
+    };
+
+    /**
+     * @brief Interleaved vertices with the position in the first three floats, followed by the attributes.
+     */
+    struct Vertices {
+        const float* data = nullptr;
+        size_t count = 0;
+        /** The number of floats per vertex */
+        size_t stride = 3;
+        /** The weight of each attribute float after the position, missing weights are zero. Attributes are compared on the scale of the normalized mesh extent */
+        std::vector<float> attributeWeights;
+    };
+
+    /**
+     * @brief Simplifies a mesh until it has at most `targetIndexCount` indices or no more edges can be collapsed.
+     * @param error Receives the largest geometric deviation of the result in object space units, may be null.
+     * @return The indices of the simplified triangles.
+     */
+    std::vector<unsigned int> simplify(const Vertices& vertices, const std::vector<unsigned int>& indices, size_t targetIndexCount, float* error = nullptr);
+
+    /**
+     * @brief Generates a chain of levels of detail, each with about half the triangles of the previous one. The first level is the original mesh.
+     * The levels are simplified in parallel from the original mesh, levels that would not reduce the triangle count further are dropped.
+     * @param levels The maximum number of levels including the original mesh.
+     */
+    std::vector<Level> generate(const Vertices& vertices, const std::vector<unsigned int>& indices, int levels, ThreadPool& pool = ThreadPool::global());
+
+    /**
+     * @brief Loads the levels of detail of a mesh file from the cache or generates them and stores the result in the cache.
+     * Cache entries are keyed by the absolute path of the source, the vertex layout and the number of levels,
+     * and are invalidated when the size or modification time of the source changes.
+     * The entries are stored next to the textures in `TextureCache::getDirectory`.
+     * @param filepath The path of the mesh file that the vertices and indices were loaded from.
+     */
+    std::vector<Level> load(const std::filesystem::path& filepath, const Vertices& vertices, const std::vector<unsigned int>& indices, int levels);
+
+    /**
+     * @brief Gets the path of the cache entry of a mesh.
+     */
+    std::filesystem::path getCachePath(const std::filesystem::path& filepath, const Vertices& vertices, int levels);
+
+}
@@ -16,6 +16,7 @@ using namespace glm;
 
 #include "mesh.hpp"
 #include "common.hpp"
+#include "trace.hpp"
 
 ////////////////////// Obj loading without tangents //////////////////////
 
@@ -37,6 +38,7 @@ struct std::hash<Mesh::VertexPTN>
 };
 
 void ObjParser::parse(const std::filesystem::path& filepath, std::vector<Mesh::VertexPTN>& vertices, std::vector<unsigned int>& indices) {
+    TRACE_ZONE_TEXT("ObjParser::parse", filepath.string());
     // Parse OBJ file
     std::string rawobj = Common::readFile(filepath);
     tinyobj::ObjReader reader;
@@ -114,6 +116,7 @@ struct std::hash<Mesh::VertexPTNT>
 };
 
 void ObjParser::parse(const std::filesystem::path& filepath, std::vector<Mesh::VertexPTNT>& vertices, std::vector<unsigned int>& indices) {
+    TRACE_ZONE_TEXT("ObjParser::parse", filepath.string());
     // Parse OBJ file
     std::string rawobj = Common::readFile(filepath);
     tinyobj::ObjReader reader;
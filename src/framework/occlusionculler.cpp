@@ -0,0 +1,276 @@
+#include "occlusionculler.hpp"
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <future>
+#include <vector>
+
+#include "bvh.hpp"
+#include "threadpool.hpp"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    #define OCCLUSION_DISPATCH
+    #include <immintrin.h>
+#endif
+
+using namespace glm;
+
+namespace {
+
+/**
+ * @brief Writes the depth of a triangle into a row of pixels where all three edge functions are non-negative.
+ * @param edges The edge functions at the center of the first pixel.
+ * @param steps The change of the edge functions from one pixel to the next.
+ */
+using RowKernel = void (*)(float* row, int count, const float* edges, const float* steps, float z, float dzdx);
+
+void rasterizeRowScalar(float* row, int count, const float* edges, const float* steps, float z, float dzdx) {
+    for (int i = 0; i < count; i++) {
+        const float x = static_cast<float>(i);
+        if (edges[0] + x * steps[0] >= 0.0f && edges[1] + x * steps[1] >= 0.0f && edges[2] + x * steps[2] >= 0.0f)
+            row[i] = std::min(row[i], z + x * dzdx);
+    }
+}
+
+#if defined(OCCLUSION_DISPATCH)
+__attribute__((target("sse4.1"))) void rasterizeRowSSE41(float* row, int count, const float* edges, const float* steps, float z, float dzdx) {
+    const __m128 zero = _mm_setzero_ps();
+    __m128 x = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+    int i = 0;
+    for (; i + 4 <= count; i += 4, x = _mm_add_ps(x, _mm_set1_ps(4.0f))) {
+        const __m128 e0 = _mm_add_ps(_mm_set1_ps(edges[0]), _mm_mul_ps(x, _mm_set1_ps(steps[0])));
+        const __m128 e1 = _mm_add_ps(_mm_set1_ps(edges[1]), _mm_mul_ps(x, _mm_set1_ps(steps[1])));
+        const __m128 e2 = _mm_add_ps(_mm_set1_ps(edges[2]), _mm_mul_ps(x, _mm_set1_ps(steps[2])));
+        const __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+        const __m128 depth = _mm_add_ps(_mm_set1_ps(z), _mm_mul_ps(x, _mm_set1_ps(dzdx)));
+        const __m128 old = _mm_loadu_ps(row + i);
+        _mm_storeu_ps(row + i, _mm_blendv_ps(old, _mm_min_ps(old, depth), inside));
+    }
+    if (i < count) {
+        const float offset = static_cast<float>(i);
+        const float rest[3] = {edges[0] + offset * steps[0], edges[1] + offset * steps[1], edges[2] + offset * steps[2]};
+        rasterizeRowScalar(row + i, count - i, rest, steps, z + offset * dzdx, dzdx);
+    }
+}
+
+__attribute__((target("avx2"))) void rasterizeRowAVX2(float* row, int count, const float* edges, const float* steps, float z, float dzdx) {
+    const __m256 zero = _mm256_setzero_ps();
+    __m256 x = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+    int i = 0;
+    for (; i + 8 <= count; i += 8, x = _mm256_add_ps(x, _mm256_set1_ps(8.0f))) {
+        const __m256 e0 = _mm256_add_ps(_mm256_set1_ps(edges[0]), _mm256_mul_ps(x, _mm256_set1_ps(steps[0])));
+        const __m256 e1 = _mm256_add_ps(_mm256_set1_ps(edges[1]), _mm256_mul_ps(x, _mm256_set1_ps(steps[1])));
+        const __m256 e2 = _mm256_add_ps(_mm256_set1_ps(edges[2]), _mm256_mul_ps(x, _mm256_set1_ps(steps[2])));
+        const __m256 inside = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(e0, zero, _CMP_GE_OQ), _mm256_cmp_ps(e1, zero, _CMP_GE_OQ)), _mm256_cmp_ps(e2, zero, _CMP_GE_OQ));
+        const __m256 depth = _mm256_add_ps(_mm256_set1_ps(z), _mm256_mul_ps(x, _mm256_set1_ps(dzdx)));
+        const __m256 old = _mm256_loadu_ps(row + i);
+        _mm256_storeu_ps(row + i, _mm256_blendv_ps(old, _mm256_min_ps(old, depth), inside));
+    }
+    if (i < count) {
+        const float offset = static_cast<float>(i);
+        const float rest[3] = {edges[0] + offset * steps[0], edges[1] + offset * steps[1], edges[2] + offset * steps[2]};
+        rasterizeRowSSE41(row + i, count - i, rest, steps, z + offset * dzdx, dzdx);
+    }
+}
+#endif
+
+struct Dispatch {
+    RowKernel kernel = rasterizeRowScalar;
+    const char* name = "scalar";
+
+    Dispatch() {
+#if defined(OCCLUSION_DISPATCH)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            kernel = rasterizeRowAVX2;
+            name = "AVX2";
+        } else if (__builtin_cpu_supports("sse4.1")) {
+            kernel = rasterizeRowSSE41;
+            name = "SSE4.1";
+        }
+#endif
+    }
+};
+
+const Dispatch& getDispatch() {
+    static const Dispatch dispatch;
+    return dispatch;
+}
+
+}
+
+OcclusionCuller::OcclusionCuller(GLsizei width, GLsizei height)
+    : width((std::max(width, 1) + TILE_SIZE - 1) / TILE_SIZE * TILE_SIZE), height((std::max(height, 1) + TILE_SIZE - 1) / TILE_SIZE * TILE_SIZE) {
+    depth.assign(static_cast<size_t>(this->width) * this->height, 1.0f);
+    tileDepth.assign(static_cast<size_t>(this->width / TILE_SIZE) * (this->height / TILE_SIZE), 1.0f);
+}
+
+void OcclusionCuller::begin(const mat4& viewProjection) {
+    this->viewProjection = viewProjection;
+    occluders.clear();
+    rasterizeMilliseconds = 0.0;
+    tested = 0;
+    occluded = 0;
+}
+
+void OcclusionCuller::addOccluder(const std::vector<vec3>& positions, const std::vector<unsigned int>& indices, const mat4& localToWorld) {
+    occluders.push_back({&positions, &indices, localToWorld});
+}
+
+void OcclusionCuller::rasterize(ThreadPool& pool) {
+    const auto start = std::chrono::steady_clock::now();
+    std::fill(depth.begin(), depth.end(), 1.0f);
+
+    // Set up all triangles in parallel, rejected triangles get empty bounds
+    size_t count = 0;
+    for (const auto& occluder : occluders) count += occluder.indices->size() / 3;
+    triangles.resize(count);
+    size_t first = 0;
+    for (const auto& occluder : occluders) {
+        const mat4 localToClip = viewProjection * occluder.localToWorld;
+        const auto& positions = *occluder.positions;
+        const auto& indices = *occluder.indices;
+        pool.parallelForChunks(0, indices.size() / 3, [&, first](size_t begin, size_t end) {
+            for (size_t t = begin; t < end; t++) {
+                Triangle& triangle = triangles[first + t];
+                triangle.minX = triangle.minY = 0;
+                triangle.maxX = triangle.maxY = -1;
+
+                vec3 screen[3];
+                bool outside[4] = {true, true, true, true};
+                bool nearClipped = false;
+                for (int k = 0; k < 3; k++) {
+                    const vec4 clip = localToClip * vec4(positions[indices[t * 3 + k]], 1.0f);
+                    // Triangles crossing the near plane are skipped instead of clipped, which only loses occlusion
+                    nearClipped |= clip.w <= 0.0f || clip.z < -clip.w;
+                    outside[0] &= clip.x < -clip.w;
+                    outside[1] &= clip.x > clip.w;
+                    outside[2] &= clip.y < -clip.w;
+                    outside[3] &= clip.y > clip.w;
+                    const vec3 ndc = vec3(clip) / clip.w;
+                    screen[k] = vec3((ndc.x * 0.5f + 0.5f) * width, (ndc.y * 0.5f + 0.5f) * height, ndc.z * 0.5f + 0.5f);
+                }
+                if (nearClipped || outside[0] || outside[1] || outside[2] || outside[3]) continue;
+
+                const vec3 &v0 = screen[0], &v1 = screen[1], &v2 = screen[2];
+                const float area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+                if (area <= 0.0f) continue; // Back facing or degenerate
+
+                // Edge k is non-negative left of the edge from vertex k to vertex k + 1
+                for (int k = 0; k < 3; k++) {
+                    const vec3 &a = screen[k], &b = screen[(k + 1) % 3];
+                    triangle.edges[k][0] = (b.x - a.x) * -a.y - (b.y - a.y) * -a.x;
+                    triangle.edges[k][1] = -(b.y - a.y);
+                    triangle.edges[k][2] = b.x - a.x;
+                }
+                triangle.dzdx = ((v1.z - v0.z) * (v2.y - v0.y) - (v2.z - v0.z) * (v1.y - v0.y)) / area;
+                triangle.dzdy = ((v2.z - v0.z) * (v1.x - v0.x) - (v1.z - v0.z) * (v2.x - v0.x)) / area;
+                // The depth plane is moved back to the farthest depth it reaches within a pixel, so a covered pixel stores the depth of its farthest corner
+                triangle.z = v0.z - triangle.dzdx * v0.x - triangle.dzdy * v0.y + 0.5f * (std::abs(triangle.dzdx) + std::abs(triangle.dzdy));
+
+                // Pixels whose centers may lie inside
+                triangle.minX = std::max(static_cast<int>(std::floor(std::min(v0.x, std::min(v1.x, v2.x)) - 0.5f)), 0);
+                triangle.minY = std::max(static_cast<int>(std::floor(std::min(v0.y, std::min(v1.y, v2.y)) - 0.5f)), 0);
+                triangle.maxX = std::min(static_cast<int>(std::ceil(std::max(v0.x, std::max(v1.x, v2.x)) - 0.5f)), width - 1);
+                triangle.maxY = std::min(static_cast<int>(std::ceil(std::max(v0.y, std::max(v1.y, v2.y)) - 0.5f)), height - 1);
+            }
+        }, 1024);
+        first += indices.size() / 3;
+    }
+
+    pool.parallelFor(0, static_cast<size_t>(height / TILE_SIZE), [&](size_t band) { rasterizeBand(static_cast<GLsizei>(band)); });
+    rasterizeMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void OcclusionCuller::rasterizeBand(GLsizei band) {
+    const RowKernel kernel = getDispatch().kernel;
+    const int bandMinY = band * TILE_SIZE, bandMaxY = bandMinY + TILE_SIZE - 1;
+    for (const Triangle& triangle : triangles) {
+        const int minY = std::max(triangle.minY, bandMinY), maxY = std::min(triangle.maxY, bandMaxY);
+        if (minY > maxY || triangle.minX > triangle.maxX) continue;
+        const float px = static_cast<float>(triangle.minX) + 0.5f;
+        const float steps[3] = {triangle.edges[0][1], triangle.edges[1][1], triangle.edges[2][1]};
+        for (int y = minY; y <= maxY; y++) {
+            const float py = static_cast<float>(y) + 0.5f;
+            float edges[3];
+            for (int k = 0; k < 3; k++) edges[k] = triangle.edges[k][0] + triangle.edges[k][1] * px + triangle.edges[k][2] * py;
+            kernel(&depth[static_cast<size_t>(y) * width + triangle.minX], triangle.maxX - triangle.minX + 1, edges, steps,
+                   triangle.z + triangle.dzdx * px + triangle.dzdy * py, triangle.dzdx);
+        }
+    }
+
+    // The tiles of the band are complete
+    const GLsizei tilesX = width / TILE_SIZE;
+    for (GLsizei tile = 0; tile < tilesX; tile++) {
+        float farthest = 0.0f;
+        for (int y = bandMinY; y <= bandMaxY; y++) {
+            const float* row = &depth[static_cast<size_t>(y) * width + tile * TILE_SIZE];
+            for (int x = 0; x < TILE_SIZE; x++) farthest = std::max(farthest, row[x]);
+        }
+        tileDepth[static_cast<size_t>(band) * tilesX + tile] = farthest;
+    }
+}
+
+std::future<void> OcclusionCuller::rasterizeAsync(ThreadPool& pool) {
+    return pool.submit([this, &pool] { rasterize(pool); });
+}
+
+bool OcclusionCuller::isVisible(const AABB& bounds, const mat4& localToWorld) const {
+    tested++;
+    const mat4 localToClip = viewProjection * localToWorld;
+    vec2 minimum(INFINITY), maximum(-INFINITY);
+    float nearest = INFINITY;
+    for (int corner = 0; corner < 8; corner++) {
+        const vec3 position((corner & 1) ? bounds.max.x : bounds.min.x, (corner & 2) ? bounds.max.y : bounds.min.y, (corner & 4) ? bounds.max.z : bounds.min.z);
+        const vec4 clip = localToClip * vec4(position, 1.0f);
+        if (clip.w <= 0.0f || clip.z < -clip.w) return true; // Crosses the near plane
+        const vec3 ndc = vec3(clip) / clip.w;
+        const vec2 screen((ndc.x * 0.5f + 0.5f) * width, (ndc.y * 0.5f + 0.5f) * height);
+        minimum = min(minimum, screen);
+        maximum = max(maximum, screen);
+        nearest = std::min(nearest, ndc.z * 0.5f + 0.5f);
+    }
+
+    // Every pixel the box touches, also partially, so a box is never hidden by a pixel it only reaches into
+    const int minX = std::max(static_cast<int>(std::floor(minimum.x)), 0), minY = std::max(static_cast<int>(std::floor(minimum.y)), 0);
+    const int maxX = std::min(static_cast<int>(std::floor(maximum.x)), width - 1), maxY = std::min(static_cast<int>(std::floor(maximum.y)), height - 1);
+    if (minX > maxX || minY > maxY) {
+        occluded++; // Outside of the frustum
+        return false;
+    }
+
+    const GLsizei tilesX = width / TILE_SIZE;
+    for (int tileY = minY / TILE_SIZE; tileY <= maxY / TILE_SIZE; tileY++) {
+        for (int tileX = minX / TILE_SIZE; tileX <= maxX / TILE_SIZE; tileX++) {
+            if (tileDepth[static_cast<size_t>(tileY) * tilesX + tileX] < nearest) continue; // Everything in the tile is in front of the box
+            const int x0 = std::max(minX, tileX * TILE_SIZE), x1 = std::min(maxX, tileX * TILE_SIZE + TILE_SIZE - 1);
+            const int y0 = std::max(minY, tileY * TILE_SIZE), y1 = std::min(maxY, tileY * TILE_SIZE + TILE_SIZE - 1);
+            for (int y = y0; y <= y1; y++) {
+                for (int x = x0; x <= x1; x++) {
+                    if (depth[static_cast<size_t>(y) * width + x] >= nearest) return true;
+                }
+            }
+        }
+    }
+    occluded++;
+    return false;
+}
+
+OcclusionCuller::Stats OcclusionCuller::getStats() const {
+    Stats stats;
+    stats.occluderTriangles = triangles.size();
+    stats.tested = tested;
+    stats.occluded = occluded;
+    stats.rasterizeMilliseconds = rasterizeMilliseconds;
+    return stats;
+}
+
+const char* OcclusionCuller::getInstructionSet() {
+    return getDispatch().name;
+}
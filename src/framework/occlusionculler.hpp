@@ -0,0 +1,138 @@
+#pragma once
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <future>
+#include <vector>
+
+#include "bvh.hpp"
+#include "threadpool.hpp"
+
+using namespace glm;
+
+/**
+ * @file occlusionculler.hpp
+ * @brief Defines the OcclusionCuller, a software depth rasterizer that tests bounding boxes against the occluders of the frame before their draws are issued.
+ */
+
+/**
+ * @class OcclusionCuller
+ * @brief Rasterizes occluder meshes into a low resolution depth buffer on the CPU and tests bounding boxes against a hierarchical version of it.
+ * Occluders write the pixels whose centers they cover with the farthest depth of their plane within the pixel, and triangles crossing the near plane are skipped.
+ * The test is not conservative at silhouettes: a pixel whose center is covered counts as hidden as a whole, so a box that is only visible through the uncovered part of such a pixel,
+ * at most half a pixel of the low resolution buffer beside the silhouette of an occluder, is culled. Requiring full coverage instead would leave cracks along every shared edge
+ * and let dense meshes whose triangles are smaller than a pixel occlude nothing, so the error is bounded by choosing the resolution instead.
+ * Boxes are tested against every pixel they touch, including partially.
+ * Bounding boxes are tested with their nearest depth against the farthest depth of each 8x8 tile first and against single pixels only where a tile is inconclusive.
+ * The image is split into bands of tile rows that are rasterized in parallel. Rows of pixels are processed with AVX2 or SSE4.1, selected at runtime on x86 with GCC and Clang.
+ * Example:
+ * ```cpp
+ * culler.begin(cam.projectionMatrix * cam.viewMatrix);
+ * culler.addOccluder(mesh.positions, mesh.indices, localToWorld);
+ * auto rasterized = culler.rasterizeAsync(); // Overlap with other work of the frame
+ * ...
+ * rasterized.wait();
+ * if (culler.isVisible(bounds, objectToWorld)) object.draw();
+ * ```
+ */
+class OcclusionCuller {
+   public:
+    /**
+     * @brief The edge length of the tiles of the hierarchical depth buffer in pixels, the resolution is rounded up to a multiple of it.
+     */
+    static constexpr GLsizei TILE_SIZE = 8;
+
+    /**
+     * @brief The statistics of the current frame.
+     */
+    struct Stats {
+        size_t occluderTriangles = 0;
+        size_t tested = 0;
+        /** Boxes that are hidden by occluders or outside of the frustum */
+        size_t occluded = 0;
+        double rasterizeMilliseconds = 0.0;
+    };
+
+    /**
+     * @brief Creates the depth buffer.
+     */
+    explicit OcclusionCuller(GLsizei width = 256, GLsizei height = 128);
+
+    /**
+     * @brief Starts a frame, removes the occluders of the last frame and resets the statistics.
+     * @param viewProjection The world to clip space matrix of the camera.
+     */
+    void begin(const mat4& viewProjection);
+
+    /**
+     * @brief Adds an occluder, the positions and indices are referenced and have to stay alive until `rasterize` returns.
+     * Occluders should be closed meshes, as triangles facing away from the camera are skipped.
+     */
+    void addOccluder(const std::vector<vec3>& positions, const std::vector<unsigned int>& indices, const mat4& localToWorld);
+
+    /**
+     * @brief Rasterizes all occluders of the frame and builds the hierarchical depth buffer.
+     */
+    void rasterize(ThreadPool& pool = ThreadPool::global());
+
+    /**
+     * @brief Runs `rasterize` on a worker thread, `isVisible` may only be called once the future is ready.
+     */
+    std::future<void> rasterizeAsync(ThreadPool& pool = ThreadPool::global());
+
+    /**
+     * @brief Tests whether any part of a bounding box could be visible. Boxes crossing the near plane are always visible, boxes outside of the frustum are not.
+     * Safe to call from several threads.
+     * @param bounds The bounding box in the space of the object.
+     */
+    bool isVisible(const AABB& bounds, const mat4& localToWorld) const;
+
+    /**
+     * @brief Gets the statistics of the current frame.
+     */
+    Stats getStats() const;
+
+    /**
+     * @brief The name of the instruction set used for rasterization, "AVX2", "SSE4.1" or "scalar".
+     */
+    static const char* getInstructionSet();
+
+    GLsizei width;
+    GLsizei height;
+
+    /**
+     * @brief The depth buffer with rows from bottom to top and depths from 0 at the near plane to 1 at the far plane, cleared to 1.
+     */
+    std::vector<float> depth;
+
+    /**
+     * @brief The farthest depth of each tile.
+     */
+    std::vector<float> tileDepth;
+
+   private:
+    struct Occluder {
+        const std::vector<vec3>* positions;
+        const std::vector<unsigned int>* indices;
+        mat4 localToWorld;
+    };
+
+    /** A triangle in screen space, ready for rasterization */
+    struct Triangle {
+        float edges[3][3]; // Edge function at the origin, step in x, step in y
+        float z, dzdx, dzdy; // Depth plane
+        int minX, minY, maxX, maxY; // Pixel bounds, inclusive
+    };
+
+    void rasterizeBand(GLsizei band);
+
+    mat4 viewProjection = mat4(1.0f);
+    std::vector<Occluder> occluders;
+    std::vector<Triangle> triangles;
+    double rasterizeMilliseconds = 0.0;
+    mutable std::atomic<size_t> tested = 0;
+    mutable std::atomic<size_t> occluded = 0;
+};
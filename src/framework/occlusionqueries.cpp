@@ -0,0 +1,132 @@
+#include "occlusionqueries.hpp"
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "gl/state.hpp"
+
+#ifdef MODERN_GL
+const GLenum OcclusionQueries::TARGET = GL_ANY_SAMPLES_PASSED_CONSERVATIVE;
+#else
+// Conservative queries need OpenGL 4.3
+const GLenum OcclusionQueries::TARGET = GL_ANY_SAMPLES_PASSED;
+#endif
+
+namespace {
+    const char* PROXY_VERTEX_SHADER = R"(#version 330 core
+layout (location = 0) in vec3 _position;
+uniform mat4 uLocalToClip;
+void main() {
+    gl_Position = uLocalToClip * vec4(_position, 1.0);
+}
+)";
+
+    const char* PROXY_FRAGMENT_SHADER = R"(#version 330 core
+void main() {}
+)";
+
+    /** The unit cube, counterclockwise seen from outside */
+    const std::vector<float> BOX_VERTICES {
+        0.0f, 0.0f, 0.0f,
+        1.0f, 0.0f, 0.0f,
+        0.0f, 1.0f, 0.0f,
+        1.0f, 1.0f, 0.0f,
+        0.0f, 0.0f, 1.0f,
+        1.0f, 0.0f, 1.0f,
+        0.0f, 1.0f, 1.0f,
+        1.0f, 1.0f, 1.0f,
+    };
+
+    const std::vector<unsigned int> BOX_INDICES {
+        0, 2, 1, 1, 2, 3, // -z
+        4, 5, 6, 5, 7, 6, // +z
+        0, 4, 2, 2, 4, 6, // -x
+        1, 3, 5, 3, 7, 5, // +x
+        0, 1, 4, 1, 5, 4, // -y
+        2, 6, 3, 3, 6, 7, // +y
+    };
+
+    bool crossesNearPlane(const AABB& bounds, const mat4& localToClip) {
+        for (int i = 0; i < 8; i++) {
+            const vec3 corner((i & 1) ? bounds.max.x : bounds.min.x, (i & 2) ? bounds.max.y : bounds.min.y, (i & 4) ? bounds.max.z : bounds.min.z);
+            const vec4 clip = localToClip * vec4(corner, 1.0f);
+            if (clip.z < -clip.w) return true;
+        }
+        return false;
+    }
+}
+
+OcclusionQueries::OcclusionQueries(unsigned int revalidateFrames) : revalidateFrames(revalidateFrames) {
+    box.load(BOX_VERTICES, BOX_INDICES);
+    shader.loadSource(PROXY_VERTEX_SHADER, PROXY_FRAGMENT_SHADER);
+    localToClipLocation = shader.uniform("uLocalToClip");
+}
+
+uint32_t OcclusionQueries::add() {
+    objects.emplace_back();
+    return static_cast<uint32_t>(objects.size() - 1);
+}
+
+void OcclusionQueries::newFrame() {
+    frame++;
+    stats = Stats();
+    stats.objects = objects.size();
+    for (auto& object : objects) {
+        // From the oldest to the newest query, so the newest result decides
+        for (size_t i = 1; i <= QUERIES_IN_FLIGHT; i++) {
+            const size_t q = (object.current + i) % QUERIES_IN_FLIGHT;
+            if (!object.pending[q] || !object.queries[q].isResultAvailable()) continue;
+            object.pending[q] = false;
+            if (object.queries[q].getResult()) {
+                object.visibleUntil = frame + revalidateFrames;
+                stats.visibleResults++;
+            } else {
+                stats.hiddenResults++;
+            }
+        }
+    }
+}
+
+void OcclusionQueries::beginTests() {
+    shader.use();
+    GLState::colorMask(false, false, false, false);
+    GLState::depthMask(false);
+}
+
+void OcclusionQueries::test(uint32_t id, const AABB& bounds, const mat4& localToClip) {
+    auto& object = objects[id];
+    object.conditional = false;
+    if (frame < object.visibleUntil || crossesNearPlane(bounds, localToClip)) {
+        stats.skipped++;
+        return;
+    }
+    // Reuses the oldest query, its result is dropped if it has not arrived yet
+    object.current = (object.current + 1) % QUERIES_IN_FLIGHT;
+    object.conditional = true;
+    object.pending[object.current] = true;
+    shader.set(localToClipLocation, localToClip * translate(mat4(1.0f), bounds.min) * scale(mat4(1.0f), bounds.max - bounds.min));
+    auto& query = object.queries[object.current];
+    query.begin(TARGET);
+    box.draw();
+    query.endAsync(TARGET);
+    stats.tested++;
+}
+
+void OcclusionQueries::endTests() {
+    GLState::colorMask(true, true, true, true);
+    GLState::depthMask(true);
+}
+
+void OcclusionQueries::beginDraw(uint32_t id) const {
+    const auto& object = objects[id];
+    if (object.conditional) object.queries[object.current].beginConditionalRender(GL_QUERY_NO_WAIT);
+}
+
+void OcclusionQueries::endDraw(uint32_t id) const {
+    if (objects[id].conditional) Query::endConditionalRender();
+}
+
+OcclusionQueries::Stats OcclusionQueries::getStats() const {
+    return stats;
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "bvh.hpp"
+#include "mesh.hpp"
+#include "gl/program.hpp"
+#include "gl/query.hpp"
+
+using namespace glm;
+
+/**
+ * @file occlusionqueries.hpp
+ * @brief Defines OcclusionQueries, which skip the draws of hidden objects on the GPU with occlusion queries and conditional rendering.
+ */
+
+/**
+ * @class OcclusionQueries
+ * @brief Tests the bounding boxes of objects against the depth buffer with occlusion queries and draws the objects with conditional rendering,
+ * so the GPU discards the draws of hidden objects without the CPU ever waiting for a result.
+ * Results that have arrived are only polled to exploit temporal coherence: objects that were visible are drawn without a test for the next frames.
+ * The boxes are tested against the depth of what was drawn before, so occluders have to be drawn first.
+ * Boxes that cross the near plane are not tested, as their proxies would be clipped.
+ * Example:
+ * ```cpp
+ * const auto object = queries.add();
+ * ...
+ * queries.newFrame(); // Polls the results of previous frames
+ * drawOccluders();
+ * queries.beginTests();
+ * queries.test(object, bounds, localToClip);
+ * queries.endTests();
+ * queries.beginDraw(object);
+ * mesh.draw();
+ * queries.endDraw(object);
+ * ```
+ */
+class OcclusionQueries {
+   public:
+    /**
+     * @brief The number of queries per object, a new test does not overwrite a query whose result is still on the way unless the GPU is further behind.
+     */
+    static constexpr size_t QUERIES_IN_FLIGHT = 3;
+
+    /**
+     * @brief The statistics of the current frame.
+     */
+    struct Stats {
+        size_t objects = 0;
+        /** Objects whose proxies were drawn */
+        size_t tested = 0;
+        /** Objects drawn without a test, as they were visible recently or cross the near plane */
+        size_t skipped = 0;
+        /** Results of previous frames that arrived in this one */
+        size_t visibleResults = 0;
+        size_t hiddenResults = 0;
+    };
+
+    /**
+     * @brief Creates the proxy box and the shader that draws it.
+     * @param revalidateFrames The number of frames a visible object is drawn without a test.
+     */
+    explicit OcclusionQueries(unsigned int revalidateFrames = 8);
+
+    /**
+     * @brief Adds an object.
+     * @return The identifier of the object.
+     */
+    uint32_t add();
+
+    /**
+     * @brief Starts a frame, polls the results of previous frames without stalling and resets the statistics.
+     */
+    void newFrame();
+
+    /**
+     * @brief Binds the proxy shader and disables writing color and depth, call before the tests of the frame.
+     */
+    void beginTests();
+
+    /**
+     * @brief Draws the bounding box of an object inside of an occlusion query unless it was visible recently.
+     * @param bounds The bounding box in the space of the object.
+     * @param localToClip The transformation from the space of the object to clip space.
+     */
+    void test(uint32_t object, const AABB& bounds, const mat4& localToClip);
+
+    /**
+     * @brief Enables writing color and depth again.
+     */
+    void endTests();
+
+    /**
+     * @brief Begins conditional rendering on the query of this frame if the object was tested.
+     */
+    void beginDraw(uint32_t object) const;
+
+    /**
+     * @brief Ends conditional rendering if the object was tested.
+     */
+    void endDraw(uint32_t object) const;
+
+    /**
+     * @brief Gets the statistics of the current frame.
+     */
+    Stats getStats() const;
+
+    /**
+     * @brief The target of the queries, `GL_ANY_SAMPLES_PASSED_CONSERVATIVE` on the modern path and `GL_ANY_SAMPLES_PASSED` otherwise.
+     */
+    static const GLenum TARGET;
+
+   private:
+    struct Object {
+        std::array<Query, QUERIES_IN_FLIGHT> queries;
+        std::array<bool, QUERIES_IN_FLIGHT> pending = {};
+        /** The query issued last */
+        size_t current = 0;
+        /** Whether the draw of this frame depends on a query */
+        bool conditional = false;
+        uint64_t visibleUntil = 0;
+    };
+
+    unsigned int revalidateFrames;
+    uint64_t frame = 0;
+    std::vector<Object> objects;
+    Stats stats;
+    Mesh box;
+    Program shader;
+    GLint localToClipLocation = -1;
+};
@@ -0,0 +1,172 @@
+#include "pathtracer.hpp"
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+#include "bvh.hpp"
+#include "camera.hpp"
+#include "exr.hpp"
+#include "ibl.hpp"
+#include "pixelconvert.hpp"
+#include "png.hpp"
+#include "threadpool.hpp"
+#include "gl/texture.hpp"
+
+using namespace glm;
+
+namespace {
+
+constexpr float PI = 3.14159265358979f;
+
+/**
+ * @brief A PCG random number generator, cheap enough to keep one per pixel.
+ */
+struct Random {
+    uint64_t state = 0;
+
+    Random() = default;
+    Random(uint64_t pixel, uint32_t seed) : state((pixel * 0x9E3779B97F4A7C15ull) ^ (static_cast<uint64_t>(seed) << 32 | seed)) {
+        next();
+        next();
+    }
+
+    uint32_t next() {
+        const uint64_t old = state;
+        state = old * 6364136223846793005ull + 1442695040888963407ull;
+        const uint32_t shifted = static_cast<uint32_t>(((old >> 18u) ^ old) >> 27u);
+        const uint32_t rotation = static_cast<uint32_t>(old >> 59u);
+        return (shifted >> rotation) | (shifted << ((32 - rotation) & 31));
+    }
+
+    /** A uniform float in [0, 1) */
+    float uniform() {
+        return static_cast<float>(next() >> 8) * (1.0f / 16777216.0f);
+    }
+};
+
+/**
+ * @brief Samples a direction around a unit normal with a cosine distribution, so the Lambertian throughput is just the albedo.
+ */
+vec3 sampleCosine(const vec3& normal, Random& random) {
+    // Orthonormal basis without branches, see Duff et al., "Building an Orthonormal Basis, Revisited"
+    const float sign = std::copysign(1.0f, normal.z);
+    const float a = -1.0f / (sign + normal.z);
+    const float b = normal.x * normal.y * a;
+    const vec3 tangent(1.0f + sign * normal.x * normal.x * a, sign * b, -sign * normal.x);
+    const vec3 bitangent(b, sign + normal.y * normal.y * a, -normal.y);
+
+    const float u = random.uniform(), phi = 2.0f * PI * random.uniform();
+    const float radius = std::sqrt(u);
+    return tangent * (radius * std::cos(phi)) + bitangent * (radius * std::sin(phi)) + normal * std::sqrt(std::max(0.0f, 1.0f - u));
+}
+
+}
+
+void PathTracer::render(const Camera& camera, const TLAS& scene, GLsizei width, GLsizei height, ThreadPool& pool, uint32_t seed) {
+    const auto start = std::chrono::steady_clock::now();
+    this->width = width;
+    this->height = height;
+    pixels.assign(static_cast<size_t>(width) * height * 4, 0.0f);
+
+    const auto environmentRadiance = [&](const vec3& direction) {
+        // Mirrored like the lookup in background.frag
+        if (environment.levels.empty()) return vec3(environmentIntensity);
+        return environment.sample(direction * vec3(-1.0f, 1.0f, 1.0f)) * environmentIntensity;
+    };
+
+    // Follows a path from its primary hit, the bounces are incoherent and traced as single rays
+    const auto trace = [&](Ray ray, Hit hit, Random& random) {
+        vec3 radiance(0.0f), throughput(1.0f);
+        for (int bounce = 0;; bounce++) {
+            if (!hit.valid()) {
+                radiance += throughput * environmentRadiance(ray.direction);
+                break;
+            }
+            if (bounce == maxBounces) break;
+            const vec3 position = ray.origin + ray.direction * hit.t;
+            vec3 normal = normalize(hit.normal);
+            if (dot(normal, ray.direction) > 0.0f) normal = -normal; // Two-sided surfaces
+            throughput *= albedo;
+            // Offset the origin relative to the magnitude of the position to avoid hitting the same surface again
+            const vec3 magnitude = abs(position);
+            const float offset = 1e-4f * std::max(1.0f, std::max(magnitude.x, std::max(magnitude.y, magnitude.z)));
+            ray = {position + normal * offset, 0.0f, sampleCosine(normal, random)};
+            hit = Hit();
+            scene.intersect(ray, hit);
+        }
+        return radiance;
+    };
+
+    const GLsizei tilesX = (width + TILE_SIZE - 1) / TILE_SIZE, tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+    pool.parallelFor(0, static_cast<size_t>(tilesX) * tilesY, [&](size_t tile) {
+        const GLsizei tileX = static_cast<GLsizei>(tile % tilesX) * TILE_SIZE, tileY = static_cast<GLsizei>(tile / tilesX) * TILE_SIZE;
+        const GLsizei endX = std::min(tileX + TILE_SIZE, width), endY = std::min(tileY + TILE_SIZE, height);
+        for (GLsizei quadY = tileY; quadY < endY; quadY += 2) {
+            for (GLsizei quadX = tileX; quadX < endX; quadX += 2) {
+                // Lanes outside of the image at odd sizes trace a duplicate of an inside pixel and are discarded
+                ivec2 lanePixels[RayPacket::SIZE];
+                Random randoms[RayPacket::SIZE];
+                vec3 sums[RayPacket::SIZE] = {};
+                for (int lane = 0; lane < RayPacket::SIZE; lane++) {
+                    lanePixels[lane] = ivec2(std::min(quadX + (lane & 1), width - 1), std::min(quadY + (lane >> 1), height - 1));
+                    randoms[lane] = Random(static_cast<uint64_t>(lanePixels[lane].y) * width + lanePixels[lane].x, seed);
+                }
+
+                for (int sample = 0; sample < samples; sample++) {
+                    RayPacket packet;
+                    for (int lane = 0; lane < RayPacket::SIZE; lane++) {
+                        const vec2 jitter(randoms[lane].uniform(), randoms[lane].uniform());
+                        const vec2 clip = (vec2(lanePixels[lane]) + jitter) / vec2(static_cast<float>(width), static_cast<float>(height)) * 2.0f - 1.0f;
+                        packet.rays[lane] = {camera.worldPosition, 0.0f, camera.getRayDirection(clip)};
+                    }
+                    Hit hits[RayPacket::SIZE];
+                    scene.intersect(packet, hits);
+                    for (int lane = 0; lane < RayPacket::SIZE; lane++) sums[lane] += trace(packet.rays[lane], hits[lane], randoms[lane]);
+                }
+
+                for (int lane = 0; lane < RayPacket::SIZE; lane++) {
+                    const GLsizei x = quadX + (lane & 1), y = quadY + (lane >> 1);
+                    if (x >= endX || y >= endY) continue;
+                    float* pixel = pixels.data() + (static_cast<size_t>(y) * width + x) * 4;
+                    const vec3 color = sums[lane] / static_cast<float>(samples);
+                    pixel[0] = color.x;
+                    pixel[1] = color.y;
+                    pixel[2] = color.z;
+                    pixel[3] = 1.0f;
+                }
+            }
+        }
+    });
+
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    threads = pool.size() + 1;
+}
+
+void PathTracer::upload(Texture<GL_TEXTURE_2D>& texture) const {
+    // Immutable storage cannot be resized, so the texture is recreated
+    texture = Texture<GL_TEXTURE_2D>();
+    texture.allocate2D(GL_RGBA32F, width, height);
+    texture.bind();
+    texture._load2D(GL_TEXTURE_2D, GL_RGBA32F, width, height, const_cast<float*>(pixels.data()), GL_RGBA, GL_FLOAT);
+}
+
+bool PathTracer::write(const std::filesystem::path& filepath) const {
+    if (filepath.extension() == ".exr") return EXR::write(filepath, pixels.data(), width, height, "RGBA", EXR::PixelType::FLOAT, EXR::Compression::ZIP, true);
+    std::vector<float> clamped(pixels.size());
+    std::transform(pixels.begin(), pixels.end(), clamped.begin(), [](float value) { return std::clamp(value, 0.0f, 1.0f); });
+    std::vector<uint8_t> bytes(pixels.size());
+    PixelConvert::linearToSRGB(clamped.data(), bytes.data(), static_cast<size_t>(width) * height, 4, true);
+    return PNG::write(filepath, bytes.data(), width, height, 4, true);
+}
+
+double PathTracer::samplesPerSecondPerCore() const {
+    if (seconds <= 0.0 || threads == 0) return 0.0;
+    return static_cast<double>(width) * height * samples / seconds / threads;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+#include "bvh.hpp"
+#include "camera.hpp"
+#include "ibl.hpp"
+#include "threadpool.hpp"
+#include "gl/texture.hpp"
+
+using namespace glm;
+
+/**
+ * @file pathtracer.hpp
+ * @brief Defines a multithreaded CPU path tracer for reference images.
+ */
+
+/**
+ * @class PathTracer
+ * @brief Renders reference images on the CPU, e.g. to validate the rasterized shading or on machines without a GPU.
+ * Primary rays are generated with the same camera model as `raygen.vert` and escaped rays sample the environment cubemap like `background.frag`,
+ * so the views match the demo. All surfaces are diffuse with the same albedo.
+ * The image is split into tiles that the thread pool hands out dynamically, and the primary rays of 2x2 pixel quads are traced as `RayPacket`s.
+ * Example:
+ * ```cpp
+ * PathTracer tracer;
+ * tracer.environment = IBL::loadCubemap("textures/studio");
+ * tracer.render(cam, tlas, 800, 600);
+ * tracer.write("reference.exr");
+ * ```
+ */
+class PathTracer {
+   public:
+    /**
+     * @brief The edge length of the square tiles in pixels, a multiple of two for the 2x2 packets.
+     */
+    static constexpr GLsizei TILE_SIZE = 16;
+
+    /**
+     * @brief Samples per pixel of every `render` call.
+     */
+    int samples = 16;
+
+    /**
+     * @brief The maximum number of diffuse bounces, 1 renders direct environment lighting only and 0 only the environment seen directly by the camera.
+     */
+    int maxBounces = 3;
+
+    /**
+     * @brief The diffuse albedo of all surfaces.
+     */
+    vec3 albedo = vec3(0.8f);
+
+    /**
+     * @brief The radiance of escaped rays, a uniform white environment if empty. Load it with `IBL::loadCubemap`.
+     */
+    IBL::Cubemap environment;
+
+    /**
+     * @brief Scales the radiance of the environment.
+     */
+    float environmentIntensity = 1.0f;
+
+    /**
+     * @brief The rendered image as linear RGBA floats with rows from bottom to top like OpenGL textures.
+     */
+    std::vector<float> pixels;
+    GLsizei width = 0;
+    GLsizei height = 0;
+
+    /**
+     * @brief The wall time of the last `render` in seconds and the number of threads it used.
+     */
+    double seconds = 0.0;
+    unsigned int threads = 0;
+
+    /**
+     * @brief Renders the scene from the view of a camera into `pixels`, the camera has to be up to date, see `Camera::updateIfChanged`.
+     * @param seed Varies the noise of the image, e.g. for averaging several renders.
+     */
+    void render(const Camera& camera, const TLAS& scene, GLsizei width, GLsizei height, ThreadPool& pool = ThreadPool::global(), uint32_t seed = 0);
+
+    /**
+     * @brief Uploads the image into a texture, replacing its storage with a `GL_RGBA32F` image of the rendered size.
+     */
+    void upload(Texture<GL_TEXTURE_2D>& texture) const;
+
+    /**
+     * @brief Writes the image to a file, `.exr` stores the linear floats losslessly and any other path is written as a clamped sRGB PNG.
+     * @return True if the file was written.
+     */
+    bool write(const std::filesystem::path& filepath) const;
+
+    /**
+     * @brief The throughput of the last `render` in paths per second and thread, comparable between machines with different core counts.
+     */
+    double samplesPerSecondPerCore() const;
+};
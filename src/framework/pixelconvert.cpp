@@ -0,0 +1,585 @@
+#include "pixelconvert.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define PIXELCONVERT_X86
+    #include <immintrin.h>
+    #ifdef _MSC_VER
+        #include <intrin.h>
+        #define TARGET_SSE41
+        #define TARGET_AVX2
+    #else
+        #include <cpuid.h>
+        #define TARGET_SSE41 __attribute__((target("sse4.1")))
+        #define TARGET_AVX2 __attribute__((target("avx2,f16c")))
+    #endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    #define PIXELCONVERT_NEON
+    #include <arm_neon.h>
+#endif
+
+namespace {
+
+using PixelConvert::InstructionSet;
+
+/**
+ * @brief The kernels of an instruction set, null if it has nothing faster than the scalar code, e.g. table lookups without gather instructions.
+ */
+struct Kernels {
+    InstructionSet instructionSet;
+    void (*flipSign)(const uint8_t*, uint8_t*, size_t);
+    void (*floatToHalf)(const float*, uint16_t*, size_t);
+    void (*halfToFloat)(const uint16_t*, float*, size_t);
+    void (*srgbToLinear)(const uint8_t*, float*, size_t);
+    void (*linearToSRGB)(const float*, uint8_t*, size_t);
+    void (*expandRGBToRGBA)(const uint8_t*, uint8_t*, size_t, uint8_t);
+    void (*swizzleRGBA)(const uint8_t*, uint8_t*, size_t, const uint8_t*);
+};
+
+const std::array<float, 256> SRGB_TO_LINEAR = [] {
+    std::array<float, 256> table{};
+    for (int i = 0; i < 256; i++) {
+        float value = i / 255.0f;
+        table[i] = value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+    }
+    return table;
+}();
+
+// Linear values at which the rounded sRGB encoding switches from i - 1 to i, encoding is a search in this table
+const std::array<float, 256> SRGB_THRESHOLDS = [] {
+    std::array<float, 256> table{};
+    table[0] = 0.0f;
+    for (int i = 1; i < 256; i++) {
+        double value = (i - 0.5) / 255.0;
+        table[i] = static_cast<float>(value <= 0.04045 ? value / 12.92 : std::pow((value + 0.055) / 1.055, 2.4));
+    }
+    return table;
+}();
+
+////////////////////////////////////////// Scalar //////////////////////////////////////////
+
+uint32_t floatBits(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+float bitsFloat(uint32_t bits) {
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+/**
+ * @brief Float to half with round to nearest even, see https://gist.github.com/rygorous/2156668
+ */
+uint16_t floatToHalfScalar(float value) {
+    constexpr uint32_t F32_INFINITY = 255u << 23;
+    constexpr uint32_t F16_MAX = (127u + 16u) << 23;
+    constexpr uint32_t DENORM_MAGIC = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+    uint32_t bits = floatBits(value);
+    const uint32_t sign = bits & 0x80000000u;
+    bits ^= sign;
+    uint16_t half;
+    if (bits >= F16_MAX) {
+        half = bits > F32_INFINITY ? 0x7E00 : 0x7C00; // NaN stays NaN, overflow becomes infinity
+    } else if (bits < (113u << 23)) {
+        // Denormals are rounded by the float addition
+        half = static_cast<uint16_t>(floatBits(bitsFloat(bits) + bitsFloat(DENORM_MAGIC)) - DENORM_MAGIC);
+    } else {
+        const uint32_t odd = (bits >> 13) & 1;
+        bits += (static_cast<uint32_t>(15 - 127) << 23) + 0xFFF + odd;
+        half = static_cast<uint16_t>(bits >> 13);
+    }
+    return static_cast<uint16_t>(half | sign >> 16);
+}
+
+float halfToFloatScalar(uint16_t half) {
+    constexpr uint32_t SHIFTED_EXPONENT = 0x7C00u << 13;
+    uint32_t bits = (half & 0x7FFFu) << 13;
+    const uint32_t exponent = bits & SHIFTED_EXPONENT;
+    bits += (127u - 15u) << 23;
+    if (exponent == SHIFTED_EXPONENT) {
+        bits += (128u - 16u) << 23; // Infinity and NaN
+    } else if (exponent == 0) {
+        bits += 1u << 23; // Denormals are renormalized by the float subtraction
+        bits = floatBits(bitsFloat(bits) - bitsFloat(113u << 23));
+    }
+    return bitsFloat(bits | (half & 0x8000u) << 16);
+}
+
+void flipSignScalar(const uint8_t* source, uint8_t* destination, size_t count) {
+    for (size_t i = 0; i < count; i++) destination[i] = source[i] ^ 0x80;
+}
+
+void floatToHalfScalar(const float* source, uint16_t* destination, size_t count) {
+    // memcpy keeps the in-place conversion free of strict aliasing assumptions
+    for (size_t i = 0; i < count; i++) {
+        float value;
+        std::memcpy(&value, source + i, sizeof(value));
+        uint16_t half = floatToHalfScalar(value);
+        std::memcpy(destination + i, &half, sizeof(half));
+    }
+}
+
+void halfToFloatScalar(const uint16_t* source, float* destination, size_t count) {
+    for (size_t i = 0; i < count; i++) destination[i] = halfToFloatScalar(source[i]);
+}
+
+void srgbToLinearScalar(const uint8_t* source, float* destination, size_t count) {
+    for (size_t i = 0; i < count; i++) destination[i] = SRGB_TO_LINEAR[source[i]];
+}
+
+void linearToSRGBScalar(const float* source, uint8_t* destination, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        // Branchless binary search for the last threshold below the value
+        const float value = source[i];
+        size_t index = 0;
+        for (size_t step = 128; step > 0; step >>= 1) index += SRGB_THRESHOLDS[index + step] <= value ? step : 0;
+        destination[i] = static_cast<uint8_t>(index);
+    }
+}
+
+void expandRGBToRGBAScalar(const uint8_t* source, uint8_t* destination, size_t pixels, uint8_t alpha) {
+    for (size_t i = 0; i < pixels; i++) {
+        destination[4 * i + 0] = source[3 * i + 0];
+        destination[4 * i + 1] = source[3 * i + 1];
+        destination[4 * i + 2] = source[3 * i + 2];
+        destination[4 * i + 3] = alpha;
+    }
+}
+
+void swizzleRGBAScalar(const uint8_t* source, uint8_t* destination, size_t pixels, const uint8_t* order) {
+    for (size_t i = 0; i < pixels; i++) {
+        uint8_t pixel[4];
+        std::memcpy(pixel, source + 4 * i, 4);
+        for (int c = 0; c < 4; c++) destination[4 * i + c] = pixel[order[c]];
+    }
+}
+
+const Kernels SCALAR = {InstructionSet::Scalar, flipSignScalar, floatToHalfScalar, halfToFloatScalar, srgbToLinearScalar, linearToSRGBScalar, expandRGBToRGBAScalar, swizzleRGBAScalar};
+
+////////////////////////////////////////// SSE4.1 / AVX2 //////////////////////////////////////////
+
+#ifdef PIXELCONVERT_X86
+
+TARGET_SSE41 void flipSignSSE41(const uint8_t* source, uint8_t* destination, size_t count) {
+    const __m128i sign = _mm_set1_epi8(static_cast<char>(0x80));
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), _mm_xor_si128(v, sign));
+    }
+    flipSignScalar(source + i, destination + i, count - i);
+}
+
+/**
+ * @brief The scalar `floatToHalfScalar` on 4 lanes, the result is in the low 16 bits of each lane.
+ */
+TARGET_SSE41 __m128i floatToHalf4(__m128 value) {
+    const __m128i bits = _mm_castps_si128(value);
+    const __m128i sign = _mm_and_si128(bits, _mm_set1_epi32(static_cast<int>(0x80000000u)));
+    const __m128i magnitude = _mm_xor_si128(bits, sign);
+    const __m128i denormMagic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+
+    // NaN stays NaN, overflow becomes infinity
+    const __m128i nan = _mm_cmpgt_epi32(magnitude, _mm_set1_epi32(255 << 23));
+    const __m128i special = _mm_or_si128(_mm_set1_epi32(0x7C00), _mm_and_si128(nan, _mm_set1_epi32(0x0200)));
+    // Denormals are rounded by the float addition
+    const __m128i denormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(magnitude), _mm_castsi128_ps(denormMagic))), denormMagic);
+    const __m128i odd = _mm_and_si128(_mm_srli_epi32(magnitude, 13), _mm_set1_epi32(1));
+    const __m128i normal = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(magnitude, _mm_set1_epi32(static_cast<int>((static_cast<uint32_t>(15 - 127) << 23) + 0xFFF))), odd), 13);
+
+    __m128i half = _mm_blendv_epi8(normal, denormal, _mm_cmplt_epi32(magnitude, _mm_set1_epi32(113 << 23)));
+    half = _mm_blendv_epi8(half, special, _mm_cmpgt_epi32(magnitude, _mm_set1_epi32(((127 + 16) << 23) - 1)));
+    return _mm_or_si128(half, _mm_srli_epi32(sign, 16));
+}
+
+TARGET_SSE41 void floatToHalfSSE41(const float* source, uint16_t* destination, size_t count) {
+    size_t i = 0;
+    // Both loads happen before the store, which only overwrites floats already read when converting in place
+    for (; i + 8 <= count; i += 8) {
+        const __m128i low = floatToHalf4(_mm_loadu_ps(source + i));
+        const __m128i high = floatToHalf4(_mm_loadu_ps(source + i + 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), _mm_packus_epi32(low, high));
+    }
+    floatToHalfScalar(source + i, destination + i, count - i);
+}
+
+/**
+ * @brief The scalar `halfToFloatScalar` on 4 lanes holding a half in their low 16 bits.
+ */
+TARGET_SSE41 __m128 halfToFloat4(__m128i half) {
+    const __m128i shiftedExponent = _mm_set1_epi32(0x7C00 << 13);
+    __m128i bits = _mm_slli_epi32(_mm_and_si128(half, _mm_set1_epi32(0x7FFF)), 13);
+    const __m128i exponent = _mm_and_si128(bits, shiftedExponent);
+    bits = _mm_add_epi32(bits, _mm_set1_epi32((127 - 15) << 23));
+    // Infinity and NaN
+    bits = _mm_add_epi32(bits, _mm_and_si128(_mm_cmpeq_epi32(exponent, shiftedExponent), _mm_set1_epi32((128 - 16) << 23)));
+    // Denormals are renormalized by the float subtraction
+    const __m128i denormal = _mm_cmpeq_epi32(exponent, _mm_setzero_si128());
+    const __m128 renormalized = _mm_sub_ps(_mm_castsi128_ps(_mm_add_epi32(bits, _mm_set1_epi32(1 << 23))), _mm_castsi128_ps(_mm_set1_epi32(113 << 23)));
+    bits = _mm_blendv_epi8(bits, _mm_castps_si128(renormalized), denormal);
+    return _mm_castsi128_ps(_mm_or_si128(bits, _mm_slli_epi32(_mm_and_si128(half, _mm_set1_epi32(0x8000)), 16)));
+}
+
+TARGET_SSE41 void halfToFloatSSE41(const uint16_t* source, float* destination, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i halves = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+        _mm_storeu_ps(destination + i, halfToFloat4(_mm_cvtepu16_epi32(halves)));
+        _mm_storeu_ps(destination + i + 4, halfToFloat4(_mm_cvtepu16_epi32(_mm_unpackhi_epi64(halves, halves))));
+    }
+    halfToFloatScalar(source + i, destination + i, count - i);
+}
+
+TARGET_SSE41 void expandRGBToRGBASSE41(const uint8_t* source, uint8_t* destination, size_t pixels, uint8_t alpha) {
+    const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m128i alphaMask = _mm_set1_epi32(static_cast<int>(static_cast<uint32_t>(alpha) << 24));
+    size_t i = 0;
+    // Each step reads 16 bytes but only consumes 12, so stop early enough to not read past the end
+    for (; i + 6 <= pixels; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + 3 * i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + 4 * i), _mm_or_si128(_mm_shuffle_epi8(v, shuffle), alphaMask));
+    }
+    expandRGBToRGBAScalar(source + 3 * i, destination + 4 * i, pixels - i, alpha);
+}
+
+TARGET_SSE41 void swizzleRGBASSE41(const uint8_t* source, uint8_t* destination, size_t pixels, const uint8_t* order) {
+    alignas(16) int8_t mask[16];
+    for (int p = 0; p < 4; p++)
+        for (int c = 0; c < 4; c++) mask[4 * p + c] = static_cast<int8_t>(4 * p + order[c]);
+    const __m128i shuffle = _mm_load_si128(reinterpret_cast<const __m128i*>(mask));
+    size_t i = 0;
+    for (; i + 4 <= pixels; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + 4 * i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + 4 * i), _mm_shuffle_epi8(v, shuffle));
+    }
+    swizzleRGBAScalar(source + 4 * i, destination + 4 * i, pixels - i, order);
+}
+
+// Without gather instructions the sRGB tables are faster to look up one value at a time
+const Kernels SSE41 = {InstructionSet::SSE41, flipSignSSE41, floatToHalfSSE41, halfToFloatSSE41, nullptr, nullptr, expandRGBToRGBASSE41, swizzleRGBASSE41};
+
+TARGET_AVX2 void flipSignAVX2(const uint8_t* source, uint8_t* destination, size_t count) {
+    const __m256i sign = _mm256_set1_epi8(static_cast<char>(0x80));
+    size_t i = 0;
+    for (; i + 32 <= count; i += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i), _mm256_xor_si256(v, sign));
+    }
+    flipSignScalar(source + i, destination + i, count - i);
+}
+
+TARGET_AVX2 void floatToHalfAVX2(const float* source, uint16_t* destination, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 v = _mm256_loadu_ps(source + i);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), _mm256_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT));
+    }
+    floatToHalfScalar(source + i, destination + i, count - i);
+}
+
+TARGET_AVX2 void halfToFloatAVX2(const uint16_t* source, float* destination, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+        _mm256_storeu_ps(destination + i, _mm256_cvtph_ps(v));
+    }
+    halfToFloatScalar(source + i, destination + i, count - i);
+}
+
+TARGET_AVX2 void srgbToLinearAVX2(const uint8_t* source, float* destination, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(source + i));
+        __m256i indices = _mm256_cvtepu8_epi32(bytes);
+        _mm256_storeu_ps(destination + i, _mm256_i32gather_ps(SRGB_TO_LINEAR.data(), indices, 4));
+    }
+    srgbToLinearScalar(source + i, destination + i, count - i);
+}
+
+TARGET_AVX2 void linearToSRGBAVX2(const float* source, uint8_t* destination, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        // The binary search of the scalar code with a gather per step
+        const __m256 value = _mm256_loadu_ps(source + i);
+        __m256i index = _mm256_setzero_si256();
+        for (int step = 128; step > 0; step >>= 1) {
+            const __m256i candidate = _mm256_add_epi32(index, _mm256_set1_epi32(step));
+            const __m256 threshold = _mm256_i32gather_ps(SRGB_THRESHOLDS.data(), candidate, 4);
+            index = _mm256_blendv_epi8(index, candidate, _mm256_castps_si256(_mm256_cmp_ps(threshold, value, _CMP_LE_OQ)));
+        }
+        const __m128i words = _mm_packus_epi32(_mm256_castsi256_si128(index), _mm256_extracti128_si256(index, 1));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(destination + i), _mm_packus_epi16(words, words));
+    }
+    linearToSRGBScalar(source + i, destination + i, count - i);
+}
+
+TARGET_AVX2 void expandRGBToRGBAAVX2(const uint8_t* source, uint8_t* destination, size_t pixels, uint8_t alpha) {
+    // The 24 bytes of 8 pixels are split into the two 128 bit lanes, then expanded within each lane like in the SSE4.1 kernel
+    const __m256i spread = _mm256_setr_epi32(0, 1, 2, 2, 3, 4, 5, 5);
+    const __m256i shuffle = _mm256_broadcastsi128_si256(_mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1));
+    const __m256i alphaMask = _mm256_set1_epi32(static_cast<int>(static_cast<uint32_t>(alpha) << 24));
+    size_t i = 0;
+    // Each step reads 32 bytes but only consumes 24, so stop early enough to not read past the end
+    for (; i + 11 <= pixels; i += 8) {
+        __m256i v = _mm256_permutevar8x32_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + 3 * i)), spread);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + 4 * i), _mm256_or_si256(_mm256_shuffle_epi8(v, shuffle), alphaMask));
+    }
+    expandRGBToRGBASSE41(source + 3 * i, destination + 4 * i, pixels - i, alpha);
+}
+
+TARGET_AVX2 void swizzleRGBAAVX2(const uint8_t* source, uint8_t* destination, size_t pixels, const uint8_t* order) {
+    alignas(16) int8_t mask[16];
+    for (int p = 0; p < 4; p++)
+        for (int c = 0; c < 4; c++) mask[4 * p + c] = static_cast<int8_t>(4 * p + order[c]);
+    // The byte shuffle works within each 128 bit lane, so the same mask is used for both
+    const __m256i shuffle = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(mask)));
+    size_t i = 0;
+    for (; i + 8 <= pixels; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + 4 * i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + 4 * i), _mm256_shuffle_epi8(v, shuffle));
+    }
+    swizzleRGBASSE41(source + 4 * i, destination + 4 * i, pixels - i, order);
+}
+
+const Kernels AVX2 = {InstructionSet::AVX2, flipSignAVX2, floatToHalfAVX2, halfToFloatAVX2, srgbToLinearAVX2, linearToSRGBAVX2, expandRGBToRGBAAVX2, swizzleRGBAAVX2};
+
+void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t registers[4]) {
+#ifdef _MSC_VER
+    int values[4];
+    __cpuidex(values, static_cast<int>(leaf), static_cast<int>(subleaf));
+    for (int i = 0; i < 4; i++) registers[i] = static_cast<uint32_t>(values[i]);
+#else
+    if (!__get_cpuid_count(leaf, subleaf, &registers[0], &registers[1], &registers[2], &registers[3]))
+        registers[0] = registers[1] = registers[2] = registers[3] = 0;
+#endif
+}
+
+uint64_t xgetbv() {
+#ifdef _MSC_VER
+    return _xgetbv(0);
+#else
+    uint32_t low, high;
+    __asm__ volatile("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+    return static_cast<uint64_t>(high) << 32 | low;
+#endif
+}
+
+#endif
+
+////////////////////////////////////////// NEON //////////////////////////////////////////
+
+#ifdef PIXELCONVERT_NEON
+
+void flipSignNEON(const uint8_t* source, uint8_t* destination, size_t count) {
+    const uint8x16_t sign = vdupq_n_u8(0x80);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) vst1q_u8(destination + i, veorq_u8(vld1q_u8(source + i), sign));
+    flipSignScalar(source + i, destination + i, count - i);
+}
+
+void floatToHalfNEON(const float* source, uint16_t* destination, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) vst1_u16(destination + i, vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(source + i))));
+    floatToHalfScalar(source + i, destination + i, count - i);
+}
+
+void halfToFloatNEON(const uint16_t* source, float* destination, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) vst1q_f32(destination + i, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(source + i))));
+    halfToFloatScalar(source + i, destination + i, count - i);
+}
+
+// The bytes of the floats in SRGB_TO_LINEAR by their position, so the table can be looked up with byte shuffles
+const auto SRGB_TO_LINEAR_BYTES = [] {
+    std::array<std::array<uint8_t, 256>, 4> planes{};
+    for (int i = 0; i < 256; i++) {
+        const uint32_t bits = floatBits(SRGB_TO_LINEAR[i]);
+        for (int b = 0; b < 4; b++) planes[b][i] = static_cast<uint8_t>(bits >> (8 * b));
+    }
+    return planes;
+}();
+
+void srgbToLinearNEON(const uint8_t* source, float* destination, size_t count) {
+    // Each byte plane is looked up in four quarters of 64 bytes, indices past a quarter keep the previous result
+    uint8x16x4_t quarters[4][4];
+    for (int b = 0; b < 4; b++)
+        for (int q = 0; q < 4; q++) quarters[b][q] = vld1q_u8_x4(SRGB_TO_LINEAR_BYTES[b].data() + 64 * q);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const uint8x16_t index = vld1q_u8(source + i);
+        uint8x16x4_t bytes;
+        for (int b = 0; b < 4; b++) {
+            uint8x16_t v = vqtbl4q_u8(quarters[b][0], index);
+            for (int q = 1; q < 4; q++) v = vqtbx4q_u8(v, quarters[b][q], vsubq_u8(index, vdupq_n_u8(static_cast<uint8_t>(64 * q))));
+            bytes.val[b] = v;
+        }
+        // Interleaving the planes assembles the little endian floats
+        vst4q_u8(reinterpret_cast<uint8_t*>(destination + i), bytes);
+    }
+    srgbToLinearScalar(source + i, destination + i, count - i);
+}
+
+void expandRGBToRGBANEON(const uint8_t* source, uint8_t* destination, size_t pixels, uint8_t alpha) {
+    size_t i = 0;
+    for (; i + 16 <= pixels; i += 16) {
+        uint8x16x3_t rgb = vld3q_u8(source + 3 * i);
+        uint8x16x4_t rgba = {{rgb.val[0], rgb.val[1], rgb.val[2], vdupq_n_u8(alpha)}};
+        vst4q_u8(destination + 4 * i, rgba);
+    }
+    expandRGBToRGBAScalar(source + 3 * i, destination + 4 * i, pixels - i, alpha);
+}
+
+void swizzleRGBANEON(const uint8_t* source, uint8_t* destination, size_t pixels, const uint8_t* order) {
+    uint8_t mask[16];
+    for (int p = 0; p < 4; p++)
+        for (int c = 0; c < 4; c++) mask[4 * p + c] = static_cast<uint8_t>(4 * p + order[c]);
+    const uint8x16_t shuffle = vld1q_u8(mask);
+    size_t i = 0;
+    for (; i + 4 <= pixels; i += 4) vst1q_u8(destination + 4 * i, vqtbl1q_u8(vld1q_u8(source + 4 * i), shuffle));
+    swizzleRGBAScalar(source + 4 * i, destination + 4 * i, pixels - i, order);
+}
+
+// Without gather instructions the binary search of the sRGB encoding is faster one value at a time
+const Kernels NEON = {InstructionSet::NEON, flipSignNEON, floatToHalfNEON, halfToFloatNEON, srgbToLinearNEON, nullptr, expandRGBToRGBANEON, swizzleRGBANEON};
+
+#endif
+
+const Kernels* getKernels(InstructionSet instructionSet) {
+    switch (instructionSet) {
+#ifdef PIXELCONVERT_X86
+        case InstructionSet::AVX2: return &AVX2;
+        case InstructionSet::SSE41: return &SSE41;
+#endif
+#ifdef PIXELCONVERT_NEON
+        case InstructionSet::NEON: return &NEON;
+#endif
+        default: return &SCALAR;
+    }
+}
+
+InstructionSet detectInstructionSet() {
+#if defined(PIXELCONVERT_X86)
+    uint32_t registers[4];
+    cpuid(0, 0, registers);
+    const uint32_t maxLeaf = registers[0];
+    cpuid(1, 0, registers);
+    const uint32_t ecx = registers[2];
+    const bool ssse3 = ecx & 1u << 9, sse41 = ecx & 1u << 19, osxsave = ecx & 1u << 27, avx = ecx & 1u << 28, f16c = ecx & 1u << 29;
+    bool avx2 = false;
+    if (maxLeaf >= 7) {
+        cpuid(7, 0, registers);
+        avx2 = registers[1] & 1u << 5;
+    }
+    // AVX also needs the OS to save the YMM registers on context switches
+    const bool avxEnabled = osxsave && avx && (xgetbv() & 0x6) == 0x6;
+    if (avxEnabled && avx2 && f16c) return InstructionSet::AVX2;
+    if (ssse3 && sse41) return InstructionSet::SSE41;
+    return InstructionSet::Scalar;
+#elif defined(PIXELCONVERT_NEON)
+    return InstructionSet::NEON;
+#else
+    return InstructionSet::Scalar;
+#endif
+}
+
+const InstructionSet SUPPORTED = detectInstructionSet();
+std::atomic<const Kernels*> active{getKernels(SUPPORTED)};
+
+const Kernels& kernels() {
+    return *active.load(std::memory_order_relaxed);
+}
+
+}
+
+PixelConvert::InstructionSet PixelConvert::getSupportedInstructionSet() {
+    return SUPPORTED;
+}
+
+PixelConvert::InstructionSet PixelConvert::getInstructionSet() {
+    return kernels().instructionSet;
+}
+
+bool PixelConvert::setInstructionSet(InstructionSet instructionSet) {
+    bool supported = instructionSet == InstructionSet::Scalar || instructionSet == SUPPORTED
+                     || (instructionSet == InstructionSet::SSE41 && SUPPORTED == InstructionSet::AVX2);
+    if (!supported) return false;
+    active.store(getKernels(instructionSet));
+    return true;
+}
+
+const char* PixelConvert::getName(InstructionSet instructionSet) {
+    switch (instructionSet) {
+        case InstructionSet::SSE41: return "SSE4.1";
+        case InstructionSet::AVX2: return "AVX2";
+        case InstructionSet::NEON: return "NEON";
+        default: return "Scalar";
+    }
+}
+
+void PixelConvert::unsignedToSigned(const uint8_t* source, int8_t* destination, size_t count) {
+    kernels().flipSign(source, reinterpret_cast<uint8_t*>(destination), count);
+}
+
+void PixelConvert::signedToUnsigned(const int8_t* source, uint8_t* destination, size_t count) {
+    kernels().flipSign(reinterpret_cast<const uint8_t*>(source), destination, count);
+}
+
+void PixelConvert::floatToHalf(const float* source, uint16_t* destination, size_t count) {
+    kernels().floatToHalf(source, destination, count);
+}
+
+void PixelConvert::halfToFloat(const uint16_t* source, float* destination, size_t count) {
+    kernels().halfToFloat(source, destination, count);
+}
+
+void PixelConvert::srgbToLinear(const uint8_t* source, float* destination, size_t pixels, int channels, bool alpha) {
+    const auto kernel = kernels().srgbToLinear;
+    (kernel ? kernel : srgbToLinearScalar)(source, destination, pixels * channels);
+    if (alpha) {
+        for (size_t i = channels - 1; i < pixels * channels; i += channels) destination[i] = source[i] / 255.0f;
+    }
+}
+
+void PixelConvert::linearToSRGB(const float* source, uint8_t* destination, size_t pixels, int channels, bool alpha) {
+    const size_t count = pixels * channels;
+    const auto kernel = kernels().linearToSRGB;
+    (kernel ? kernel : linearToSRGBScalar)(source, destination, count);
+    if (alpha) {
+        for (size_t i = channels - 1; i < count; i += channels)
+            destination[i] = static_cast<uint8_t>(std::clamp(source[i] * 255.0f + 0.5f, 0.0f, 255.0f));
+    }
+}
+
+void PixelConvert::expandRGBToRGBA(const uint8_t* source, uint8_t* destination, size_t pixels, uint8_t alpha) {
+    kernels().expandRGBToRGBA(source, destination, pixels, alpha);
+}
+
+void PixelConvert::swizzleRGBA(const uint8_t* source, uint8_t* destination, size_t pixels, const std::array<uint8_t, 4>& order) {
+    kernels().swizzleRGBA(source, destination, pixels, order.data());
+}
+
+void PixelConvert::flipRows(void* data, size_t rowBytes, size_t rows) {
+    // Rows are swapped through a small buffer, memcpy is already vectorized by the C library
+    auto* bytes = static_cast<uint8_t*>(data);
+    uint8_t buffer[4096];
+    for (size_t row = 0; row < rows / 2; row++) {
+        uint8_t* top = bytes + row * rowBytes;
+        uint8_t* bottom = bytes + (rows - 1 - row) * rowBytes;
+        for (size_t offset = 0; offset < rowBytes; offset += sizeof(buffer)) {
+            const size_t size = std::min(sizeof(buffer), rowBytes - offset);
+            std::memcpy(buffer, top + offset, size);
+            std::memcpy(top + offset, bottom + offset, size);
+            std::memcpy(bottom + offset, buffer, size);
+        }
+    }
+}
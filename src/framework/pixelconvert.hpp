@@ -0,0 +1,98 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @file pixelconvert.hpp
+ * @brief Defines vectorized pixel format conversions used for texture upload and readback.
+ */
+
+/**
+ * @brief Vectorized conversion kernels between pixel formats.
+ * The kernels are selected at runtime for the best instruction set of the CPU (SSE4.1, AVX2 with F16C, NEON), with a scalar fallback.
+ * The sRGB conversions are table lookups, which SSE4.1 (both) and NEON (`linearToSRGB`) do one value at a time as they lack gather instructions.
+ * All kernels work on tightly packed data, source and destination may be the same buffer unless noted otherwise.
+ */
+namespace PixelConvert {
+
+    enum class InstructionSet {
+        Scalar,
+        SSE41,
+        AVX2,
+        NEON,
+    };
+
+    /**
+     * @brief Gets the best instruction set supported by the CPU.
+     */
+    InstructionSet getSupportedInstructionSet();
+
+    /**
+     * @brief Gets the instruction set the kernels currently use.
+     */
+    InstructionSet getInstructionSet();
+
+    /**
+     * @brief Selects the kernels of an instruction set, e.g. to compare their throughput.
+     * @return False if the CPU does not support the instruction set, the selection is unchanged then.
+     */
+    bool setInstructionSet(InstructionSet instructionSet);
+
+    /**
+     * @brief Gets the name of an instruction set, e.g. "AVX2".
+     */
+    const char* getName(InstructionSet instructionSet);
+
+    /**
+     * @brief Converts unsigned to signed bytes by subtracting 128, as needed for `_SNORM` textures loaded from 8 bit images.
+     */
+    void unsignedToSigned(const uint8_t* source, int8_t* destination, size_t count);
+
+    /**
+     * @brief Converts signed to unsigned bytes by adding 128, as needed for writing `_SNORM` textures to 8 bit images.
+     */
+    void signedToUnsigned(const int8_t* source, uint8_t* destination, size_t count);
+
+    /**
+     * @brief Converts floats to half floats with round to nearest even.
+     * The conversion may also be done in place, i.e. `destination` may point to the start of `source`.
+     */
+    void floatToHalf(const float* source, uint16_t* destination, size_t count);
+
+    /**
+     * @brief Converts half floats to floats, `source` and `destination` must not overlap.
+     */
+    void halfToFloat(const uint16_t* source, float* destination, size_t count);
+
+    /**
+     * @brief Decodes sRGB encoded bytes to linear floats in [0, 1], `source` and `destination` must not overlap.
+     * @param channels The number of channels per pixel.
+     * @param alpha Whether the last channel is alpha, which is stored linearly and only normalized.
+     */
+    void srgbToLinear(const uint8_t* source, float* destination, size_t pixels, int channels, bool alpha);
+
+    /**
+     * @brief Encodes linear floats in [0, 1] to sRGB bytes with exact rounding, `source` and `destination` must not overlap.
+     * @param channels The number of channels per pixel.
+     * @param alpha Whether the last channel is alpha, which is stored linearly and only quantized.
+     */
+    void linearToSRGB(const float* source, uint8_t* destination, size_t pixels, int channels, bool alpha);
+
+    /**
+     * @brief Expands RGB to RGBA bytes with a constant alpha, `source` and `destination` must not overlap.
+     */
+    void expandRGBToRGBA(const uint8_t* source, uint8_t* destination, size_t pixels, uint8_t alpha = 255);
+
+    /**
+     * @brief Reorders the channels of RGBA bytes, channel `c` of the result is channel `order[c]` of the source, e.g. `{2, 1, 0, 3}` converts between RGBA and BGRA.
+     */
+    void swizzleRGBA(const uint8_t* source, uint8_t* destination, size_t pixels, const std::array<uint8_t, 4>& order);
+
+    /**
+     * @brief Flips an image vertically in place, converting between the top-left origin of image files and the bottom-left origin of OpenGL.
+     */
+    void flipRows(void* data, size_t rowBytes, size_t rows);
+
+}
@@ -0,0 +1,256 @@
+#include "png.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "deflate.hpp"
+#include "threadpool.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define PNG_SSE2
+    #include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    #define PNG_NEON
+    #include <arm_neon.h>
+#endif
+
+namespace {
+
+constexpr size_t BAND_BYTES = 1 << 18; // Raw bytes per band, small enough to keep all threads busy
+
+enum Filter : uint8_t {
+    FILTER_SUB = 1,
+    FILTER_UP = 2,
+    FILTER_PAETH = 4,
+};
+
+uint8_t paeth(int a, int b, int c) {
+    int pa = std::abs(b - c), pb = std::abs(a - c), pc = std::abs(a + b - 2 * c);
+    if (pa <= pb && pa <= pc) return static_cast<uint8_t>(a);
+    return static_cast<uint8_t>(pb <= pc ? b : c);
+}
+
+/**
+ * @brief Sums the absolute values of the filtered bytes interpreted as signed, the usual heuristic to pick the filter that compresses best.
+ */
+uint64_t score(const uint8_t* filtered, size_t size) {
+    uint64_t sum = 0;
+    size_t i = 0;
+#if defined(PNG_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    __m128i total = zero;
+    for (; i + 16 <= size; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(filtered + i));
+        __m128i magnitude = _mm_min_epu8(v, _mm_sub_epi8(zero, v));
+        total = _mm_add_epi64(total, _mm_sad_epu8(magnitude, zero));
+    }
+    alignas(16) uint64_t lanes[2];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), total);
+    sum = lanes[0] + lanes[1];
+#elif defined(PNG_NEON)
+    uint64x2_t total = vdupq_n_u64(0);
+    for (; i + 16 <= size; i += 16) {
+        int8x16_t v = vreinterpretq_s8_u8(vld1q_u8(filtered + i));
+        total = vpadalq_u32(total, vpaddlq_u16(vpaddlq_u8(vreinterpretq_u8_s8(vqabsq_s8(v)))));
+    }
+    sum = vgetq_lane_u64(total, 0) + vgetq_lane_u64(total, 1);
+#endif
+    for (; i < size; i++) sum += std::min<int>(filtered[i], 256 - filtered[i]);
+    return sum;
+}
+
+void filterSub(const uint8_t* row, uint8_t* out, size_t size, size_t bpp) {
+    std::memcpy(out, row, std::min(bpp, size));
+    size_t i = bpp;
+#if defined(PNG_SSE2)
+    for (; i + 16 <= size; i += 16) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i - bpp));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_sub_epi8(x, a));
+    }
+#elif defined(PNG_NEON)
+    for (; i + 16 <= size; i += 16) vst1q_u8(out + i, vsubq_u8(vld1q_u8(row + i), vld1q_u8(row + i - bpp)));
+#endif
+    for (; i < size; i++) out[i] = static_cast<uint8_t>(row[i] - row[i - bpp]);
+}
+
+void filterUp(const uint8_t* row, const uint8_t* previous, uint8_t* out, size_t size) {
+    size_t i = 0;
+#if defined(PNG_SSE2)
+    for (; i + 16 <= size; i += 16) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(previous + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_sub_epi8(x, b));
+    }
+#elif defined(PNG_NEON)
+    for (; i + 16 <= size; i += 16) vst1q_u8(out + i, vsubq_u8(vld1q_u8(row + i), vld1q_u8(previous + i)));
+#endif
+    for (; i < size; i++) out[i] = static_cast<uint8_t>(row[i] - previous[i]);
+}
+
+#if defined(PNG_SSE2)
+/**
+ * @brief Paeth predictor for 8 pixels widened to 16 bit.
+ */
+__m128i paeth16(__m128i a, __m128i b, __m128i c) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i bc = _mm_sub_epi16(b, c), ac = _mm_sub_epi16(a, c);
+    __m128i sum = _mm_add_epi16(bc, ac);
+    __m128i pa = _mm_max_epi16(bc, _mm_sub_epi16(zero, bc));
+    __m128i pb = _mm_max_epi16(ac, _mm_sub_epi16(zero, ac));
+    __m128i pc = _mm_max_epi16(sum, _mm_sub_epi16(zero, sum));
+    __m128i notA = _mm_or_si128(_mm_cmpgt_epi16(pa, pb), _mm_cmpgt_epi16(pa, pc));
+    __m128i notB = _mm_cmpgt_epi16(pb, pc);
+    __m128i bOrC = _mm_or_si128(_mm_andnot_si128(notB, b), _mm_and_si128(notB, c));
+    return _mm_or_si128(_mm_andnot_si128(notA, a), _mm_and_si128(notA, bOrC));
+}
+#endif
+
+void filterPaeth(const uint8_t* row, const uint8_t* previous, uint8_t* out, size_t size, size_t bpp) {
+    size_t i = 0;
+    for (; i < std::min(bpp, size); i++) out[i] = static_cast<uint8_t>(row[i] - paeth(0, previous[i], 0));
+#if defined(PNG_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= size; i += 16) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i - bpp));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(previous + i));
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(previous + i - bpp));
+        __m128i low = paeth16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero), _mm_unpacklo_epi8(c, zero));
+        __m128i high = paeth16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero), _mm_unpackhi_epi8(c, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_sub_epi8(x, _mm_packus_epi16(low, high)));
+    }
+#elif defined(PNG_NEON)
+    for (; i + 16 <= size; i += 16) {
+        uint8x16_t a = vld1q_u8(row + i - bpp), b = vld1q_u8(previous + i), c = vld1q_u8(previous + i - bpp);
+        // pa = |b - c|, pb = |a - c| fit in 8 bits, pc = |a + b - 2c| needs 16 bits
+        uint8x16_t pa = vabdq_u8(b, c), pb = vabdq_u8(a, c);
+        int16x8_t sumLow = vaddq_s16(vreinterpretq_s16_u16(vsubl_u8(vget_low_u8(b), vget_low_u8(c))), vreinterpretq_s16_u16(vsubl_u8(vget_low_u8(a), vget_low_u8(c))));
+        int16x8_t sumHigh = vaddq_s16(vreinterpretq_s16_u16(vsubl_u8(vget_high_u8(b), vget_high_u8(c))), vreinterpretq_s16_u16(vsubl_u8(vget_high_u8(a), vget_high_u8(c))));
+        uint8x16_t pc = vcombine_u8(vqmovun_s16(vabsq_s16(sumLow)), vqmovun_s16(vabsq_s16(sumHigh)));
+        uint8x16_t useA = vandq_u8(vcleq_u8(pa, pb), vcleq_u8(pa, pc));
+        uint8x16_t prediction = vbslq_u8(useA, a, vbslq_u8(vcleq_u8(pb, pc), b, c));
+        vst1q_u8(out + i, vsubq_u8(vld1q_u8(row + i), prediction));
+    }
+#endif
+    for (; i < size; i++) out[i] = static_cast<uint8_t>(row[i] - paeth(row[i - bpp], previous[i], previous[i - bpp]));
+}
+
+void appendBigEndian(std::vector<uint8_t>& out, uint32_t value) {
+    for (int shift = 24; shift >= 0; shift -= 8) out.push_back(static_cast<uint8_t>(value >> shift));
+}
+
+/**
+ * @brief Appends a complete chunk with length, type, data and CRC.
+ */
+void appendChunk(std::vector<uint8_t>& out, const char* type, const uint8_t* data, size_t size) {
+    appendBigEndian(out, static_cast<uint32_t>(size));
+    const size_t typeOffset = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data, data + size);
+    appendBigEndian(out, Deflate::crc32(out.data() + typeOffset, size + 4));
+}
+
+/**
+ * @brief Encodes the image into a list of byte ranges that form the file when concatenated, avoiding a copy of the band data.
+ */
+std::vector<std::vector<uint8_t>> encodeParts(const uint8_t* pixels, int width, int height, int channels, bool bottomUp) {
+    uint8_t colorType;
+    switch (channels) {
+        case 1: colorType = 0; break;
+        case 2: colorType = 4; break;
+        case 3: colorType = 2; break;
+        case 4: colorType = 6; break;
+        default: throw std::runtime_error("PNG: Unsupported number of channels " + std::to_string(channels));
+    }
+    if (width <= 0 || height <= 0) throw std::runtime_error("PNG: Invalid image size");
+
+    const size_t rowBytes = static_cast<size_t>(width) * channels;
+    const size_t bandRows = std::max<size_t>(1, BAND_BYTES / rowBytes);
+    const size_t bands = (height + bandRows - 1) / bandRows;
+    auto getRow = [&](size_t y) { return pixels + (bottomUp ? height - 1 - y : y) * rowBytes; };
+
+    // Signature and header
+    std::vector<std::vector<uint8_t>> parts(bands + 2);
+    auto& header = parts.front();
+    header = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    std::vector<uint8_t> ihdr;
+    appendBigEndian(ihdr, static_cast<uint32_t>(width));
+    appendBigEndian(ihdr, static_cast<uint32_t>(height));
+    ihdr.insert(ihdr.end(), {8, colorType, 0, 0, 0}); // Bit depth, color type, deflate, adaptive filtering, no interlacing
+    appendChunk(header, "IHDR", ihdr.data(), ihdr.size());
+
+    // Each band is filtered, deflated and checksummed independently and becomes one IDAT chunk
+    std::vector<uint32_t> checksums(bands);
+    std::vector<size_t> filteredSizes(bands);
+    ThreadPool::global().parallelFor(0, bands, [&](size_t band) {
+        const size_t begin = band * bandRows, end = std::min<size_t>(height, begin + bandRows);
+        std::vector<uint8_t> filtered((end - begin) * (rowBytes + 1));
+        std::vector<uint8_t> candidates(3 * rowBytes);
+        const std::vector<uint8_t> zeros(begin == 0 ? rowBytes : 0, 0);
+        for (size_t y = begin; y < end; y++) {
+            const uint8_t* row = getRow(y);
+            const uint8_t* previous = y == 0 ? zeros.data() : getRow(y - 1);
+            uint8_t* sub = candidates.data();
+            uint8_t* up = sub + rowBytes;
+            uint8_t* paeth = up + rowBytes;
+            filterSub(row, sub, rowBytes, channels);
+            filterUp(row, previous, up, rowBytes);
+            filterPaeth(row, previous, paeth, rowBytes, channels);
+            uint64_t scores[3] = {score(sub, rowBytes), score(up, rowBytes), score(paeth, rowBytes)};
+            const int best = static_cast<int>(std::min_element(scores, scores + 3) - scores);
+            const Filter filters[3] = {FILTER_SUB, FILTER_UP, FILTER_PAETH};
+            uint8_t* out = filtered.data() + (y - begin) * (rowBytes + 1);
+            out[0] = filters[best];
+            std::memcpy(out + 1, candidates.data() + best * rowBytes, rowBytes);
+        }
+        checksums[band] = Deflate::adler32(filtered.data(), filtered.size());
+        filteredSizes[band] = filtered.size();
+
+        std::vector<uint8_t> data;
+        data.reserve(filtered.size() / 2);
+        if (band == 0) data = {0x78, 0x01}; // zlib header
+        Deflate::compress(filtered.data(), filtered.size(), band + 1 == bands, data);
+        auto& chunk = parts[band + 1];
+        chunk.reserve(data.size() + 12);
+        appendChunk(chunk, "IDAT", data.data(), data.size());
+    });
+
+    // The zlib checksum closes the stream in a last small IDAT chunk
+    uint32_t adler = 1;
+    for (size_t band = 0; band < bands; band++) adler = Deflate::adler32Combine(adler, checksums[band], filteredSizes[band]);
+    std::vector<uint8_t> trailer;
+    appendBigEndian(trailer, adler);
+    auto& footer = parts.back();
+    appendChunk(footer, "IDAT", trailer.data(), trailer.size());
+    appendChunk(footer, "IEND", nullptr, 0);
+    return parts;
+}
+
+}
+
+std::vector<uint8_t> PNG::encode(const uint8_t* pixels, int width, int height, int channels, bool bottomUp) {
+    auto parts = encodeParts(pixels, width, height, channels, bottomUp);
+    size_t size = 0;
+    for (const auto& part : parts) size += part.size();
+    std::vector<uint8_t> result;
+    result.reserve(size);
+    for (const auto& part : parts) result.insert(result.end(), part.begin(), part.end());
+    return result;
+}
+
+bool PNG::write(const std::filesystem::path& filepath, const uint8_t* pixels, int width, int height, int channels, bool bottomUp) {
+    auto parts = encodeParts(pixels, width, height, channels, bottomUp);
+    std::ofstream file(filepath, std::ios::binary);
+    if (!file) return false;
+    for (const auto& part : parts) file.write(reinterpret_cast<const char*>(part.data()), static_cast<std::streamsize>(part.size()));
+    return static_cast<bool>(file);
+}
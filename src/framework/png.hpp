@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+/**
+ * @file png.hpp
+ * @brief Defines a fast multithreaded PNG encoder for screenshots and texture dumps.
+ */
+
+/**
+ * @brief Encodes 8 bit PNG images in parallel.
+ * The image is split into bands of rows that are filtered with SIMD (choosing between the Sub, Up and Paeth filters per row) and deflated independently,
+ * each band becomes its own `IDAT` chunk. The result is a standard PNG that any decoder reads, at a compression ratio close to zlib's fastest level.
+ */
+namespace PNG {
+
+    /**
+     * @brief Encodes an image into a PNG file in memory.
+     * @param pixels The tightly packed 8 bit pixels.
+     * @param channels The number of channels, 1 (gray), 2 (gray and alpha), 3 (RGB) or 4 (RGBA).
+     * @param bottomUp Whether the first row of `pixels` is the bottom row of the image, as returned by `glReadPixels`.
+     * @throw `std::runtime_error` if the number of channels is not supported.
+     */
+    std::vector<uint8_t> encode(const uint8_t* pixels, int width, int height, int channels, bool bottomUp = false);
+
+    /**
+     * @brief Encodes an image and writes it to a PNG file, see `encode`.
+     * @return True if the file was written successfully.
+     */
+    bool write(const std::filesystem::path& filepath, const uint8_t* pixels, int width, int height, int channels, bool bottomUp = false);
+
+}
@@ -0,0 +1,152 @@
+#include "renderqueue.hpp"
+
+#include <glad/gl.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "gl/state.hpp"
+
+namespace {
+    inline size_t alignUp(size_t value, size_t alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+}
+
+////////////////////////////// CommandList //////////////////////////////
+
+void CommandList::clear() {
+    packets.clear();
+    uniforms.clear();
+}
+
+void CommandList::draw(uint64_t key, Program& program, Mesh& mesh, std::initializer_list<TextureBinding> textures, const void* data, size_t uniformSize, GLsizei instances) {
+    if (textures.size() > DrawPacket::MAX_TEXTURES) throw std::runtime_error("Draw packet exceeds the maximum number of textures");
+
+    DrawPacket packet;
+    packet.key = key;
+    packet.program = &program;
+    packet.mesh = &mesh;
+    std::copy(textures.begin(), textures.end(), packet.textures.begin());
+    packet.numTextures = static_cast<uint32_t>(textures.size());
+    packet.instances = instances;
+
+    if (data && uniformSize) {
+        const size_t offset = alignUp(uniforms.size(), uniformAlignment);
+        uniforms.resize(offset + uniformSize);
+        std::memcpy(uniforms.data() + offset, data, uniformSize);
+        packet.uniformOffset = static_cast<uint32_t>(offset);
+        packet.uniformSize = static_cast<uint32_t>(uniformSize);
+    }
+
+    packets.push_back(packet);
+}
+
+////////////////////////////// RenderQueue //////////////////////////////
+
+RenderQueue::RenderQueue(GLuint uniformBinding, ThreadPool& pool) : uniformBinding(uniformBinding), pool(pool), lists(pool.size() + 1) {
+    GLint alignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    uniformAlignment = static_cast<size_t>(std::max(alignment, 1));
+    for (auto& list : lists) list.uniformAlignment = uniformAlignment;
+}
+
+uint64_t RenderQueue::makeKey(uint8_t pass, uint16_t program, uint16_t material, float depth, bool backToFront) {
+    constexpr uint32_t DEPTH_MAX = (1u << 24) - 1;
+    uint32_t quantized = static_cast<uint32_t>(std::clamp(depth, 0.0f, 1.0f) * static_cast<float>(DEPTH_MAX));
+    if (backToFront) quantized = DEPTH_MAX - quantized;
+    return static_cast<uint64_t>(pass) << 56
+         | static_cast<uint64_t>(program) << 40
+         | static_cast<uint64_t>(material) << 24
+         | quantized;
+}
+
+void RenderQueue::reset() {
+    for (auto& list : lists) list.clear();
+}
+
+CommandList& RenderQueue::getList(size_t index) {
+    return lists.at(index);
+}
+
+size_t RenderQueue::numLists() const {
+    return lists.size();
+}
+
+void RenderQueue::record(size_t count, const std::function<void(CommandList&, size_t)>& recordItem) {
+    if (count == 0) return;
+    // One chunk per list, so every list is only ever written by one thread
+    const size_t grain = (count + lists.size() - 1) / lists.size();
+    pool.parallelForChunks(0, count, [this, grain, &recordItem](size_t begin, size_t end) {
+        CommandList& list = lists[begin / grain];
+        for (size_t i = begin; i < end; i++) recordItem(list, i);
+    }, grain);
+}
+
+void RenderQueue::merge() {
+    packets.clear();
+    uniforms.clear();
+    for (const auto& list : lists) {
+        const size_t base = alignUp(uniforms.size(), uniformAlignment);
+        uniforms.resize(base + list.uniforms.size());
+        if (!list.uniforms.empty()) std::memcpy(uniforms.data() + base, list.uniforms.data(), list.uniforms.size());
+        for (auto packet : list.packets) {
+            packet.uniformOffset += static_cast<uint32_t>(base);
+            packets.push_back(packet);
+        }
+    }
+}
+
+void RenderQueue::sort() {
+    const size_t n = packets.size();
+    order.resize(n);
+    scratch.resize(n);
+    for (size_t i = 0; i < n; i++) order[i] = {packets[i].key, static_cast<uint32_t>(i)};
+
+    // LSD radix sort with 8 bit digits, stable so equal keys keep their recording order
+    for (unsigned int shift = 0; shift < 64; shift += 8) {
+        std::array<size_t, 256> histogram{};
+        for (const auto& entry : order) histogram[(entry.key >> shift) & 0xFF]++;
+        // Skip digits that are equal for all keys, e.g. unused passes or programs
+        if (histogram[(order[0].key >> shift) & 0xFF] == n) continue;
+
+        size_t sum = 0;
+        for (auto& count : histogram) {
+            const size_t c = count;
+            count = sum;
+            sum += c;
+        }
+        for (const auto& entry : order) scratch[histogram[(entry.key >> shift) & 0xFF]++] = entry;
+        order.swap(scratch);
+    }
+}
+
+void RenderQueue::submit() {
+    merge();
+    submittedPackets = packets.size();
+    if (packets.empty()) return;
+    sort();
+
+    if (!uniforms.empty()) {
+        // Reallocating every frame orphans the old storage, so the driver does not have to wait for the previous frame
+        uniformBufferSize = std::max(uniformBufferSize, uniforms.size());
+        uniformBuffer.allocate(uniformBufferSize, GL_STREAM_DRAW);
+        uniformBuffer._set(uniforms.size(), uniforms.data(), 0);
+    }
+
+    for (const auto& entry : order) {
+        const DrawPacket& packet = packets[entry.index];
+        packet.program->use();
+        for (uint32_t unit = 0; unit < packet.numTextures; unit++) {
+            const auto& texture = packet.textures[unit];
+            GLState::bindTextureUnit(unit, texture.target, texture.handle);
+        }
+        if (packet.uniformSize)
+            GLState::bindBufferRange(GL_UNIFORM_BUFFER, uniformBinding, uniformBuffer.handle, packet.uniformOffset, packet.uniformSize);
+        if (packet.instances == 1) packet.mesh->draw();
+        else packet.mesh->draw(packet.instances);
+    }
+}
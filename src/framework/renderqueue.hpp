@@ -0,0 +1,189 @@
+#pragma once
+
+#include <glad/gl.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <vector>
+
+#include "mesh.hpp"
+#include "threadpool.hpp"
+#include "gl/buffer.hpp"
+#include "gl/program.hpp"
+
+/**
+ * @file renderqueue.hpp
+ * @brief Defines command lists of draw packets that are recorded on worker threads and replayed sorted on the OpenGL thread.
+ */
+
+/**
+ * @brief Texture bound to a texture unit by a draw packet, the unit is the position in `DrawPacket::textures`.
+ */
+struct TextureBinding {
+    GLenum target = GL_TEXTURE_2D;
+    GLuint handle = 0;
+};
+
+/**
+ * @brief A single draw call with everything needed to issue it, recorded without touching OpenGL.
+ */
+struct DrawPacket {
+    /** Maximum number of textures bound by one draw packet */
+    static constexpr size_t MAX_TEXTURES = 4;
+
+    /** Sort key, packets are replayed in ascending order, see `RenderQueue::makeKey` */
+    uint64_t key = 0;
+    Program* program = nullptr;
+    Mesh* mesh = nullptr;
+    std::array<TextureBinding, MAX_TEXTURES> textures;
+    uint32_t numTextures = 0;
+    /** Offset of the per-draw uniform data in the uniform arena of the command list (after merging: of the queue) */
+    uint32_t uniformOffset = 0;
+    /** Size of the per-draw uniform data in bytes, 0 if the packet has no uniform data */
+    uint32_t uniformSize = 0;
+    /** Number of instances, 1 issues a non-instanced draw */
+    GLsizei instances = 1;
+};
+
+/**
+ * @class CommandList
+ * @brief Records draw packets and their uniform data, one list per recording thread.
+ * A CommandList never calls OpenGL and can thus be filled on any thread.
+ */
+class CommandList {
+   public:
+    /**
+     * @brief Removes all packets and uniform data but keeps the allocated memory.
+     */
+    void clear();
+
+    /**
+     * @brief Records a draw packet.
+     * @param key The sort key, see `RenderQueue::makeKey`.
+     * @param program The program to draw with.
+     * @param mesh The mesh to draw.
+     * @param textures Textures bound to the units 0, 1, ... in order.
+     * @param uniforms Per-draw uniform data that is bound as uniform buffer range at `RenderQueue::uniformBinding`, may be `nullptr`.
+     * @param uniformSize The size of the uniform data in bytes.
+     * @param instances The number of instances.
+     */
+    void draw(uint64_t key, Program& program, Mesh& mesh, std::initializer_list<TextureBinding> textures, const void* uniforms, size_t uniformSize, GLsizei instances = 1);
+
+    /**
+     * @brief Records a draw packet with a uniform struct.
+     * @tparam T The type of the uniform struct, has to match the std140 layout of the uniform block.
+     */
+    template <typename T>
+    void draw(uint64_t key, Program& program, Mesh& mesh, std::initializer_list<TextureBinding> textures, const T& uniforms, GLsizei instances = 1) {
+        draw(key, program, mesh, textures, &uniforms, sizeof(T), instances);
+    }
+
+    /**
+     * @brief Records a draw packet without uniform data.
+     */
+    void draw(uint64_t key, Program& program, Mesh& mesh, std::initializer_list<TextureBinding> textures = {}, GLsizei instances = 1) {
+        draw(key, program, mesh, textures, nullptr, 0, instances);
+    }
+
+    std::vector<DrawPacket> packets;
+    std::vector<std::byte> uniforms;
+
+    /** Alignment of the uniform data, set by `RenderQueue` to `GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT` */
+    size_t uniformAlignment = 256;
+};
+
+/**
+ * @class RenderQueue
+ * @brief Merges command lists recorded in parallel, sorts their packets by key and replays them on the OpenGL thread.
+ * Sorting by a key that packs pass, program, material and depth groups draws with equal state, so the `GLState` cache can skip most state changes.
+ * Example:
+ * ```cpp
+ * queue.record(objects.size(), [&](CommandList& list, size_t i) {
+ *     list.draw(RenderQueue::makeKey(0, 0, i, depth[i]), shader, meshes[i], {{GL_TEXTURE_2D, texture.handle}}, objectData[i]);
+ * });
+ * queue.submit();
+ * ```
+ */
+class RenderQueue {
+   public:
+    /**
+     * @brief Creates a queue with one command list per worker of the pool and the calling thread.
+     * @note Has to be constructed on the OpenGL thread as it queries the uniform buffer alignment.
+     * @param uniformBinding The uniform buffer binding point the per-draw uniform data is bound to.
+     * @param pool The thread pool used for recording.
+     */
+    explicit RenderQueue(GLuint uniformBinding, ThreadPool& pool = ThreadPool::global());
+
+    /**
+     * @brief Packs a sort key, packets are replayed in ascending key order.
+     * Layout from most to least significant bits: pass (8 bits), program (16 bits), material (16 bits), depth (24 bits).
+     * @param pass The render pass, e.g. opaque before transparent.
+     * @param program An identifier of the program, packets with the same program are grouped within a pass.
+     * @param material An identifier of the material (textures and constants).
+     * @param depth The normalized view depth in [0, 1], quantized to 24 bits.
+     * @param backToFront Inverts the depth for back to front sorting, e.g. for transparent geometry.
+     */
+    static uint64_t makeKey(uint8_t pass, uint16_t program, uint16_t material, float depth, bool backToFront = false);
+
+    /**
+     * @brief Clears all command lists so they can be recorded again.
+     */
+    void reset();
+
+    /**
+     * @brief Gets the command list of a recording thread.
+     * @param index The index of the list in `[0, numLists())`.
+     */
+    CommandList& getList(size_t index);
+
+    /**
+     * @brief The number of command lists, one per worker of the pool and one for the calling thread.
+     */
+    size_t numLists() const;
+
+    /**
+     * @brief Records `count` items in parallel, every chunk of items is recorded into a separate command list.
+     * Does not clear the lists, call `reset` once per frame before recording.
+     * @param count The number of items.
+     * @param recordItem Called for each item with the list to record into and the index of the item.
+     */
+    void record(size_t count, const std::function<void(CommandList&, size_t)>& recordItem);
+
+    /**
+     * @brief Merges all command lists, sorts the packets by key, uploads the uniform data and issues the draw calls.
+     * Has to be called on the OpenGL thread.
+     */
+    void submit();
+
+    /**
+     * @brief The number of packets issued by the last `submit`.
+     */
+    size_t submittedPackets = 0;
+
+    /**
+     * @brief The uniform buffer binding point the per-draw uniform data is bound to.
+     */
+    GLuint uniformBinding;
+
+   private:
+    struct SortEntry {
+        uint64_t key;
+        uint32_t index;
+    };
+
+    void merge();
+    void sort();
+
+    ThreadPool& pool;
+    std::vector<CommandList> lists;
+    std::vector<DrawPacket> packets;
+    std::vector<std::byte> uniforms;
+    std::vector<SortEntry> order;
+    std::vector<SortEntry> scratch;
+    Buffer<GL_UNIFORM_BUFFER> uniformBuffer;
+    size_t uniformBufferSize = 0;
+    size_t uniformAlignment = 256;
+};
@@ -0,0 +1,130 @@
+#include "rendertargetpool.hpp"
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+
+#include "gl/state.hpp"
+
+RenderTarget::RenderTarget(const RenderTargetDesc& desc) : desc(desc) {
+    GLenum attachment = getAttachment(desc.internalFormat);
+    if (desc.samples > 1) {
+        multisampleTexture = std::make_unique<Texture<GL_TEXTURE_2D_MULTISAMPLE>>();
+        multisampleTexture->allocate2DMultisample(desc.internalFormat, desc.size.x, desc.size.y, desc.samples);
+        framebuffer.attach(attachment, *multisampleTexture);
+    } else {
+        texture = std::make_unique<Texture<GL_TEXTURE_2D>>();
+        texture->allocate2D(desc.internalFormat, desc.size.x, desc.size.y, desc.mipmaps);
+        texture->set(GL_TEXTURE_MIN_FILTER, desc.mipmaps > 0 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+        texture->set(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        texture->set(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        texture->set(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        framebuffer.attach(attachment, *texture);
+    }
+    framebuffer.setDrawBuffers({attachment == GL_COLOR_ATTACHMENT0 ? attachment : GL_NONE});
+    framebuffer.checkStatus();
+}
+
+Texture<GL_TEXTURE_2D>& RenderTarget::getTexture() {
+    if (!texture) throw std::runtime_error("RenderTarget: Multisampled targets have no single sampled texture");
+    return *texture;
+}
+
+Texture<GL_TEXTURE_2D_MULTISAMPLE>& RenderTarget::getMultisampleTexture() {
+    if (!multisampleTexture) throw std::runtime_error("RenderTarget: Target is not multisampled");
+    return *multisampleTexture;
+}
+
+void RenderTarget::bind() {
+    framebuffer.bind();
+    GLState::viewport(0, 0, desc.size.x, desc.size.y);
+}
+
+size_t RenderTarget::bytes() const {
+    size_t total = 0;
+    glm::ivec2 size = desc.size;
+    for (GLint level = 0; level <= desc.mipmaps; level++) {
+        total += static_cast<size_t>(size.x) * size.y * getBytesPerPixel(desc.internalFormat);
+        size = glm::max(size / 2, glm::ivec2(1));
+    }
+    return total * std::max(desc.samples, 1);
+}
+
+RenderTargetPool::RenderTargetPool(uint32_t maxUnusedFrames) : maxUnusedFrames(maxUnusedFrames) {}
+
+RenderTarget& RenderTargetPool::acquire(const RenderTargetDesc& desc) {
+    return acquire(desc, false);
+}
+
+RenderTarget& RenderTargetPool::acquire(const RenderTargetDesc& desc, bool relative) {
+    // Relative targets are part of the key, a fixed size request must not get a target that is freed by `resize`
+    for (auto& target : targets) {
+        if (!target->inUse && target->relative == relative && target->desc == desc) {
+            target->inUse = true;
+            target->lastUsedFrame = frame;
+            return *target;
+        }
+    }
+    targets.push_back(std::make_unique<RenderTarget>(desc));
+    allocations++;
+    auto& target = *targets.back();
+    target.inUse = true;
+    target.relative = relative;
+    target.lastUsedFrame = frame;
+    return target;
+}
+
+RenderTarget& RenderTargetPool::acquire(GLenum internalFormat, float scale, GLint mipmaps, GLsizei samples) {
+    RenderTargetDesc desc;
+    desc.internalFormat = internalFormat;
+    desc.size = glm::max(glm::ivec2(resolution * scale), glm::ivec2(1));
+    desc.mipmaps = mipmaps;
+    desc.samples = samples;
+    return acquire(desc, true);
+}
+
+void RenderTargetPool::release(RenderTarget& target) {
+    target.inUse = false;
+}
+
+void RenderTargetPool::endFrame() {
+    for (auto& target : targets) target->inUse = false;
+    targets.erase(std::remove_if(targets.begin(), targets.end(), [&](const std::unique_ptr<RenderTarget>& target) {
+        return frame - target->lastUsedFrame > maxUnusedFrames;
+    }), targets.end());
+    lastFrameAllocations = allocations;
+    allocations = 0;
+    frame++;
+}
+
+void RenderTargetPool::resize(const glm::vec2& newResolution) {
+    if (newResolution == resolution) return;
+    resolution = newResolution;
+    // Relative targets of the old size can never be matched again, so they are freed right away instead of waiting for eviction
+    targets.erase(std::remove_if(targets.begin(), targets.end(), [](const std::unique_ptr<RenderTarget>& target) {
+        return target->relative && !target->inUse;
+    }), targets.end());
+}
+
+void RenderTargetPool::clear() {
+    if (std::any_of(targets.begin(), targets.end(), [](const std::unique_ptr<RenderTarget>& target) { return target->inUse; }))
+        throw std::runtime_error("RenderTargetPool: Cannot clear while targets are in use");
+    targets.clear();
+}
+
+size_t RenderTargetPool::size() const {
+    return targets.size();
+}
+
+size_t RenderTargetPool::bytes() const {
+    size_t total = 0;
+    for (const auto& target : targets) total += target->bytes();
+    return total;
+}
+
+uint32_t RenderTargetPool::getLastFrameAllocations() const {
+    return lastFrameAllocations;
+}
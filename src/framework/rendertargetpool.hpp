@@ -0,0 +1,151 @@
+#pragma once
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "gl/framebuffer.hpp"
+#include "gl/texture.hpp"
+
+/**
+ * @file rendertargetpool.hpp
+ * @brief Defines a RenderTargetPool that recycles temporary render targets between frames.
+ */
+
+/**
+ * @brief The key of a pooled render target.
+ */
+struct RenderTargetDesc {
+    GLenum internalFormat = GL_RGBA8;
+    glm::ivec2 size = glm::ivec2(0);
+    GLint mipmaps = 0;
+    /** Samples per pixel, values above 1 allocate a `GL_TEXTURE_2D_MULTISAMPLE` texture */
+    GLsizei samples = 1;
+
+    bool operator==(const RenderTargetDesc& other) const {
+        return internalFormat == other.internalFormat && size == other.size && mipmaps == other.mipmaps && samples == other.samples;
+    }
+};
+
+/**
+ * @class RenderTarget
+ * @brief A texture together with a framebuffer that has it attached, owned by a RenderTargetPool.
+ */
+class RenderTarget {
+   public:
+    explicit RenderTarget(const RenderTargetDesc& desc);
+
+    /**
+     * @brief Gets the texture, only valid for single sampled targets.
+     */
+    Texture<GL_TEXTURE_2D>& getTexture();
+
+    /**
+     * @brief Gets the multisampled texture, only valid for targets with more than one sample.
+     */
+    Texture<GL_TEXTURE_2D_MULTISAMPLE>& getMultisampleTexture();
+
+    /**
+     * @brief Binds the framebuffer and sets the viewport to the size of the target.
+     */
+    void bind();
+
+    /**
+     * @brief The number of bytes of the texture including mipmaps and samples.
+     */
+    size_t bytes() const;
+
+    const RenderTargetDesc desc;
+    Framebuffer framebuffer;
+
+   private:
+    friend class RenderTargetPool;
+    std::unique_ptr<Texture<GL_TEXTURE_2D>> texture;
+    std::unique_ptr<Texture<GL_TEXTURE_2D_MULTISAMPLE>> multisampleTexture;
+    uint64_t lastUsedFrame = 0;
+    bool inUse = false;
+    bool relative = false;
+};
+
+/**
+ * @class RenderTargetPool
+ * @brief Hands out temporary render targets keyed by format, size, mipmaps, samples and whether the size is relative to the resolution so that effects like blurs or downsample chains do not create GL objects every frame.
+ * Targets are acquired during a frame and returned to the pool by `endFrame` (or earlier by `release`).
+ * Targets that were not used for a number of frames are deleted.
+ * Targets sized relative to the resolution are rebuilt lazily after `resize`, so in steady state no GL objects are created.
+ * Example:
+ * ```cpp
+ * auto& half = pool.acquire(GL_RGBA16F, 0.5f);
+ * half.bind();
+ * // ...
+ * pool.endFrame();
+ * ```
+ */
+class RenderTargetPool {
+   public:
+    /**
+     * @param maxUnusedFrames The number of frames a free target is kept before it is deleted.
+     */
+    explicit RenderTargetPool(uint32_t maxUnusedFrames = 3);
+
+    /**
+     * @brief Gets a free target matching the description, allocating a new one if none is available.
+     * The reference stays valid until the target is evicted, which never happens while it is in use.
+     */
+    RenderTarget& acquire(const RenderTargetDesc& desc);
+
+    /**
+     * @brief Gets a free target with a size relative to the resolution set by `resize`.
+     */
+    RenderTarget& acquire(GLenum internalFormat, float scale = 1.0f, GLint mipmaps = 0, GLsizei samples = 1);
+
+    /**
+     * @brief Returns a target to the pool before the end of the frame, so it can be reused by a later effect of the same frame.
+     */
+    void release(RenderTarget& target);
+
+    /**
+     * @brief Returns all targets to the pool and deletes those unused for more than `maxUnusedFrames` frames.
+     */
+    void endFrame();
+
+    /**
+     * @brief Sets the resolution for relative targets, free targets of the old resolution are deleted.
+     * Call this from `App::resizeCallback`.
+     */
+    void resize(const glm::vec2& resolution);
+
+    /**
+     * @brief Deletes all targets, none of them may be in use.
+     */
+    void clear();
+
+    /**
+     * @brief The number of targets currently allocated.
+     */
+    size_t size() const;
+
+    /**
+     * @brief The number of bytes of all allocated targets.
+     */
+    size_t bytes() const;
+
+    /**
+     * @brief The number of targets that were created in the last frame, zero in steady state.
+     */
+    uint32_t getLastFrameAllocations() const;
+
+   private:
+    RenderTarget& acquire(const RenderTargetDesc& desc, bool relative);
+
+    std::vector<std::unique_ptr<RenderTarget>> targets;
+    glm::vec2 resolution = glm::vec2(1.0f);
+    uint64_t frame = 0;
+    uint32_t maxUnusedFrames;
+    uint32_t allocations = 0;
+    uint32_t lastFrameAllocations = 0;
+};
@@ -0,0 +1,216 @@
+#include "scene.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "threadpool.hpp"
+
+using namespace glm;
+
+namespace {
+
+constexpr size_t GRAIN = 1024;
+
+mat4 composeTRS(const vec3& translation, const quat& rotation, const vec3& scale) {
+    const mat3 r = mat3_cast(rotation);
+    return mat4(vec4(r[0] * scale.x, 0.0f), vec4(r[1] * scale.y, 0.0f), vec4(r[2] * scale.z, 0.0f), vec4(translation, 1.0f));
+}
+
+template <typename T>
+void permute(std::vector<T>& values, const std::vector<uint32_t>& order) {
+    std::vector<T> sorted(values.size());
+    for (size_t i = 0; i < order.size(); i++) sorted[i] = values[order[i]];
+    values = std::move(sorted);
+}
+
+}
+
+Scene::Node Scene::create(Node parent, const vec3& translation, const quat& rotation, const vec3& scale) {
+    if (parent != NONE && parent >= slots.size()) throw std::runtime_error("Scene: Invalid parent node");
+    const Node node = static_cast<Node>(slots.size());
+    const uint32_t slot = static_cast<uint32_t>(handles.size());
+    slots.push_back(slot);
+    parentHandles.push_back(parent);
+    handles.push_back(node);
+    parents.push_back(parent == NONE ? NONE : slots[parent]);
+    translations.push_back(translation);
+    rotations.push_back(rotation);
+    scales.push_back(scale);
+    worldMatrices.push_back(mat4(1.0f));
+    dirty.push_back(1);
+    updated.push_back(0);
+    // The next update sorts the node into its level
+    orderChanged = true;
+    anyDirty = true;
+    return node;
+}
+
+void Scene::setParent(Node node, Node parent) {
+    if (node >= slots.size()) throw std::runtime_error("Scene: Invalid node");
+    if (parent != NONE && parent >= slots.size()) throw std::runtime_error("Scene: Invalid parent node");
+    // Includes the node itself, which would become its own parent
+    for (Node ancestor = parent; ancestor != NONE; ancestor = parentHandles[ancestor]) {
+        if (ancestor == node) throw std::runtime_error("Scene: A node cannot be moved into its own subtree");
+    }
+    parentHandles[node] = parent;
+    parents[slots[node]] = parent == NONE ? NONE : slots[parent];
+    dirty[slots[node]] = 1;
+    orderChanged = true;
+    anyDirty = true;
+}
+
+void Scene::setTranslation(Node node, const vec3& translation) {
+    const uint32_t slot = slots[node];
+    translations[slot] = translation;
+    dirty[slot] = 1;
+    anyDirty = true;
+}
+
+void Scene::setRotation(Node node, const quat& rotation) {
+    const uint32_t slot = slots[node];
+    rotations[slot] = rotation;
+    dirty[slot] = 1;
+    anyDirty = true;
+}
+
+void Scene::setScale(Node node, const vec3& scale) {
+    const uint32_t slot = slots[node];
+    scales[slot] = scale;
+    dirty[slot] = 1;
+    anyDirty = true;
+}
+
+void Scene::setLocalTransform(Node node, const vec3& translation, const quat& rotation, const vec3& scale) {
+    const uint32_t slot = slots[node];
+    translations[slot] = translation;
+    rotations[slot] = rotation;
+    scales[slot] = scale;
+    dirty[slot] = 1;
+    anyDirty = true;
+}
+
+Scene::Node Scene::getParent(Node node) const {
+    return parentHandles[node];
+}
+
+const vec3& Scene::getTranslation(Node node) const {
+    return translations[slots[node]];
+}
+
+const quat& Scene::getRotation(Node node) const {
+    return rotations[slots[node]];
+}
+
+const vec3& Scene::getScale(Node node) const {
+    return scales[slots[node]];
+}
+
+const mat4& Scene::getWorldMatrix(Node node) const {
+    return worldMatrices[slots[node]];
+}
+
+bool Scene::wasUpdated(Node node) const {
+    return updated[slots[node]];
+}
+
+size_t Scene::size() const {
+    return handles.size();
+}
+
+void Scene::clear() {
+    *this = Scene();
+}
+
+void Scene::sortByDepth() {
+    // Depths by handle, parents can have larger handles after `setParent`
+    const size_t count = slots.size();
+    std::vector<uint32_t> depths(count, NONE);
+    std::vector<Node> stack;
+    for (Node node = 0; node < count; node++) {
+        Node current = node;
+        while (current != NONE && depths[current] == NONE) {
+            stack.push_back(current);
+            current = parentHandles[current];
+        }
+        uint32_t depth = current == NONE ? 0 : depths[current] + 1;
+        while (!stack.empty()) {
+            depths[stack.back()] = depth++;
+            stack.pop_back();
+        }
+    }
+
+    // Counting sort by depth, stable in the handle
+    const uint32_t levels = count ? *std::max_element(depths.begin(), depths.end()) + 1 : 0;
+    levelOffsets.assign(levels + 1, 0);
+    for (uint32_t depth : depths) levelOffsets[depth + 1]++;
+    for (uint32_t level = 0; level < levels; level++) levelOffsets[level + 1] += levelOffsets[level];
+    std::vector<size_t> cursors(levelOffsets.begin(), levelOffsets.end() - 1);
+    std::vector<uint32_t> order(count); // Old slot of every new slot
+    for (Node node = 0; node < count; node++) order[cursors[depths[node]]++] = slots[node];
+
+    permute(handles, order);
+    permute(translations, order);
+    permute(rotations, order);
+    permute(scales, order);
+    permute(worldMatrices, order);
+    permute(dirty, order);
+    permute(updated, order);
+    for (uint32_t slot = 0; slot < count; slot++) slots[handles[slot]] = slot;
+    parents.resize(count);
+    for (uint32_t slot = 0; slot < count; slot++) {
+        const Node parent = parentHandles[handles[slot]];
+        parents[slot] = parent == NONE ? NONE : slots[parent];
+    }
+    orderChanged = false;
+}
+
+size_t Scene::update(ThreadPool& pool) {
+    if (!anyDirty) {
+        std::fill(updated.begin(), updated.end(), 0);
+        return 0;
+    }
+    if (orderChanged) sortByDepth();
+
+    // Parents are always in an earlier level, so every level only reads finished world matrices and flags
+    std::atomic<size_t> recomputed = 0;
+    const auto updateRange = [&](size_t begin, size_t end) {
+        size_t count = 0;
+        for (size_t slot = begin; slot < end; slot++) {
+            const uint32_t parent = parents[slot];
+            const bool parentUpdated = parent != NONE && updated[parent];
+            if (!dirty[slot] && !parentUpdated) {
+                updated[slot] = 0;
+                continue;
+            }
+            const mat4 local = composeTRS(translations[slot], rotations[slot], scales[slot]);
+            worldMatrices[slot] = parent == NONE ? local : worldMatrices[parent] * local;
+            dirty[slot] = 0;
+            updated[slot] = 1;
+            count++;
+        }
+        recomputed += count;
+    };
+    for (size_t level = 0; level + 1 < levelOffsets.size(); level++) {
+        const size_t begin = levelOffsets[level], end = levelOffsets[level + 1];
+        if (end - begin >= PARALLEL_LEVEL_SIZE) pool.parallelForChunks(begin, end, updateRange, GRAIN);
+        else updateRange(begin, end);
+    }
+    anyDirty = false;
+    return recomputed;
+}
+
+void Scene::forEachParallel(ThreadPool& pool, const std::function<void(size_t)>& body) const {
+    const auto range = [&](size_t begin, size_t end) {
+        for (size_t slot = begin; slot < end; slot++) body(slot);
+    };
+    if (size() >= PARALLEL_LEVEL_SIZE) pool.parallelForChunks(0, size(), range, GRAIN);
+    else range(0, size());
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "threadpool.hpp"
+
+using namespace glm;
+
+/**
+ * @file scene.hpp
+ * @brief Defines a transform hierarchy with incremental parallel world matrix updates.
+ */
+
+/**
+ * @class Scene
+ * @brief A transform hierarchy stored as structure of arrays sorted by depth, so every level of the tree is a contiguous range.
+ * Nodes are addressed by stable handles. Setting a local transform marks the node dirty and `update` recomputes the world matrices
+ * of dirty nodes and their descendants only, level by level, with large levels split across the thread pool.
+ * Example:
+ * ```cpp
+ * auto root = scene.create();
+ * auto child = scene.create(root, vec3(2.0f, 0.0f, 0.0f));
+ * scene.setRotation(root, angleAxis(time, vec3(0.0f, 1.0f, 0.0f)));
+ * scene.update();
+ * scene.writeObjectBuffers(cam.projectionMatrix * cam.viewMatrix, objects.data());
+ * ```
+ */
+class Scene {
+   public:
+    using Node = uint32_t;
+
+    /**
+     * @brief The parent of root nodes.
+     */
+    static constexpr Node NONE = std::numeric_limits<Node>::max();
+
+    /**
+     * @brief Levels with at least this many nodes are updated in parallel.
+     */
+    static constexpr size_t PARALLEL_LEVEL_SIZE = 4096;
+
+    /**
+     * @brief Creates a node, nodes are numbered consecutively starting at zero.
+     * @param parent The parent node or `NONE` for a root node.
+     */
+    Node create(Node parent = NONE, const vec3& translation = vec3(0.0f), const quat& rotation = quat(1.0f, 0.0f, 0.0f, 0.0f), const vec3& scale = vec3(1.0f));
+
+    /**
+     * @brief Moves a node and its subtree to a new parent.
+     * @throw `std::runtime_error` if a node does not exist or the new parent is part of the subtree, including the node itself.
+     */
+    void setParent(Node node, Node parent);
+
+    void setTranslation(Node node, const vec3& translation);
+    void setRotation(Node node, const quat& rotation);
+    void setScale(Node node, const vec3& scale);
+    void setLocalTransform(Node node, const vec3& translation, const quat& rotation, const vec3& scale);
+
+    Node getParent(Node node) const;
+    const vec3& getTranslation(Node node) const;
+    const quat& getRotation(Node node) const;
+    const vec3& getScale(Node node) const;
+
+    /**
+     * @brief The local to world matrix of a node as of the last `update`.
+     */
+    const mat4& getWorldMatrix(Node node) const;
+
+    /**
+     * @brief Whether the world matrix of a node changed in the last `update`, e.g. to skip uploads of static objects.
+     */
+    bool wasUpdated(Node node) const;
+
+    /**
+     * @brief The number of nodes.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Removes all nodes.
+     */
+    void clear();
+
+    /**
+     * @brief Recomputes the world matrices of all dirty nodes and their descendants.
+     * @return The number of recomputed world matrices.
+     */
+    size_t update(ThreadPool& pool = ThreadPool::global());
+
+    /**
+     * @brief Fills per-object uniform data for every node in bulk from the world matrices of the last `update`, indexed by node.
+     * @tparam T A uniform struct with `mat4 uLocalToWorld` and `mat4 uLocalToClip` members like the `ObjectBuffer` of the demo.
+     * @param viewProjection The world to clip space matrix of the camera.
+     * @param objects An array with `size()` elements.
+     */
+    template <typename T>
+    void writeObjectBuffers(const mat4& viewProjection, T* objects, ThreadPool& pool = ThreadPool::global()) const {
+        forEachParallel(pool, [&](size_t slot) {
+            const mat4& world = worldMatrices[slot];
+            T& object = objects[handles[slot]];
+            object.uLocalToWorld = world;
+            object.uLocalToClip = viewProjection * world;
+        });
+    }
+
+   private:
+    void sortByDepth();
+    void forEachParallel(ThreadPool& pool, const std::function<void(size_t)>& body) const;
+
+    // Indexed by handle
+    std::vector<uint32_t> slots;
+    std::vector<Node> parentHandles;
+
+    // Indexed by slot, sorted by depth
+    std::vector<Node> handles;
+    std::vector<uint32_t> parents;
+    std::vector<vec3> translations;
+    std::vector<quat> rotations;
+    std::vector<vec3> scales;
+    std::vector<mat4> worldMatrices;
+    std::vector<uint8_t> dirty;
+    std::vector<uint8_t> updated;
+    /** Start of every level and the total number of nodes */
+    std::vector<size_t> levelOffsets;
+
+    bool orderChanged = false;
+    bool anyDirty = false;
+};
@@ -0,0 +1,255 @@
+#include "texturecache.hpp"
+
+#include <glad/gl.h>
+#include <stb_image.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "bcencoder.hpp"
+#include "common.hpp"
+#include "dds.hpp"
+#include "framework/context.hpp"
+#include "pixelconvert.hpp"
+#include "threadpool.hpp"
+#include "gl/texture.hpp"
+
+namespace {
+
+constexpr uint32_t CACHE_MAGIC = 0x43544342; // "BCTC"
+constexpr uint32_t CACHE_VERSION = 2;
+
+/** Starts every cache entry and ties it to the state of its source */
+struct EntryHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t sourceSize;
+    int64_t sourceTime;
+};
+
+struct CacheHeader {
+    uint32_t internalFormat;
+    int32_t width;
+    int32_t height;
+    uint32_t levels;
+};
+
+std::filesystem::path cacheDirectory = Context::APP_DIR / "cache";
+
+bool isSRGBFormat(GLenum internalFormat) {
+    switch (internalFormat) {
+        case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT:
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+        case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+        case GL_SRGB8_ALPHA8:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * @brief Halves an image with a box filter, odd sizes repeat the last row or column.
+ */
+std::vector<float> downsample(const std::vector<float>& source, GLsizei width, GLsizei height, int channels) {
+    GLsizei w = std::max(width / 2, 1), h = std::max(height / 2, 1);
+    std::vector<float> result(static_cast<size_t>(w) * h * channels);
+    ThreadPool::global().parallelFor(0, static_cast<size_t>(h), [&](size_t y) {
+        GLsizei y0 = std::min(static_cast<GLsizei>(2 * y), height - 1), y1 = std::min(static_cast<GLsizei>(2 * y + 1), height - 1);
+        for (GLsizei x = 0; x < w; x++) {
+            GLsizei x0 = std::min(2 * x, width - 1), x1 = std::min(2 * x + 1, width - 1);
+            for (int c = 0; c < channels; c++) {
+                auto at = [&](GLsizei sx, GLsizei sy) { return source[(static_cast<size_t>(sy) * width + sx) * channels + c]; };
+                result[(y * w + x) * channels + c] = 0.25f * (at(x0, y0) + at(x1, y0) + at(x0, y1) + at(x1, y1));
+            }
+        }
+    });
+    return result;
+}
+
+/** The number of levels of the full mip chain down to 1x1 */
+GLint countFullLevels(GLsizei width, GLsizei height) {
+    return static_cast<GLint>(std::floor(std::log2(std::max(width, height)))) + 1;
+}
+
+GLint countLevels(GLsizei width, GLsizei height, GLint mipmaps) {
+    return std::clamp(mipmaps + 1, 1, countFullLevels(width, height));
+}
+
+EntryHeader getEntryHeader(const std::filesystem::path& source, uint32_t magic, uint32_t version) {
+    return {magic, version, static_cast<uint64_t>(std::filesystem::file_size(source)),
+            static_cast<int64_t>(std::filesystem::last_write_time(source).time_since_epoch().count())};
+}
+
+bool readCache(std::istream& file, GLenum internalFormat, TextureCache::CompressedImage& image) {
+    CacheHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+    if (header.internalFormat != internalFormat) return false;
+    // A corrupt header must not cause huge allocations, so the levels have to fill exactly the rest of the file
+    if (header.width <= 0 || header.height <= 0 || header.levels == 0
+        || header.levels > static_cast<uint32_t>(countFullLevels(header.width, header.height))) return false;
+    std::vector<size_t> sizes;
+    size_t total = 0;
+    GLsizei width = header.width, height = header.height;
+    for (uint32_t level = 0; level < header.levels; level++) {
+        sizes.push_back(DDS::getSurfaceSize(internalFormat, width, height));
+        total += sizes.back();
+        width = std::max(width / 2, 1);
+        height = std::max(height / 2, 1);
+    }
+    const auto start = file.tellg();
+    if (start < 0 || !file.seekg(0, std::ios::end)) return false;
+    const auto remaining = static_cast<size_t>(file.tellg() - start);
+    if (remaining != total || !file.seekg(start)) return false;
+
+    image.internalFormat = internalFormat;
+    image.width = header.width;
+    image.height = header.height;
+    image.levels.resize(header.levels);
+    for (size_t i = 0; i < sizes.size(); i++) {
+        image.levels[i].resize(sizes[i]);
+        if (!file.read(reinterpret_cast<char*>(image.levels[i].data()), static_cast<std::streamsize>(sizes[i]))) return false;
+    }
+    return true;
+}
+
+void writeCache(std::ostream& file, const TextureCache::CompressedImage& image) {
+    CacheHeader header = {image.internalFormat, image.width, image.height, static_cast<uint32_t>(image.levels.size())};
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const auto& level : image.levels) file.write(reinterpret_cast<const char*>(level.data()), static_cast<std::streamsize>(level.size()));
+}
+
+}
+
+TextureCache::CompressedImage TextureCache::compress(GLenum internalFormat, const std::filesystem::path& filepath, GLint mipmaps, bool flip) {
+    Context::setWorkingDirectory(); // Ensure that the working directory is set correctly
+    stbi_set_flip_vertically_on_load(flip);
+
+    CompressedImage image;
+    image.internalFormat = internalFormat;
+    GLsizei channelsInFile;
+    const bool compressed = isCompressedFormat(internalFormat);
+    bool isFloat = BCEncoder::isFloatFormat(internalFormat);
+    int channels = isFloat ? 3 : 4;
+    if (!compressed) {
+        // Uncompressed mip chains are only produced for DDS files, see texconv
+        if (internalFormat != GL_RGBA8 && internalFormat != GL_SRGB8_ALPHA8 && internalFormat != GL_RGBA32F && internalFormat != GL_RGB32F)
+            throw std::runtime_error("TextureCache: Unsupported format for " + filepath.string());
+        isFloat = internalFormat == GL_RGBA32F || internalFormat == GL_RGB32F;
+        channels = internalFormat == GL_RGB32F ? 3 : 4;
+    }
+    const bool srgb = isSRGBFormat(internalFormat);
+
+    // Mipmaps are filtered in linear floating point and requantized per level
+    std::vector<float> pixels;
+    if (isFloat) {
+        float* data = stbi_loadf(filepath.string().c_str(), &image.width, &image.height, &channelsInFile, channels);
+        if (!data) throw std::runtime_error("Failed to parse image " + filepath.string() + ": " + stbi_failure_reason());
+        pixels.assign(data, data + static_cast<size_t>(image.width) * image.height * channels);
+        stbi_image_free(data);
+    } else {
+        stbi_uc* data = stbi_load(filepath.string().c_str(), &image.width, &image.height, &channelsInFile, channels);
+        if (!data) throw std::runtime_error("Failed to parse image " + filepath.string() + ": " + stbi_failure_reason());
+        pixels.resize(static_cast<size_t>(image.width) * image.height * channels);
+        if (srgb) {
+            PixelConvert::srgbToLinear(data, pixels.data(), static_cast<size_t>(image.width) * image.height, channels, true);
+        } else {
+            for (size_t i = 0; i < pixels.size(); i++) pixels[i] = data[i] / 255.0f;
+        }
+        stbi_image_free(data);
+    }
+
+    GLsizei width = image.width, height = image.height;
+    const GLint levels = countLevels(width, height, mipmaps);
+    std::vector<uint8_t> bytes;
+    for (GLint level = 0; level < levels; level++) {
+        if (level > 0) {
+            pixels = downsample(pixels, width, height, channels);
+            width = std::max(width / 2, 1);
+            height = std::max(height / 2, 1);
+        }
+        if (isFloat) {
+            if (compressed) {
+                image.levels.push_back(BCEncoder::compress(internalFormat, pixels.data(), width, height));
+            } else {
+                const auto* begin = reinterpret_cast<const uint8_t*>(pixels.data());
+                image.levels.emplace_back(begin, begin + pixels.size() * sizeof(float));
+            }
+        } else {
+            bytes.resize(pixels.size());
+            if (srgb) {
+                PixelConvert::linearToSRGB(pixels.data(), bytes.data(), static_cast<size_t>(width) * height, channels, true);
+            } else {
+                for (size_t i = 0; i < pixels.size(); i++)
+                    bytes[i] = static_cast<uint8_t>(std::clamp(std::lround(pixels[i] * 255.0f), 0l, 255l));
+            }
+            image.levels.push_back(compressed ? BCEncoder::compress(internalFormat, bytes.data(), width, height) : bytes);
+        }
+    }
+    return image;
+}
+
+std::filesystem::path TextureCache::getCachePath(GLenum internalFormat, const std::filesystem::path& filepath, GLint mipmaps, bool flip) {
+    size_t hash = 0;
+    Common::hash_combine(hash, std::filesystem::absolute(filepath).string(), internalFormat, mipmaps, flip);
+    std::stringstream name;
+    name << filepath.stem().string() << "_" << std::hex << hash << ".bctc";
+    return cacheDirectory / name.str();
+}
+
+TextureCache::CompressedImage TextureCache::load(GLenum internalFormat, const std::filesystem::path& filepath, GLint mipmaps, bool flip) {
+    Context::setWorkingDirectory(); // Ensure that the working directory is set correctly
+    auto cachePath = getCachePath(internalFormat, filepath, mipmaps, flip);
+    CompressedImage image;
+    if (readEntry(cachePath, filepath, CACHE_MAGIC, CACHE_VERSION, [&](std::istream& file) { return readCache(file, internalFormat, image); })) return image;
+
+    std::cout << "Compressing " << std::filesystem::absolute(filepath) << std::endl;
+    image = compress(internalFormat, filepath, mipmaps, flip);
+    writeEntry(cachePath, filepath, CACHE_MAGIC, CACHE_VERSION, [&](std::ostream& file) { writeCache(file, image); });
+    return image;
+}
+
+bool TextureCache::readEntry(const std::filesystem::path& cachePath, const std::filesystem::path& source, uint32_t magic, uint32_t version,
+                             const std::function<bool(std::istream&)>& read) {
+    std::ifstream file(cachePath, std::ios::binary);
+    if (!file) return false;
+    const EntryHeader expected = getEntryHeader(source, magic, version);
+    EntryHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+    if (header.magic != expected.magic || header.version != expected.version || header.sourceSize != expected.sourceSize
+        || header.sourceTime != expected.sourceTime) return false;
+    return read(file);
+}
+
+void TextureCache::writeEntry(const std::filesystem::path& cachePath, const std::filesystem::path& source, uint32_t magic, uint32_t version,
+                              const std::function<void(std::ostream&)>& write) {
+    std::error_code error;
+    std::filesystem::create_directories(cachePath.parent_path(), error);
+    std::ofstream file(cachePath, std::ios::binary);
+    if (!file) {
+        std::cerr << "Warning: Could not write cache entry " << cachePath << std::endl;
+        return;
+    }
+    const EntryHeader header = getEntryHeader(source, magic, version);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    write(file);
+}
+
+void TextureCache::setDirectory(const std::filesystem::path& directory) {
+    cacheDirectory = directory;
+}
+
+const std::filesystem::path& TextureCache::getDirectory() {
+    return cacheDirectory;
+}
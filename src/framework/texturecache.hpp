@@ -0,0 +1,85 @@
+#pragma once
+
+#include <glad/gl.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+/**
+ * @file texturecache.hpp
+ * @brief Defines the TextureCache, which block compresses textures once at import and keeps the result on disk.
+ */
+
+/**
+ * @brief Produces block compressed mip chains from image files and caches them on disk, so later runs upload pre-compressed blocks straight away.
+ * Cache entries are keyed by the absolute path of the source, the format, the number of mipmaps and the orientation,
+ * and are invalidated when the size or modification time of the source changes.
+ * Used by `Texture::load` and `Texture::loadCubemap` for compressed internal formats.
+ * The directory and the entry format are shared with the other caches of the framework, e.g. `MeshLOD::load`.
+ */
+namespace TextureCache {
+
+    /**
+     * @brief A block compressed image with its mip chain.
+     */
+    struct CompressedImage {
+        GLenum internalFormat = GL_NONE;
+        GLsizei width = 0;
+        GLsizei height = 0;
+        /** The blocks (or texels for uncompressed formats) of each mip level, starting with the base level */
+        std::vector<std::vector<uint8_t>> levels;
+    };
+
+    /**
+     * @brief Loads a compressed image from the cache or compresses it and stores the result in the cache.
+     * @param internalFormat The compressed internal format, see `isCompressedFormat`.
+     * @param filepath The path to the image file.
+     * @param mipmaps The number of mipmaps to generate, clamped to the full chain.
+     * @param flip Whether the image is flipped vertically, as OpenGL expects the origin at the bottom left.
+     * @throw `std::runtime_error` when the file could not be parsed or the format is not supported by the encoder.
+     */
+    CompressedImage load(GLenum internalFormat, const std::filesystem::path& filepath, GLint mipmaps, bool flip);
+
+    /**
+     * @brief Compresses an image file without touching the cache, see `load`.
+     * Besides the compressed formats this also produces mip chains for `GL_RGBA8`, `GL_SRGB8_ALPHA8`, `GL_RGBA32F` and `GL_RGB32F`, which are stored as is.
+     */
+    CompressedImage compress(GLenum internalFormat, const std::filesystem::path& filepath, GLint mipmaps, bool flip);
+
+    /**
+     * @brief Gets the path of the cache entry of an image.
+     */
+    std::filesystem::path getCachePath(GLenum internalFormat, const std::filesystem::path& filepath, GLint mipmaps, bool flip);
+
+    /**
+     * @brief Reads a cache entry if it was written for the current size and modification time of its source.
+     * @param magic Identifies the kind of entry.
+     * @param version The version of the entry format, entries of other versions are ignored.
+     * @param read Reads the payload after the header, returns false if it is invalid.
+     * @return Whether the entry exists, is up to date and its payload was read.
+     */
+    bool readEntry(const std::filesystem::path& cachePath, const std::filesystem::path& source, uint32_t magic, uint32_t version,
+                   const std::function<bool(std::istream&)>& read);
+
+    /**
+     * @brief Writes a cache entry for the current size and modification time of its source, failures are only reported as a warning.
+     * @param write Writes the payload after the header.
+     */
+    void writeEntry(const std::filesystem::path& cachePath, const std::filesystem::path& source, uint32_t magic, uint32_t version,
+                    const std::function<void(std::ostream&)>& write);
+
+    /**
+     * @brief Sets the directory for cache entries, defaults to `cache` in the application directory.
+     */
+    void setDirectory(const std::filesystem::path& directory);
+
+    /**
+     * @brief Gets the directory for cache entries.
+     */
+    const std::filesystem::path& getDirectory();
+
+}
@@ -0,0 +1,118 @@
+#include "threadpool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "trace.hpp"
+
+ThreadPool::ThreadPool(unsigned int threads) {
+    workers.reserve(threads);
+    for (unsigned int i = 0; i < threads; i++) {
+        workers.emplace_back([this, i]() {
+            if constexpr (Trace::COMPILED) Trace::setThreadName("Worker " + std::to_string(i));
+            work();
+        });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    condition.notify_all();
+    for (auto& worker : workers) worker.join();
+}
+
+ThreadPool& ThreadPool::global() {
+    static ThreadPool pool;
+    return pool;
+}
+
+unsigned int ThreadPool::defaultThreadCount() {
+    const unsigned int hardware = std::thread::hardware_concurrency();
+    return hardware > 1 ? hardware - 1 : 1;
+}
+
+unsigned int ThreadPool::size() const {
+    return static_cast<unsigned int>(workers.size());
+}
+
+void ThreadPool::enqueue(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push(std::move(task));
+    }
+    condition.notify_one();
+}
+
+void ThreadPool::work() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this]() { return stopping || !tasks.empty(); });
+            if (stopping && tasks.empty()) return;
+            task = std::move(tasks.front());
+            tasks.pop();
+        }
+        TRACE_ZONE("Task");
+        task();
+    }
+}
+
+void ThreadPool::parallelFor(size_t begin, size_t end, const std::function<void(size_t)>& body, size_t grain) {
+    parallelForChunks(begin, end, [&body](size_t chunkBegin, size_t chunkEnd) {
+        for (size_t i = chunkBegin; i < chunkEnd; i++) body(i);
+    }, grain);
+}
+
+void ThreadPool::parallelForChunks(size_t begin, size_t end, const std::function<void(size_t, size_t)>& body, size_t grain) {
+    if (begin >= end) return;
+    grain = std::max<size_t>(grain, 1);
+    const size_t chunks = (end - begin + grain - 1) / grain;
+    if (chunks == 1) {
+        body(begin, end);
+        return;
+    }
+
+    // Shared between the calling thread and the helpers, helpers may outlive this call if they never got to run
+    struct Loop {
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> done{0};
+        std::mutex mutex;
+        std::condition_variable finished;
+        std::exception_ptr exception;
+    };
+    auto loop = std::make_shared<Loop>();
+
+    auto run = [loop, begin, end, grain, chunks, &body]() {
+        size_t chunk;
+        while ((chunk = loop->next.fetch_add(1)) < chunks) {
+            const size_t chunkBegin = begin + chunk * grain;
+            try {
+                body(chunkBegin, std::min(chunkBegin + grain, end));
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(loop->mutex);
+                if (!loop->exception) loop->exception = std::current_exception();
+            }
+            if (loop->done.fetch_add(1) + 1 == chunks) {
+                std::lock_guard<std::mutex> lock(loop->mutex);
+                loop->finished.notify_all();
+            }
+        }
+    };
+
+    const size_t helpers = std::min<size_t>(workers.size(), chunks - 1);
+    for (size_t i = 0; i < helpers; i++) enqueue(run);
+    run(); // The calling thread participates
+
+    std::unique_lock<std::mutex> lock(loop->mutex);
+    loop->finished.wait(lock, [&loop, chunks]() { return loop->done.load() == chunks; });
+    if (loop->exception) std::rethrow_exception(loop->exception);
+}
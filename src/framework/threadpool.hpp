@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @file threadpool.hpp
+ * @brief Defines a ThreadPool class for running CPU work on worker threads.
+ */
+
+/**
+ * @class ThreadPool
+ * @brief Fixed set of worker threads that execute submitted tasks and parallel loops.
+ * The pool never touches OpenGL, all GL calls have to stay on the thread that owns the context.
+ */
+class ThreadPool {
+   public:
+    /**
+     * @brief Starts the worker threads.
+     * @param threads The number of worker threads, defaults to the number of hardware threads minus the calling thread.
+     */
+    explicit ThreadPool(unsigned int threads = defaultThreadCount());
+
+    /**
+     * @brief Copy constructor (deleted).
+     */
+    ThreadPool(const ThreadPool&) = delete;
+
+    /**
+     * @brief Copy assignment operator (deleted).
+     */
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Destructor, finishes all queued tasks and joins the worker threads.
+     */
+    ~ThreadPool();
+
+    /**
+     * @brief Gets a process wide pool that is created on first use.
+     */
+    static ThreadPool& global();
+
+    /**
+     * @brief The number of hardware threads minus one for the calling thread, but at least one.
+     */
+    static unsigned int defaultThreadCount();
+
+    /**
+     * @brief The number of worker threads.
+     */
+    unsigned int size() const;
+
+    /**
+     * @brief Queues a task for execution on a worker thread.
+     * @return A future that holds the result or the exception thrown by the task.
+     */
+    template <typename F>
+    auto submit(F&& task) -> std::future<std::invoke_result_t<F>>;
+
+    /**
+     * @brief Calls `body(i)` for every `i` in `[begin, end)` and blocks until all calls returned.
+     * The range is split into chunks of `grain` indices that are claimed dynamically by the workers and the calling thread,
+     * so calling `parallelFor` from inside a task cannot deadlock.
+     * @throw Rethrows the first exception thrown by `body`.
+     */
+    void parallelFor(size_t begin, size_t end, const std::function<void(size_t)>& body, size_t grain = 1);
+
+    /**
+     * @brief Calls `body(chunkBegin, chunkEnd)` for consecutive chunks of at most `grain` indices in `[begin, end)` and blocks until all calls returned.
+     * @throw Rethrows the first exception thrown by `body`.
+     */
+    void parallelForChunks(size_t begin, size_t end, const std::function<void(size_t, size_t)>& body, size_t grain);
+
+   private:
+    void enqueue(std::function<void()> task);
+    void work();
+
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool stopping = false;
+};
+
+template <typename F>
+auto ThreadPool::submit(F&& task) -> std::future<std::invoke_result_t<F>> {
+    using R = std::invoke_result_t<F>;
+    auto packaged = std::make_shared<std::packaged_task<R()>>(std::forward<F>(task));
+    auto future = packaged->get_future();
+    enqueue([packaged]() { (*packaged)(); });
+    return future;
+}
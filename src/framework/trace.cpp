@@ -0,0 +1,291 @@
+#include "trace.hpp"
+
+#include <glad/gl.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "gl/query.hpp"
+
+namespace {
+    struct Event {
+        const char* name = nullptr;
+        uint64_t start = 0;
+        uint64_t duration = 0;
+        std::string detail;
+    };
+
+    constexpr size_t CHUNK_SIZE = 1024;
+    /** Events of a thread beyond this are dropped, so a recording that is left running does not grow without bounds */
+    constexpr size_t MAX_EVENTS = 256 * CHUNK_SIZE;
+
+    /** Events are only written by the owning thread and published by incrementing `count` */
+    struct Chunk {
+        std::array<Event, CHUNK_SIZE> events;
+        std::atomic<size_t> count = 0;
+        std::atomic<Chunk*> next = nullptr;
+    };
+
+    struct ThreadBuffer {
+        uint32_t id = 0;
+        std::string name;
+        Chunk head;
+        Chunk* tail = &head;
+        /** The recording the events belong to, only changed by the owning thread while holding the mutex of the registry */
+        uint64_t session = 0;
+        /** Only used by the owning thread */
+        size_t size = 0;
+        /** Whether events were dropped because the buffer was full */
+        std::atomic<bool> dropped = false;
+
+        void push(Event&& event) {
+            if (size == MAX_EVENTS) {
+                dropped.store(true, std::memory_order_relaxed);
+                return;
+            }
+            size++;
+            size_t count = tail->count.load(std::memory_order_relaxed);
+            if (count == CHUNK_SIZE) {
+                auto chunk = new Chunk();
+                tail->next.store(chunk, std::memory_order_release);
+                tail = chunk;
+                count = 0;
+            }
+            tail->events[count] = std::move(event);
+            tail->count.store(count + 1, std::memory_order_release);
+        }
+
+        /** Discards all events, must not run concurrently with `writeThread` */
+        void clear() {
+            for (Chunk* chunk = head.next.load(std::memory_order_relaxed); chunk;) {
+                Chunk* next = chunk->next.load(std::memory_order_relaxed);
+                delete chunk;
+                chunk = next;
+            }
+            head.next.store(nullptr, std::memory_order_relaxed);
+            head.count.store(0, std::memory_order_relaxed);
+            tail = &head;
+            size = 0;
+            dropped.store(false, std::memory_order_relaxed);
+        }
+    };
+
+    /** A GPU zone whose queries have not been read yet */
+    struct GPUSlot {
+        const char* name = nullptr;
+        Query begin;
+        Query end;
+    };
+
+    /** Only used on the thread of the OpenGL context */
+    struct GPUTimeline {
+        std::vector<std::unique_ptr<GPUSlot>> slots;
+        std::vector<size_t> free;
+        std::vector<size_t> pending;
+        /** CPU minus GPU time in nanoseconds */
+        int64_t offset = 0;
+        bool calibrated = false;
+    };
+
+    struct Registry {
+        std::mutex mutex;
+        std::vector<ThreadBuffer*> threads;
+        /** The GPU timeline is exported as its own thread */
+        ThreadBuffer gpu;
+        std::atomic<bool> recording = false;
+        std::atomic<bool> calibrate = false;
+        /** Incremented by `Trace::start`, buffers of an older recording are cleared by their thread before its next event */
+        std::atomic<uint64_t> session = 0;
+
+        Registry() {
+            gpu.name = "GPU";
+        }
+    };
+
+    const auto START = std::chrono::steady_clock::now();
+
+    Registry& getRegistry() {
+        // Never destroyed, so threads that outlive static destruction can still record
+        static auto registry = new Registry();
+        return *registry;
+    }
+
+    ThreadBuffer& getThreadBuffer() {
+        thread_local ThreadBuffer* buffer = nullptr;
+        if (!buffer) {
+            auto& registry = getRegistry();
+            std::lock_guard lock(registry.mutex);
+            // Buffers are kept after their thread exits so their events can still be written
+            buffer = new ThreadBuffer();
+            buffer->id = static_cast<uint32_t>(registry.threads.size() + 1);
+            buffer->name = "Thread " + std::to_string(buffer->id);
+            registry.threads.push_back(buffer);
+        }
+        return *buffer;
+    }
+
+    /** Appends an event on the thread that owns the buffer */
+    void append(ThreadBuffer& buffer, Event&& event) {
+        auto& registry = getRegistry();
+        const uint64_t session = registry.session.load(std::memory_order_relaxed);
+        if (buffer.session != session) {
+            // The lock keeps `Trace::write` from reading the events while they are discarded
+            std::lock_guard lock(registry.mutex);
+            buffer.clear();
+            buffer.session = session;
+        }
+        buffer.push(std::move(event));
+    }
+
+    GPUTimeline& getGPUTimeline() {
+        static GPUTimeline timeline;
+        return timeline;
+    }
+
+    void writeEscaped(std::ostream& stream, std::string_view text) {
+        for (const char c : text) {
+            switch (c) {
+                case '"': stream << "\\\""; break;
+                case '\\': stream << "\\\\"; break;
+                case '\n': stream << "\\n"; break;
+                case '\t': stream << "\\t"; break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20) {
+                        char escaped[8];
+                        std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                        stream << escaped;
+                    } else {
+                        stream << c;
+                    }
+            }
+        }
+    }
+
+    /** Writes the name of a thread and its events if they belong to the current recording, called with the mutex of the registry held */
+    void writeThread(std::ostream& stream, const ThreadBuffer& buffer, const char* category, uint64_t session, bool& first) {
+        const bool current = buffer.session == session;
+        stream << (first ? "" : ",\n") << R"({"name":"thread_name","ph":"M","pid":1,"tid":)" << buffer.id << R"(,"args":{"name":")";
+        writeEscaped(stream, buffer.name);
+        if (current && buffer.dropped.load(std::memory_order_relaxed)) stream << " (truncated)";
+        stream << "\"}}";
+        first = false;
+        if (!current) return;
+        for (const Chunk* chunk = &buffer.head; chunk; chunk = chunk->next.load(std::memory_order_acquire)) {
+            const size_t count = chunk->count.load(std::memory_order_acquire);
+            for (size_t i = 0; i < count; i++) {
+                const auto& event = chunk->events[i];
+                // Timestamps are in microseconds
+                char times[64];
+                std::snprintf(times, sizeof(times), R"("ts":%.3f,"dur":%.3f)", event.start * 1e-3, event.duration * 1e-3);
+                stream << ",\n" << R"({"name":")";
+                writeEscaped(stream, event.name);
+                stream << R"(","cat":")" << category << R"(","ph":"X",)" << times << R"(,"pid":1,"tid":)" << buffer.id;
+                if (!event.detail.empty()) {
+                    stream << R"(,"args":{"detail":")";
+                    writeEscaped(stream, event.detail);
+                    stream << "\"}";
+                }
+                stream << "}";
+            }
+        }
+    }
+}
+
+uint64_t Trace::now() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - START).count());
+}
+
+void Trace::start() {
+    auto& registry = getRegistry();
+    registry.session.fetch_add(1);
+    registry.calibrate.store(true);
+    registry.recording.store(true);
+}
+
+void Trace::stop() {
+    getRegistry().recording.store(false);
+}
+
+bool Trace::isRecording() {
+    return getRegistry().recording.load(std::memory_order_relaxed);
+}
+
+void Trace::setThreadName(std::string_view name) {
+    auto& buffer = getThreadBuffer();
+    auto& registry = getRegistry();
+    std::lock_guard lock(registry.mutex);
+    buffer.name = name;
+}
+
+void Trace::record(const char* name, uint64_t start, std::string&& detail) {
+    const uint64_t end = now();
+    append(getThreadBuffer(), {name, start, end - start, std::move(detail)});
+}
+
+void Trace::newFrame() {
+    auto& timeline = getGPUTimeline();
+    auto& gpu = getRegistry().gpu;
+    size_t kept = 0;
+    // Zones end in order, so the first one that is not available ends the search
+    size_t i = 0;
+    for (; i < timeline.pending.size(); i++) {
+        auto& slot = *timeline.slots[timeline.pending[i]];
+        if (!slot.end.isResultAvailable()) break;
+        const auto begin = static_cast<int64_t>(slot.begin.getResult64()), end = static_cast<int64_t>(slot.end.getResult64());
+        append(gpu, {slot.name, static_cast<uint64_t>(std::max<int64_t>(begin + timeline.offset, 0)), static_cast<uint64_t>(std::max<int64_t>(end - begin, 0)), {}});
+        timeline.free.push_back(timeline.pending[i]);
+    }
+    for (; i < timeline.pending.size(); i++) timeline.pending[kept++] = timeline.pending[i];
+    timeline.pending.resize(kept);
+}
+
+bool Trace::write(const std::filesystem::path& filepath) {
+    std::ofstream stream(filepath);
+    if (!stream) return false;
+    stream << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    auto& registry = getRegistry();
+    bool first = true;
+    {
+        std::lock_guard lock(registry.mutex);
+        const uint64_t session = registry.session.load();
+        for (const auto buffer : registry.threads) writeThread(stream, *buffer, "cpu", session, first);
+        writeThread(stream, registry.gpu, "gpu", session, first);
+    }
+    stream << "\n]}\n";
+    return static_cast<bool>(stream);
+}
+
+Trace::GPUZone::GPUZone(const char* name) {
+    if (!isRecording()) return;
+    auto& timeline = getGPUTimeline();
+    if (getRegistry().calibrate.exchange(false) || !timeline.calibrated) {
+        // Maps the GPU clock to the CPU clock, the difference drifts only slowly
+        GLint64 gpuTime = 0;
+        glGetInteger64v(GL_TIMESTAMP, &gpuTime);
+        timeline.offset = static_cast<int64_t>(now()) - gpuTime;
+        timeline.calibrated = true;
+    }
+    if (timeline.free.empty()) {
+        timeline.free.push_back(timeline.slots.size());
+        timeline.slots.push_back(std::make_unique<GPUSlot>());
+    }
+    zone = static_cast<int64_t>(timeline.free.back());
+    timeline.free.pop_back();
+    auto& slot = *timeline.slots[zone];
+    slot.name = name;
+    slot.begin.timestamp();
+}
+
+Trace::GPUZone::~GPUZone() {
+    if (zone < 0) return;
+    auto& timeline = getGPUTimeline();
+    timeline.slots[zone]->end.timestamp();
+    timeline.pending.push_back(static_cast<size_t>(zone));
+}
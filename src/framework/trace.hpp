@@ -0,0 +1,149 @@
+#pragma once
+
+#include <glad/gl.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <utility>
+
+/**
+ * @file trace.hpp
+ * @brief Defines scoped CPU and GPU zones that are exported as trace events for Perfetto and chrome://tracing.
+ */
+
+/**
+ * Zones are only compiled in with the CMake option `ENABLE_TRACE`, otherwise the macros expand to nothing and their arguments are not evaluated.
+ * Example:
+ * ```cpp
+ * void load(const std::filesystem::path& filepath) {
+ *     TRACE_ZONE_TEXT("load", filepath.string()); // Measures until the end of the scope
+ *     ...
+ * }
+ * void render() {
+ *     TRACE_GPU_ZONE("Shadows"); // Measures the GPU time of the commands issued in the scope
+ *     ...
+ * }
+ * Trace::start();
+ * ...
+ * Trace::write("trace.json");
+ * ```
+ */
+#ifdef ENABLE_TRACE
+    #define TRACE_CONCAT_IMPL(a, b) a##b
+    #define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+    /** Records a zone named by a string literal until the end of the scope */
+    #define TRACE_ZONE(name) Trace::Zone TRACE_CONCAT(traceZone, __LINE__)(name)
+    /** Records a zone with a detail string, e.g. the file that is loaded, which is only evaluated while recording */
+    #define TRACE_ZONE_TEXT(name, text) Trace::Zone TRACE_CONCAT(traceZone, __LINE__)(name, [&]() -> std::string { return text; })
+    /** Records a zone on the GPU timeline with timer queries, only on the thread of the OpenGL context */
+    #define TRACE_GPU_ZONE(name) Trace::GPUZone TRACE_CONCAT(traceGPUZone, __LINE__)(name)
+#else
+    #define TRACE_ZONE(name)
+    #define TRACE_ZONE_TEXT(name, text)
+    #define TRACE_GPU_ZONE(name)
+#endif
+
+/**
+ * @brief Records zones into buffers owned by each thread and exports them in the trace event JSON format.
+ * Threads append to their own chunked buffer without locks and publish each event with a release store, so `write` can run while other threads record.
+ * Each thread keeps at most 262144 events per recording, later ones are dropped and the thread is marked as truncated in the trace.
+ * GPU zones are resolved once their timestamp queries are available and are placed on the CPU timeline with an offset measured by `GL_TIMESTAMP`.
+ */
+namespace Trace {
+
+#ifdef ENABLE_TRACE
+    constexpr bool COMPILED = true;
+#else
+    constexpr bool COMPILED = false;
+#endif
+
+    /**
+     * @brief Nanoseconds since the start of the application on a monotonic clock.
+     */
+    uint64_t now();
+
+    /**
+     * @brief Starts recording and discards the events of earlier recordings, zones opened before are skipped.
+     */
+    void start();
+
+    /**
+     * @brief Stops recording, the recorded events are kept until `write`.
+     */
+    void stop();
+
+    bool isRecording();
+
+    /**
+     * @brief Names the calling thread in the exported trace.
+     */
+    void setThreadName(std::string_view name);
+
+    /**
+     * @brief Resolves the GPU zones whose queries are available without stalling, called once per frame by `App::run`.
+     */
+    void newFrame();
+
+    /**
+     * @brief Writes all events recorded so far as trace event JSON, which can be opened in https://ui.perfetto.dev.
+     * @return Whether the file could be written.
+     */
+    bool write(const std::filesystem::path& filepath);
+
+    /**
+     * @brief Records an event that started at `start` and ends now, used by `Zone`.
+     */
+    void record(const char* name, uint64_t start, std::string&& detail = {});
+
+    /**
+     * @class Zone
+     * @brief Measures the time from its construction to its destruction on the calling thread, see `TRACE_ZONE`.
+     */
+    class Zone {
+       public:
+        explicit Zone(const char* name) : name(isRecording() ? name : nullptr), start(this->name ? now() : 0) {}
+
+        /**
+         * @brief Opens a zone with a detail string, `text` returns it and is only called if the zone is recorded, see `TRACE_ZONE_TEXT`.
+         */
+        template <typename Text>
+        Zone(const char* name, Text&& text) : Zone(name) {
+            if (this->name) detail = text();
+        }
+
+        Zone(const Zone&) = delete;
+        Zone& operator=(const Zone&) = delete;
+
+        ~Zone() {
+            if (name) record(name, start, std::move(detail));
+        }
+
+        /** Whether the zone is recorded, which requires that recording was started when it was opened */
+        bool isActive() const { return name != nullptr; }
+
+        void setDetail(std::string text) { detail = std::move(text); }
+
+       private:
+        const char* name;
+        uint64_t start;
+        std::string detail;
+    };
+
+    /**
+     * @class GPUZone
+     * @brief Measures the GPU time of the commands issued during its lifetime with `GL_TIMESTAMP` queries, see `TRACE_GPU_ZONE`.
+     */
+    class GPUZone {
+       public:
+        explicit GPUZone(const char* name);
+        GPUZone(const GPUZone&) = delete;
+        GPUZone& operator=(const GPUZone&) = delete;
+        ~GPUZone();
+
+       private:
+        /** Index of the pending zone, or -1 if not recording */
+        int64_t zone = -1;
+    };
+}
@@ -0,0 +1,139 @@
+#include <glad/gl.h>
+
+#define GLFW_INCLUDE_NONE
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "framework/gl/capture.hpp"
+#include "framework/gl/validation.hpp"
+
+/**
+ * @file main.cpp
+ * @brief Replays a capture recorded with `GLCapture` in a hidden window as fast as possible and reports the throughput of the driver.
+ */
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+void printUsage() {
+    std::cout << "Usage: replay [-n loops] [--finish] capture.glcapture\n\n"
+              << "  -n loops   Number of times all frames are replayed after the setup (default 10)\n"
+              << "  --finish   Waits for the GPU after every frame to measure frame times instead of the throughput\n\n"
+              << "Captures are recorded with: demo --capture capture.glcapture frames\n";
+}
+
+/**
+ * @brief Creates a hidden window with the context version of `App`, its default framebuffer has the size of the captured one.
+ */
+GLFWwindow* createContext(const glm::ivec2& resolution) {
+    if (!glfwInit()) throw std::runtime_error("Failed to initialize GLFW");
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+#ifndef MODERN_GL
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
+#else
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+#endif
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_SRGB_CAPABLE, GLFW_TRUE);
+#ifdef __APPLE__
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GLFW_TRUE);
+#endif
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow* window = glfwCreateWindow(std::max(resolution.x, 1), std::max(resolution.y, 1), "replay", nullptr, nullptr);
+    if (!window) throw std::runtime_error("Failed to create window");
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGL(glfwGetProcAddress)) throw std::runtime_error("Failed to initialize GLAD");
+    glfwSwapInterval(0);
+    // Calls go directly to the driver
+    GLValidation::setLevel(GLValidation::Level::Off);
+    return window;
+}
+
+double milliseconds(Clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+}
+
+int main(int argc, char** argv) {
+    try {
+        int loops = 10;
+        bool finish = false;
+        std::filesystem::path path;
+        for (int i = 1; i < argc; i++) {
+            const std::string arg = argv[i];
+            if (arg == "-n" && i + 1 < argc) loops = std::max(std::stoi(argv[++i]), 1);
+            else if (arg == "--finish") finish = true;
+            else if (arg == "-h" || arg == "--help") {
+                printUsage();
+                return 0;
+            } else if (!arg.empty() && arg[0] == '-') {
+                throw std::runtime_error("Unknown option " + arg);
+            } else {
+                path = arg;
+            }
+        }
+        if (path.empty()) {
+            printUsage();
+            return 1;
+        }
+
+        GLCapture::Replay replay(path);
+        const auto resolution = replay.getResolution();
+        GLFWwindow* window = createContext(resolution);
+        std::cout << "OpenGL Renderer: " << glGetString(GL_RENDERER) << "\n"
+                  << replay.getFrameCount() << " frames at " << resolution.x << "x" << resolution.y << std::endl;
+        if (replay.getFrameCount() == 0) throw std::runtime_error("The capture contains no frames");
+
+        auto start = Clock::now();
+        replay.runSetup();
+        glFinish();
+        std::cout << "Setup: " << replay.getSetupCallCount() << " calls in " << std::fixed << std::setprecision(2) << milliseconds(Clock::now() - start) << " ms" << std::endl;
+
+        size_t frameCalls = 0;
+        for (size_t frame = 0; frame < replay.getFrameCount(); frame++) frameCalls += replay.getFrameCallCount(frame);
+
+        // Every loop replays all frames, the frames are measured separately only with --finish
+        std::vector<double> times;
+        for (int loop = 0; loop < loops; loop++) {
+            const auto loopStart = Clock::now();
+            for (size_t frame = 0; frame < replay.getFrameCount(); frame++) {
+                const auto frameStart = Clock::now();
+                replay.runFrame(frame);
+                glfwSwapBuffers(window);
+                if (finish) {
+                    glFinish();
+                    times.push_back(milliseconds(Clock::now() - frameStart));
+                }
+            }
+            replay.deleteSyncs();
+            if (!finish) {
+                glFinish();
+                times.push_back(milliseconds(Clock::now() - loopStart) / static_cast<double>(replay.getFrameCount()));
+            }
+        }
+
+        std::sort(times.begin(), times.end());
+        double average = 0.0;
+        for (const double time : times) average += time;
+        average /= static_cast<double>(times.size());
+        std::cout << (finish ? "Frame time" : "Frame time per loop") << ": best " << times.front() << " ms, median " << times[times.size() / 2] << " ms, average " << average << " ms\n"
+                  << "Calls: " << frameCalls / replay.getFrameCount() << " per frame, " << std::setprecision(1) << static_cast<double>(frameCalls) / replay.getFrameCount() / (average * 1e-3) / 1e6 << " million per second" << std::endl;
+
+        glfwDestroyWindow(window);
+        glfwTerminate();
+    } catch (std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,152 @@
+#include <glad/gl.h>
+
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "framework/dds.hpp"
+#include "framework/texturecache.hpp"
+#include "framework/gl/texture.hpp"
+
+/**
+ * @file main.cpp
+ * @brief Converts PNG/HDR images into DDS files with precomputed mip chains that `Texture::loadDDS` uploads without decoding.
+ */
+
+namespace {
+
+struct FormatName {
+    const char* name;
+    GLenum internalFormat;
+};
+
+const FormatName FORMATS[] = {
+    {"bc1", GL_COMPRESSED_RGB_S3TC_DXT1_EXT},
+    {"bc1-srgb", GL_COMPRESSED_SRGB_S3TC_DXT1_EXT},
+    {"bc1a", GL_COMPRESSED_RGBA_S3TC_DXT1_EXT},
+    {"bc3", GL_COMPRESSED_RGBA_S3TC_DXT5_EXT},
+    {"bc3-srgb", GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT},
+    {"bc4", GL_COMPRESSED_RED_RGTC1},
+    {"bc5", GL_COMPRESSED_RG_RGTC2},
+    {"bc6h", GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT},
+    {"bc7", GL_COMPRESSED_RGBA_BPTC_UNORM},
+    {"bc7-srgb", GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM},
+    {"rgba8", GL_RGBA8},
+    {"srgba8", GL_SRGB8_ALPHA8},
+    {"rgb32f", GL_RGB32F},
+    {"rgba32f", GL_RGBA32F},
+};
+
+const std::array<const char*, 6> CUBEMAP_FACES = {"px.hdr", "nx.hdr", "py.hdr", "ny.hdr", "pz.hdr", "nz.hdr"};
+
+GLenum parseFormat(const std::string& name) {
+    for (const auto& format : FORMATS)
+        if (name == format.name) return format.internalFormat;
+    throw std::runtime_error("Unknown format " + name);
+}
+
+void printUsage() {
+    std::cout << "Usage: texconv [-f format] [-m mipmaps] [--cubemap] -o output.dds input...\n"
+              << "       texconv --all directory\n\n"
+              << "  -f format   Output format (default bc7-srgb for LDR and bc6h for HDR inputs):\n             ";
+    for (const auto& format : FORMATS) std::cout << " " << format.name;
+    std::cout << "\n"
+              << "  -m mipmaps  Number of mipmaps in addition to the base level (default full chain)\n"
+              << "  --cubemap   The input is a directory containing px.hdr, nx.hdr, py.hdr, ny.hdr, pz.hdr and nz.hdr\n"
+              << "              or six images in this order\n"
+              << "  input...    Multiple inputs are written as an array texture\n"
+              << "  --all       Converts every .png, .hdr and cubemap directory in a directory next to its source\n";
+}
+
+GLenum defaultFormat(const std::filesystem::path& input) {
+    return input.extension() == ".hdr" ? GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT : GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM;
+}
+
+/**
+ * @brief Encodes all inputs as layers of one DDS file, 2D images are flipped for OpenGL while cubemap faces are not.
+ */
+void convert(const std::vector<std::filesystem::path>& inputs, const std::filesystem::path& output, GLenum internalFormat, GLint mipmaps, bool cubemap) {
+    std::vector<std::vector<std::vector<uint8_t>>> layers;
+    GLsizei width = 0, height = 0;
+    for (const auto& input : inputs) {
+        std::cout << "Converting " << input << std::endl;
+        auto image = TextureCache::compress(internalFormat, input, mipmaps, !cubemap);
+        if (layers.empty()) {
+            width = image.width;
+            height = image.height;
+        } else if (image.width != width || image.height != height) {
+            throw std::runtime_error("All layers need the same size, but " + input.string() + " differs");
+        }
+        layers.push_back(std::move(image.levels));
+    }
+    DDS::write(output, internalFormat, width, height, cubemap, layers);
+}
+
+std::vector<std::filesystem::path> cubemapFaces(const std::filesystem::path& directory) {
+    std::vector<std::filesystem::path> faces;
+    for (const char* face : CUBEMAP_FACES) faces.push_back(directory / face);
+    return faces;
+}
+
+void convertAll(const std::filesystem::path& directory) {
+    for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+        const auto& path = entry.path();
+        if (entry.is_directory() && std::filesystem::exists(path / CUBEMAP_FACES[0])) {
+            convert(cubemapFaces(path), path.string() + ".dds", GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT, 16, true);
+        } else if (entry.is_regular_file() && (path.extension() == ".png" || path.extension() == ".hdr")) {
+            auto output = path;
+            output.replace_extension(".dds");
+            convert({path}, output, defaultFormat(path), 16, false);
+        }
+    }
+}
+
+}
+
+int main(int argc, char** argv) {
+    try {
+        GLenum internalFormat = GL_NONE;
+        GLint mipmaps = 16; // Clamped to the full chain
+        bool cubemap = false;
+        std::filesystem::path output;
+        std::vector<std::filesystem::path> inputs;
+
+        // Paths are made absolute right away, as loading changes the working directory in debug builds
+        for (int i = 1; i < argc; i++) {
+            const std::string arg = argv[i];
+            const bool hasValue = i + 1 < argc;
+            if (arg == "-f" && hasValue) internalFormat = parseFormat(argv[++i]);
+            else if (arg == "-m" && hasValue) mipmaps = std::stoi(argv[++i]);
+            else if (arg == "-o" && hasValue) output = std::filesystem::absolute(argv[++i]);
+            else if (arg == "--cubemap") cubemap = true;
+            else if (arg == "--all" && hasValue) {
+                convertAll(std::filesystem::absolute(argv[++i]));
+                return 0;
+            } else if (arg == "-h" || arg == "--help") {
+                printUsage();
+                return 0;
+            } else if (!arg.empty() && arg[0] == '-') {
+                throw std::runtime_error("Unknown option " + arg);
+            } else {
+                inputs.push_back(std::filesystem::absolute(arg));
+            }
+        }
+
+        if (inputs.empty() || output.empty()) {
+            printUsage();
+            return -1;
+        }
+        if (cubemap && inputs.size() == 1) inputs = cubemapFaces(inputs[0]);
+        if (cubemap && inputs.size() != 6) throw std::runtime_error("Cubemaps need six faces");
+        if (internalFormat == GL_NONE) internalFormat = defaultFormat(inputs[0]);
+        convert(inputs, output, internalFormat, mipmaps, cubemap);
+    } catch (std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return -1;
+    }
+    return 0;
+}